@@ -0,0 +1,34 @@
+/*
+ * Medibox - delta patches against the versioned alarm table
+ *
+ * A patch names the table version it was computed against and only the
+ * slots it touches, keyed by the 1-based alarm id:
+ *
+ *   {"base": 12, "1": "07:30", "2": null}
+ *
+ * "HH:MM" inserts or updates that alarm (and activates it), null deletes
+ * it. A patch is all-or-nothing: every entry is validated before any slot
+ * changes, and a base other than the current version is rejected so an
+ * edit made meanwhile on the device is never silently overwritten.
+ * Plain C++ with no Arduino dependencies.
+ */
+
+#ifndef ALARM_PATCH_H
+#define ALARM_PATCH_H
+
+#include <stdint.h>
+#include "json_parser.h"
+#include "settings.h"
+
+enum AlarmPatchResult {
+  ALARM_PATCH_OK,
+  ALARM_PATCH_STALE,      // base does not match the current version
+  ALARM_PATCH_INVALID     // unknown id, bad time or missing base
+};
+
+// Applies body to alarms in place if it is valid against version. On
+// success *changedMask has a bit set for every slot whose value changed.
+AlarmPatchResult alarm_patch_apply(const JsonFlatParser& body, Alarm* alarms,
+                                   uint32_t version, uint32_t* changedMask);
+
+#endif
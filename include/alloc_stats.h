@@ -0,0 +1,24 @@
+/*
+ * Medibox - heap allocation counters
+ *
+ * malloc, calloc, realloc and free are wrapped at link time
+ * (-Wl,--wrap=... in platformio.ini), so every allocation in the firmware,
+ * Arduino String and operator new included, bumps a counter. Allocations
+ * made by one watched task (the loop task) are also counted separately,
+ * which lets loop() check that a code path allocates nothing: read
+ * alloc_stats_task_allocs() before and after it.
+ *
+ * heap_caps_malloc() called directly bypasses the wrappers.
+ */
+
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <stdint.h>
+
+// Counts the calling task's allocations from now on
+void alloc_stats_watch_current_task();
+// Allocations made by the watched task since it was set; wraps
+uint32_t alloc_stats_task_allocs();
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Medibox - pin assignments (see diagram.json for the wiring)
+ *
+ * Shared by the firmware, the ESP32 HAL and the host runner, which
+ * presses the same buttons the board has.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+// Buttons, active low
+#define BTN_UP 33
+#define BTN_OK 32
+#define BTN_DOWN 35
+#define BTN_CANCEL 34
+
+// Rotary encoder (build with -D INPUT_ENCODER=1)
+#define ENC_A 18
+#define ENC_B 19
+#define ENC_SW 23
+
+// Outputs
+#define LED_PIN 15
+#define BUZZER_PIN 5
+
+// DHT22 temperature/humidity sensor
+#define DHT_PIN 12
+
+#endif
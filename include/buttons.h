@@ -0,0 +1,34 @@
+/*
+ * Medibox - debounced buttons with long-press auto-repeat
+ *
+ * A press is reported once on the debounced down edge. Holding UP or DOWN
+ * for BUTTON_HOLD_MS starts auto-repeat at 5/s, which speeds up to 20/s
+ * after BUTTON_FAST_AFTER_MS, so scrolling to 23:45 takes a couple of
+ * seconds instead of dozens of presses. Repeats that fell due since the
+ * last poll are merged into one event with a count, so a slow loop()
+ * never builds a backlog and a consumer can apply them with one redraw.
+ *
+ * A falling-edge interrupt on each pin records when the press began, so
+ * latency measured from ButtonEvent::atUs includes the debounce time and
+ * any wait for loop() to poll.
+ */
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+#include "input.h"
+
+#define BUTTON_DEBOUNCE_MS 30
+#define BUTTON_HOLD_MS 500
+#define BUTTON_REPEAT_SLOW_MS 200
+#define BUTTON_REPEAT_FAST_MS 50
+#define BUTTON_FAST_AFTER_MS 1500   // Of auto-repeat
+
+// Buttons are active low with internal pull-ups
+void buttons_begin(uint8_t up, uint8_t ok, uint8_t down, uint8_t cancel);
+ButtonEvent buttons_poll();
+// buttons_poll() as an input device
+const InputDevice* buttons_device();
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Medibox - minimal CBOR (RFC 8949) writer
+ *
+ * Same idea as JsonWriter: encodes straight into a caller-owned buffer
+ * with no heap use, and output that does not fit sets a sticky overflow
+ * flag. Only definite-length maps and arrays, integers and text strings,
+ * which is all the telemetry format needs. Integers always use the
+ * shortest encoding.
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CBOR_UINT 0x00
+#define CBOR_NEGINT 0x20
+#define CBOR_TEXT 0x60
+#define CBOR_ARRAY 0x80
+#define CBOR_MAP 0xA0
+
+class CborWriter {
+public:
+  CborWriter(uint8_t* buf, size_t cap) : buf(buf), cap(cap), len(0), overflow(false) {}
+
+  void begin_map(uint32_t pairs) { put_head(CBOR_MAP, pairs); }
+  void begin_array(uint32_t items) { put_head(CBOR_ARRAY, items); }
+
+  void value(uint32_t v) { put_head(CBOR_UINT, v); }
+
+  void value(int32_t v) {
+    if (v < 0) {
+      put_head(CBOR_NEGINT, (uint32_t)(-1 - v));
+    } else {
+      put_head(CBOR_UINT, (uint32_t)v);
+    }
+  }
+
+  void value(const char* s) {
+    size_t n = strlen(s);
+    put_head(CBOR_TEXT, n);
+    if (len + n > cap) {
+      overflow = true;
+      return;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+
+  const uint8_t* data() const { return buf; }
+  size_t length() const { return len; }
+  bool overflowed() const { return overflow; }
+
+private:
+  uint8_t* buf;
+  size_t cap;
+  size_t len;
+  bool overflow;
+
+  void put(uint8_t b) {
+    if (len < cap) {
+      buf[len++] = b;
+    } else {
+      overflow = true;
+    }
+  }
+
+  // Major type plus argument: inline below 24, else 1, 2 or 4 bytes follow
+  void put_head(uint8_t major, uint32_t v) {
+    if (v < 24) {
+      put(major | v);
+    } else if (v <= 0xFF) {
+      put(major | 24);
+      put(v);
+    } else if (v <= 0xFFFF) {
+      put(major | 25);
+      put(v >> 8);
+      put(v & 0xFF);
+    } else {
+      put(major | 26);
+      for (int shift = 24; shift >= 0; shift -= 8) put((v >> shift) & 0xFF);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Medibox - live dashboard stream over WebSocket (ws://<device>/ws)
+ *
+ * Every DASHBOARD_PERIOD_MS the server task encodes what changed since the
+ * last push into one binary message and sends that same buffer to every
+ * synced client. Clients that just connected get a keyframe instead.
+ *
+ * A message is a sequence of sections, each starting with a type byte:
+ *   0x01 state keyframe / 0x02 state delta
+ *        u16 LE field mask, then for each set bit a zigzag varint holding
+ *        the value (keyframe) or the change since the last message (delta)
+ *        fields: 0 temp (c°C), 1 humidity (c%RH), 2 status bits
+ *        (bit0 ringing, bit1 snoozing, bits 4-7 ringing alarm),
+ *        3.. alarm slots as active << 15 | minute of day
+ *   0x03 framebuffer delta (only with DASHBOARD_FRAMEBUFFER)
+ *        8 byte bitmap of changed 16 byte blocks of the SSD1306 buffer,
+ *        then the changed blocks in order; a keyframe sets every bit
+ */
+
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DASHBOARD_PERIOD_MS 500
+#ifndef DASHBOARD_FRAMEBUFFER
+#define DASHBOARD_FRAMEBUFFER 1
+#endif
+
+// framebuffer may be NULL to disable the display mirror
+void dashboard_begin(const uint8_t* framebuffer, size_t fbLen);
+
+// Called from loop(); only stores the latest values
+void dashboard_update_sensor(float temperature, float humidity);
+void dashboard_update_alarm(bool ringing, bool snoozing, int ringingNum);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Medibox - rotary encoder input on the ESP32 pulse counter
+ *
+ * A PCNT unit decodes the quadrature signal in hardware (4 counts per
+ * cycle, with a glitch filter), so no edge is missed however long loop()
+ * takes and the CPU never sees an interrupt. Each poll turns the counts
+ * gathered since the last one into a single UP/DOWN burst event with the
+ * number of detents, so a fast spin is one redraw, not one per click.
+ * Clockwise is UP (next value), unless ENCODER_REVERSE is set.
+ *
+ * The push switch, if wired, gives OK on release and CANCEL once held for
+ * BUTTON_HOLD_MS, so the menus can be used with the encoder alone.
+ *
+ * Build with -D INPUT_ENCODER=1 to enable it next to the buttons.
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <stdint.h>
+#include "input.h"
+
+#ifndef INPUT_ENCODER
+#define INPUT_ENCODER 0
+#endif
+
+#ifndef ENCODER_COUNTS_PER_DETENT
+#define ENCODER_COUNTS_PER_DETENT 4   // Common for KY-040 style encoders
+#endif
+#ifndef ENCODER_REVERSE
+#define ENCODER_REVERSE 0
+#endif
+#define ENCODER_NO_SWITCH 0xFF
+
+// Returns NULL if the pulse counter could not be set up
+const InputDevice* encoder_begin(uint8_t pinA, uint8_t pinB, uint8_t pinSwitch);
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Medibox - fixed-capacity string for display text
+ *
+ * Lives on the stack (or wherever it is declared) and never touches the
+ * heap, unlike Arduino String, whose temporaries fragment the heap when
+ * they are built on every loop(). Text that does not fit is cut off at
+ * the capacity and flagged, never overruns the buffer.
+ *
+ *   FixedString<12> label;
+ *   label.printf("Alarm %d", n);
+ *   display.println(label.c_str());
+ */
+
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// N includes the terminating NUL
+template <size_t N>
+class FixedString {
+public:
+  static_assert(N > 1, "room for at least one character");
+
+  FixedString() : len(0), truncated_(false) { buf[0] = '\0'; }
+  explicit FixedString(const char* s) : FixedString() { append(s); }
+
+  void clear() {
+    len = 0;
+    truncated_ = false;
+    buf[0] = '\0';
+  }
+
+  FixedString& append(const char* s) {
+    size_t n = strlen(s);
+    if (n > N - 1 - len) {
+      n = N - 1 - len;
+      truncated_ = true;
+    }
+    memcpy(buf + len, s, n);
+    len += n;
+    buf[len] = '\0';
+    return *this;
+  }
+
+  FixedString& append(char c) {
+    if (len + 1 < N) {
+      buf[len++] = c;
+      buf[len] = '\0';
+    } else {
+      truncated_ = true;
+    }
+    return *this;
+  }
+
+  // Appends formatted text
+  __attribute__((format(printf, 2, 3)))
+  FixedString& printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + len, N - len, format, args);
+    va_end(args);
+    if (n < 0) {
+      buf[len] = '\0';
+    } else if ((size_t)n >= N - len) {
+      len = N - 1;
+      truncated_ = true;
+    } else {
+      len += n;
+    }
+    return *this;
+  }
+
+  const char* c_str() const { return buf; }
+  size_t length() const { return len; }
+  static constexpr size_t capacity() { return N - 1; }
+  bool truncated() const { return truncated_; }
+
+private:
+  char buf[N];
+  size_t len;
+  bool truncated_;
+};
+
+#endif
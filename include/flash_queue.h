@@ -0,0 +1,56 @@
+/*
+ * Medibox - persistent store-and-forward queue for telemetry records
+ *
+ * A circular log of 256 byte pages on a raw flash region. Records collect
+ * in a RAM page and are programmed one full page at a time; the uplink
+ * reads them back in order and truncates with acknowledgements once the
+ * broker has confirmed delivery. The last fully acknowledged page sequence
+ * is persisted, so after a reboot everything not yet confirmed is sent
+ * again (at-least-once). When the region fills up the oldest sector is
+ * overwritten and counted as dropped.
+ *
+ * Storage access goes through FlashStorage so the queue logic does not
+ * depend on the ESP-IDF partition API. Not thread safe: the uplink task
+ * owns the queue.
+ */
+
+#ifndef FLASH_QUEUE_H
+#define FLASH_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_codec.h"
+
+#define FLASH_QUEUE_PAGE 256
+#define FLASH_QUEUE_SECTOR 4096
+#define FLASH_QUEUE_PER_PAGE 12    // (256 - 8 byte header) / 20 byte records
+
+struct FlashStorage {
+  void* ctx;
+  size_t size;                     // Multiple of FLASH_QUEUE_SECTOR, at most 256 KiB used
+  bool (*read)(void* ctx, size_t offset, void* dst, size_t len);
+  bool (*write)(void* ctx, size_t offset, const void* src, size_t len);
+  bool (*erase_sector)(void* ctx, size_t offset);
+  uint32_t (*load_acked)(void* ctx);   // Last fully acknowledged page sequence
+  void (*store_acked)(void* ctx, uint32_t seq);
+};
+
+struct FlashQueueStats {
+  uint32_t pending;        // Records not yet acknowledged
+  uint32_t unread;         // Records not yet handed out by read()
+  uint32_t pagesWritten;
+  uint32_t sectorsErased;
+  uint32_t dropped;        // Records lost to overwrite when full
+};
+
+bool flash_queue_begin(const FlashStorage* storage);
+
+void flash_queue_push(const TelemetryRecord& rec);
+// Copies up to max unread records in FIFO order and advances the read cursor
+size_t flash_queue_read(TelemetryRecord* out, size_t max);
+// Confirms delivery of the oldest count records handed out by read()
+void flash_queue_ack(size_t count);
+
+void flash_queue_stats(FlashQueueStats* out);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Medibox - circular log of flash pages shared by the flash logs
+ *
+ * The telemetry queue (flash_queue.h) and the sensor history
+ * (sensor_log.h) store their records the same way. Each page starts with
+ * a FlashPageHeader and is programmed whole. Page sequence numbers only
+ * ever increase, and page seq always lives in slot seq % pageCount. A
+ * sector is erased just before its first page is programmed, which drops
+ * the oldest sector once the log has wrapped.
+ *
+ * This layer finds the pages after a reboot, decides where writing
+ * resumes, and programs and validates pages. What the pages hold, and
+ * what a dropped sector means, is up to the log using it. Not thread
+ * safe; callers lock as they need.
+ */
+
+#ifndef FLASH_RING_H
+#define FLASH_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "flash_queue.h"
+
+#define FLASH_RING_BLANK 0xFFFFFFFFu   // Sequence of an erased page
+#define FLASH_RING_PAGES_PER_SECTOR (FLASH_QUEUE_SECTOR / FLASH_QUEUE_PAGE)
+#define FLASH_RING_PEEK 8              // Body bytes a scan hands to its visitor
+
+struct FlashPageHeader {
+  uint32_t seq;
+  uint16_t count;                      // Records, always full on flash
+  uint16_t crc;                        // CRC-16/CCITT of the rest of the page
+};
+
+struct FlashRing {
+  const FlashStorage* store;
+  uint32_t pageCount;                  // Whole sectors
+  uint16_t perPage;
+};
+
+// Called for each slot holding a full page of its own sequence
+typedef void (*FlashRingVisitor)(void* ctx, uint32_t slot, const FlashPageHeader& header,
+                                 const uint8_t* peek);
+
+// Uses up to maxPages (a multiple of a sector) of the storage; false if
+// it holds fewer than two sectors
+bool flash_ring_begin(FlashRing* ring, const FlashStorage* storage, uint32_t maxPages,
+                      uint16_t perPage);
+// Visits the page headers; returns the newest sequence, FLASH_RING_BLANK
+// if there is none
+uint32_t flash_ring_scan(const FlashRing* ring, FlashRingVisitor visit, void* ctx);
+// The sequence to program next: after newest, or first on empty flash
+uint32_t flash_ring_resume(const FlashRing* ring, uint32_t newest, uint32_t first);
+
+size_t flash_ring_offset(const FlashRing* ring, uint32_t seq);
+// Whether programming seq erases its sector first
+bool flash_ring_starts_sector(const FlashRing* ring, uint32_t seq);
+// Fills in the header's sequence and CRC and programs page seq; len
+// includes the header
+void flash_ring_write(const FlashRing* ring, uint32_t seq, void* page, size_t len);
+// False unless the slot holds a full, intact page seq
+bool flash_ring_read(const FlashRing* ring, uint32_t seq, void* page, size_t len);
+
+#endif
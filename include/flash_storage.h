@@ -0,0 +1,20 @@
+/*
+ * Medibox - FlashStorage backed by a raw data partition
+ *
+ * Binds a flash log to a partition found by label. The last acknowledged
+ * page sequence lives in NVS under the same name, so it survives a reboot
+ * without rewriting flash pages.
+ */
+
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include "flash_queue.h"
+
+#define TELEMETRY_PARTITION "telemq"
+#define SENSOR_LOG_PARTITION "sensorlog"
+
+// Returns NULL if the partition is missing from the partition table
+const FlashStorage* flash_storage_partition(const char* label);
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Medibox - hardware abstraction layer
+ *
+ * The few things the application needs from the board: a clock, GPIO, the
+ * bus the display sits on, the temperature/humidity sensor and a WiFi
+ * station. hal_esp32.cpp implements it on the device; hal_linux.cpp
+ * implements it on the host for the native environment (see hal_linux.h),
+ * so the UI, input and WiFi logic build and run off-target.
+ *
+ * Those modules call hal_* rather than the Arduino core or the drivers.
+ * Drawing stays with Adafruit GFX, which is portable; only the bus under
+ * it is board-specific. The network services (HTTP, MQTT, OTA, telemetry)
+ * sit on lwIP and the IDF and stay on the device.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#elif !defined(IRAM_ATTR)
+#define IRAM_ATTR
+#endif
+
+class TwoWire;
+
+// Clock. millis/micros wrap like their Arduino counterparts; both are
+// safe to call from an interrupt handler.
+uint32_t hal_millis();
+uint32_t hal_micros();
+void hal_delay(uint32_t ms);
+// Local wall-clock time, false until it has been set (NTP on the device)
+bool hal_local_time(struct tm* out);
+
+// GPIO
+enum HalPinMode : uint8_t {
+  HAL_OUTPUT,
+  HAL_INPUT_PULLUP
+};
+
+typedef void (*HalPinHandler)(void* arg);
+
+void hal_pin_mode(uint8_t pin, HalPinMode mode);
+bool hal_pin_read(uint8_t pin);           // true for high
+void hal_pin_write(uint8_t pin, bool high);
+// Runs handler(arg) in interrupt context on every falling edge
+void hal_pin_on_falling(uint8_t pin, HalPinHandler handler, void* arg);
+
+// Display transport: the I2C bus to hand to Adafruit_SSD1306
+TwoWire* hal_display_bus();
+
+// Temperature (°C) and relative humidity (%) sensor
+void hal_sensor_begin();
+bool hal_sensor_read(float* temperature, float* humidity);
+
+// WiFi station. Events may be delivered from another task.
+enum HalNetworkEvent : uint8_t {
+  HAL_NETWORK_GOT_IP,
+  HAL_NETWORK_DROPPED          // Disconnected or lost the address
+};
+
+typedef void (*HalNetworkHandler)(HalNetworkEvent event);
+
+void hal_network_begin(HalNetworkHandler handler);
+void hal_network_connect(const char* ssid, const char* password);
+void hal_network_disconnect();
+uint32_t hal_random();
+
+#endif
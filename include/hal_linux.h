@@ -0,0 +1,50 @@
+/*
+ * Medibox - host side of the hardware abstraction layer
+ *
+ * In the native environment the host plays the board: tests, benchmarks
+ * and the host runner (src/host/host_main.cpp) drive the pins, the sensor
+ * and the network from here, and read back what the firmware did. Outputs and input levels are
+ * plain memory; the display bus only counts what is sent over it.
+ *
+ * The clock is the host's monotonic clock until virtual time is switched
+ * on. Virtual time only moves with hal_linux_advance_us() and hal_delay(),
+ * so runs are fast and repeatable, and a delay(4000) costs nothing.
+ */
+
+#ifndef HAL_LINUX_H
+#define HAL_LINUX_H
+
+#include <stdint.h>
+#include <time.h>
+#include "hal.h"
+
+#define HAL_LINUX_PINS 64
+
+struct HalLinuxBusStats {
+  uint32_t transactions;      // beginTransmission() .. endTransmission()
+  uint32_t bytes;
+};
+
+// Starts virtual time at 0 (or returns to the host clock)
+void hal_linux_virtual_time(bool on);
+void hal_linux_advance_us(uint32_t us);
+// Sets the wall clock; 0 makes hal_local_time() fail as before NTP sync.
+// It starts out at the host's time.
+void hal_linux_set_time(time_t utc);
+
+// Drives an input; a high-to-low change runs the falling-edge handler
+void hal_linux_set_pin(uint8_t pin, bool high);
+// Level of a pin, inputs included
+bool hal_linux_pin(uint8_t pin);
+
+// NAN for either value makes the next reads fail
+void hal_linux_set_sensor(float temperature, float humidity);
+
+// Connect attempts succeed at once unless this is turned off
+void hal_linux_network_autoconnect(bool on);
+void hal_linux_network_event(HalNetworkEvent event);
+const char* hal_linux_network_ssid();   // Of the last connect, "" after a disconnect
+
+void hal_linux_bus_stats(HalLinuxBusStats* out);
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Medibox - embedded HTTP/1.1 server
+ *
+ * A single task multiplexes a few keep-alive connections with select().
+ * Each connection owns a fixed parse state: the request line and headers
+ * are read line by line into a small buffer and a JSON body is fed through
+ * JsonFlatParser as it arrives, so a request never needs more than
+ * HTTP_MAX_BODY bytes of budget and nothing is allocated per request.
+ * A request line longer than HTTP_MAX_LINE gets a 400; longer header
+ * lines are skipped.
+ *
+ * Responses go out through HttpResponse, which streams a JsonWriter as
+ * chunked transfer encoding from one static send buffer. Static content
+ * is sent straight from where it lives (flash) with a Content-Length.
+ *
+ * GET HTTP_WS_PATH upgrades a connection to a server-push WebSocket.
+ * Frames are built once by the caller and sent unchanged to every socket,
+ * so fan-out costs one send() per client. Socket I/O only ever happens
+ * on the server task; work that pushes frames runs from the tick hook.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_parser.h"
+#include "json_writer.h"
+
+#define HTTP_PORT 80
+#define HTTP_MAX_CLIENTS 4
+#define HTTP_MAX_LINE 128
+#define HTTP_MAX_PATH 96
+#define HTTP_MAX_BODY 512
+#define HTTP_TX_BUFFER 512
+#define HTTP_IDLE_TIMEOUT_MS 10000
+#define HTTP_WS_PATH "/ws"
+#define WS_FRAME_HEADER_MAX 4   // Server frames are unmasked and < 64 KiB
+
+enum HttpMethod {
+  HTTP_UNKNOWN,
+  HTTP_GET,
+  HTTP_POST,
+  HTTP_PUT,
+  HTTP_DELETE,
+  HTTP_PATCH
+};
+
+struct HttpRequest {
+  HttpMethod method;
+  char path[HTTP_MAX_PATH];
+  const char* query;      // Part of path after '?', "" if none
+  size_t contentLength;
+  bool keepAlive;
+  bool wsUpgrade;
+  char wsKey[32];
+  char ifNoneMatch[48];   // Truncated; only compared against our own ETags
+  JsonFlatParser body;
+};
+
+class HttpResponse {
+public:
+  HttpResponse(int fd, char* buf, size_t cap, bool keepAlive);
+
+  // Response without a body (204, 404, ...)
+  void send_status(int status);
+  // Sends the headers and returns a writer that streams the body
+  JsonWriter& begin_json(int status);
+  // Precompressed body sent in place, without copying it to the buffer
+  void send_gzip(const char* contentType, const char* etag, const uint8_t* data, size_t len);
+  void send_not_modified(const char* etag);
+  // Chunked body of another content type, streamed with write()
+  void begin_stream(int status, const char* contentType);
+  bool write(const char* data, size_t len);
+  // Flushes the writer and terminates the chunked body
+  void end();
+
+  bool failed() const { return error; }
+
+private:
+  int fd;
+  char* buf;
+  size_t cap;
+  bool keepAlive;
+  bool error;
+  JsonWriter writer;
+
+  static bool send_chunk(void* ctx, const char* data, size_t len);
+  bool send_all(const char* data, size_t len);
+};
+
+typedef void (*HttpHandler)(HttpRequest& req, HttpResponse& res);
+typedef void (*HttpTick)();
+
+struct HttpStats {
+  uint32_t requests;
+  uint32_t errors;          // 4xx from the parser and dropped connections
+  uint32_t bytesSent;
+  uint32_t activeClients;
+  uint32_t wsClients;
+  uint32_t wsFramesSent;
+  uint32_t minFreeHeap;     // lowest free heap seen while serving
+};
+
+void http_server_begin(uint16_t port, HttpHandler handler);
+// Runs on the server task roughly every periodMs
+void http_server_set_tick(HttpTick tick, uint32_t periodMs);
+
+// Writes a binary frame header ending right before payload, returns where
+// the frame starts. payload must have WS_FRAME_HEADER_MAX bytes in front.
+uint8_t* ws_frame_header(uint8_t* payload, size_t len);
+// True if a socket connected since the last broadcast to new clients
+bool ws_has_new_clients();
+bool ws_has_synced_clients();
+// Sends one prebuilt frame to either the new clients (who then count as
+// synced) or to the already synced ones
+void ws_broadcast(const uint8_t* frame, size_t len, bool toNewClients);
+const char* http_status_text(int status);
+// Copies the value of name=value from the query string, without percent
+// decoding; false if the parameter is absent or too long
+bool http_query_param(const HttpRequest& req, const char* name, char* out, size_t cap);
+void http_server_stats(HttpStats* out);
+
+#endif
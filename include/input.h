@@ -0,0 +1,40 @@
+/*
+ * Medibox - input devices for the menus and alarm screens
+ *
+ * Every input backend (the four buttons, the rotary encoder, a scripted
+ * source on the host, input_script.h) is an InputDevice: a poll callback
+ * that turns its own hardware state into ButtonEvents. loop() calls
+ * input_poll(), which polls the registered devices in order and returns
+ * the first event, so the UI never knows which device produced it. The
+ * same spot records and replays input macros (input_macro.h).
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+#define INPUT_MAX_DEVICES 4
+
+enum Button {NONE, UP, OK_BTN, DOWN, CANCEL_BTN};
+
+struct ButtonEvent {
+  Button button;      // NONE if nothing happened
+  uint8_t count;      // Steps to apply: 1 for a press, >= 1 for bursts
+  bool repeat;        // Part of a burst (held button, spinning encoder):
+                      // redraws may be coalesced, single-press actions
+                      // ignore it
+  uint32_t atUs;      // micros() when the input happened, for latency
+};
+
+struct InputDevice {
+  const char* name;
+  void* ctx;
+  ButtonEvent (*poll)(void* ctx);   // Called every loop(), must not block
+};
+
+// Devices are polled in the order they were added; false if full
+bool input_add_device(const InputDevice* device);
+ButtonEvent input_poll();
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Medibox - input-to-photon latency
+ *
+ * Measures how long a press takes to become visible: from the moment the
+ * input happened (ButtonEvent::atUs, stamped by the button's GPIO
+ * interrupt) to the end of the next frame transfer to the OLED, which
+ * includes any time loop() spent elsewhere before polling, the handling,
+ * rendering and the I2C flush. When several events arrive before a frame,
+ * the earliest one counts, as that is how long the user waited.
+ *
+ * One histogram per kind of screen, in /metrics as
+ * medibox_input_to_photon_us{screen="..."}; typing 'l' on the serial
+ * console prints a summary.
+ */
+
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <stdint.h>
+#include "input.h"
+
+class Print;
+
+enum UiScreen : uint8_t {
+  UI_SCREEN_CLOCK,
+  UI_SCREEN_ALARM,      // Alarm ringing
+  UI_SCREEN_MENU,
+  UI_SCREEN_EDIT,
+  UI_SCREEN_VIEW,
+  UI_SCREEN_COUNT
+};
+
+// An event handed to the UI while screen was showing; NONE is ignored
+void input_latency_event(const ButtonEvent& ev, UiScreen screen);
+// A frame has been sent to the panel
+void input_latency_frame();
+// Count, p50, p95 (bucket bounds) and max per screen
+void input_latency_report(Print& out);
+
+#endif
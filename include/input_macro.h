@@ -0,0 +1,67 @@
+/*
+ * Medibox - input macro recorder and replayer
+ *
+ * Records the events input_poll() hands to the UI, with their times, and
+ * plays them back in place of the live devices at the same offsets. While
+ * replaying, each step is measured up to the next one: the time from the
+ * event to the end of the first frame flushed after it (so handling,
+ * rendering and the I2C transfer), and all frames and bytes flushed to
+ * the display until the next step. tools/ui_replay.py drives this over
+ * /api/macro and compares the results against stored baselines.
+ *
+ * Replays are only comparable from the same starting state: record and
+ * replay from the clock screen. Once the last step has run, the replay
+ * keeps measuring for MACRO_SETTLE_MS so delayed redraws (the "done"
+ * screens) are counted.
+ */
+
+#ifndef INPUT_MACRO_H
+#define INPUT_MACRO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "input.h"
+
+#define MACRO_MAX_STEPS 128
+#define MACRO_SETTLE_MS 2000
+
+enum MacroState : uint8_t {
+  MACRO_IDLE,
+  MACRO_RECORDING,
+  MACRO_REPLAYING,
+  MACRO_DONE          // Results of the last replay are available
+};
+
+struct MacroStep {
+  uint32_t atMs;      // Since the first step
+  ButtonEvent event;
+};
+
+struct MacroResult {
+  uint32_t latencyUs; // To the end of the first frame after the step, 0 if none
+  uint16_t frames;
+  uint32_t bytes;
+};
+
+void macro_begin();
+
+// Control, from any task. Each returns false in the wrong state.
+bool macro_record();                       // Replaces the macro with live input
+bool macro_stop();                         // Ends a recording or aborts a replay
+bool macro_clear();
+bool macro_append(const MacroStep& step);  // Steps must be in time order
+bool macro_replay();
+MacroState macro_state();
+size_t macro_step_count();
+// Copies step i and, after a replay, its result
+bool macro_step(size_t i, MacroStep* step, MacroResult* result);
+
+const char* macro_button_name(Button button);
+bool macro_parse_button(const char* name, Button* button);
+
+// Hooks for input.cpp and the display, from the loop task
+bool macro_next(ButtonEvent* ev);          // True while replaying, *ev is the step or NONE
+void macro_observe(const ButtonEvent& ev);
+void macro_note_flush(uint32_t bytes);
+
+#endif
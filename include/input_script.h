@@ -0,0 +1,41 @@
+/*
+ * Medibox - scripted input device for host tests
+ *
+ * An InputDevice that plays back a queue of ButtonEvents, one per poll,
+ * so tests can drive input_poll() and the menus with exactly the events
+ * the buttons or the encoder would send: single presses, held-button
+ * repeats and encoder turns with a count above 1. Idle polls can be
+ * queued between them. Events queued with atUs 0 are stamped with
+ * hal_micros() when they are polled.
+ *
+ * Host only (src/host/input_script.cpp); add it with input_add_device().
+ */
+
+#ifndef INPUT_SCRIPT_H
+#define INPUT_SCRIPT_H
+
+#include <stdint.h>
+#include "input.h"
+
+#define INPUT_SCRIPT_MAX 64
+
+struct InputScript {
+  InputDevice device;
+  ButtonEvent events[INPUT_SCRIPT_MAX];
+  uint8_t head;
+  uint8_t count;
+};
+
+// Returns the script's device
+const InputDevice* input_script_begin(InputScript* script, const char* name);
+// False if the queue is full
+bool input_script_push(InputScript* script, const ButtonEvent& ev);
+bool input_script_press(InputScript* script, Button button);
+// An encoder turn or a held button's merged repeats
+bool input_script_burst(InputScript* script, Button button, uint8_t count);
+// Polls that return NONE before the next queued event
+bool input_script_idle(InputScript* script, uint8_t polls);
+uint8_t input_script_pending(const InputScript* script);
+void input_script_clear(InputScript* script);
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Medibox - incremental parser for flat JSON objects
+ *
+ * Request bodies arrive in arbitrary TCP segments, so the parser is a byte
+ * driven state machine that can be fed any split of the input. It only
+ * understands one level of {"key": scalar, ...}, which is all the REST API
+ * accepts, and holds at most one key and one value at a time. Each
+ * completed pair is collected into a fixed table; anything longer than the
+ * fixed limits is a parse error, not a reallocation.
+ */
+
+#ifndef JSON_PARSER_H
+#define JSON_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_KEY_MAX 16
+#define JSON_VALUE_MAX 24
+#define JSON_MAX_FIELDS 8
+
+struct JsonField {
+  char key[JSON_KEY_MAX];
+  char value[JSON_VALUE_MAX];   // Strings unquoted, literals verbatim
+  bool isString;
+};
+
+class JsonFlatParser {
+public:
+  JsonFlatParser() { reset(); }
+
+  void reset() {
+    state = EXPECT_OPEN;
+    fieldCount = 0;
+    tokenLen = 0;
+  }
+
+  // Returns false once the input is known to be invalid
+  bool feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len && state != FAILED; i++) {
+      step(data[i]);
+    }
+    return state != FAILED;
+  }
+
+  bool complete() const { return state == DONE; }
+  size_t count() const { return fieldCount; }
+  const JsonField& field(size_t i) const { return fields[i]; }
+
+  const JsonField* find(const char* key) const {
+    for (size_t i = 0; i < fieldCount; i++) {
+      if (strcmp(fields[i].key, key) == 0) return &fields[i];
+    }
+    return NULL;
+  }
+
+  bool get_int(const char* key, long* out) const {
+    const JsonField* f = find(key);
+    if (f == NULL || f->isString) return false;
+    char* end;
+    *out = strtol(f->value, &end, 10);
+    return *end == '\0';
+  }
+
+  bool get_float(const char* key, float* out) const {
+    const JsonField* f = find(key);
+    if (f == NULL || f->isString) return false;
+    char* end;
+    *out = strtof(f->value, &end);
+    return *end == '\0';
+  }
+
+  bool get_bool(const char* key, bool* out) const {
+    const JsonField* f = find(key);
+    if (f == NULL || f->isString) return false;
+    if (strcmp(f->value, "true") == 0) *out = true;
+    else if (strcmp(f->value, "false") == 0) *out = false;
+    else return false;
+    return true;
+  }
+
+private:
+  enum State {
+    EXPECT_OPEN, EXPECT_KEY_OR_CLOSE, IN_KEY, EXPECT_COLON, EXPECT_VALUE,
+    IN_STRING, IN_STRING_ESCAPE, IN_LITERAL, EXPECT_COMMA_OR_CLOSE, DONE, FAILED
+  };
+
+  State state;
+  JsonField fields[JSON_MAX_FIELDS];
+  size_t fieldCount;
+  size_t tokenLen;
+
+  static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+  bool append(char* dst, size_t cap, char c) {
+    if (tokenLen + 1 >= cap) {
+      state = FAILED;
+      return false;
+    }
+    dst[tokenLen++] = c;
+    dst[tokenLen] = '\0';
+    return true;
+  }
+
+  void start_field() {
+    if (fieldCount >= JSON_MAX_FIELDS) {
+      state = FAILED;
+      return;
+    }
+    fields[fieldCount].key[0] = '\0';
+    fields[fieldCount].value[0] = '\0';
+    tokenLen = 0;
+    state = IN_KEY;
+  }
+
+  void end_value() {
+    fieldCount++;
+    state = EXPECT_COMMA_OR_CLOSE;
+  }
+
+  void step(char c) {
+    JsonField& f = fields[fieldCount < JSON_MAX_FIELDS ? fieldCount : JSON_MAX_FIELDS - 1];
+    switch (state) {
+      case EXPECT_OPEN:
+        if (c == '{') state = EXPECT_KEY_OR_CLOSE;
+        else if (!is_space(c)) state = FAILED;
+        break;
+      case EXPECT_KEY_OR_CLOSE:
+        if (c == '"') start_field();
+        else if (c == '}' && fieldCount == 0) state = DONE;
+        else if (!is_space(c)) state = FAILED;
+        break;
+      case IN_KEY:
+        if (c == '"') state = EXPECT_COLON;
+        else append(f.key, JSON_KEY_MAX, c);
+        break;
+      case EXPECT_COLON:
+        if (c == ':') state = EXPECT_VALUE;
+        else if (!is_space(c)) state = FAILED;
+        break;
+      case EXPECT_VALUE:
+        tokenLen = 0;
+        if (c == '"') {
+          f.isString = true;
+          state = IN_STRING;
+        } else if (c == '-' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z')) {
+          f.isString = false;
+          state = IN_LITERAL;
+          append(f.value, JSON_VALUE_MAX, c);
+        } else if (!is_space(c)) {
+          state = FAILED;
+        }
+        break;
+      case IN_STRING:
+        if (c == '"') end_value();
+        else if (c == '\\') state = IN_STRING_ESCAPE;
+        else append(f.value, JSON_VALUE_MAX, c);
+        break;
+      case IN_STRING_ESCAPE:
+        // Only the simple escapes are needed for settings values
+        state = IN_STRING;
+        append(f.value, JSON_VALUE_MAX, c == 'n' ? '\n' : c == 't' ? '\t' : c);
+        break;
+      case IN_LITERAL:
+        if (c == ',' || c == '}' || is_space(c)) {
+          end_value();
+          step(c);
+        } else {
+          append(f.value, JSON_VALUE_MAX, c);
+        }
+        break;
+      case EXPECT_COMMA_OR_CLOSE:
+        if (c == ',') state = EXPECT_KEY_OR_CLOSE;
+        else if (c == '}') state = DONE;
+        else if (!is_space(c)) state = FAILED;
+        break;
+      case DONE:
+        if (!is_space(c)) state = FAILED;
+        break;
+      case FAILED:
+        break;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Medibox - minimal JSON writer
+ *
+ * Writes compact JSON straight into a caller-owned buffer: no String, no
+ * heap, no DOM. Commas are inserted automatically from a small nesting
+ * stack. Without a sink, output that does not fit sets a sticky overflow
+ * flag instead of truncating mid-token. With a sink, a full buffer is
+ * handed to the sink and reused, so arbitrarily long documents stream
+ * through a small fixed buffer.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define JSON_MAX_DEPTH 8
+
+// Receives each full buffer; returning false aborts the document
+typedef bool (*JsonSink)(void* ctx, const char* data, size_t len);
+
+class JsonWriter {
+public:
+  JsonWriter(char* buf, size_t cap, JsonSink sink = NULL, void* sinkCtx = NULL)
+      : buf(buf), cap(cap), len(0), depth(0), overflow(false), sink(sink), sinkCtx(sinkCtx) {
+    needComma[0] = false;
+    if (cap > 0) buf[0] = '\0';
+  }
+
+  void begin_object() { open('{'); }
+  void end_object() { close('}'); }
+  void begin_array() { open('['); }
+  void end_array() { close(']'); }
+
+  void key(const char* name) {
+    separator();
+    put_string(name);
+    put(':');
+    afterKey = true;
+  }
+
+  void value(int32_t v) {
+    separator();
+    put_int(v);
+  }
+
+  void value(uint32_t v) {
+    separator();
+    put_uint(v);
+  }
+
+  void value(bool v) {
+    separator();
+    put_raw(v ? "true" : "false");
+  }
+
+  void value(const char* s) {
+    separator();
+    put_string(s);
+  }
+
+  // Fixed-point output, rounded to the given number of decimals
+  void value(float v, uint8_t decimals) {
+    separator();
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    if (v < 0) {
+      put('-');
+      v = -v;
+    }
+    uint32_t scaled = (uint32_t)(v * scale + 0.5f);
+    put_uint(scaled / scale);
+    if (decimals) {
+      put('.');
+      uint32_t frac = scaled % scale;
+      for (uint32_t d = scale / 10; d > 0; d /= 10) {
+        put('0' + (frac / d) % 10);
+      }
+    }
+  }
+
+  void null() {
+    separator();
+    put_raw("null");
+  }
+
+  // Appends pre-formatted text verbatim, e.g. for non-JSON bodies
+  void raw(const char* data, size_t n) {
+    while (n--) put(*data++);
+  }
+
+  // Hands buffered output to the sink; true if everything was accepted
+  bool flush() {
+    if (sink == NULL || overflow) return !overflow;
+    if (len > 0 && !sink(sinkCtx, buf, len)) {
+      overflow = true;
+      return false;
+    }
+    len = 0;
+    return true;
+  }
+
+  const char* c_str() const { return buf; }
+  size_t length() const { return len; }
+  size_t remaining() const { return cap - len; }
+  bool overflowed() const { return overflow; }
+
+private:
+  char* buf;
+  size_t cap;
+  size_t len;
+  uint8_t depth;
+  bool overflow;
+  JsonSink sink;
+  void* sinkCtx;
+  bool afterKey = false;
+  bool needComma[JSON_MAX_DEPTH + 1];
+
+  void put(char c) {
+    if (len + 1 >= cap && sink != NULL && !overflow) {
+      flush();
+    }
+    if (len + 1 < cap) {
+      buf[len++] = c;
+      buf[len] = '\0';
+    } else {
+      overflow = true;
+    }
+  }
+
+  void put_raw(const char* s) {
+    while (*s) put(*s++);
+  }
+
+  void put_uint(uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do {
+      tmp[n++] = '0' + v % 10;
+      v /= 10;
+    } while (v);
+    while (n) put(tmp[--n]);
+  }
+
+  void put_int(int32_t v) {
+    if (v < 0) {
+      put('-');
+      put_uint((uint32_t)(-(int64_t)v));
+    } else {
+      put_uint((uint32_t)v);
+    }
+  }
+
+  void put_string(const char* s) {
+    put('"');
+    for (; *s; s++) {
+      char c = *s;
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put(c);
+      } else if ((uint8_t)c < 0x20) {
+        static const char hex[] = "0123456789abcdef";
+        put_raw("\\u00");
+        put(hex[(c >> 4) & 0xF]);
+        put(hex[c & 0xF]);
+      } else {
+        put(c);
+      }
+    }
+    put('"');
+  }
+
+  // Emits the comma before a new element, except straight after a key
+  void separator() {
+    if (afterKey) {
+      afterKey = false;
+    } else if (needComma[depth]) {
+      put(',');
+    }
+    needComma[depth] = true;
+  }
+
+  void open(char c) {
+    separator();
+    put(c);
+    if (depth < JSON_MAX_DEPTH) {
+      depth++;
+    } else {
+      overflow = true;
+    }
+    needComma[depth] = false;
+  }
+
+  void close(char c) {
+    if (depth > 0) depth--;
+    put(c);
+  }
+};
+
+#endif
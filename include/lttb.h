@@ -0,0 +1,74 @@
+/*
+ * Medibox - streaming largest-triangle-three-buckets downsampling
+ *
+ * Reduces a time series to at most `points` points that keep its visual
+ * shape, in one pass over time-ordered input. Buckets split the requested
+ * time range evenly, so gaps in the data simply leave buckets empty.
+ *
+ * Plain LTTB needs every point of a bucket until the next bucket's average
+ * is known. Instead each bucket keeps only the min and max point of
+ * LTTB_SUBBUCKETS equal slices (MinMaxLTTB preselection), which is where
+ * the largest triangle almost always lies. Memory is two buckets of
+ * candidates whatever the range or input size.
+ */
+
+#ifndef LTTB_H
+#define LTTB_H
+
+#include <stdint.h>
+
+#define LTTB_SUBBUCKETS 8
+#define LTTB_MIN_POINTS 3
+
+static_assert(LTTB_SUBBUCKETS <= 8, "slice bitmap is 8 bits");
+
+struct LttbPoint {
+  uint32_t t;
+  int32_t y;
+};
+
+// Returning false stops the stream
+typedef bool (*LttbEmit)(void* ctx, const LttbPoint& p);
+
+class LttbStream {
+public:
+  void begin(uint32_t from, uint32_t to, uint32_t points, LttbEmit emit, void* ctx);
+  // Points must arrive in time order within [from, to]
+  bool add(uint32_t t, int32_t y);
+  // Emits the remaining selections and the last point
+  bool finish();
+
+  uint32_t emitted() const { return emittedCount; }
+
+private:
+  struct Bucket {
+    uint32_t index;
+    uint32_t count;
+    uint64_t sumT;     // Offsets from `from`, so no overflow at any range
+    int64_t sumY;
+    uint8_t used;      // Bit per slice holding a min/max pair
+    LttbPoint min[LTTB_SUBBUCKETS];
+    LttbPoint max[LTTB_SUBBUCKETS];
+  };
+
+  uint32_t from;
+  uint32_t width;
+  LttbEmit emitFn;
+  void* emitCtx;
+  uint32_t emittedCount;
+  bool ok;
+
+  bool haveFirst;
+  LttbPoint selected;  // Last emitted point, the triangle's first corner
+  LttbPoint last;
+  bool havePending, haveCurrent;
+  Bucket pending;      // Complete, waiting for the next bucket's average
+  Bucket current;
+
+  void start_bucket(Bucket& b, uint32_t index);
+  void emit(const LttbPoint& p);
+  // Emits the candidate of b with the largest triangle (selected, p, c)
+  void select(const Bucket& b, int64_t cT, int64_t cY);
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Medibox - heap and task stack monitor
+ *
+ * Every MEM_MONITOR_PERIOD_MS, loop() takes one sample: free heap, the
+ * lowest free heap since boot, the largest free block and the least free
+ * stack each watched task has had (its high-water mark). The last
+ * MEM_MONITOR_HISTORY samples give the heap's trend, and from it how
+ * long until the free heap falls to MEM_HEAP_CRITICAL_BYTES.
+ *
+ * An alert is raised, before anything runs out, when the heap is low or
+ * too fragmented for large buffers, when the trend reaches the critical
+ * level within MEM_FORECAST_WARN_S, or when a task's stack headroom gets
+ * thin. Changes of the alert are printed on Serial and traced; 'm' on the
+ * serial console prints the current figures. In /metrics: the heap
+ * gauges, medibox_task_stack_free_bytes{task="..."} (-1 while the task
+ * is not running), the trend, the forecast and the alert level.
+ *
+ * Tasks watch themselves when they start, and a task that ends must
+ * forget itself before vTaskDelete().
+ */
+
+#ifndef MEM_MONITOR_H
+#define MEM_MONITOR_H
+
+#include <stdint.h>
+
+class Print;
+
+#define MEM_MONITOR_PERIOD_MS 10000
+#define MEM_MONITOR_HISTORY 30          // 5 minutes of samples
+#define MEM_TREND_MIN_SAMPLES 12        // Before a trend is trusted
+#define MEM_FORECAST_WARN_S 3600
+#define MEM_HEAP_WARN_BYTES 32768
+#define MEM_HEAP_CRITICAL_BYTES 16384
+#define MEM_BLOCK_WARN_BYTES 8192       // TLS and HTTP buffers need blocks this large
+#define MEM_STACK_WARN_BYTES 768
+#define MEM_STACK_CRITICAL_BYTES 256
+
+enum MemTask : uint8_t {
+  MEM_TASK_LOOP,
+  MEM_TASK_HTTP,
+  MEM_TASK_UPLINK,      // MQTT or UDP telemetry
+  MEM_TASK_OTA,
+  MEM_TASK_COUNT
+};
+
+enum MemAlert : uint8_t {
+  MEM_OK,
+  MEM_WARNING,
+  MEM_CRITICAL
+};
+
+// Why the alert is raised, bits
+#define MEM_REASON_LOW_HEAP 1
+#define MEM_REASON_FRAGMENTED 2
+#define MEM_REASON_HEAP_FALLING 4
+#define MEM_REASON_LOW_STACK 8
+
+// Before any task watches itself
+void mem_monitor_begin();
+void mem_monitor_watch_current_task(MemTask task);
+void mem_monitor_forget_task(MemTask task);
+// Called every loop(); samples once per period
+void mem_monitor_loop();
+MemAlert mem_monitor_alert(uint8_t* reasons);
+void mem_monitor_report(Print& out);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Medibox - table-driven menus for the OLED and the four buttons
+ *
+ * Every screen is a constexpr Screen: a list of items, a value editor or a
+ * read-only view, with its callbacks. A generic navigator keeps a short
+ * stack of open screens, so handling a button is a lookup in the current
+ * table, and all drawing goes through one renderer. Adding an alarm slot
+ * or a setting is a new table row, not a new state with its own redraw
+ * code.
+ *
+ * All text is a StrId (ui_text.h), so the tables are the same for every
+ * language. Titles, item labels and done titles are printf formats given
+ * the screen's arg + 1, e.g. "Set Alarm %d".
+ *
+ *   MENU  UP/DOWN move over enabled items, OK opens the item's child (or
+ *         goes back if it has none), CANCEL goes back; going back from
+ *         the first screen closes the menus
+ *   EDIT  UP/DOWN change the current field, OK moves to the next one and
+ *         commits on the last, CANCEL goes back without saving
+ *   VIEW  OK commits if the screen has a commit, else goes back
+ *
+ * After a commit the screen's doneTitle is shown for MENU_DONE_MS, then
+ * the navigator returns to the top menu.
+ *
+ * Burst events (a held button or a spinning encoder, see input.h) apply
+ * all their steps at once, and during a burst the screen is redrawn at
+ * most every MENU_REPEAT_REDRAW_MS, so a fast scroll costs a few
+ * full-frame flushes rather than one per step. The last value is drawn
+ * by menu_handle(NONE) once the interval has passed, so loop() must
+ * keep calling it while idle.
+ */
+
+#ifndef MENU_H
+#define MENU_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "input.h"
+#include "ui_text.h"
+
+class Adafruit_GFX;
+class Adafruit_SSD1306;
+
+#define MENU_DEPTH 4
+#define MENU_MAX_FIELDS 2
+#define MENU_DONE_MS 1500
+#define MENU_REPEAT_REDRAW_MS 100   // Frame rate cap during a burst
+
+enum ScreenKind : uint8_t {
+  SCREEN_MENU,
+  SCREEN_EDIT,
+  SCREEN_VIEW
+};
+
+struct Screen;
+
+struct MenuItem {
+  StrId label;
+  StrId disabledLabel;            // Shown while enabled() is false, or STR_NONE
+  const Screen* child;            // Opened by OK, NULL goes back
+  bool (*enabled)(uint8_t arg);   // Validator, NULL if always selectable
+  uint8_t arg;                    // Handed to the child's callbacks
+};
+
+struct EditField {
+  StrId label;                    // Line above the value, or STR_NONE
+  int16_t min, max;
+  bool wrap;
+};
+
+struct Screen {
+  ScreenKind kind;
+  StrId title;
+  StrId footer;                   // STR_NONE: editors show the key help
+  const MenuItem* items;          // SCREEN_MENU
+  const EditField* fields;        // SCREEN_EDIT
+  uint8_t count;                  // Items or fields
+  void (*load)(uint8_t arg, int16_t* values);
+  void (*draw)(Adafruit_GFX& gfx, uint8_t arg, const int16_t* values);
+  void (*commit)(uint8_t arg, const int16_t* values);
+  StrId doneTitle;
+};
+
+template <typename T, size_t N>
+constexpr uint8_t count_of(const T (&)[N]) {
+  return N;
+}
+
+constexpr Screen menu_screen(StrId title, const MenuItem* items, uint8_t count, StrId footer) {
+  return Screen{SCREEN_MENU, title, footer, items, NULL, count, NULL, NULL, NULL, STR_NONE};
+}
+
+constexpr Screen edit_screen(StrId title, const EditField* fields, uint8_t count,
+                             void (*load)(uint8_t, int16_t*),
+                             void (*draw)(Adafruit_GFX&, uint8_t, const int16_t*),
+                             void (*commit)(uint8_t, const int16_t*), StrId doneTitle,
+                             StrId footer) {
+  return Screen{SCREEN_EDIT, title, footer, NULL, fields, count, load, draw, commit, doneTitle};
+}
+
+constexpr Screen view_screen(StrId title, void (*load)(uint8_t, int16_t*),
+                             void (*draw)(Adafruit_GFX&, uint8_t, const int16_t*),
+                             void (*commit)(uint8_t, const int16_t*), StrId doneTitle,
+                             StrId footer) {
+  return Screen{SCREEN_VIEW, title, footer, NULL, NULL, 0, load, draw, commit, doneTitle};
+}
+
+// The Medibox menus (menu_screens.cpp)
+extern const Screen mainMenu;
+
+// flush sends the frame buffer to the panel
+void menu_begin(Adafruit_SSD1306* display, void (*flush)());
+void menu_open(const Screen* root);
+bool menu_active();
+// What the top screen is, while active
+ScreenKind menu_screen_kind();
+// Heap allocations made while drawing menu screens, for
+// medibox_ui_allocs_total; wraps
+uint32_t menu_render_allocs();
+// Called every loop() while active, also when nothing was pressed
+void menu_handle(const ButtonEvent& ev);
+
+#endif
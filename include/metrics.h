@@ -0,0 +1,115 @@
+/*
+ * Medibox - metrics registry rendered in Prometheus text format
+ *
+ * Metrics are defined as static objects next to the code they measure and
+ * link themselves into one registry at startup, so adding a metric never
+ * touches a central table. Updates are single relaxed atomic operations
+ * (a few tens of cycles, no locks, safe from any task); a histogram adds
+ * a short scan of its bucket bounds. Values that already live elsewhere
+ * are exported through a sampler called only when /metrics is rendered.
+ *
+ * Counters and histogram sums are 32 bit and wrap; Prometheus treats a
+ * wrap like a counter reset.
+ *
+ * Series of one family share a name and differ in their labels, e.g.
+ * screen="menu". Define them one after another in the same file, so they
+ * are rendered together under a single HELP/TYPE header.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum MetricType : uint8_t {
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM
+};
+
+typedef uint32_t (*MetricSampler)();
+// Receives rendered text; returning false stops rendering
+typedef bool (*MetricSink)(void* ctx, const char* data, size_t len);
+
+class Metric {
+public:
+  const char* const name;
+  const char* const help;
+  const MetricType type;
+  const char* const labels;   // Without braces, NULL for none
+  Metric* next;
+
+protected:
+  Metric(const char* name, const char* help, MetricType type, const char* labels);
+};
+
+class MetricCounter : public Metric {
+public:
+  MetricCounter(const char* name, const char* help, MetricSampler sampler = NULL,
+                const char* labels = NULL)
+      : Metric(name, help, METRIC_COUNTER, labels), value(0), sampler(sampler) {}
+
+  void inc(uint32_t n = 1) { __atomic_fetch_add(&value, n, __ATOMIC_RELAXED); }
+  uint32_t get() const { return sampler ? sampler() : __atomic_load_n(&value, __ATOMIC_RELAXED); }
+
+private:
+  uint32_t value;
+  MetricSampler sampler;
+};
+
+class MetricGauge : public Metric {
+public:
+  MetricGauge(const char* name, const char* help, MetricSampler sampler = NULL,
+              const char* labels = NULL)
+      : Metric(name, help, METRIC_GAUGE, labels), value(0), sampler(sampler) {}
+
+  void set(int32_t v) { __atomic_store_n(&value, v, __ATOMIC_RELAXED); }
+  void add(int32_t n) { __atomic_fetch_add(&value, n, __ATOMIC_RELAXED); }
+  int32_t get() const { return sampler ? (int32_t)sampler() : __atomic_load_n(&value, __ATOMIC_RELAXED); }
+
+private:
+  int32_t value;
+  MetricSampler sampler;
+};
+
+// bounds are inclusive upper bounds in ascending order; buckets needs
+// room for one more entry than bounds (the +Inf bucket)
+class MetricHistogram : public Metric {
+public:
+  MetricHistogram(const char* name, const char* help, const uint32_t* bounds,
+                  uint8_t boundCount, uint32_t* buckets, const char* labels = NULL)
+      : Metric(name, help, METRIC_HISTOGRAM, labels), bounds(bounds), boundCount(boundCount),
+        buckets(buckets), sum(0) {}
+
+  void observe(uint32_t v) {
+    uint8_t i = 0;
+    while (i < boundCount && v > bounds[i]) i++;
+    __atomic_fetch_add(&buckets[i], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sum, v, __ATOMIC_RELAXED);
+  }
+
+  const uint32_t* const bounds;
+  const uint8_t boundCount;
+  uint32_t* const buckets;
+  uint32_t sum;
+};
+
+// Defines a histogram together with its bucket storage
+#define METRIC_HISTOGRAM(var, name, help, ...)                                 \
+  static const uint32_t var##Bounds[] = {__VA_ARGS__};                         \
+  static uint32_t var##Buckets[sizeof(var##Bounds) / sizeof(uint32_t) + 1];   \
+  static MetricHistogram var(name, help, var##Bounds,                          \
+                             sizeof(var##Bounds) / sizeof(uint32_t), var##Buckets)
+
+// The same, as one labelled series of a family
+#define METRIC_HISTOGRAM_LABELLED(var, name, labels, help, ...)                \
+  static const uint32_t var##Bounds[] = {__VA_ARGS__};                         \
+  static uint32_t var##Buckets[sizeof(var##Bounds) / sizeof(uint32_t) + 1];   \
+  static MetricHistogram var(name, help, var##Bounds,                          \
+                             sizeof(var##Bounds) / sizeof(uint32_t), var##Buckets, labels)
+
+// Streams every registered metric in Prometheus exposition format 0.0.4
+bool metrics_render(MetricSink sink, void* ctx);
+
+#endif
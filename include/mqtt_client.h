@@ -0,0 +1,48 @@
+/*
+ * Medibox - minimal MQTT 3.1.1 publisher
+ *
+ * Publish-only client over WiFiClient with QoS 0/1. QoS 1 messages are
+ * copied into a fixed window of in-flight slots and kept until PUBACK,
+ * then retransmitted with DUP set after a timeout or a reconnect. All
+ * packet buffers are static, nothing is allocated per message.
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MQTT_MAX_PACKET 2048
+#define MQTT_MAX_INFLIGHT 4
+#define MQTT_RETRY_MS 10000
+#define MQTT_CONNECT_TIMEOUT_MS 5000
+
+struct MqttMetrics {
+  uint32_t connects;
+  uint32_t published;
+  uint32_t acked;
+  uint32_t retransmits;
+  uint32_t bytesSent;
+};
+
+bool mqtt_connect(const char* host, uint16_t port, const char* clientId, uint16_t keepAliveS);
+void mqtt_disconnect();
+bool mqtt_connected();
+
+typedef void (*MqttAckHandler)(uint16_t packetId);
+
+// Returns false if not connected, the packet is too big, or (QoS 1) the
+// in-flight window is full. For QoS 1 the packet id is stored in packetId.
+bool mqtt_publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                  uint16_t* packetId = NULL);
+// Called from mqtt_poll() when the broker acknowledges a QoS 1 message
+void mqtt_on_ack(MqttAckHandler handler);
+
+// Reads acks, resends overdue QoS 1 messages and keeps the session alive
+void mqtt_poll();
+
+int mqtt_inflight();
+void mqtt_metrics(MqttMetrics* out);
+
+#endif
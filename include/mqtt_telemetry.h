@@ -0,0 +1,33 @@
+/*
+ * Medibox - MQTT telemetry uplink
+ *
+ * A background task moves records from the telemetry queue into the flash
+ * queue, and on every cadence tick publishes what accumulated as QoS 1
+ * messages on medibox/<device>/telemetry. Records are only dropped from
+ * flash once the broker acknowledges them, so readings taken while offline
+ * are sent in batches once the link is back, at most one batch every
+ * MQTT_DRAIN_INTERVAL_MS. Override the broker at build time with
+ * -D MQTT_BROKER_HOST=\"...\" in platformio.ini.
+ */
+
+#ifndef MQTT_TELEMETRY_H
+#define MQTT_TELEMETRY_H
+
+#include <stdint.h>
+
+#ifndef MQTT_BROKER_HOST
+#define MQTT_BROKER_HOST "host.wokwi.internal"  // Host machine when simulating
+#endif
+#ifndef MQTT_BROKER_PORT
+#define MQTT_BROKER_PORT 1883
+#endif
+#define MQTT_KEEPALIVE_S 60
+#define MQTT_PUBLISH_PERIOD_MS 60000
+#define MQTT_BATCH_MAX 24
+#define MQTT_DRAIN_INTERVAL_MS 250
+
+void mqtt_telemetry_begin();
+void mqtt_telemetry_set_period(uint32_t periodMs);
+const char* mqtt_telemetry_device_id();
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Medibox - streaming firmware update over HTTP
+ *
+ * Downloads OTA_IMAGE_PATH from an HTTP server in OTA_CHUNK sized pieces
+ * and writes each one straight into the inactive app partition, hashing
+ * it (SHA-256) on the way. The expected hash is read from OTA_HASH_PATH,
+ * in sha256sum format.
+ *
+ * A dropped connection resumes with a Range request from the last written
+ * offset. Every OTA_CHECKPOINT_BYTES the offset is saved to NVS, so a
+ * reboot also resumes; the hash of the part already in flash is then
+ * recomputed from flash. The boot partition is switched only when the
+ * whole image matches the hash and passes the bootloader's image check.
+ *
+ * The hash guards against truncated or corrupted transfers, not against a
+ * malicious server: only point the device at a server you trust.
+ */
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <stdint.h>
+
+#define OTA_IMAGE_PATH "/firmware.bin"
+#define OTA_HASH_PATH "/firmware.bin.sha256"
+#define OTA_CHUNK 4096                 // One flash sector
+#define OTA_CHECKPOINT_BYTES 65536
+#define OTA_MAX_RETRIES 10
+#define OTA_RETRY_MS 2000
+#define OTA_IO_TIMEOUT_MS 10000
+
+enum OtaState {
+  OTA_IDLE,
+  OTA_DOWNLOADING,
+  OTA_VERIFYING,
+  OTA_REBOOTING,
+  OTA_FAILED
+};
+
+struct OtaStatus {
+  OtaState state;
+  uint32_t offset;        // Bytes written and hashed so far
+  uint32_t size;          // Image size, 0 until the server reports it
+  uint32_t resumes;       // Range requests after a dropped connection
+  const char* error;      // Reason for OTA_FAILED
+};
+
+// Starts the download task; false if an update is already running
+bool ota_update_start(const char* host, uint16_t port);
+void ota_update_status(OtaStatus* out);
+const char* ota_state_name(OtaState state);
+
+#endif
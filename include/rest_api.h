@@ -0,0 +1,39 @@
+/*
+ * Medibox - REST API for alarms and settings
+ *
+ *   GET    /api/alarms          list all alarm slots
+ *   POST   /api/alarms          {"hour":7,"minute":30} into a free slot
+ *   GET    /api/alarms/<id>     one slot (id is 1-based, as on screen)
+ *   PUT    /api/alarms/<id>     {"hour":..,"minute":..,"active":..}
+ *   DELETE /api/alarms/<id>
+ *   GET    /api/alarmset        {"version":..,"alarms":[..]}
+ *   PATCH  /api/alarmset        {"base":12,"1":"07:30","2":null}, see
+ *                               alarm_patch.h; 409 with the current table
+ *                               if base is stale
+ *   GET    /api/timezone        PUT {"offset":5.5}
+ *   GET    /api/thresholds      PUT {"minTemp":..,"maxTemp":..,
+ *                                    "minHumidity":..,"maxHumidity":..}
+ *   GET    /api/stats           request counters and heap low-water mark
+ *   GET    /api/history         ?from=&to=&points=300&series=temp|humidity
+ *                               LTTB downsample of the sensor log
+ *                               (sensor_log.h); raw=1 for every reading
+ *   GET    /api/ota             update progress
+ *   POST   /api/ota             {"host":"192.168.1.10","port":8000} starts a
+ *                               firmware update from that server
+ *   GET    /api/macro           input macro, state and per-step replay results
+ *   POST   /api/macro           {"action":"record|stop|clear|replay"}, or
+ *                               {"at":1200,"button":"UP","count":3,
+ *                               "repeat":true} appends a step (input_macro.h)
+ *   GET    /api/trace           binary event trace dump (trace.h)
+ *   POST   /api/trace           {"enabled":false} pauses tracing
+ *   GET    /metrics             every registered metric (metrics.h) in
+ *                               Prometheus text format
+ *   GET    /                    browser UI for all of the above (web_ui.h)
+ */
+
+#ifndef REST_API_H
+#define REST_API_H
+
+void rest_api_begin();
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * Medibox - on-flash history of temperature and humidity readings
+ *
+ * One reading every SENSOR_LOG_INTERVAL_MS is kept as 8 bytes (timestamp
+ * and the two values scaled like telemetry), 31 to a 256 byte page, in a
+ * circular log on its own partition: the default 704 KiB hold about a
+ * month. Pages are programmed whole and the oldest sector is erased when
+ * the log wraps (flash_ring.h, as for the telemetry queue). The page still
+ * filling in RAM, at most 15 minutes of readings, is lost on reboot.
+ *
+ * Timestamps only grow with page sequence, so a RAM index of the first
+ * timestamp in every sector is enough to start a range scan within one
+ * sector of the requested time. Scans copy one page at a time under the
+ * lock and may run on any task while loop() keeps appending.
+ */
+
+#ifndef SENSOR_LOG_H
+#define SENSOR_LOG_H
+
+#include <stdint.h>
+#include "flash_queue.h"
+
+#define SENSOR_LOG_INTERVAL_MS 30000
+#define SENSOR_LOG_PER_PAGE 31     // (256 - 8 byte header) / 8 byte readings
+#define SENSOR_LOG_MAX_SECTORS 256
+
+struct SensorReading {
+  uint32_t timestamp;
+  int16_t temp;                    // x TELEMETRY_SCALE
+  int16_t humidity;
+};
+
+// Returning false stops the scan
+typedef bool (*SensorLogVisitor)(void* ctx, const SensorReading& r);
+
+struct SensorLogStats {
+  uint32_t readings;
+  uint32_t oldest;                 // Timestamps, 0 while empty
+  uint32_t newest;
+  uint32_t pagesWritten;
+  uint32_t sectorsErased;
+};
+
+bool sensor_log_begin(const FlashStorage* storage);
+
+// Called from loop() with every reading; keeps one per interval once the
+// clock is set
+void sensor_log_sample(float temperature, float humidity);
+
+// Visits readings with from <= timestamp <= to in time order, returns how
+// many were visited
+uint32_t sensor_log_scan(uint32_t from, uint32_t to, SensorLogVisitor visit, void* ctx);
+
+void sensor_log_stats(SensorLogStats* out);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Medibox - user settings shared between the UI and network tasks
+ *
+ * loop() reads these without locking (every field is a single word). Any
+ * writer, including the UI, takes the lock and calls settings_changed() so
+ * other parts can notice the update by polling settings_version().
+ *
+ * The alarm table is persisted in NVS, one record per slot, and carries
+ * its own version so remote clients can patch it against a known base
+ * (see alarm_patch.h). Alarm edits go through settings_commit_alarms().
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdint.h>
+
+#define MAX_ALARMS 2
+
+struct Alarm {
+  bool active;
+  int hour;
+  int minute;
+};
+
+// Temperature and humidity healthy ranges
+struct HealthRanges {
+  float minTemp;
+  float maxTemp;
+  float minHumidity;
+  float maxHumidity;
+};
+
+struct Settings {
+  Alarm alarms[MAX_ALARMS];
+  float timeZoneOffset; // Hours, in 30 minute increments
+  HealthRanges ranges;
+  uint32_t alarmVersion; // Bumped once per committed alarm table change
+};
+
+extern Settings settings;
+
+void settings_begin();
+void settings_lock();
+void settings_unlock();
+void settings_changed();
+uint32_t settings_version();
+// With the lock held, after editing settings.alarms: writes only the slots
+// in changedMask (bit i = slot i) to flash and bumps alarmVersion
+void settings_commit_alarms(uint32_t changedMask);
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Medibox - telemetry producer side
+ *
+ * loop() feeds raw sensor readings and alarm events in here. Readings are
+ * folded into fixed-length windows so the uplink only ever sees one record
+ * per window; finished records wait in a bounded queue for the uplink task.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "telemetry_codec.h"
+
+#define TELEMETRY_WINDOW_MS 60000
+#define TELEMETRY_QUEUE_LEN 64
+
+void telemetry_begin();
+
+// Producer side, called from loop(); never blocks
+void telemetry_sensor_sample(float temperature, float humidity);
+void telemetry_adherence(int alarmNum, AdherenceEvent event, uint16_t responseSec);
+
+// Consumer side, called from the uplink task
+bool telemetry_pop(TelemetryRecord* out, uint32_t waitMs);
+uint32_t telemetry_pending();
+uint32_t telemetry_dropped();
+
+#endif
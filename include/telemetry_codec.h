@@ -0,0 +1,84 @@
+/*
+ * Medibox - telemetry record format and payload codec
+ *
+ * Plain C++ with no Arduino dependencies so the same sources can be built
+ * for host-side tools. Sensor values are fixed point in hundredths
+ * (centi-degrees C, centi-percent RH).
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_SCALE 100
+// Worst-case JSON size of one record inside a batch
+#define TELEMETRY_JSON_RECORD_MAX 80
+// Worst-case CBOR size of one record: array head, u32 timestamp, 7 x 3 bytes
+#define TELEMETRY_CBOR_RECORD_MAX 27
+
+enum TelemetryType : uint8_t {
+  TELEMETRY_SENSOR = 1,
+  TELEMETRY_ADHERENCE = 2
+};
+
+enum AdherenceEvent : uint8_t {
+  ADHERENCE_RANG = 1,
+  ADHERENCE_DISMISSED = 2,
+  ADHERENCE_SNOOZED = 3
+};
+
+// Aggregate of all DHT readings taken during one window
+struct SensorWindow {
+  uint16_t samples;
+  int16_t tempMin, tempMax, tempMean;
+  int16_t humMin, humMax, humMean;
+};
+
+struct AdherenceRecord {
+  uint8_t alarm;
+  uint8_t event;          // AdherenceEvent
+  uint16_t responseSec;   // ring to dismiss/snooze, 0 for RANG
+};
+
+struct TelemetryRecord {
+  uint32_t timestamp;     // unix seconds, 0 if the clock was not set yet
+  uint8_t type;           // TelemetryType
+  uint8_t reserved;
+  union {
+    SensorWindow sensor;
+    AdherenceRecord adherence;
+  };
+};
+
+// Encodes as many of recs[0..count) as fit into buf, returns the number of
+// records consumed (0 if not even one fits). *outLen receives the size.
+//   {"dev":..,"seq":..,"sensor":[[ts,n,tmin,tmax,tmean,hmin,hmax,hmean],..],
+//    "events":[[ts,alarm,event,responseSec],..]}
+size_t telemetry_encode_json(char* buf, size_t cap, const char* device, uint32_t seq,
+                             const TelemetryRecord* recs, size_t count, size_t* outLen);
+
+// Same contract and layout as telemetry_encode_json, as CBOR with integer
+// map keys:
+//   {0: dev, 1: seq, 2: [[ts,n,tmin,tmax,tmean,hmin,hmax,hmean],..],
+//    3: [[ts,alarm,event,responseSec],..]}
+size_t telemetry_encode_cbor(uint8_t* buf, size_t cap, const char* device, uint32_t seq,
+                             const TelemetryRecord* recs, size_t count, size_t* outLen);
+
+#define TELEMETRY_DEVICE_MAX 32
+
+struct TelemetryBatch {
+  char device[TELEMETRY_DEVICE_MAX];
+  uint32_t seq;
+  size_t count;           // Records stored in out
+};
+
+// Inverse of the encoders for host-side tools. Records beyond max are
+// skipped; false if the payload is malformed.
+bool telemetry_decode_json(const char* buf, size_t len, TelemetryBatch* batch,
+                           TelemetryRecord* out, size_t max);
+bool telemetry_decode_cbor(const uint8_t* buf, size_t len, TelemetryBatch* batch,
+                           TelemetryRecord* out, size_t max);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Medibox - NTP time service
+ *
+ * Wraps SNTP so that the local clock is disciplined rather than stepped:
+ * - the oscillator frequency error is estimated from successive sync offsets
+ * - that error is trimmed out continuously between syncs
+ * - small offsets are slewed with adjtime(), only large ones are stepped
+ * - the resync interval grows as the drift estimate settles
+ *
+ * Error bound: between syncs the local clock is kept within
+ * TIME_SYNC_ERROR_BOUND_MS of NTP time (plus NTP path jitter, typically a
+ * few tens of ms), so an alarm fires within that window of its minute.
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+
+// Offsets above this are stepped, anything smaller is slewed
+#define TIME_SYNC_SLEW_LIMIT_MS 1000
+// Worst-case clock error allowed to build up between two syncs
+#define TIME_SYNC_ERROR_BOUND_MS 500
+// Resync interval limits (seconds)
+#define TIME_SYNC_MIN_INTERVAL_S (15UL * 60)
+#define TIME_SYNC_MAX_INTERVAL_S (12UL * 60 * 60)
+// Samples closer together than this are too noisy to estimate drift from
+#define TIME_SYNC_MIN_SAMPLE_S 60
+// How often the frequency correction is applied from loop()
+#define TIME_SYNC_TRIM_PERIOD_MS 10000
+
+void time_sync_begin(const char* server, float tzHours);
+void time_sync_set_timezone(float tzHours);
+void time_sync_loop();
+
+bool time_sync_is_synced();
+float time_sync_drift_ppm();
+int32_t time_sync_last_offset_ms();
+uint32_t time_sync_interval_s();
+uint32_t time_sync_count();
+uint32_t time_sync_step_count();
+
+#endif
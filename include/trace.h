@@ -0,0 +1,88 @@
+/*
+ * Medibox - event trace
+ *
+ * A fixed ring of compact records (time, event, phase, one argument) of
+ * what the firmware did lately: button edges and events, alarm changes,
+ * sensor reads, display flushes, WiFi changes. Writers claim a slot with
+ * one atomic increment and never lock, so any task or interrupt handler
+ * can trace; once full, the oldest records are overwritten. Each slot is
+ * stamped with its sequence number after it is written, and the dump
+ * skips slots that change while being copied.
+ *
+ * The dump is binary, little-endian: a TraceDumpHeader and then the
+ * records from oldest to newest. GET /api/trace serves it as is; typing
+ * 't' on the serial console prints it as hex lines between "TRACE BEGIN"
+ * and "TRACE END". tools/trace_to_chrome.py turns either into Chrome
+ * trace_event JSON for Perfetto (ui.perfetto.dev) or chrome://tracing.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+#ifndef TRACE_CAPACITY
+#define TRACE_CAPACITY 512      // 12 bytes of RAM each
+#endif
+#define TRACE_MAGIC 0x5254424d  // "MBTR"
+#define TRACE_VERSION 1
+
+// Numbers are part of the dump format: append only, and keep
+// tools/trace_to_chrome.py in step
+enum TraceEvent : uint8_t {
+  TRACE_BUTTON_EDGE,    // arg: Button, from the GPIO interrupt
+  TRACE_INPUT,          // arg: Button | repeat << 7 | count << 8
+  TRACE_ALARM_RING,     // arg: alarm number
+  TRACE_ALARM_SNOOZE,
+  TRACE_ALARM_STOP,
+  TRACE_SENSOR_READ,    // Span; end arg: temperature in tenths of °C, INT16_MIN if failed
+  TRACE_DISPLAY_FLUSH,  // Span; end arg: bytes sent
+  TRACE_WIFI,           // arg: WifiState
+  TRACE_MEMORY_ALERT    // arg: MemAlert | reasons << 8
+};
+
+enum TracePhase : uint8_t {
+  TRACE_INSTANT,
+  TRACE_BEGIN,
+  TRACE_END
+};
+
+struct TraceRecord {
+  uint32_t seq;         // 1 for the first record since boot
+  uint32_t us;          // hal_micros()
+  uint8_t event;
+  uint8_t phase;
+  uint16_t arg;
+};
+
+struct TraceDumpHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t recordSize;
+  uint16_t capacity;
+  uint32_t nowUs;       // When the dump started
+  uint32_t written;     // Records since boot; more than in the dump means some were overwritten
+};
+
+static_assert(sizeof(TraceRecord) == 12, "dump format");
+static_assert(sizeof(TraceDumpHeader) == 16, "dump format");
+
+// Safe from any task and from interrupt handlers
+void trace(TraceEvent event, uint16_t arg = 0, TracePhase phase = TRACE_INSTANT);
+void trace_begin(TraceEvent event, uint16_t arg = 0);
+void trace_end(TraceEvent event, uint16_t arg = 0);
+
+// Tracing starts enabled
+void trace_enable(bool on);
+bool trace_enabled();
+
+// Hands the dump to sink in pieces; false if the sink gave up
+typedef bool (*TraceSink)(void* ctx, const uint8_t* data, size_t len);
+bool trace_dump(TraceSink sink, void* ctx);
+// The dump as hex lines, 32 bytes each, between "TRACE BEGIN" and "TRACE END"
+void trace_print(Print& out);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Medibox - CBOR over UDP telemetry uplink
+ *
+ * Fire-and-forget alternative to the MQTT uplink for sites where a TCP
+ * session is too costly: records are encoded with telemetry_encode_cbor()
+ * into a fixed buffer and sent as single datagrams. Up to UDP_BATCH_MAX
+ * records share a datagram; a partial batch is sent once its oldest record
+ * is UDP_MAX_DELAY_MS old. Nothing is retransmitted; the receiver detects
+ * loss from gaps in the per-datagram sequence number, which restarts at 0
+ * on boot. Build with -D TELEMETRY_UDP=1 to use it instead of MQTT, and
+ * run tools/udp_receiver.py on the collector.
+ */
+
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include <stdint.h>
+
+#ifndef TELEMETRY_UDP
+#define TELEMETRY_UDP 0
+#endif
+#ifndef UDP_TELEMETRY_HOST
+#define UDP_TELEMETRY_HOST "host.wokwi.internal"
+#endif
+#ifndef UDP_TELEMETRY_PORT
+#define UDP_TELEMETRY_PORT 5683
+#endif
+#ifndef UDP_BATCH_MAX
+#define UDP_BATCH_MAX 8
+#endif
+#ifndef UDP_MAX_DELAY_MS
+#define UDP_MAX_DELAY_MS 300000
+#endif
+// Below the typical path MTU so datagrams are never fragmented
+#define UDP_DATAGRAM_MAX 512
+
+struct UdpTelemetryStats {
+  uint32_t datagrams;
+  uint32_t records;
+  uint32_t bytes;
+  uint32_t sendErrors;
+};
+
+void udp_telemetry_begin();
+void udp_telemetry_stats(UdpTelemetryStats* out);
+
+#endif
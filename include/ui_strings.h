@@ -0,0 +1,90 @@
+/*
+ * Medibox - UI string IDs, generated by tools/gen_strings.py from
+ * strings/. Do not edit; see ui_text.h.
+ */
+
+#ifndef UI_STRINGS_H
+#define UI_STRINGS_H
+
+#include <stdint.h>
+
+enum StrId : uint16_t {
+  STR_NONE,
+  STR_BOOT_STARTING,
+  STR_WIFI_CONNECTING,
+  STR_BOOT_READY,
+  STR_TIME_FAILED,
+  STR_DAY_SUNDAY,
+  STR_DAY_MONDAY,
+  STR_DAY_TUESDAY,
+  STR_DAY_WEDNESDAY,
+  STR_DAY_THURSDAY,
+  STR_DAY_FRIDAY,
+  STR_DAY_SATURDAY,
+  STR_MONTH_JANUARY,
+  STR_MONTH_FEBRUARY,
+  STR_MONTH_MARCH,
+  STR_MONTH_APRIL,
+  STR_MONTH_MAY,
+  STR_MONTH_JUNE,
+  STR_MONTH_JULY,
+  STR_MONTH_AUGUST,
+  STR_MONTH_SEPTEMBER,
+  STR_MONTH_OCTOBER,
+  STR_MONTH_NOVEMBER,
+  STR_MONTH_DECEMBER,
+  STR_CLOCK_FORMAT,
+  STR_RING_LINE1,
+  STR_RING_LINE2,
+  STR_RING_ALARM,
+  STR_RING_HELP,
+  STR_SNOOZED,
+  STR_SNOOZE_HELP,
+  STR_STOPPED,
+  STR_WARNING,
+  STR_WARN_BOTH,
+  STR_WARN_TEMP,
+  STR_WARN_HUMIDITY,
+  STR_TEMP_LABEL,
+  STR_HUMIDITY_LABEL,
+  STR_HEALTHY_TEMP,
+  STR_HEALTHY_HUMIDITY,
+  STR_MENU_TITLE,
+  STR_MENU_SET_TIMEZONE,
+  STR_MENU_SET_ALARM,
+  STR_MENU_VIEW_ALARMS,
+  STR_MENU_DELETE_ALARM,
+  STR_MENU_BACK,
+  STR_EDIT_HELP_NEXT,
+  STR_EDIT_HELP_SET,
+  STR_SET_ALARM_TITLE,
+  STR_SET_HOUR,
+  STR_SET_MINUTE,
+  STR_ALARM_SET,
+  STR_SET_TIMEZONE_TITLE,
+  STR_TIMEZONE_CURRENT,
+  STR_TIMEZONE_UPDATED,
+  STR_TIMEZONE_HELP,
+  STR_ALARMS_TITLE,
+  STR_ALARMS_ENTRY,
+  STR_ALARMS_NONE,
+  STR_ALARMS_HELP,
+  STR_DELETE_MENU_TITLE,
+  STR_DELETE_ITEM,
+  STR_DELETE_NOT_SET,
+  STR_DELETE_BACK,
+  STR_DELETE_MENU_HELP,
+  STR_DELETE_TITLE,
+  STR_DELETE_CURRENT,
+  STR_DELETE_HELP,
+  STR_DELETED,
+  STR_COUNT
+};
+
+enum UiLanguage : uint8_t {
+  LANG_EN,
+  LANG_DE,
+  LANG_COUNT
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Medibox - localized UI text
+ *
+ * Every string shown on the OLED comes from a table generated from
+ * strings/<lang>.txt by tools/gen_strings.py, indexed by StrId. The
+ * tables are const, so they stay in flash and tr() returns a pointer into
+ * them: nothing is copied to RAM. Each entry also carries the string's
+ * length, line count and width, measured at build time, for layout
+ * without strlen() or font metrics at run time.
+ *
+ * The language is picked at build time with -DUI_LANGUAGE=LANG_DE (or
+ * another LANG_ from ui_strings.h) and can be switched at run time.
+ * Strings are in code page 437; the display must be put in cp437 mode.
+ */
+
+#ifndef UI_TEXT_H
+#define UI_TEXT_H
+
+#include <stdint.h>
+#include "ui_strings.h"
+
+#ifndef UI_LANGUAGE
+#define UI_LANGUAGE LANG_EN
+#endif
+
+#define UI_CHAR_WIDTH 6   // Built-in font at text size 1, spacing included
+
+struct UiText {
+  uint16_t offset;      // Into the language's text blob
+  uint8_t length;       // Bytes, without the terminating NUL
+  uint8_t lines;        // A trailing newline does not add a line
+  uint16_t width;       // Longest line in pixels at text size 1
+};
+
+struct UiLanguageTable {
+  const char* code;     // "en", "de", ...
+  const char* text;
+  const UiText* entries;
+};
+
+// Generated (ui_strings.cpp)
+extern const UiLanguageTable uiLanguages[LANG_COUNT];
+
+void ui_set_language(UiLanguage lang);
+UiLanguage ui_language();
+// STR_NONE gives ""
+const char* tr(StrId id);
+const UiText& tr_metrics(StrId id);
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Medibox - browser UI for alarms and settings
+ *
+ * The files under web/ are gzipped at build time by tools/embed_web.py
+ * into const arrays in flash (src/web_assets.cpp). A request is answered
+ * by sending those bytes straight from the memory-mapped flash, so serving
+ * the UI allocates nothing and copies nothing into RAM. Every asset has a
+ * strong ETag; browsers revalidate (Cache-Control: no-cache) and get a
+ * bodyless 304 while the firmware is unchanged.
+ */
+
+#ifndef WEB_UI_H
+#define WEB_UI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct HttpRequest;
+class HttpResponse;
+
+struct WebAsset {
+  const char* path;
+  const char* contentType;
+  const char* etag;       // Quoted, as sent in the ETag header
+  const uint8_t* data;    // gzip
+  uint32_t size;
+};
+
+extern const WebAsset webAssets[];
+extern const size_t webAssetCount;
+
+// Serves GET requests for UI assets ("/" is index.html); false if the path
+// is not an asset and the caller should continue routing
+bool web_ui_handle(HttpRequest& req, HttpResponse& res);
+
+#endif
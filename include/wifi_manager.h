@@ -0,0 +1,56 @@
+/*
+ * Medibox - background WiFi connection manager
+ *
+ * Connection progress is driven by WiFi events and advanced from loop()
+ * without ever waiting. Failed attempts rotate through the stored networks
+ * and back off exponentially with random jitter so a fleet does not hammer
+ * an access point in lockstep after an outage.
+ */
+
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdint.h>
+
+#define WIFI_MAX_NETWORKS 4
+#define WIFI_MAX_LISTENERS 6
+#define WIFI_CONNECT_TIMEOUT_MS 15000
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+
+enum WifiState {
+  WIFI_IDLE,
+  WIFI_CONNECTING,
+  WIFI_CONNECTED,
+  WIFI_BACKOFF
+};
+
+struct WifiNetwork {
+  const char* ssid;
+  const char* password;
+};
+
+struct WifiMetrics {
+  uint32_t attempts;          // connection attempts started
+  uint32_t connects;          // attempts that reached GOT_IP
+  uint32_t reconnects;        // connects after a previous session dropped
+  uint32_t lastConnectMs;     // begin() to GOT_IP of the latest session
+  uint32_t avgConnectMs;      // running mean over all connects
+  uint32_t sessionUptimeMs;   // current session, 0 when offline
+  uint32_t totalUptimeMs;     // all sessions including the current one
+};
+
+// Called from loop() whenever the published state changes
+typedef void (*WifiListener)(WifiState state);
+
+bool wifi_manager_add_network(const char* ssid, const char* password);
+void wifi_manager_add_listener(WifiListener listener);
+void wifi_manager_begin();
+void wifi_manager_loop();
+
+WifiState wifi_manager_state();
+bool wifi_manager_connected();
+const char* wifi_manager_ssid();
+void wifi_manager_metrics(WifiMetrics* out);
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Medibox - the Arduino core on the host (native environment)
+ *
+ * Only what the Adafruit GFX/SSD1306 libraries and the portable Medibox
+ * modules use. Pins and time go to the Linux HAL (hal_linux.cpp), Serial
+ * is stdin/stdout. Built with -D ARDUINO=10805 so the libraries take
+ * their modern Arduino paths.
+ */
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "hal.h"
+#include "Print.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+// Everything is in RAM on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const unsigned char*)(addr))
+#endif
+#ifndef pgm_read_word
+#define pgm_read_word(addr) (*(const unsigned short*)(addr))
+#endif
+#ifndef pgm_read_dword
+#define pgm_read_dword(addr) (*(const unsigned long*)(addr))
+#endif
+#ifndef pgm_read_pointer
+#define pgm_read_pointer(addr) (*(void* const*)(addr))
+#endif
+
+using std::max;
+using std::min;
+
+inline unsigned long millis() { return hal_millis(); }
+inline unsigned long micros() { return hal_micros(); }
+inline void delay(unsigned long ms) { hal_delay(ms); }
+inline void delayMicroseconds(unsigned int) {}
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  hal_pin_mode(pin, mode == OUTPUT ? HAL_OUTPUT : HAL_INPUT_PULLUP);
+}
+inline int digitalRead(uint8_t pin) { return hal_pin_read(pin) ? HIGH : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { hal_pin_write(pin, value != LOW); }
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+// Output goes to stdout; input is whatever the host program feeds in
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void feed(char c);
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif
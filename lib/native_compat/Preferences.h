@@ -0,0 +1,28 @@
+/*
+ * Medibox - ESP32 Preferences (NVS) on the host (see Arduino.h)
+ *
+ * Kept in memory for the life of the process.
+ */
+
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Preferences {
+public:
+  bool begin(const char* name, bool readOnly = false);
+  void end() { space = NULL; }
+  size_t getBytes(const char* key, void* buf, size_t maxLen);
+  size_t putBytes(const char* key, const void* value, size_t len);
+  uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+  size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  bool remove(const char* key);
+
+private:
+  void* space = NULL;
+  bool readOnly = false;
+};
+
+#endif
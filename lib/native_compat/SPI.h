@@ -0,0 +1,37 @@
+/*
+ * Medibox - Arduino SPI on the host (see Arduino.h); declared for the
+ * display libraries, never used by Medibox
+ */
+
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction() {}
+  void setBitOrder(uint8_t) {}
+  void setDataMode(uint8_t) {}
+  uint8_t transfer(uint8_t) { return 0; }
+  void transfer(void*, size_t) {}
+  void transferBytes(const uint8_t*, uint8_t*, size_t) {}
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Medibox - Arduino Wire on the host (see Arduino.h)
+ *
+ * A bus with no devices on it that acknowledges everything and counts
+ * the traffic, for hal_display_bus(). Transfers are chunked like the
+ * ESP32 core's, which buffers I2C_BUFFER_LENGTH bytes.
+ */
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include <Arduino.h>
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire : public Stream {
+public:
+  bool begin() { return true; }
+  void end() {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t) { transactions++; }
+  uint8_t endTransmission(bool = true) { return 0; }
+  size_t requestFrom(uint8_t, size_t, bool = true) { return 0; }
+  size_t write(uint8_t) override {
+    bytes++;
+    return 1;
+  }
+  size_t write(const uint8_t*, size_t size) override {
+    bytes += size;
+    return size;
+  }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  using Print::write;
+
+  uint32_t transactions = 0;
+  uint32_t bytes = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
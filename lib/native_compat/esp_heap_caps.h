@@ -0,0 +1,17 @@
+/*
+ * Medibox - ESP-IDF heap statistics on the host (see Arduino.h); the host
+ * heap is not tracked, so every figure is 0
+ */
+
+#ifndef NATIVE_ESP_HEAP_CAPS_H
+#define NATIVE_ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline size_t heap_caps_get_free_size(unsigned int) { return 0; }
+inline size_t heap_caps_get_minimum_free_size(unsigned int) { return 0; }
+inline size_t heap_caps_get_largest_free_block(unsigned int) { return 0; }
+
+#endif
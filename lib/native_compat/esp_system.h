@@ -0,0 +1,13 @@
+/*
+ * Medibox - ESP-IDF system calls on the host (see Arduino.h); the host
+ * heap is not tracked, so the free heap is 0
+ */
+
+#ifndef NATIVE_ESP_SYSTEM_H
+#define NATIVE_ESP_SYSTEM_H
+
+#include <stdint.h>
+
+inline uint32_t esp_get_free_heap_size() { return 0; }
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * Medibox - FreeRTOS on the host (see Arduino.h); only the mutexes
+ */
+
+#ifndef NATIVE_FREERTOS_H
+#define NATIVE_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Medibox - FreeRTOS mutexes on the host, as std::recursive_mutex. A
+ * timeout other than 0 waits forever.
+ */
+
+#ifndef NATIVE_SEMPHR_H
+#define NATIVE_SEMPHR_H
+
+#include <mutex>
+#include "FreeRTOS.h"
+
+typedef std::recursive_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::recursive_mutex(); }
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new std::recursive_mutex(); }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t m, TickType_t ticks) {
+  if (ticks == 0) return m->try_lock() ? pdTRUE : pdFALSE;
+  m->lock();
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t m) {
+  m->unlock();
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t m, TickType_t ticks) {
+  return xSemaphoreTake(m, ticks);
+}
+
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t m) {
+  return xSemaphoreGive(m);
+}
+
+#endif
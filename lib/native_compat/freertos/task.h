@@ -0,0 +1,30 @@
+/*
+ * Medibox - FreeRTOS tasks on the host, as detached std::threads. Ticks
+ * are milliseconds and the core is ignored.
+ */
+
+#ifndef NATIVE_TASK_H
+#define NATIVE_TASK_H
+
+#include <chrono>
+#include <thread>
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack,
+                                          void* arg, unsigned priority, TaskHandle_t* handle,
+                                          BaseType_t core) {
+  std::thread(task, arg).detach();
+  if (handle != NULL) *handle = NULL;
+  return pdTRUE;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+#endif
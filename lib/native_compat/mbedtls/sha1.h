@@ -0,0 +1,12 @@
+/*
+ * Medibox - mbedTLS SHA-1 on the host, for the WebSocket handshake
+ */
+
+#ifndef NATIVE_MBEDTLS_SHA1_H
+#define NATIVE_MBEDTLS_SHA1_H
+
+#include <stddef.h>
+
+int mbedtls_sha1_ret(const unsigned char* input, size_t len, unsigned char output[20]);
+
+#endif
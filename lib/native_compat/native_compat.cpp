@@ -0,0 +1,180 @@
+/*
+ * Medibox - the Arduino core on the host (see Arduino.h)
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <SPI.h>
+#include <Wire.h>
+#include <mbedtls/sha1.h>
+
+#include <stdarg.h>
+#include <map>
+#include <string>
+#include <vector>
+
+HostSerial Serial;
+TwoWire Wire;
+SPIClass SPI;
+
+unsigned int String::length() const {
+  return strlen(text);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size-- > 0) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::write(const char* s) {
+  return s == NULL ? 0 : write((const uint8_t*)s, strlen(s));
+}
+
+size_t Print::print(long n, int base) {
+  if (base == DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", n);
+    return write(buf);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+  return write(buf);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
+
+size_t HostSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+static char serialInput[64];
+static size_t serialHead = 0;    // Next to read
+static size_t serialCount = 0;
+
+void HostSerial::feed(char c) {
+  if (serialCount == sizeof(serialInput)) return;
+  serialInput[(serialHead + serialCount++) % sizeof(serialInput)] = c;
+}
+
+int HostSerial::available() {
+  return (int)serialCount;
+}
+
+int HostSerial::read() {
+  if (serialCount == 0) return -1;
+  char c = serialInput[serialHead];
+  serialHead = (serialHead + 1) % sizeof(serialInput);
+  serialCount--;
+  return (uint8_t)c;
+}
+
+// namespace -> key -> value
+typedef std::map<std::string, std::vector<uint8_t>> PrefSpace;
+static std::map<std::string, PrefSpace> prefSpaces;
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  space = &prefSpaces[name];
+  this->readOnly = readOnly;
+  return true;
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+  if (space == NULL) return 0;
+  PrefSpace& s = *(PrefSpace*)space;
+  PrefSpace::iterator it = s.find(key);
+  if (it == s.end() || it->second.size() > maxLen) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+  if (space == NULL || readOnly) return 0;
+  const uint8_t* bytes = (const uint8_t*)value;
+  (*(PrefSpace*)space)[key].assign(bytes, bytes + len);
+  return len;
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+  uint32_t value;
+  return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+bool Preferences::remove(const char* key) {
+  if (space == NULL || readOnly) return false;
+  return ((PrefSpace*)space)->erase(key) > 0;
+}
+
+static uint32_t rol(uint32_t v, int n) {
+  return (v << n) | (v >> (32 - n));
+}
+
+int mbedtls_sha1_ret(const unsigned char* input, size_t len, unsigned char output[20]) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  // Message, 0x80, zeros and the bit length, in whole 64 byte blocks
+  std::vector<uint8_t> msg(input, input + len);
+  msg.push_back(0x80);
+  while (msg.size() % 64 != 56) msg.push_back(0);
+  for (int i = 7; i >= 0; i--) msg.push_back((uint8_t)((uint64_t)len * 8 >> (i * 8)));
+
+  for (size_t block = 0; block < msg.size(); block += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t* p = &msg[block + i * 4];
+      w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) output[i] = (uint8_t)(h[i / 4] >> (24 - i % 4 * 8));
+  return 0;
+}
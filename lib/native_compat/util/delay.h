@@ -0,0 +1 @@
+/* Medibox - nothing to declare on the host (native environment) */
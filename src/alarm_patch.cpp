@@ -0,0 +1,59 @@
+/*
+ * Medibox - delta patches against the versioned alarm table (see alarm_patch.h)
+ */
+
+#include "alarm_patch.h"
+
+// Strict "HH:MM", 24 hour clock
+static bool parse_time(const char* s, int* hour, int* minute) {
+  for (int i = 0; i < 5; i++) {
+    if (i == 2 ? s[i] != ':' : (s[i] < '0' || s[i] > '9')) return false;
+  }
+  if (s[5] != '\0') return false;
+  *hour = (s[0] - '0') * 10 + (s[1] - '0');
+  *minute = (s[3] - '0') * 10 + (s[4] - '0');
+  return *hour < 24 && *minute < 60;
+}
+
+AlarmPatchResult alarm_patch_apply(const JsonFlatParser& body, Alarm* alarms,
+                                   uint32_t version, uint32_t* changedMask) {
+  *changedMask = 0;
+  long base;
+  if (!body.get_int("base", &base)) return ALARM_PATCH_INVALID;
+  if (base < 0 || (uint32_t)base != version) return ALARM_PATCH_STALE;
+
+  // Stage every entry first so a bad one leaves the table untouched
+  Alarm staged[MAX_ALARMS];
+  memcpy(staged, alarms, sizeof(staged));
+  uint32_t touched = 0;
+  for (size_t i = 0; i < body.count(); i++) {
+    const JsonField& f = body.field(i);
+    if (strcmp(f.key, "base") == 0) continue;
+
+    char* end;
+    long id = strtol(f.key, &end, 10);
+    if (*end != '\0' || id < 1 || id > MAX_ALARMS) return ALARM_PATCH_INVALID;
+    uint32_t bit = 1u << (id - 1);
+    if (touched & bit) return ALARM_PATCH_INVALID;   // Same id twice
+    touched |= bit;
+
+    Alarm& a = staged[id - 1];
+    if (!f.isString && strcmp(f.value, "null") == 0) {
+      a.active = false;
+    } else if (f.isString && parse_time(f.value, &a.hour, &a.minute)) {
+      a.active = true;
+    } else {
+      return ALARM_PATCH_INVALID;
+    }
+  }
+
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    const Alarm& a = alarms[i];
+    const Alarm& b = staged[i];
+    if (a.active != b.active || (b.active && (a.hour != b.hour || a.minute != b.minute))) {
+      alarms[i] = b;
+      *changedMask |= 1u << i;
+    }
+  }
+  return ALARM_PATCH_OK;
+}
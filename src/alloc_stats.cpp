@@ -0,0 +1,71 @@
+/*
+ * Medibox - heap allocation counters (see alloc_stats.h)
+ */
+
+#include "alloc_stats.h"
+
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "metrics.h"
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+// Plain words rather than metric objects: malloc runs before static
+// constructors, which would reset the counts
+static uint32_t allocs = 0;
+static uint32_t frees = 0;
+static uint32_t taskAllocs = 0;
+static TaskHandle_t watched = NULL;
+
+static MetricCounter allocsTotal("medibox_heap_allocs_total", "Heap allocations, all tasks",
+                                 [] { return __atomic_load_n(&allocs, __ATOMIC_RELAXED); });
+static MetricCounter freesTotal("medibox_heap_frees_total", "Heap frees, all tasks",
+                                [] { return __atomic_load_n(&frees, __ATOMIC_RELAXED); });
+
+static void count_alloc() {
+  __atomic_fetch_add(&allocs, 1, __ATOMIC_RELAXED);
+  if (watched != NULL && xTaskGetCurrentTaskHandle() == watched) {
+    __atomic_fetch_add(&taskAllocs, 1, __ATOMIC_RELAXED);
+  }
+}
+
+extern "C" {
+
+void* __wrap_malloc(size_t size) {
+  count_alloc();
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+  count_alloc();
+  return __real_calloc(n, size);
+}
+
+// Growing a String goes through here
+void* __wrap_realloc(void* ptr, size_t size) {
+  count_alloc();
+  return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr) {
+  if (ptr != NULL) __atomic_fetch_add(&frees, 1, __ATOMIC_RELAXED);
+  __real_free(ptr);
+}
+
+}
+
+void alloc_stats_watch_current_task() {
+  __atomic_store_n(&taskAllocs, 0, __ATOMIC_RELAXED);
+  watched = xTaskGetCurrentTaskHandle();
+}
+
+uint32_t alloc_stats_task_allocs() {
+  return __atomic_load_n(&taskAllocs, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,99 @@
+/*
+ * Medibox - debounced buttons with long-press auto-repeat (see buttons.h)
+ */
+
+#include "buttons.h"
+
+#include <stddef.h>
+
+#include "hal.h"
+#include "trace.h"
+
+// Indexed by Button; NONE has no pin
+static uint8_t pins[5];
+static Button stable = NONE;        // Debounced state
+static unsigned long lastChange = 0;
+static unsigned long holdStart = 0;
+static unsigned long nextRepeat = 0;
+// hal_micros() of the first falling edge per button since it was last idle,
+// 0 if none; set from the GPIO interrupt
+static volatile uint32_t edgeUs[5];
+
+static void IRAM_ATTR on_edge(void* arg) {
+  volatile uint32_t* stamp = (volatile uint32_t*)arg;
+  trace(TRACE_BUTTON_EDGE, stamp - edgeUs);     // Bounces included
+  if (*stamp == 0) *stamp = hal_micros() | 1;   // Never 0 once set
+}
+
+void buttons_begin(uint8_t up, uint8_t ok, uint8_t down, uint8_t cancel) {
+  pins[UP] = up;
+  pins[OK_BTN] = ok;
+  pins[DOWN] = down;
+  pins[CANCEL_BTN] = cancel;
+  for (int b = UP; b <= CANCEL_BTN; b++) {
+    hal_pin_mode(pins[b], HAL_INPUT_PULLUP);
+    hal_pin_on_falling(pins[b], on_edge, (void*)&edgeUs[b]);
+  }
+}
+
+// Same priority as before when several are down
+static Button read_raw() {
+  static const Button order[] = {UP, OK_BTN, DOWN, CANCEL_BTN};
+  for (Button b : order) {
+    if (!hal_pin_read(pins[b])) return b;
+  }
+  return NONE;
+}
+
+static unsigned long repeat_interval(unsigned long now) {
+  return now - holdStart >= BUTTON_HOLD_MS + BUTTON_FAST_AFTER_MS ? BUTTON_REPEAT_FAST_MS
+                                                                  : BUTTON_REPEAT_SLOW_MS;
+}
+
+ButtonEvent buttons_poll() {
+  ButtonEvent ev = {NONE, 0, false, 0};
+  unsigned long now = hal_millis();
+  Button raw = read_raw();
+
+  // Edges while idle are bounces of the last release
+  if (raw == NONE && stable == NONE) {
+    for (int b = UP; b <= CANCEL_BTN; b++) edgeUs[b] = 0;
+  }
+
+  if (raw != stable) {
+    // Ignore bounces right after the last accepted change
+    if (now - lastChange < BUTTON_DEBOUNCE_MS) return ev;
+    stable = raw;
+    lastChange = now;
+    if (raw == NONE) return ev;
+    holdStart = now;
+    nextRepeat = now + BUTTON_HOLD_MS;
+    ev.button = raw;
+    ev.count = 1;
+    // Dated from the edge, not from when loop() got round to polling
+    ev.atUs = edgeUs[raw] != 0 ? edgeUs[raw] : hal_micros();
+    edgeUs[raw] = 0;
+    return ev;
+  }
+
+  if ((stable == UP || stable == DOWN) && (long)(now - nextRepeat) >= 0) {
+    ev.button = stable;
+    ev.repeat = true;
+    // Dated from when the first of these repeats fell due
+    ev.atUs = hal_micros() - (now - nextRepeat) * 1000;
+    while ((long)(now - nextRepeat) >= 0 && ev.count < UINT8_MAX) {
+      ev.count++;
+      nextRepeat += repeat_interval(nextRepeat);
+    }
+  }
+  return ev;
+}
+
+static ButtonEvent poll_device(void* ctx) {
+  return buttons_poll();
+}
+
+const InputDevice* buttons_device() {
+  static const InputDevice device = {"buttons", NULL, poll_device};
+  return &device;
+}
@@ -0,0 +1,154 @@
+/*
+ * Medibox - live dashboard stream over WebSocket (see dashboard.h)
+ */
+
+#include "dashboard.h"
+
+#include <Arduino.h>
+
+#include "http_server.h"
+#include "settings.h"
+#include "telemetry_codec.h"
+
+#define SECTION_STATE_KEY 0x01
+#define SECTION_STATE_DELTA 0x02
+#define SECTION_FRAMEBUFFER 0x03
+
+#define FIELD_TEMP 0
+#define FIELD_HUMIDITY 1
+#define FIELD_STATUS 2
+#define FIELD_ALARMS 3
+#define FIELD_COUNT (FIELD_ALARMS + MAX_ALARMS)
+
+#define FB_BLOCK 16
+#define FB_MAX 1024
+#define FB_BITMAP (FB_MAX / FB_BLOCK / 8)
+
+// Worst case: header, both state sections fully populated, whole framebuffer
+#define MESSAGE_MAX (1 + 2 + FIELD_COUNT * 5 + 1 + FB_BITMAP + FB_MAX)
+
+// Latest values from loop(); single words, read without locking
+static volatile int32_t liveTemp = 0;
+static volatile int32_t liveHumidity = 0;
+static volatile int32_t liveStatus = 0;
+
+static const uint8_t* framebuffer = NULL;
+static size_t fbLength = 0;
+
+// What synced clients have already been sent
+static int32_t sentFields[FIELD_COUNT];
+static uint8_t sentFramebuffer[FB_MAX];
+
+// Shared encode buffers, each sent unchanged to every client in its group
+static uint8_t deltaMessage[WS_FRAME_HEADER_MAX + MESSAGE_MAX];
+static uint8_t keyMessage[WS_FRAME_HEADER_MAX + MESSAGE_MAX];
+
+static size_t put_varint(uint8_t* p, int32_t v) {
+  uint32_t z = ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);   // zigzag
+  size_t n = 0;
+  while (z >= 0x80) {
+    p[n++] = (z & 0x7F) | 0x80;
+    z >>= 7;
+  }
+  p[n++] = z;
+  return n;
+}
+
+static void snapshot(int32_t* fields) {
+  fields[FIELD_TEMP] = liveTemp;
+  fields[FIELD_HUMIDITY] = liveHumidity;
+  fields[FIELD_STATUS] = liveStatus;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    const Alarm& a = settings.alarms[i];
+    fields[FIELD_ALARMS + i] = (a.active ? 0x8000 : 0) | (a.hour * 60 + a.minute);
+  }
+}
+
+// State section against base (NULL for a keyframe); returns 0 if unchanged
+static size_t encode_state(uint8_t* out, const int32_t* fields, const int32_t* base) {
+  size_t n = 3;
+  uint16_t mask = 0;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (base != NULL && fields[i] == base[i]) continue;
+    mask |= 1 << i;
+    n += put_varint(out + n, base != NULL ? fields[i] - base[i] : fields[i]);
+  }
+  if (mask == 0) return 0;
+  out[0] = base != NULL ? SECTION_STATE_DELTA : SECTION_STATE_KEY;
+  out[1] = mask & 0xFF;
+  out[2] = mask >> 8;
+  return n;
+}
+
+// Framebuffer section against sentFramebuffer (all blocks for a keyframe)
+static size_t encode_framebuffer(uint8_t* out, const uint8_t* fb, bool key) {
+  uint8_t* bitmap = out + 1;
+  memset(bitmap, 0, FB_BITMAP);
+  size_t n = 1 + FB_BITMAP;
+  bool any = false;
+  for (size_t block = 0; block * FB_BLOCK < fbLength; block++) {
+    const uint8_t* src = fb + block * FB_BLOCK;
+    if (!key && memcmp(src, sentFramebuffer + block * FB_BLOCK, FB_BLOCK) == 0) continue;
+    bitmap[block / 8] |= 1 << (block % 8);
+    memcpy(out + n, src, FB_BLOCK);
+    n += FB_BLOCK;
+    any = true;
+  }
+  if (!any) return 0;
+  out[0] = SECTION_FRAMEBUFFER;
+  return n;
+}
+
+static void send_message(uint8_t* buf, size_t len, bool toNew) {
+  uint8_t* payload = buf + WS_FRAME_HEADER_MAX;
+  uint8_t* frame = ws_frame_header(payload, len);
+  ws_broadcast(frame, payload + len - frame, toNew);
+}
+
+// Runs on the HTTP server task
+static void dashboard_tick() {
+  bool haveSynced = ws_has_synced_clients();
+  bool haveNew = ws_has_new_clients();
+  if (!haveSynced && !haveNew) return;
+
+  int32_t fields[FIELD_COUNT];
+  snapshot(fields);
+
+  // The display is drawn concurrently; a torn block is simply resent on
+  // the next tick because it is compared against what was sent, not drawn
+  static uint8_t fb[FB_MAX];
+  if (framebuffer != NULL) memcpy(fb, framebuffer, fbLength);
+
+  if (haveSynced) {
+    uint8_t* p = deltaMessage + WS_FRAME_HEADER_MAX;
+    size_t len = encode_state(p, fields, sentFields);
+    if (framebuffer != NULL) len += encode_framebuffer(p + len, fb, false);
+    if (len > 0) send_message(deltaMessage, len, false);
+  }
+  if (haveNew) {
+    uint8_t* p = keyMessage + WS_FRAME_HEADER_MAX;
+    size_t len = encode_state(p, fields, NULL);
+    if (framebuffer != NULL) len += encode_framebuffer(p + len, fb, true);
+    send_message(keyMessage, len, true);
+  }
+
+  memcpy(sentFields, fields, sizeof(sentFields));
+  if (framebuffer != NULL) memcpy(sentFramebuffer, fb, fbLength);
+}
+
+void dashboard_begin(const uint8_t* fb, size_t fbLen) {
+  if (DASHBOARD_FRAMEBUFFER && fb != NULL && fbLen <= FB_MAX) {
+    framebuffer = fb;
+    fbLength = fbLen;
+  }
+  http_server_set_tick(dashboard_tick, DASHBOARD_PERIOD_MS);
+}
+
+void dashboard_update_sensor(float temperature, float humidity) {
+  liveTemp = lroundf(temperature * TELEMETRY_SCALE);
+  liveHumidity = lroundf(humidity * TELEMETRY_SCALE);
+}
+
+void dashboard_update_alarm(bool ringing, bool snoozing, int ringingNum) {
+  liveStatus = (ringing ? 0x01 : 0) | (snoozing ? 0x02 : 0) | ((ringingNum & 0x0F) << 4);
+}
@@ -0,0 +1,116 @@
+/*
+ * Medibox - rotary encoder on the ESP32 pulse counter (see encoder.h)
+ */
+
+#include "encoder.h"
+
+#include <driver/pcnt.h>
+
+#include "buttons.h"
+#include "hal.h"
+#include "metrics.h"
+
+#define UNIT PCNT_UNIT_0
+#define FILTER_APB_CYCLES 1023   // 12.8 us, the longest the filter allows
+#define CLEAR_AT 10000           // Well inside the 16 bit counter
+
+static int16_t lastCount = 0;
+static int32_t pending = 0;      // Counts not yet worth a detent
+static uint8_t switchPin = ENCODER_NO_SWITCH;
+static bool switchDown = false;
+static bool switchHeld = false;  // CANCEL already sent for this press
+static unsigned long switchChange = 0;
+
+static MetricCounter detentsTotal("medibox_encoder_detents_total", "Encoder detents turned");
+static MetricCounter bursts("medibox_encoder_events_total",
+                            "Encoder events, each covering one or more detents");
+
+static bool setup_channel(pcnt_channel_t channel, uint8_t pulse, uint8_t ctrl,
+                          pcnt_count_mode_t pos, pcnt_count_mode_t neg) {
+  pcnt_config_t config = {};
+  config.pulse_gpio_num = pulse;
+  config.ctrl_gpio_num = ctrl;
+  config.channel = channel;
+  config.unit = UNIT;
+  config.pos_mode = pos;
+  config.neg_mode = neg;
+  config.lctrl_mode = PCNT_MODE_REVERSE;
+  config.hctrl_mode = PCNT_MODE_KEEP;
+  config.counter_h_lim = INT16_MAX;
+  config.counter_l_lim = INT16_MIN;
+  return pcnt_unit_config(&config) == ESP_OK;
+}
+
+static ButtonEvent poll_switch(unsigned long now) {
+  ButtonEvent ev = {NONE, 0, false, 0};
+  bool down = !hal_pin_read(switchPin);
+  if (down != switchDown && now - switchChange >= BUTTON_DEBOUNCE_MS) {
+    switchDown = down;
+    switchChange = now;
+    // A short press acts on release, once it cannot become a hold
+    if (!down && !switchHeld) ev.button = OK_BTN;
+    switchHeld = false;
+  } else if (switchDown && !switchHeld && now - switchChange >= BUTTON_HOLD_MS) {
+    switchHeld = true;
+    ev.button = CANCEL_BTN;
+  }
+  if (ev.button != NONE) {
+    ev.count = 1;
+    ev.atUs = hal_micros();
+  }
+  return ev;
+}
+
+static ButtonEvent poll_device(void* ctx) {
+  int16_t count = 0;
+  pcnt_get_counter_value(UNIT, &count);
+  pending += count - lastCount;
+  lastCount = count;
+  if (count > CLEAR_AT || count < -CLEAR_AT) {
+    // Edges between the read and the clear are lost: a few us every
+    // couple of thousand detents
+    pcnt_counter_clear(UNIT);
+    lastCount = 0;
+  }
+
+  int32_t detents = pending / ENCODER_COUNTS_PER_DETENT;
+  if (detents != 0) {
+    pending -= detents * ENCODER_COUNTS_PER_DETENT;
+    bool up = (detents > 0) != ENCODER_REVERSE;
+    uint32_t steps = detents > 0 ? detents : -detents;
+    detentsTotal.inc(steps);
+    bursts.inc();
+    // PCNT has no timestamps: the input is dated when the poll sees it
+    ButtonEvent ev = {up ? UP : DOWN, (uint8_t)(steps > UINT8_MAX ? UINT8_MAX : steps), true,
+                      (uint32_t)hal_micros()};
+    return ev;
+  }
+
+  if (switchPin != ENCODER_NO_SWITCH) return poll_switch(hal_millis());
+  ButtonEvent none = {NONE, 0, false, 0};
+  return none;
+}
+
+const InputDevice* encoder_begin(uint8_t pinA, uint8_t pinB, uint8_t pinSwitch) {
+  static const InputDevice device = {"encoder", NULL, poll_device};
+
+  hal_pin_mode(pinA, HAL_INPUT_PULLUP);
+  hal_pin_mode(pinB, HAL_INPUT_PULLUP);
+  // Both edges of both phases: channel 0 counts A gated by B, channel 1
+  // counts B gated by A, the directions chosen so they agree
+  if (!setup_channel(PCNT_CHANNEL_0, pinA, pinB, PCNT_COUNT_DEC, PCNT_COUNT_INC) ||
+      !setup_channel(PCNT_CHANNEL_1, pinB, pinA, PCNT_COUNT_INC, PCNT_COUNT_DEC)) {
+    return NULL;
+  }
+  pcnt_set_filter_value(UNIT, FILTER_APB_CYCLES);
+  pcnt_filter_enable(UNIT);
+  pcnt_counter_pause(UNIT);
+  pcnt_counter_clear(UNIT);
+  pcnt_counter_resume(UNIT);
+  lastCount = 0;
+  pending = 0;
+
+  switchPin = pinSwitch;
+  if (switchPin != ENCODER_NO_SWITCH) hal_pin_mode(switchPin, HAL_INPUT_PULLUP);
+  return &device;
+}
@@ -0,0 +1,192 @@
+/*
+ * Medibox - persistent store-and-forward queue (see flash_queue.h)
+ *
+ * The pages form a flash_ring.h log, so the queue needs no index: a boot
+ * scan of the page headers finds the newest page, and the persisted ack
+ * sequence tells where unsent data starts.
+ */
+
+#include "flash_queue.h"
+
+#include <string.h>
+
+#include "flash_ring.h"
+
+#define PAGES_PER_SECTOR FLASH_RING_PAGES_PER_SECTOR
+#define MAX_PAGES 1024               // 256 KiB; storage beyond it is left unused
+
+struct Page {
+  FlashPageHeader header;
+  TelemetryRecord records[FLASH_QUEUE_PER_PAGE];
+};
+
+static_assert(sizeof(Page) <= FLASH_QUEUE_PAGE, "page overflows a flash page");
+
+static const FlashStorage* store = NULL;
+static FlashRing ring;
+static uint32_t pageCount = 0;
+
+static Page ramPage;                 // Page being filled, logically seq headSeq
+static uint32_t headSeq = 0;         // Next page to program
+static uint32_t tailSeq = 0;         // Oldest unacknowledged page
+static uint32_t tailIndex = 0;
+static uint32_t readSeq = 0;         // Next record for read()
+static uint32_t readIndex = 0;
+
+static Page readCache;
+static uint32_t cachedSeq = FLASH_RING_BLANK;
+static FlashQueueStats stats = {};
+// Slots holding a good page of their sequence. Recovery after a torn write
+// skips the rest of a sector, and a corrupt page is skipped by read(); the
+// cursors and counts pass over those without losing records.
+static uint32_t present[MAX_PAGES / 32];
+
+static bool is_present(uint32_t seq) {
+  uint32_t slot = seq % pageCount;
+  return present[slot / 32] & (1u << slot % 32);
+}
+
+static void set_present(uint32_t seq, bool on) {
+  uint32_t slot = seq % pageCount;
+  if (on) {
+    present[slot / 32] |= 1u << slot % 32;
+  } else {
+    present[slot / 32] &= ~(1u << slot % 32);
+  }
+}
+
+// Records from the cursor up to, not including, the RAM page
+static uint32_t records_from(uint32_t seq, uint32_t index) {
+  uint32_t pages = 0;
+  for (; seq < headSeq; seq++) pages += is_present(seq);
+  return pages * FLASH_QUEUE_PER_PAGE - index;
+}
+
+static uint32_t page_records(uint32_t seq) {
+  if (seq == headSeq) return ramPage.header.count;
+  return is_present(seq) ? FLASH_QUEUE_PER_PAGE : 0;
+}
+
+// Moves a cursor past pages that are about to be erased
+static void skip_to(uint32_t* seq, uint32_t* index, uint32_t firstKept) {
+  if (*seq < firstKept) {
+    *seq = firstKept;
+    *index = 0;
+  }
+}
+
+static void write_ram_page() {
+  if (flash_ring_starts_sector(&ring, headSeq)) {
+    // Reclaim the oldest sector; anything unacknowledged in it is lost
+    uint32_t firstKept = headSeq - pageCount + PAGES_PER_SECTOR;
+    if (headSeq >= pageCount && tailSeq < firstKept) {
+      stats.dropped += records_from(tailSeq, tailIndex) - records_from(firstKept, 0);
+      skip_to(&tailSeq, &tailIndex, firstKept);
+      skip_to(&readSeq, &readIndex, firstKept);
+      store->store_acked(store->ctx, firstKept - 1);
+    }
+    stats.sectorsErased++;
+    for (uint32_t seq = headSeq; seq < headSeq + PAGES_PER_SECTOR; seq++) set_present(seq, false);
+  }
+
+  flash_ring_write(&ring, headSeq, &ramPage, sizeof(ramPage));
+  set_present(headSeq, true);
+  stats.pagesWritten++;
+
+  headSeq++;
+  ramPage.header.count = 0;
+}
+
+static const Page* load_page(uint32_t seq) {
+  if (seq == headSeq) return &ramPage;
+  if (cachedSeq != seq) {
+    cachedSeq = FLASH_RING_BLANK;
+    if (!flash_ring_read(&ring, seq, &readCache, sizeof(readCache))) return NULL;
+    cachedSeq = seq;
+  }
+  return &readCache;
+}
+
+struct Scan {
+  uint32_t acked;
+  uint32_t oldest;                   // Unacknowledged
+};
+
+static void scan_page(void* ctx, uint32_t slot, const FlashPageHeader& h, const uint8_t* peek) {
+  Scan* scan = (Scan*)ctx;
+  set_present(h.seq, true);
+  if (h.seq > scan->acked && h.seq < scan->oldest) scan->oldest = h.seq;
+}
+
+bool flash_queue_begin(const FlashStorage* storage) {
+  if (!flash_ring_begin(&ring, storage, MAX_PAGES, FLASH_QUEUE_PER_PAGE)) return false;
+  store = storage;
+  pageCount = ring.pageCount;
+
+  // Find the newest page and the oldest one the broker has not confirmed
+  Scan scan = {store->load_acked(store->ctx), FLASH_RING_BLANK};
+  memset(present, 0, sizeof(present));
+  uint32_t newest = flash_ring_scan(&ring, scan_page, &scan);
+  headSeq = flash_ring_resume(&ring, newest, 1);
+
+  tailSeq = scan.oldest == FLASH_RING_BLANK ? headSeq : scan.oldest;
+  tailIndex = 0;
+  readSeq = tailSeq;
+  readIndex = 0;
+  ramPage.header.count = 0;
+  cachedSeq = FLASH_RING_BLANK;
+  return true;
+}
+
+void flash_queue_push(const TelemetryRecord& rec) {
+  if (store == NULL) return;
+  ramPage.records[ramPage.header.count++] = rec;
+  if (ramPage.header.count == FLASH_QUEUE_PER_PAGE) {
+    write_ram_page();
+  }
+}
+
+size_t flash_queue_read(TelemetryRecord* out, size_t max) {
+  size_t n = 0;
+  while (store != NULL && n < max && readSeq <= headSeq) {
+    uint32_t count = page_records(readSeq);
+    if (readIndex >= count) {
+      if (readSeq == headSeq) break;   // Caught up with the RAM page
+      readSeq++;
+      readIndex = 0;
+      continue;
+    }
+    const Page* page = load_page(readSeq);
+    if (page == NULL) {
+      // Corrupt page: skip it rather than stall the queue
+      stats.dropped += count - readIndex;
+      set_present(readSeq, false);
+      readSeq++;
+      readIndex = 0;
+      continue;
+    }
+    while (n < max && readIndex < count) {
+      out[n++] = page->records[readIndex++];
+    }
+  }
+  return n;
+}
+
+void flash_queue_ack(size_t count) {
+  if (store == NULL) return;
+  uint32_t before = tailSeq;
+  tailIndex += count;
+  while (tailSeq < headSeq && tailIndex >= page_records(tailSeq)) {
+    tailIndex -= page_records(tailSeq);
+    tailSeq++;
+  }
+  if (tailSeq != before) {
+    store->store_acked(store->ctx, tailSeq - 1);
+  }
+}
+
+void flash_queue_stats(FlashQueueStats* out) {
+  *out = stats;
+  out->pending = records_from(tailSeq, tailIndex) + ramPage.header.count;
+  out->unread = records_from(readSeq, readIndex) + ramPage.header.count;
+}
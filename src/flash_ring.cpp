@@ -0,0 +1,88 @@
+/*
+ * Medibox - circular log of flash pages (see flash_ring.h)
+ */
+
+#include "flash_ring.h"
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static uint16_t page_crc(const void* page, size_t len) {
+  const uint8_t* body = (const uint8_t*)page + sizeof(FlashPageHeader);
+  return crc16(body, len - sizeof(FlashPageHeader));
+}
+
+bool flash_ring_begin(FlashRing* ring, const FlashStorage* storage, uint32_t maxPages,
+                      uint16_t perPage) {
+  if (storage == NULL || storage->size < 2 * FLASH_QUEUE_SECTOR) return false;
+  ring->store = storage;
+  ring->pageCount = storage->size / FLASH_QUEUE_SECTOR * FLASH_RING_PAGES_PER_SECTOR;
+  if (ring->pageCount > maxPages) ring->pageCount = maxPages;
+  ring->perPage = perPage;
+  return true;
+}
+
+uint32_t flash_ring_scan(const FlashRing* ring, FlashRingVisitor visit, void* ctx) {
+  struct {
+    FlashPageHeader header;
+    uint8_t peek[FLASH_RING_PEEK];
+  } head;
+  const FlashPageHeader& h = head.header;
+  uint32_t newest = FLASH_RING_BLANK;
+  for (uint32_t slot = 0; slot < ring->pageCount; slot++) {
+    if (!ring->store->read(ring->store->ctx, (size_t)slot * FLASH_QUEUE_PAGE, &head, sizeof(head))) {
+      continue;
+    }
+    if (h.seq == FLASH_RING_BLANK || h.seq % ring->pageCount != slot || h.count != ring->perPage) {
+      continue;
+    }
+    if (visit != NULL) visit(ctx, slot, h, head.peek);
+    if (newest == FLASH_RING_BLANK || h.seq > newest) newest = h.seq;
+  }
+  return newest;
+}
+
+uint32_t flash_ring_resume(const FlashRing* ring, uint32_t newest, uint32_t first) {
+  // Pages after the head in its sector are programmed without an erase, so
+  // if any of them is not blank start over at the next sector boundary
+  uint32_t head = newest == FLASH_RING_BLANK ? first : newest + 1;
+  for (uint32_t seq = head; seq % FLASH_RING_PAGES_PER_SECTOR != 0; seq++) {
+    FlashPageHeader h;
+    ring->store->read(ring->store->ctx, flash_ring_offset(ring, seq), &h, sizeof(h));
+    if (h.seq != FLASH_RING_BLANK) {
+      return head + FLASH_RING_PAGES_PER_SECTOR - head % FLASH_RING_PAGES_PER_SECTOR;
+    }
+  }
+  return head;
+}
+
+size_t flash_ring_offset(const FlashRing* ring, uint32_t seq) {
+  return (size_t)(seq % ring->pageCount) * FLASH_QUEUE_PAGE;
+}
+
+bool flash_ring_starts_sector(const FlashRing* ring, uint32_t seq) {
+  return flash_ring_offset(ring, seq) % FLASH_QUEUE_SECTOR == 0;
+}
+
+void flash_ring_write(const FlashRing* ring, uint32_t seq, void* page, size_t len) {
+  size_t offset = flash_ring_offset(ring, seq);
+  if (offset % FLASH_QUEUE_SECTOR == 0) ring->store->erase_sector(ring->store->ctx, offset);
+  FlashPageHeader* h = (FlashPageHeader*)page;
+  h->seq = seq;
+  h->crc = page_crc(page, len);
+  ring->store->write(ring->store->ctx, offset, page, len);
+}
+
+bool flash_ring_read(const FlashRing* ring, uint32_t seq, void* page, size_t len) {
+  if (!ring->store->read(ring->store->ctx, flash_ring_offset(ring, seq), page, len)) return false;
+  const FlashPageHeader* h = (const FlashPageHeader*)page;
+  return h->seq == seq && h->count == ring->perPage && h->crc == page_crc(page, len);
+}
@@ -0,0 +1,74 @@
+/*
+ * Medibox - FlashStorage backed by a raw data partition (see flash_storage.h)
+ */
+
+#include "flash_storage.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+
+#define ACKED_KEY "acked"
+#define MAX_BINDINGS 2
+
+struct Binding {
+  FlashStorage storage;
+  const esp_partition_t* part;
+  const char* label;          // Also the NVS namespace
+};
+
+static Binding bindings[MAX_BINDINGS];
+
+static bool part_read(void* ctx, size_t offset, void* dst, size_t len) {
+  return esp_partition_read(((Binding*)ctx)->part, offset, dst, len) == ESP_OK;
+}
+
+static bool part_write(void* ctx, size_t offset, const void* src, size_t len) {
+  return esp_partition_write(((Binding*)ctx)->part, offset, src, len) == ESP_OK;
+}
+
+static bool part_erase(void* ctx, size_t offset) {
+  return esp_partition_erase_range(((Binding*)ctx)->part, offset, FLASH_QUEUE_SECTOR) == ESP_OK;
+}
+
+static uint32_t load_acked(void* ctx) {
+  Preferences prefs;
+  uint32_t seq = 0;
+  if (prefs.begin(((Binding*)ctx)->label, true)) {
+    seq = prefs.getUInt(ACKED_KEY, 0);
+    prefs.end();
+  }
+  return seq;
+}
+
+static void store_acked(void* ctx, uint32_t seq) {
+  Preferences prefs;
+  if (prefs.begin(((Binding*)ctx)->label, false)) {
+    prefs.putUInt(ACKED_KEY, seq);
+    prefs.end();
+  }
+}
+
+const FlashStorage* flash_storage_partition(const char* label) {
+  const esp_partition_t* part =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if (part == NULL) return NULL;
+
+  Binding* b = NULL;
+  for (int i = 0; i < MAX_BINDINGS && b == NULL; i++) {
+    if (bindings[i].part == NULL || bindings[i].part == part) b = &bindings[i];
+  }
+  if (b == NULL) return NULL;
+
+  b->part = part;
+  b->label = label;
+  FlashStorage& storage = b->storage;
+  storage.ctx = b;
+  storage.size = part->size - part->size % FLASH_QUEUE_SECTOR;
+  storage.read = part_read;
+  storage.write = part_write;
+  storage.erase_sector = part_erase;
+  storage.load_acked = load_acked;
+  storage.store_acked = store_acked;
+  return &storage;
+}
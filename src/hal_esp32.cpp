@@ -0,0 +1,90 @@
+/*
+ * Medibox - hardware abstraction layer for the ESP32 (see hal.h)
+ */
+
+#include "hal.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <DHT.h>
+
+#include "board.h"
+
+static DHT dht(DHT_PIN, DHT22);
+static HalNetworkHandler networkHandler = NULL;
+
+uint32_t IRAM_ATTR hal_millis() {
+  return millis();
+}
+
+uint32_t IRAM_ATTR hal_micros() {
+  return micros();
+}
+
+void hal_delay(uint32_t ms) {
+  delay(ms);
+}
+
+bool hal_local_time(struct tm* out) {
+  return getLocalTime(out);
+}
+
+void hal_pin_mode(uint8_t pin, HalPinMode mode) {
+  pinMode(pin, mode == HAL_OUTPUT ? OUTPUT : INPUT_PULLUP);
+}
+
+bool hal_pin_read(uint8_t pin) {
+  return digitalRead(pin) == HIGH;
+}
+
+void hal_pin_write(uint8_t pin, bool high) {
+  digitalWrite(pin, high ? HIGH : LOW);
+}
+
+void hal_pin_on_falling(uint8_t pin, HalPinHandler handler, void* arg) {
+  attachInterruptArg(digitalPinToInterrupt(pin), handler, arg, FALLING);
+}
+
+TwoWire* hal_display_bus() {
+  return &Wire;
+}
+
+void hal_sensor_begin() {
+  dht.begin();
+}
+
+bool hal_sensor_read(float* temperature, float* humidity) {
+  *humidity = dht.readHumidity();
+  *temperature = dht.readTemperature();
+  return !isnan(*humidity) && !isnan(*temperature);
+}
+
+static void on_wifi_event(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (networkHandler == NULL) return;
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    networkHandler(HAL_NETWORK_GOT_IP);
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED ||
+             event == ARDUINO_EVENT_WIFI_STA_LOST_IP) {
+    networkHandler(HAL_NETWORK_DROPPED);
+  }
+}
+
+void hal_network_begin(HalNetworkHandler handler) {
+  networkHandler = handler;
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false); // Reconnects are paced by wifi_manager
+  WiFi.onEvent(on_wifi_event);
+}
+
+void hal_network_connect(const char* ssid, const char* password) {
+  WiFi.begin(ssid, password);
+}
+
+void hal_network_disconnect() {
+  WiFi.disconnect();
+}
+
+uint32_t hal_random() {
+  return esp_random();
+}
@@ -0,0 +1,288 @@
+/*
+ * Medibox - drawing microbenchmarks (bench environment)
+ *
+ * Times the Adafruit GFX primitives the UI leans on, the SSD1306 frame
+ * transfer and each Medibox screen, rendered by the firmware's own code
+ * into the real driver over the host's counting I2C bus. Each benchmark
+ * runs in batches of enough iterations to take BATCH_NS; the fastest of
+ * BATCH_RUNS batches is the result, as noise only ever adds time. Time is
+ * virtual for the firmware, so the warning screen's delays cost nothing.
+ *
+ * Besides the host time per operation, every benchmark reports what it
+ * sent over the display bus and how long that takes on the wire at the
+ * panel's 400 kHz, which is what a frame costs on the device. Results
+ * go to a JSON file; tools/bench_compare.py checks them against
+ * tools/bench/baseline.json.
+ *
+ *   pio run -e bench && .pio/build/bench/program bench.json
+ *   python3 tools/bench_compare.py bench.json
+ *
+ * Host times are only comparable on the same machine and build: refresh
+ * the baseline (--update-baseline) when either changes.
+ */
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+#include <stdio.h>
+#include <time.h>
+
+#include "board.h"
+#include "hal_linux.h"
+#include "input.h"
+#include "json_writer.h"
+#include "menu.h"
+
+// main.cpp
+void setup();
+void loop();
+void print_clock(const struct tm& t);
+void check_temp();
+extern Adafruit_SSD1306 display;
+extern bool alarmRinging;
+extern int alarmRingingNum;
+
+#define BATCH_NS 20000000.0     // Long enough that clock reads and jitter vanish
+#define BATCH_RUNS 7
+#define MAX_BATCH 1000000
+#define I2C_HZ 400000           // Adafruit_SSD1306's clock during transfers
+#define BENCH_TIME 1760000000   // A fixed wall clock, so every run draws the same
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;          // Per batch
+  double bestNs;                // Per operation
+  double medianNs;
+  uint32_t busBytes;            // Per operation
+  uint32_t busTransactions;
+};
+
+typedef void (*BenchFn)(uint32_t i);
+
+static BenchResult results[32];
+static size_t resultCount = 0;
+static uint8_t bitmap[32 * 32 / 8];
+static const ButtonEvent up = {UP, 1, false, 0};
+static const ButtonEvent down = {DOWN, 1, false, 0};
+static const ButtonEvent ok = {OK_BTN, 1, false, 0};
+static const ButtonEvent cancel = {CANCEL_BTN, 1, false, 0};
+
+static double now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double batch_ns(BenchFn fn, uint32_t n) {
+  double start = now_ns();
+  for (uint32_t i = 0; i < n; i++) fn(i);
+  return now_ns() - start;
+}
+
+// Every benchmark starts from the same clock
+static void reset_clock() {
+  hal_linux_virtual_time(true);
+  hal_linux_set_time(BENCH_TIME);
+}
+
+static void bench(const char* name, BenchFn fn) {
+  if (resultCount == sizeof(results) / sizeof(results[0])) return;
+  reset_clock();
+  uint32_t n = 1;
+  while (n < MAX_BATCH && batch_ns(fn, n) < BATCH_NS) n *= 2;
+
+  double runs[BATCH_RUNS];
+  HalLinuxBusStats before, after;
+  for (int r = 0; r < BATCH_RUNS; r++) {
+    hal_linux_bus_stats(&before);
+    runs[r] = batch_ns(fn, n) / n;
+    hal_linux_bus_stats(&after);
+  }
+  for (int i = 1; i < BATCH_RUNS; i++) {
+    for (int j = i; j > 0 && runs[j] < runs[j - 1]; j--) {
+      double t = runs[j];
+      runs[j] = runs[j - 1];
+      runs[j - 1] = t;
+    }
+  }
+
+  BenchResult& res = results[resultCount++];
+  res.name = name;
+  res.iterations = n;
+  res.bestNs = runs[0];
+  res.medianNs = runs[BATCH_RUNS / 2];
+  res.busBytes = (after.bytes - before.bytes) / n;
+  res.busTransactions = (after.transactions - before.transactions) / n;
+}
+
+// Each transaction also carries a start, the address byte and a stop
+static double wire_us(const BenchResult& r) {
+  uint32_t bits = r.busBytes * 9 + r.busTransactions * 11;
+  return bits * 1e6 / I2C_HZ;
+}
+
+// Primitives, cycling through positions so no call is a repeat of the last
+
+static void draw_char(uint32_t i) {
+  display.drawChar((i % 21) * 6, (i / 21 % 8) * 8, 'A' + i % 26, WHITE, BLACK, 1);
+}
+
+static void draw_char_x2(uint32_t i) {
+  display.drawChar((i % 10) * 12, (i / 10 % 4) * 16, 'A' + i % 26, WHITE, BLACK, 2);
+}
+
+static void print_text(uint32_t i) {
+  display.setTextSize(1);
+  display.setCursor(0, (i % 8) * 8);
+  display.print("Sat 18 Oct 09:41:07");
+}
+
+static void fill_rect(uint32_t i) {
+  // Off the page boundaries, the common case
+  display.fillRect(i % 64, 3 + i % 24, 64, 29, i & 1 ? WHITE : BLACK);
+}
+
+static void draw_bitmap(uint32_t i) {
+  display.drawBitmap(i % 96, i % 32, bitmap, 32, 32, WHITE, BLACK);
+}
+
+static void clear_display(uint32_t) {
+  display.clearDisplay();
+}
+
+static void send_frame(uint32_t) {
+  display.display();
+}
+
+// Screens, each a full render and flush by the firmware
+
+static void clock_screen(uint32_t i) {
+  time_t t = BENCH_TIME + i;
+  struct tm local;
+  localtime_r(&t, &local);
+  print_clock(local);
+}
+
+static void main_menu(uint32_t) {
+  menu_open(&mainMenu);
+}
+
+static void menu_scroll(uint32_t i) {
+  menu_handle(i & 1 ? up : down);
+}
+
+// Stepping the hour of alarm 1
+static void alarm_editor(uint32_t) {
+  menu_handle(up);
+}
+
+// An unhandled press redraws the view
+static void alarm_list(uint32_t) {
+  menu_handle(down);
+}
+
+static void warning_screen(uint32_t) {
+  check_temp();
+}
+
+// Whole loop() iterations, input and housekeeping included
+
+static void clock_loop(uint32_t) {
+  loop();
+}
+
+static void alarm_loop(uint32_t) {
+  loop();
+}
+
+static void open_menu(int downs) {
+  menu_open(&mainMenu);
+  while (downs-- > 0) menu_handle(down);
+  menu_handle(ok);
+}
+
+static void run_all() {
+  for (size_t i = 0; i < sizeof(bitmap); i++) bitmap[i] = (uint8_t)(0x55 << (i & 1));
+
+  bench("gfx/drawChar", draw_char);
+  bench("gfx/drawChar_size2", draw_char_x2);
+  bench("gfx/print", print_text);
+  bench("gfx/fillRect", fill_rect);
+  bench("gfx/drawBitmap", draw_bitmap);
+  bench("ssd1306/clearDisplay", clear_display);
+  bench("ssd1306/display", send_frame);
+
+  bench("screen/clock", clock_screen);
+  bench("screen/menu", main_menu);
+  bench("screen/menu_scroll", menu_scroll);
+  open_menu(1);
+  bench("screen/alarm_editor", alarm_editor);
+  open_menu(3);
+  bench("screen/alarm_list", alarm_list);
+  menu_handle(cancel);   // Back to the clock
+  menu_handle(cancel);
+  hal_linux_set_sensor(35, 90);
+  bench("screen/warning", warning_screen);
+  hal_linux_set_sensor(28, 70);
+
+  bench("loop/clock", clock_loop);
+  alarmRinging = true;
+  alarmRingingNum = 1;
+  bench("loop/alarm", alarm_loop);
+  alarmRinging = false;
+}
+
+static bool write_file(void* ctx, const char* data, size_t len) {
+  return fwrite(data, 1, len, (FILE*)ctx) == len;
+}
+
+static bool write_json(const char* path) {
+  FILE* f = fopen(path, "w");
+  if (f == NULL) return false;
+  char buf[256];
+  JsonWriter json(buf, sizeof(buf), write_file, f);
+  json.begin_object();
+  json.key("benchmarks");
+  json.begin_object();
+  for (size_t i = 0; i < resultCount; i++) {
+    const BenchResult& r = results[i];
+    json.key(r.name);
+    json.begin_object();
+    json.key("ns");
+    json.value((float)r.bestNs, 1);
+    json.key("median_ns");
+    json.value((float)r.medianNs, 1);
+    json.key("iterations");
+    json.value(r.iterations);
+    json.key("bus_bytes");
+    json.value(r.busBytes);
+    json.key("bus_transactions");
+    json.value(r.busTransactions);
+    json.key("wire_us");
+    json.value((float)wire_us(r), 1);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  bool ok = json.flush() && fputc('\n', f) != EOF;
+  return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char** argv) {
+  reset_clock();
+  setup();
+  run_all();
+
+  printf("\n%-22s %12s %12s %10s %9s %9s\n", "benchmark", "ns/op", "median", "iters",
+         "bus B/op", "wire us");
+  for (size_t i = 0; i < resultCount; i++) {
+    const BenchResult& r = results[i];
+    printf("%-22s %12.1f %12.1f %10u %9u %9.1f\n", r.name, r.bestNs, r.medianNs,
+           (unsigned)r.iterations, (unsigned)r.busBytes, wire_us(r));
+  }
+  if (argc > 1 && !write_json(argv[1])) {
+    fprintf(stderr, "%s: cannot write results\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
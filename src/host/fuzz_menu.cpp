@@ -0,0 +1,310 @@
+/*
+ * Medibox - fuzzer for the UI state machine (fuzz environments)
+ *
+ * Runs the firmware's loop() under sequences of button presses, time
+ * jumps, sensor readings and alarm changes from the network, decoded
+ * from the fuzzer's input, and checks after every loop() that:
+ *
+ *   - one loop() takes at most STEP_HOST_MS of host time and blocks for
+ *     at most STEP_VIRTUAL_MS of the firmware's (virtual) time
+ *   - an alarm is never ringing and snoozed at once, and the alarm number
+ *     is a real slot while either is set
+ *   - LED and buzzer are off unless an alarm is ringing
+ *   - the alarm table and time zone stay within what the editors allow
+ *   - an active alarm rings when loop() finds its minute on the clock with
+ *     nothing else going on, unless an alarm already rang in that minute
+ *
+ * and, at the end of each input, that CANCEL ends any alarm and closes any
+ * open menu. A failed check aborts with the step, so the fuzzer keeps the
+ * input.
+ *
+ * Each step is two bytes, an operation and its argument:
+ *
+ *   0-3  UP, OK, DOWN, CANCEL, held 40-110 ms or, with bit 3 of the
+ *        argument, long enough to auto-repeat
+ *   4    let (argument x 2) seconds pass
+ *   5    odd argument: set the clock to alarm (argument >> 1) & 1;
+ *        even: to minute (argument >> 1) x 12 of the day
+ *   6    sensor reading, 255 for a failed read
+ *   7    alarm (argument & 1) set from the network: active if bit 1,
+ *        at hour (argument >> 2) % 24
+ *   8    move the clock (argument % 7) + 1 days on, same time of day
+ *
+ * Operations are taken modulo 9. Each input starts at the same time of
+ * day, but on a day after everything the previous input reached, so what
+ * the firmware remembers about alarms that already rang cannot leak into
+ * it.
+ *
+ * The seed corpus is in tools/fuzz/menu_corpus/. With libFuzzer (clang):
+ *
+ *   pio run -e fuzz && .pio/build/fuzz/program tools/fuzz/menu_corpus
+ *
+ * The fuzz_replay environment builds the same checks with the default
+ * compiler and only replays the files or directories it is given.
+ */
+
+#include <Arduino.h>
+
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "board.h"
+#include "buttons.h"
+#include "hal_linux.h"
+#include "input.h"
+#include "menu.h"
+#include "settings.h"
+
+// main.cpp
+void setup();
+void loop();
+extern bool alarmRinging;
+extern int alarmRingingNum;
+extern bool alarmSnoozing;
+
+#define STEP_HOST_MS 250         // Generous: sanitizers slow everything down
+#define STEP_VIRTUAL_MS 10000    // Warning (5 s) plus an alarm starting (0.9 s)
+#define TICK_MS 10               // Between loop() calls while time passes
+#define MAX_STEPS 512
+#define FUZZ_START_TIME 1760000000
+// Inputs reach at most 256 x 7 days ahead, so start days can go back to
+// FUZZ_START_TIME after this many without meeting the last input's days
+#define FUZZ_WRAP_DAYS 4096
+
+#define FUZZ_CHECK(cond) \
+  do { \
+    if (!(cond)) fail(#cond); \
+  } while (0)
+
+static const uint8_t buttonPins[] = {BTN_UP, BTN_OK, BTN_DOWN, BTN_CANCEL};
+static Alarm defaultAlarms[MAX_ALARMS];
+static float defaultTimeZone;
+static size_t step = 0;
+static long lastRangMinute = -1;   // Local minute an alarm last started ringing
+static time_t latestTime = 0;      // Furthest the clock has been
+
+static void fail(const char* what) {
+  fprintf(stderr, "fuzz_menu: step %u: check failed: %s\n", (unsigned)step, what);
+  abort();
+}
+
+static double host_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void check_state() {
+  FUZZ_CHECK(!(alarmRinging && alarmSnoozing));
+  if (alarmRinging || alarmSnoozing) {
+    FUZZ_CHECK(alarmRingingNum >= 1 && alarmRingingNum <= MAX_ALARMS);
+  }
+  if (!alarmRinging) {
+    FUZZ_CHECK(!hal_linux_pin(LED_PIN));
+    FUZZ_CHECK(!hal_linux_pin(BUZZER_PIN));
+  }
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    FUZZ_CHECK(settings.alarms[i].hour >= 0 && settings.alarms[i].hour < 24);
+    FUZZ_CHECK(settings.alarms[i].minute >= 0 && settings.alarms[i].minute < 60);
+  }
+  float tz = settings.timeZoneOffset;
+  FUZZ_CHECK(tz >= -12 && tz <= 12 && tz * 2 == floorf(tz * 2));
+}
+
+static long minute_of(const struct tm& t) {
+  return ((t.tm_year * 366L + t.tm_yday) * 24 + t.tm_hour) * 60 + t.tm_min;
+}
+
+// After a loop() that started with no alarm and no menu at clockStart
+static void check_alarm_rang(time_t clockStart) {
+  // The clock as loop() read it, in the time zone it may have just applied
+  struct tm t;
+  localtime_r(&clockStart, &t);
+  long minute = minute_of(t);
+  if (alarmRinging) {
+    lastRangMinute = minute;
+    return;
+  }
+  if (minute == lastRangMinute) return;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    const Alarm& a = settings.alarms[i];
+    FUZZ_CHECK(!(a.active && a.hour == t.tm_hour && a.minute == t.tm_min));
+  }
+}
+
+static void run_loop() {
+  struct tm local;
+  bool idle = hal_local_time(&local) && !alarmRinging && !alarmSnoozing && !menu_active();
+  time_t clockStart = mktime(&local);
+  uint32_t virtualStart = hal_millis();
+  double hostStart = host_ms();
+  loop();
+  FUZZ_CHECK(host_ms() - hostStart <= STEP_HOST_MS);
+  FUZZ_CHECK(hal_millis() - virtualStart <= STEP_VIRTUAL_MS);
+  check_state();
+  if (idle) check_alarm_rang(clockStart);
+  if (hal_local_time(&local) && mktime(&local) > latestTime) latestTime = mktime(&local);
+}
+
+// Lets time pass with loop() running, as on the device; loop()'s own
+// delays count towards it
+static void pass_ms(uint32_t ms) {
+  uint32_t end = hal_millis() + ms;
+  while ((int32_t)(hal_millis() - end) < 0) {
+    hal_linux_advance_us(TICK_MS * 1000);
+    run_loop();
+  }
+}
+
+static void press(uint8_t pin, uint8_t arg) {
+  uint32_t holdMs = 40 + (arg & 7) * (arg & 8 ? BUTTON_HOLD_MS : TICK_MS);
+  hal_linux_set_pin(pin, false);
+  pass_ms(holdMs);
+  hal_linux_set_pin(pin, true);
+  pass_ms(BUTTON_DEBOUNCE_MS + TICK_MS);
+}
+
+static void set_clock(uint8_t arg) {
+  struct tm local;
+  hal_local_time(&local);
+  if (arg & 1) {
+    const Alarm& a = settings.alarms[(arg >> 1) & 1];
+    local.tm_hour = a.hour;
+    local.tm_min = a.minute;
+  } else {
+    int minute = (arg >> 1) * 12;
+    local.tm_hour = minute / 60;
+    local.tm_min = minute % 60;
+  }
+  local.tm_sec = 0;
+  local.tm_isdst = -1;
+  hal_linux_set_time(mktime(&local));
+}
+
+static void pass_days(uint8_t arg) {
+  struct tm local;
+  hal_local_time(&local);
+  local.tm_mday += arg % 7 + 1;
+  local.tm_isdst = -1;
+  hal_linux_set_time(mktime(&local));
+}
+
+static void set_sensor(uint8_t arg) {
+  if (arg == 255) {
+    hal_linux_set_sensor(NAN, NAN);
+  } else {
+    hal_linux_set_sensor(15 + (arg & 15) * 1.5f, 50 + (arg >> 4) * 3.0f);
+  }
+}
+
+// What a client of /api/alarms does
+static void network_alarm(uint8_t arg) {
+  int slot = arg & 1;
+  settings_lock();
+  settings.alarms[slot].active = arg & 2;
+  settings.alarms[slot].hour = (arg >> 2) % 24;
+  settings.alarms[slot].minute = (arg * 7) % 60;
+  settings_commit_alarms(1u << slot);
+  settings_unlock();
+}
+
+// Back to the clock screen with the settings setup() left, through the
+// same inputs a user has: CANCEL stops an alarm, a snooze runs out
+static void reset() {
+  for (uint8_t pin : buttonPins) hal_linux_set_pin(pin, true);
+  for (int i = 0; i < 4 && (alarmRinging || alarmSnoozing); i++) {
+    for (int j = 0; j < 10 && alarmSnoozing; j++) {
+      hal_linux_advance_us(60 * 1000000u);
+      run_loop();
+    }
+    if (alarmRinging) press(BTN_CANCEL, 0);
+  }
+  FUZZ_CHECK(!alarmRinging && !alarmSnoozing);
+  static const ButtonEvent cancel = {CANCEL_BTN, 1, false, 0};
+  for (int i = 0; i < MENU_DEPTH + 1 && menu_active(); i++) menu_handle(cancel);
+  FUZZ_CHECK(!menu_active());
+
+  settings_lock();
+  memcpy(settings.alarms, defaultAlarms, sizeof(defaultAlarms));
+  settings.timeZoneOffset = defaultTimeZone;
+  settings_commit_alarms((1u << MAX_ALARMS) - 1);
+  settings_changed();
+  settings_unlock();
+
+  hal_linux_set_sensor(28, 70);
+  hal_linux_virtual_time(true);
+  long day = latestTime > FUZZ_START_TIME ? (latestTime - FUZZ_START_TIME) / 86400 + 1 : 0;
+  if (day > FUZZ_WRAP_DAYS) day = 0;
+  hal_linux_set_time(FUZZ_START_TIME + day * 86400);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  static bool started = false;
+  if (!started) {
+    // The firmware's Serial output would drown the fuzzer's
+    if (freopen("/dev/null", "w", stdout) == NULL) return 0;
+    hal_linux_virtual_time(true);
+    hal_linux_set_time(FUZZ_START_TIME);
+    setup();
+    memcpy(defaultAlarms, settings.alarms, sizeof(defaultAlarms));
+    defaultTimeZone = settings.timeZoneOffset;
+    started = true;
+  }
+  step = 0;
+  reset();
+
+  for (; step < MAX_STEPS && step * 2 + 1 < size; step++) {
+    uint8_t op = data[step * 2] % 9;
+    uint8_t arg = data[step * 2 + 1];
+    switch (op) {
+      case 0: case 1: case 2: case 3: press(buttonPins[op], arg); break;
+      case 4: pass_ms(arg * 2000u); break;
+      case 5: set_clock(arg); run_loop(); break;
+      case 6: set_sensor(arg); run_loop(); break;
+      case 7: network_alarm(arg); run_loop(); break;
+      case 8: pass_days(arg); run_loop(); break;
+    }
+  }
+  reset();
+  return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+static bool replay_file(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) return false;
+  static uint8_t buf[MAX_STEPS * 2];
+  size_t len = fread(buf, 1, sizeof(buf), f);
+  fclose(f);
+  LLVMFuzzerTestOneInput(buf, len);
+  fprintf(stderr, "%s: ok\n", path);
+  return true;
+}
+
+// Replays files, and the files in directories, like libFuzzer without
+// fuzzing
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    struct stat st;
+    if (stat(argv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+      DIR* dir = opendir(argv[i]);
+      for (struct dirent* e; dir != NULL && (e = readdir(dir)) != NULL;) {
+        if (e->d_name[0] == '.') continue;
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", argv[i], e->d_name);
+        replay_file(path);
+      }
+      if (dir != NULL) closedir(dir);
+    } else if (!replay_file(argv[i])) {
+      fprintf(stderr, "%s: cannot read\n", argv[i]);
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,192 @@
+/*
+ * Medibox - hardware abstraction layer on the host (see hal_linux.h)
+ */
+
+#include "hal_linux.h"
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <Wire.h>
+
+static bool virtualClock = false;
+static uint64_t virtualUs = 0;
+static uint64_t hostStartUs = 0;
+
+// Wall clock: wallBase at clock reading wallBaseUs
+static time_t wallBase = 0;
+static uint64_t wallBaseUs = 0;
+static bool wallStarted = false;
+
+struct Pin {
+  bool high;
+  HalPinHandler handler;
+  void* arg;
+};
+
+static Pin pins[HAL_LINUX_PINS];
+static bool pinsStarted = false;
+
+static float sensorTemperature = 28.0f;
+static float sensorHumidity = 70.0f;
+
+static HalNetworkHandler networkHandler = NULL;
+static bool autoconnect = true;
+static char networkSsid[33] = "";
+static uint32_t randomState = 2463534242u;
+
+static uint64_t host_us() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t now_us() {
+  if (virtualClock) return virtualUs;
+  if (hostStartUs == 0) hostStartUs = host_us();
+  return host_us() - hostStartUs;
+}
+
+// Inputs idle high, as with the pull-ups on the board
+static void start_pins() {
+  if (pinsStarted) return;
+  for (Pin& p : pins) p.high = true;
+  pinsStarted = true;
+}
+
+static Pin* pin_at(uint8_t pin) {
+  start_pins();
+  return pin < HAL_LINUX_PINS ? &pins[pin] : NULL;
+}
+
+uint32_t hal_millis() {
+  return (uint32_t)(now_us() / 1000);
+}
+
+uint32_t hal_micros() {
+  return (uint32_t)now_us();
+}
+
+void hal_delay(uint32_t ms) {
+  if (virtualClock) {
+    virtualUs += (uint64_t)ms * 1000;
+  } else {
+    usleep(ms * 1000);
+  }
+}
+
+bool hal_local_time(struct tm* out) {
+  if (!wallStarted) hal_linux_set_time(time(NULL));
+  if (wallBase == 0) return false;
+  time_t now = wallBase + (time_t)((now_us() - wallBaseUs) / 1000000);
+  return localtime_r(&now, out) != NULL;
+}
+
+void hal_pin_mode(uint8_t pin, HalPinMode mode) {
+  Pin* p = pin_at(pin);
+  if (p != NULL && mode == HAL_INPUT_PULLUP) p->high = true;
+}
+
+bool hal_pin_read(uint8_t pin) {
+  Pin* p = pin_at(pin);
+  return p != NULL && p->high;
+}
+
+void hal_pin_write(uint8_t pin, bool high) {
+  Pin* p = pin_at(pin);
+  if (p != NULL) p->high = high;
+}
+
+void hal_pin_on_falling(uint8_t pin, HalPinHandler handler, void* arg) {
+  Pin* p = pin_at(pin);
+  if (p == NULL) return;
+  p->handler = handler;
+  p->arg = arg;
+}
+
+TwoWire* hal_display_bus() {
+  return &Wire;
+}
+
+void hal_sensor_begin() {
+}
+
+bool hal_sensor_read(float* temperature, float* humidity) {
+  *temperature = sensorTemperature;
+  *humidity = sensorHumidity;
+  return !isnan(sensorTemperature) && !isnan(sensorHumidity);
+}
+
+void hal_network_begin(HalNetworkHandler handler) {
+  networkHandler = handler;
+}
+
+void hal_network_connect(const char* ssid, const char* password) {
+  (void)password;
+  strncpy(networkSsid, ssid, sizeof(networkSsid) - 1);
+  if (autoconnect) hal_linux_network_event(HAL_NETWORK_GOT_IP);
+}
+
+void hal_network_disconnect() {
+  networkSsid[0] = '\0';
+}
+
+// xorshift32, the same sequence on every run
+uint32_t hal_random() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void hal_linux_virtual_time(bool on) {
+  // The wall clock carries on from where it was
+  if (wallStarted && wallBase != 0) wallBase += (time_t)((now_us() - wallBaseUs) / 1000000);
+  virtualClock = on;
+  virtualUs = 0;
+  wallBaseUs = now_us();
+}
+
+void hal_linux_advance_us(uint32_t us) {
+  if (virtualClock) virtualUs += us;
+}
+
+void hal_linux_set_time(time_t utc) {
+  wallStarted = true;
+  wallBase = utc;
+  wallBaseUs = now_us();
+}
+
+void hal_linux_set_pin(uint8_t pin, bool high) {
+  Pin* p = pin_at(pin);
+  if (p == NULL) return;
+  bool falling = p->high && !high;
+  p->high = high;
+  if (falling && p->handler != NULL) p->handler(p->arg);
+}
+
+bool hal_linux_pin(uint8_t pin) {
+  return hal_pin_read(pin);
+}
+
+void hal_linux_set_sensor(float temperature, float humidity) {
+  sensorTemperature = temperature;
+  sensorHumidity = humidity;
+}
+
+void hal_linux_network_autoconnect(bool on) {
+  autoconnect = on;
+}
+
+void hal_linux_network_event(HalNetworkEvent event) {
+  if (networkHandler != NULL) networkHandler(event);
+}
+
+const char* hal_linux_network_ssid() {
+  return networkSsid;
+}
+
+void hal_linux_bus_stats(HalLinuxBusStats* out) {
+  out->transactions = Wire.transactions;
+  out->bytes = Wire.bytes;
+}
@@ -0,0 +1,134 @@
+/*
+ * Medibox - runs the firmware on the host (native environment)
+ *
+ * Calls setup() and then loop() like the Arduino core, shows the OLED in
+ * the terminal whenever its content changes and turns keys into button
+ * presses:
+ *
+ *   w  UP      s  DOWN      Enter  OK      x  CANCEL
+ *
+ * Anything else goes to the firmware's Serial input ('l' prints the
+ * latency summary). Serial output scrolls below the display. Ctrl-C quits.
+ *
+ *   pio run -e native && .pio/build/native/program
+ */
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "board.h"
+#include "hal_linux.h"
+
+// main.cpp
+void setup();
+void loop();
+extern Adafruit_SSD1306 display;
+
+#define PRESS_MS 100          // Held long enough to get past the debounce
+#define LOOP_SLEEP_US 5000    // The device's loop is paced by the I2C flush
+#define FRAME_LINES 33        // 64 pixel rows at two per line, and a rule
+
+// Unit tests bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+static struct termios savedTerm;
+static bool terminal = false;
+static int pressedPin = -1;
+static uint32_t releaseAt = 0;
+static uint8_t shown[128 * 64 / 8];   // The largest SSD1306
+
+static void restore_terminal() {
+  if (!terminal) return;
+  tcsetattr(0, TCSANOW, &savedTerm);
+  // Full-screen scrolling again
+  static const char reset[] = "\033[r\n";
+  (void)write(1, reset, sizeof(reset) - 1);
+}
+
+static void on_interrupt(int) {
+  restore_terminal();
+  _exit(0);
+}
+
+// Keys without Enter, no echo, Serial output below the display
+static void start_terminal() {
+  if (!isatty(0) || !isatty(1) || tcgetattr(0, &savedTerm) != 0) return;
+  struct termios raw = savedTerm;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  tcsetattr(0, TCSANOW, &raw);
+  terminal = true;
+  atexit(restore_terminal);
+  signal(SIGINT, on_interrupt);
+  printf("\033[2J\033[%d;r\033[%d;1H", FRAME_LINES + 1, FRAME_LINES + 1);
+}
+
+static void press(int pin) {
+  if (pressedPin >= 0) hal_linux_set_pin(pressedPin, true);
+  pressedPin = pin;
+  hal_linux_set_pin(pin, false);
+  releaseAt = hal_millis() + PRESS_MS;
+}
+
+static void read_keys() {
+  struct pollfd in = {0, POLLIN, 0};
+  char c;
+  while (poll(&in, 1, 0) > 0 && (in.revents & POLLIN) && read(0, &c, 1) == 1) {
+    switch (c) {
+      case 'w': press(BTN_UP); break;
+      case 's': press(BTN_DOWN); break;
+      case '\n':
+      case '\r': press(BTN_OK); break;
+      case 'x': press(BTN_CANCEL); break;
+      default: Serial.feed(c); break;
+    }
+  }
+  if (pressedPin >= 0 && (int32_t)(hal_millis() - releaseAt) >= 0) {
+    hal_linux_set_pin(pressedPin, true);
+    pressedPin = -1;
+  }
+}
+
+// The SSD1306 buffer holds 8 rows per byte, a page of bytes per 8 rows
+static bool pixel(const uint8_t* buf, int x, int y) {
+  return buf[x + (y / 8) * display.width()] & (1 << (y & 7));
+}
+
+// Two pixel rows per line with half blocks
+static void show_display() {
+  const uint8_t* buf = display.getBuffer();
+  size_t len = display.width() * display.height() / 8;
+  if (buf == NULL || len > sizeof(shown) || memcmp(buf, shown, len) == 0) return;
+  memcpy(shown, buf, len);
+
+  static const char* const blocks[] = {" ", "▀", "▄", "█"};
+  if (terminal) printf("\0337\033[H");
+  for (int y = 0; y < display.height(); y += 2) {
+    for (int x = 0; x < display.width(); x++) {
+      fputs(blocks[pixel(buf, x, y) | pixel(buf, x, y + 1) << 1], stdout);
+    }
+    fputc('\n', stdout);
+  }
+  for (int x = 0; x < display.width(); x++) fputs("─", stdout);
+  fputc('\n', stdout);
+  if (terminal) printf("\0338");
+}
+
+int main() {
+  start_terminal();
+  setup();
+  for (;;) {
+    read_keys();
+    loop();
+    show_display();
+    fflush(stdout);
+    usleep(LOOP_SLEEP_US);
+  }
+}
+#endif
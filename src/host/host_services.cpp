@@ -0,0 +1,87 @@
+/*
+ * Medibox - host stand-ins for the services that need the ESP-IDF
+ *
+ * Telemetry, the REST API and dashboard, flash partitions and SNTP sit on
+ * lwIP and the IDF, so on the host they do nothing and the firmware runs
+ * offline: nothing is published, no history is kept, and the wall clock
+ * is the host's. The timezone is applied the same way as on the device.
+ * The HTTP server itself builds on the host for its tests, but nothing
+ * starts it.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc_stats.h"
+#include "dashboard.h"
+#include "flash_storage.h"
+#include "mem_monitor.h"
+#include "mqtt_telemetry.h"
+#include "rest_api.h"
+#include "sensor_log.h"
+#include "telemetry.h"
+#include "time_sync.h"
+#include "udp_telemetry.h"
+
+void telemetry_begin() {}
+void telemetry_sensor_sample(float temperature, float humidity) {}
+void telemetry_adherence(int alarmNum, AdherenceEvent event, uint16_t responseSec) {}
+void mqtt_telemetry_begin() {}
+void udp_telemetry_begin() {}
+void rest_api_begin() {}
+
+void dashboard_begin(const uint8_t* framebuffer, size_t fbLen) {}
+void dashboard_update_sensor(float temperature, float humidity) {}
+void dashboard_update_alarm(bool ringing, bool snoozing, int ringingNum) {}
+
+const FlashStorage* flash_storage_partition(const char* label) {
+  return NULL;
+}
+
+bool sensor_log_begin(const FlashStorage* storage) {
+  return false;
+}
+
+void sensor_log_sample(float temperature, float humidity) {}
+
+void time_sync_begin(const char* server, float tzHours) {
+  time_sync_set_timezone(tzHours);
+}
+
+void time_sync_set_timezone(float tzHours) {
+  int minutes = (int)lroundf(tzHours * 60.0f);
+  char sign = minutes >= 0 ? '-' : '+';   // POSIX TZ offsets are inverted
+  if (minutes < 0) minutes = -minutes;
+
+  char tz[16];
+  snprintf(tz, sizeof(tz), "UTC%c%d:%02d", sign, minutes / 60, minutes % 60);
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+void time_sync_loop() {}
+
+// The malloc wrappers are an ESP32 link option
+void alloc_stats_watch_current_task() {}
+
+uint32_t alloc_stats_task_allocs() {
+  return 0;
+}
+
+// Heap and stack figures come from the IDF heap and FreeRTOS
+void mem_monitor_begin() {}
+void mem_monitor_watch_current_task(MemTask task) {}
+void mem_monitor_forget_task(MemTask task) {}
+void mem_monitor_loop() {}
+
+MemAlert mem_monitor_alert(uint8_t* reasons) {
+  if (reasons != NULL) *reasons = 0;
+  return MEM_OK;
+}
+
+void mem_monitor_report(Print& out) {
+  out.println("Memory: not monitored on the host");
+}
@@ -0,0 +1,61 @@
+/*
+ * Medibox - scripted input device for host tests (see input_script.h)
+ */
+
+#include "input_script.h"
+
+#include <stddef.h>
+
+#include "hal.h"
+
+static ButtonEvent poll(void* ctx) {
+  InputScript* script = (InputScript*)ctx;
+  ButtonEvent ev = {NONE, 0, false, 0};
+  if (script->count == 0) return ev;
+  ev = script->events[script->head];
+  script->head = (script->head + 1) % INPUT_SCRIPT_MAX;
+  script->count--;
+  if (ev.button != NONE && ev.atUs == 0) ev.atUs = hal_micros();
+  return ev;
+}
+
+const InputDevice* input_script_begin(InputScript* script, const char* name) {
+  script->device.name = name;
+  script->device.ctx = script;
+  script->device.poll = poll;
+  input_script_clear(script);
+  return &script->device;
+}
+
+bool input_script_push(InputScript* script, const ButtonEvent& ev) {
+  if (script->count == INPUT_SCRIPT_MAX) return false;
+  script->events[(script->head + script->count) % INPUT_SCRIPT_MAX] = ev;
+  script->count++;
+  return true;
+}
+
+bool input_script_press(InputScript* script, Button button) {
+  ButtonEvent ev = {button, 1, false, 0};
+  return input_script_push(script, ev);
+}
+
+bool input_script_burst(InputScript* script, Button button, uint8_t count) {
+  ButtonEvent ev = {button, count, true, 0};
+  return input_script_push(script, ev);
+}
+
+bool input_script_idle(InputScript* script, uint8_t polls) {
+  ButtonEvent ev = {NONE, 0, false, 0};
+  if (script->count + polls > INPUT_SCRIPT_MAX) return false;
+  while (polls--) input_script_push(script, ev);
+  return true;
+}
+
+uint8_t input_script_pending(const InputScript* script) {
+  return script->count;
+}
+
+void input_script_clear(InputScript* script) {
+  script->head = 0;
+  script->count = 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Medibox - replays UI input macros on the host (macro_replay environment)
+ *
+ * Boots the firmware under virtual time and replays each macro file given
+ * (the .macro files in tools/macros/, as tools/ui_replay.py records them)
+ * through macro_append() and macro_replay(), in order and in one
+ * session, as the device does over /api/macro. loop() runs every
+ * TICK_MS, so the frames and bytes each step sends to the display come
+ * out the same on every run and every machine. Latencies are in virtual
+ * time and only show delays the firmware waits out, not how long drawing
+ * takes.
+ *
+ * Results go to a JSON file; tools/ui_replay.py native compares them
+ * against tools/macros/native/<macro>.baseline.json.
+ *
+ *   pio run -e macro_replay
+ *   .pio/build/macro_replay/program replay.json tools/macros/set_alarm.macro
+ */
+
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_linux.h"
+#include "input_macro.h"
+#include "json_writer.h"
+
+// main.cpp
+void setup();
+void loop();
+
+#define TICK_MS 10
+#define REPLAY_START_TIME 1760000000
+#define MAX_REPLAY_MS (10 * 60 * 1000)   // Per macro, settling included
+
+struct Replay {
+  char name[48];
+  size_t steps;
+  MacroStep step[MACRO_MAX_STEPS];
+  MacroResult result[MACRO_MAX_STEPS];
+};
+
+static Replay replays[16];
+static size_t replayCount = 0;
+
+// "set_alarm" for "tools/macros/set_alarm.macro"
+static void macro_name(const char* path, char* out, size_t len) {
+  const char* base = strrchr(path, '/');
+  base = base != NULL ? base + 1 : path;
+  snprintf(out, len, "%s", base);
+  char* dot = strrchr(out, '.');
+  if (dot != NULL) *dot = '\0';
+}
+
+// <ms> <button> [count] [repeat] per line, # starts a comment
+static bool load_macro(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (f == NULL) {
+    fprintf(stderr, "%s: cannot read\n", path);
+    return false;
+  }
+  macro_clear();
+  char line[128];
+  bool ok = true;
+  for (int number = 1; ok && fgets(line, sizeof(line), f) != NULL; number++) {
+    char* hash = strchr(line, '#');
+    if (hash != NULL) *hash = '\0';
+    char button[16], repeat[16] = "";
+    unsigned long at;
+    unsigned count = 1;
+    int fields = sscanf(line, "%lu %15s %u %15s", &at, button, &count, repeat);
+    if (fields <= 0) continue;
+    MacroStep step = {};
+    step.atMs = at;
+    step.event.count = count;
+    step.event.repeat = strcmp(repeat, "repeat") == 0;
+    ok = fields >= 2 && count > 0 && count <= 255 &&
+         macro_parse_button(button, &step.event.button) && (fields < 4 || step.event.repeat) &&
+         macro_append(step);
+    if (!ok) fprintf(stderr, "%s:%d: bad step\n", path, number);
+  }
+  fclose(f);
+  return ok && macro_step_count() > 0;
+}
+
+static bool replay(const char* path) {
+  if (replayCount == sizeof(replays) / sizeof(replays[0]) || !load_macro(path)) return false;
+  if (!macro_replay()) return false;
+  uint32_t start = hal_millis();
+  while (macro_state() == MACRO_REPLAYING) {
+    if (hal_millis() - start > MAX_REPLAY_MS) {
+      fprintf(stderr, "%s: replay did not finish\n", path);
+      return false;
+    }
+    hal_linux_advance_us(TICK_MS * 1000);
+    loop();
+  }
+
+  Replay& r = replays[replayCount++];
+  macro_name(path, r.name, sizeof(r.name));
+  r.steps = macro_step_count();
+  for (size_t i = 0; i < r.steps; i++) macro_step(i, &r.step[i], &r.result[i]);
+  return true;
+}
+
+static bool write_file(void* ctx, const char* data, size_t len) {
+  return fwrite(data, 1, len, (FILE*)ctx) == len;
+}
+
+static bool write_json(const char* path) {
+  FILE* f = fopen(path, "w");
+  if (f == NULL) return false;
+  char buf[256];
+  JsonWriter json(buf, sizeof(buf), write_file, f);
+  json.begin_object();
+  json.key("macros");
+  json.begin_object();
+  for (size_t i = 0; i < replayCount; i++) {
+    const Replay& r = replays[i];
+    uint32_t frames = 0, bytes = 0;
+    json.key(r.name);
+    json.begin_object();
+    json.key("steps");
+    json.begin_array();
+    for (size_t s = 0; s < r.steps; s++) {
+      json.begin_object();
+      json.key("at");
+      json.value(r.step[s].atMs);
+      json.key("button");
+      json.value(macro_button_name(r.step[s].event.button));
+      json.key("us");
+      json.value(r.result[s].latencyUs);
+      json.key("frames");
+      json.value((uint32_t)r.result[s].frames);
+      json.key("bytes");
+      json.value(r.result[s].bytes);
+      json.end_object();
+      frames += r.result[s].frames;
+      bytes += r.result[s].bytes;
+    }
+    json.end_array();
+    json.key("frames");
+    json.value(frames);
+    json.key("bytes");
+    json.value(bytes);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+  bool ok = json.flush() && fputc('\n', f) != EOF;
+  return fclose(f) == 0 && ok;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <results.json> <macro>...\n", argv[0]);
+    return 2;
+  }
+  // The firmware's Serial output would bury the results
+  if (freopen("/dev/null", "w", stdout) == NULL) return 1;
+  hal_linux_virtual_time(true);
+  hal_linux_set_time(REPLAY_START_TIME);
+  hal_linux_set_sensor(28, 70);
+  setup();
+
+  for (int i = 2; i < argc; i++) {
+    if (!replay(argv[i])) return 1;
+    const Replay& r = replays[replayCount - 1];
+    uint32_t frames = 0, bytes = 0;
+    for (size_t s = 0; s < r.steps; s++) {
+      frames += r.result[s].frames;
+      bytes += r.result[s].bytes;
+    }
+    fprintf(stderr, "%s: %u steps, %u frames, %u bytes\n", r.name, (unsigned)r.steps,
+            (unsigned)frames, (unsigned)bytes);
+  }
+  if (!write_json(argv[1])) {
+    fprintf(stderr, "%s: cannot write results\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
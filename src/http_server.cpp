@@ -0,0 +1,613 @@
+/*
+ * Medibox - embedded HTTP/1.1 server (see http_server.h)
+ */
+
+#include "http_server.h"
+
+#include <Arduino.h>
+#include <esp_system.h>
+#include <lwip/sockets.h>
+#include <mbedtls/sha1.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "mem_monitor.h"
+#include "metrics.h"
+
+#define SERVER_STACK 6144
+#define SELECT_TIMEOUT_MS 100
+#define SEND_TIMEOUT_S 2
+#define CHUNK_HEADER 8   // room for "1ff\r\n" in front of each chunk
+#define CHUNK_TRAILER 2  // "\r\n" after each chunk
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_OP_CLOSE 0x8
+#define WS_OP_PING 0x9
+#define WS_OP_PONG 0xA
+
+enum ParseState {
+  PARSE_REQUEST_LINE,
+  PARSE_HEADERS,
+  PARSE_BODY,
+  PARSE_WS     // Upgraded: incoming bytes are WebSocket frames
+};
+
+enum WsClientState {
+  WS_NONE,
+  WS_NEW,      // Needs a full keyframe before any delta
+  WS_SYNCED
+};
+
+struct Connection {
+  int fd;
+  ParseState state;
+  char line[HTTP_MAX_LINE];
+  size_t lineLen;
+  bool lineTooLong;
+  size_t bodyRead;
+  unsigned long lastActivity;
+  HttpRequest req;
+  // Incoming WebSocket frame, control payloads are kept in line[]
+  WsClientState ws;
+  uint8_t wsHeader[14];
+  size_t wsHeaderLen;
+  bool wsInPayload;
+  size_t wsPayloadLen;
+  size_t wsPayloadRead;
+};
+
+static int listenFd = -1;
+static HttpHandler requestHandler = NULL;
+static Connection conns[HTTP_MAX_CLIENTS];
+static char txBuffer[HTTP_TX_BUFFER];   // Shared: requests are served one at a time
+static HttpStats stats = {};
+
+static MetricCounter requestsMetric("medibox_http_requests_total", "HTTP requests served",
+                                    [] { return stats.requests; });
+// Request parsed to response handed to the socket, i.e. the device's share
+// of time-to-first-byte
+METRIC_HISTOGRAM(handlerTime, "medibox_http_handler_us", "Time spent in the request handler",
+                 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 100000);
+static MetricCounter bytesMetric("medibox_http_sent_bytes_total", "HTTP response bytes sent",
+                                 [] { return stats.bytesSent; });
+static HttpTick tickHook = NULL;
+static uint32_t tickPeriodMs = 0;
+
+const char* http_status_text(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 422: return "Unprocessable Entity";
+    default: return "Internal Server Error";
+  }
+}
+
+bool http_query_param(const HttpRequest& req, const char* name, char* out, size_t cap) {
+  size_t nameLen = strlen(name);
+  for (const char* p = req.query; *p != '\0';) {
+    const char* end = strchr(p, '&');
+    if (end == NULL) end = p + strlen(p);
+    if ((size_t)(end - p) > nameLen && strncmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+      const char* value = p + nameLen + 1;
+      if ((size_t)(end - value) >= cap) return false;
+      memcpy(out, value, end - value);
+      out[end - value] = '\0';
+      return true;
+    }
+    p = *end == '&' ? end + 1 : end;
+  }
+  return false;
+}
+
+HttpResponse::HttpResponse(int fd, char* buf, size_t cap, bool keepAlive)
+    : fd(fd), buf(buf), cap(cap), keepAlive(keepAlive), error(false),
+      writer(buf + CHUNK_HEADER, cap - CHUNK_HEADER - CHUNK_TRAILER, send_chunk, this) {}
+
+bool HttpResponse::send_all(const char* data, size_t len) {
+  while (len > 0 && !error) {
+    int n = send(fd, data, len, 0);
+    if (n <= 0) {
+      error = true;
+      break;
+    }
+    data += n;
+    len -= n;
+    stats.bytesSent += n;
+  }
+  return !error;
+}
+
+// The writer's buffer sits inside ours, so the chunk framing is written
+// around the data in place and the whole chunk goes out in one send()
+bool HttpResponse::send_chunk(void* ctx, const char* data, size_t len) {
+  HttpResponse* self = (HttpResponse*)ctx;
+  char head[CHUNK_HEADER + 1];
+  int headLen = snprintf(head, sizeof(head), "%x\r\n", (unsigned)len);
+  char* start = (char*)data - headLen;
+  memcpy(start, head, headLen);
+  char* tail = (char*)data + len;
+  tail[0] = '\r';
+  tail[1] = '\n';
+  return self->send_all(start, headLen + len + CHUNK_TRAILER);
+}
+
+void HttpResponse::send_status(int status) {
+  int n = snprintf(buf, cap,
+                   "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: %s\r\n"
+                   "Access-Control-Allow-Origin: *\r\n\r\n",
+                   status, http_status_text(status), keepAlive ? "keep-alive" : "close");
+  send_all(buf, n);
+}
+
+void HttpResponse::send_gzip(const char* contentType, const char* etag, const uint8_t* data,
+                             size_t len) {
+  int n = snprintf(buf, cap,
+                   "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Encoding: gzip\r\n"
+                   "Content-Length: %u\r\nETag: %s\r\nCache-Control: no-cache\r\n"
+                   "Connection: %s\r\n\r\n",
+                   contentType, (unsigned)len, etag, keepAlive ? "keep-alive" : "close");
+  if (send_all(buf, n)) send_all((const char*)data, len);
+}
+
+void HttpResponse::send_not_modified(const char* etag) {
+  int n = snprintf(buf, cap,
+                   "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nCache-Control: no-cache\r\n"
+                   "Connection: %s\r\n\r\n",
+                   etag, keepAlive ? "keep-alive" : "close");
+  send_all(buf, n);
+}
+
+void HttpResponse::begin_stream(int status, const char* contentType) {
+  int n = snprintf(buf, cap,
+                   "HTTP/1.1 %d %s\r\nContent-Type: %s\r\n"
+                   "Transfer-Encoding: chunked\r\nConnection: %s\r\n"
+                   "Access-Control-Allow-Origin: *\r\n\r\n",
+                   status, http_status_text(status), contentType,
+                   keepAlive ? "keep-alive" : "close");
+  send_all(buf, n);
+}
+
+JsonWriter& HttpResponse::begin_json(int status) {
+  begin_stream(status, "application/json");
+  return writer;
+}
+
+bool HttpResponse::write(const char* data, size_t len) {
+  writer.raw(data, len);
+  return !error && !writer.overflowed();
+}
+
+void HttpResponse::end() {
+  writer.flush();
+  send_all("0\r\n\r\n", 5);
+}
+
+static void reset_request(Connection& c) {
+  c.state = PARSE_REQUEST_LINE;
+  c.lineLen = 0;
+  c.lineTooLong = false;
+  c.bodyRead = 0;
+  c.req.method = HTTP_UNKNOWN;
+  c.req.path[0] = '\0';
+  c.req.query = c.req.path;
+  c.req.contentLength = 0;
+  c.req.keepAlive = true;
+  c.req.wsUpgrade = false;
+  c.req.wsKey[0] = '\0';
+  c.req.ifNoneMatch[0] = '\0';
+  c.req.body.reset();
+}
+
+static void close_conn(Connection& c) {
+  if (c.fd >= 0) {
+    close(c.fd);
+    c.fd = -1;
+    stats.activeClients--;
+    if (c.ws != WS_NONE) stats.wsClients--;
+    c.ws = WS_NONE;
+  }
+}
+
+static void reject(Connection& c, int status) {
+  HttpResponse res(c.fd, txBuffer, sizeof(txBuffer), false);
+  res.send_status(status);
+  stats.errors++;
+  close_conn(c);
+}
+
+static void dispatch(Connection& c) {
+  HttpResponse res(c.fd, txBuffer, sizeof(txBuffer), c.req.keepAlive);
+  stats.requests++;
+  uint32_t start = micros();
+  requestHandler(c.req, res);
+  handlerTime.observe(micros() - start);
+
+  uint32_t freeHeap = esp_get_free_heap_size();
+  if (stats.minFreeHeap == 0 || freeHeap < stats.minFreeHeap) {
+    stats.minFreeHeap = freeHeap;
+  }
+
+  if (res.failed() || !c.req.keepAlive) {
+    close_conn(c);
+  } else {
+    reset_request(c);
+  }
+}
+
+static HttpMethod parse_method(const char* s, size_t len) {
+  if (len == 3 && memcmp(s, "GET", 3) == 0) return HTTP_GET;
+  if (len == 4 && memcmp(s, "POST", 4) == 0) return HTTP_POST;
+  if (len == 3 && memcmp(s, "PUT", 3) == 0) return HTTP_PUT;
+  if (len == 6 && memcmp(s, "DELETE", 6) == 0) return HTTP_DELETE;
+  if (len == 5 && memcmp(s, "PATCH", 5) == 0) return HTTP_PATCH;
+  return HTTP_UNKNOWN;
+}
+
+// "GET /api/alarms HTTP/1.1"
+static bool parse_request_line(Connection& c) {
+  char* sp1 = (char*)memchr(c.line, ' ', c.lineLen);
+  if (sp1 == NULL) return false;
+  char* path = sp1 + 1;
+  char* sp2 = (char*)memchr(path, ' ', c.lineLen - (path - c.line));
+  if (sp2 == NULL || (size_t)(sp2 - path) >= HTTP_MAX_PATH) return false;
+
+  c.req.method = parse_method(c.line, sp1 - c.line);
+  memcpy(c.req.path, path, sp2 - path);
+  c.req.path[sp2 - path] = '\0';
+  char* query = strchr(c.req.path, '?');
+  if (query != NULL) {
+    *query = '\0';
+    c.req.query = query + 1;
+  } else {
+    c.req.query = c.req.path + (sp2 - path);
+  }
+  // HTTP/1.0 closes by default
+  c.req.keepAlive = strncmp(sp2 + 1, "HTTP/1.0", 8) != 0;
+  return true;
+}
+
+static void parse_header(Connection& c) {
+  char* colon = (char*)memchr(c.line, ':', c.lineLen);
+  if (colon == NULL) return;
+  *colon = '\0';
+  const char* value = colon + 1;
+  while (*value == ' ') value++;
+
+  if (strcasecmp(c.line, "Content-Length") == 0) {
+    c.req.contentLength = strtoul(value, NULL, 10);
+  } else if (strcasecmp(c.line, "Connection") == 0) {
+    if (strncasecmp(value, "close", 5) == 0) c.req.keepAlive = false;
+    else if (strncasecmp(value, "keep-alive", 10) == 0) c.req.keepAlive = true;
+  } else if (strcasecmp(c.line, "Upgrade") == 0) {
+    c.req.wsUpgrade = strcasecmp(value, "websocket") == 0;
+  } else if (strcasecmp(c.line, "Sec-WebSocket-Key") == 0) {
+    strncpy(c.req.wsKey, value, sizeof(c.req.wsKey) - 1);
+    c.req.wsKey[sizeof(c.req.wsKey) - 1] = '\0';
+  } else if (strcasecmp(c.line, "If-None-Match") == 0) {
+    strncpy(c.req.ifNoneMatch, value, sizeof(c.req.ifNoneMatch) - 1);
+    c.req.ifNoneMatch[sizeof(c.req.ifNoneMatch) - 1] = '\0';
+  }
+}
+
+static size_t base64_encode(const uint8_t* in, size_t len, char* out) {
+  static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t v = in[i] << 16;
+    if (i + 1 < len) v |= in[i + 1] << 8;
+    if (i + 2 < len) v |= in[i + 2];
+    out[o++] = table[(v >> 18) & 0x3F];
+    out[o++] = table[(v >> 12) & 0x3F];
+    out[o++] = i + 1 < len ? table[(v >> 6) & 0x3F] : '=';
+    out[o++] = i + 2 < len ? table[v & 0x3F] : '=';
+  }
+  out[o] = '\0';
+  return o;
+}
+
+// RFC 6455 handshake; the connection then only carries frames
+static void upgrade_websocket(Connection& c) {
+  char keyGuid[sizeof(c.req.wsKey) + sizeof(WS_GUID)];
+  snprintf(keyGuid, sizeof(keyGuid), "%s%s", c.req.wsKey, WS_GUID);
+  uint8_t digest[20];
+  mbedtls_sha1_ret((const uint8_t*)keyGuid, strlen(keyGuid), digest);
+  char accept[32];
+  base64_encode(digest, sizeof(digest), accept);
+
+  int n = snprintf(txBuffer, sizeof(txBuffer),
+                   "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+  if (send(c.fd, txBuffer, n, 0) != n) {
+    close_conn(c);
+    return;
+  }
+  stats.requests++;
+  stats.wsClients++;
+  c.ws = WS_NEW;
+  c.state = PARSE_WS;
+  c.wsHeaderLen = 0;
+  c.wsInPayload = false;
+}
+
+static void ws_send_control(Connection& c, uint8_t opcode, const void* data, size_t len) {
+  uint8_t frame[2 + 125];
+  frame[0] = 0x80 | opcode;
+  frame[1] = len;
+  memcpy(frame + 2, data, len);
+  if (send(c.fd, frame, 2 + len, 0) != (int)(2 + len)) {
+    close_conn(c);
+  }
+}
+
+// Client frames are only read for control opcodes; data is discarded
+static void handle_ws_byte(Connection& c, uint8_t b) {
+  if (!c.wsInPayload) {
+    c.wsHeader[c.wsHeaderLen++] = b;
+    if (c.wsHeaderLen < 2) return;
+
+    uint8_t lenCode = c.wsHeader[1] & 0x7F;
+    size_t extLen = lenCode == 126 ? 2 : lenCode == 127 ? 8 : 0;
+    size_t headerLen = 2 + extLen + ((c.wsHeader[1] & 0x80) ? 4 : 0);
+    if (c.wsHeaderLen < headerLen) return;
+
+    c.wsPayloadLen = lenCode;
+    if (extLen) {
+      c.wsPayloadLen = 0;
+      for (size_t i = 0; i < extLen; i++) c.wsPayloadLen = (c.wsPayloadLen << 8) | c.wsHeader[2 + i];
+    }
+    c.wsPayloadRead = 0;
+    c.wsInPayload = true;
+    c.lineLen = 0;
+    if (c.wsPayloadLen > 0) return;
+  } else {
+    const uint8_t* mask = c.wsHeader + c.wsHeaderLen - 4;
+    bool masked = c.wsHeader[1] & 0x80;
+    if (c.lineLen < 125) c.line[c.lineLen++] = masked ? b ^ mask[c.wsPayloadRead % 4] : b;
+    c.wsPayloadRead++;
+    if (c.wsPayloadRead < c.wsPayloadLen) return;
+  }
+
+  // Whole frame received
+  uint8_t opcode = c.wsHeader[0] & 0x0F;
+  c.wsHeaderLen = 0;
+  c.wsInPayload = false;
+  if (opcode == WS_OP_CLOSE) {
+    ws_send_control(c, WS_OP_CLOSE, NULL, 0);
+    close_conn(c);
+  } else if (opcode == WS_OP_PING) {
+    ws_send_control(c, WS_OP_PONG, c.line, c.lineLen);
+  }
+}
+
+// Returns false if the connection was closed while handling the line
+static bool handle_line(Connection& c) {
+  if (c.state == PARSE_REQUEST_LINE) {
+    if (c.lineTooLong) {
+      reject(c, 400);
+      return false;
+    }
+    if (c.lineLen == 0) return true;   // Tolerate stray CRLF between requests
+    if (!parse_request_line(c)) {
+      reject(c, 400);
+      return false;
+    }
+    c.state = PARSE_HEADERS;
+    return true;
+  }
+
+  // Browsers send Accept and User-Agent lines longer than the buffer;
+  // none of the headers we read comes close, so skip the line
+  if (c.lineLen > 0) {
+    if (!c.lineTooLong) parse_header(c);
+    return true;
+  }
+
+  // Blank line: headers done
+  if (c.req.contentLength > HTTP_MAX_BODY) {
+    reject(c, 413);
+    return false;
+  }
+  if (c.req.wsUpgrade && c.req.method == HTTP_GET && strcmp(c.req.path, HTTP_WS_PATH) == 0) {
+    upgrade_websocket(c);
+    return false;
+  }
+  if (c.req.contentLength == 0) {
+    dispatch(c);
+    return c.fd >= 0;
+  }
+  c.state = PARSE_BODY;
+  return true;
+}
+
+static void handle_bytes(Connection& c, const char* data, size_t len) {
+  for (size_t i = 0; i < len && c.fd >= 0; i++) {
+    if (c.state == PARSE_WS) {
+      handle_ws_byte(c, data[i]);
+      continue;
+    }
+    if (c.state == PARSE_BODY) {
+      size_t take = c.req.contentLength - c.bodyRead;
+      if (take > len - i) take = len - i;
+      c.req.body.feed(data + i, take);
+      c.bodyRead += take;
+      i += take - 1;
+      if (c.bodyRead == c.req.contentLength) {
+        dispatch(c);
+      }
+      continue;
+    }
+
+    char ch = data[i];
+    if (ch == '\r') continue;
+    if (ch == '\n') {
+      c.line[c.lineLen] = '\0';
+      if (!handle_line(c)) {
+        if (c.state != PARSE_WS) return;
+        continue;
+      }
+      c.lineLen = 0;
+      c.lineTooLong = false;
+    } else if (c.lineLen + 1 < HTTP_MAX_LINE) {
+      c.line[c.lineLen++] = ch;
+    } else {
+      c.lineTooLong = true;
+    }
+  }
+}
+
+static void accept_client() {
+  int fd = accept(listenFd, NULL, NULL);
+  if (fd < 0) return;
+
+  for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    if (conns[i].fd < 0) {
+      struct timeval tv = {SEND_TIMEOUT_S, 0};
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      conns[i].fd = fd;
+      conns[i].lastActivity = millis();
+      conns[i].ws = WS_NONE;
+      reset_request(conns[i]);
+      stats.activeClients++;
+      return;
+    }
+  }
+  close(fd); // All slots busy
+  stats.errors++;
+}
+
+static void server_task(void* arg) {
+  mem_monitor_watch_current_task(MEM_TASK_HTTP);
+  char rx[256];
+  unsigned long lastTick = millis();
+
+  for (;;) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(listenFd, &readable);
+    int maxFd = listenFd;
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+      if (conns[i].fd >= 0) {
+        FD_SET(conns[i].fd, &readable);
+        if (conns[i].fd > maxFd) maxFd = conns[i].fd;
+      }
+    }
+
+    struct timeval timeout = {0, SELECT_TIMEOUT_MS * 1000};
+    int ready = select(maxFd + 1, &readable, NULL, NULL, &timeout);
+    if (ready < 0) {
+      vTaskDelay(pdMS_TO_TICKS(SELECT_TIMEOUT_MS));
+      continue;
+    }
+
+    if (FD_ISSET(listenFd, &readable)) {
+      accept_client();
+    }
+
+    unsigned long now = millis();
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+      Connection& c = conns[i];
+      if (c.fd < 0) continue;
+
+      if (FD_ISSET(c.fd, &readable)) {
+        int n = recv(c.fd, rx, sizeof(rx), 0);
+        if (n <= 0) {
+          close_conn(c);
+          continue;
+        }
+        c.lastActivity = now;
+        handle_bytes(c, rx, n);
+      } else if (c.ws == WS_NONE && now - c.lastActivity > HTTP_IDLE_TIMEOUT_MS) {
+        close_conn(c);
+      }
+    }
+
+    if (tickHook != NULL && now - lastTick >= tickPeriodMs) {
+      lastTick = now;
+      tickHook();
+    }
+  }
+}
+
+void http_server_begin(uint16_t port, HttpHandler handler) {
+  requestHandler = handler;
+  for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    conns[i].fd = -1;
+  }
+
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd < 0) return;
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 4) < 0) {
+    close(listenFd);
+    listenFd = -1;
+    return;
+  }
+
+  xTaskCreatePinnedToCore(server_task, "http", SERVER_STACK, NULL, 1, NULL, 0);
+}
+
+void http_server_set_tick(HttpTick tick, uint32_t periodMs) {
+  tickPeriodMs = periodMs;
+  tickHook = tick;
+}
+
+uint8_t* ws_frame_header(uint8_t* payload, size_t len) {
+  if (len < 126) {
+    payload[-2] = 0x82;   // FIN + binary
+    payload[-1] = len;
+    return payload - 2;
+  }
+  payload[-4] = 0x82;
+  payload[-3] = 126;
+  payload[-2] = len >> 8;
+  payload[-1] = len & 0xFF;
+  return payload - 4;
+}
+
+static bool has_clients(WsClientState state) {
+  for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    if (conns[i].fd >= 0 && conns[i].ws == state) return true;
+  }
+  return false;
+}
+
+bool ws_has_new_clients() {
+  return has_clients(WS_NEW);
+}
+
+bool ws_has_synced_clients() {
+  return has_clients(WS_SYNCED);
+}
+
+void ws_broadcast(const uint8_t* frame, size_t len, bool toNewClients) {
+  WsClientState target = toNewClients ? WS_NEW : WS_SYNCED;
+  for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    Connection& c = conns[i];
+    if (c.fd < 0 || c.ws != target) continue;
+    if (send(c.fd, frame, len, 0) != (int)len) {
+      close_conn(c);
+      continue;
+    }
+    c.ws = WS_SYNCED;
+    stats.wsFramesSent++;
+    stats.bytesSent += len;
+  }
+}
+
+void http_server_stats(HttpStats* out) {
+  *out = stats;
+}
@@ -0,0 +1,31 @@
+/*
+ * Medibox - input devices (see input.h)
+ */
+
+#include "input.h"
+
+#include <stddef.h>
+
+#include "input_macro.h"
+
+static const InputDevice* devices[INPUT_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+
+bool input_add_device(const InputDevice* device) {
+  if (device == NULL || deviceCount == INPUT_MAX_DEVICES) return false;
+  devices[deviceCount++] = device;
+  return true;
+}
+
+ButtonEvent input_poll() {
+  ButtonEvent ev = {NONE, 0, false, 0};
+  // A replay stands in for every device
+  if (macro_next(&ev)) return ev;
+  // The rest keep their state (a held button, counted detents) until
+  // the next call
+  for (uint8_t i = 0; i < deviceCount && ev.button == NONE; i++) {
+    ev = devices[i]->poll(devices[i]->ctx);
+  }
+  macro_observe(ev);
+  return ev;
+}
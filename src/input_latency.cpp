@@ -0,0 +1,79 @@
+/*
+ * Medibox - input-to-photon latency (see input_latency.h)
+ */
+
+#include "input_latency.h"
+
+#include <Arduino.h>
+
+#include "hal.h"
+#include "metrics.h"
+
+#define LATENCY_NAME "medibox_input_to_photon_us"
+#define LATENCY_HELP "Time from an input to the end of the frame that shows it"
+// 100 ms is about where a response stops feeling immediate
+#define LATENCY_BOUNDS 5000, 10000, 20000, 30000, 50000, 75000, 100000, 150000, 250000, \
+                       500000, 1000000, 2000000, 5000000
+
+METRIC_HISTOGRAM_LABELLED(clockLatency, LATENCY_NAME, "screen=\"clock\"", LATENCY_HELP, LATENCY_BOUNDS);
+METRIC_HISTOGRAM_LABELLED(alarmLatency, LATENCY_NAME, "screen=\"alarm\"", LATENCY_HELP, LATENCY_BOUNDS);
+METRIC_HISTOGRAM_LABELLED(menuLatency, LATENCY_NAME, "screen=\"menu\"", LATENCY_HELP, LATENCY_BOUNDS);
+METRIC_HISTOGRAM_LABELLED(editLatency, LATENCY_NAME, "screen=\"edit\"", LATENCY_HELP, LATENCY_BOUNDS);
+METRIC_HISTOGRAM_LABELLED(viewLatency, LATENCY_NAME, "screen=\"view\"", LATENCY_HELP, LATENCY_BOUNDS);
+
+static MetricHistogram* const histograms[UI_SCREEN_COUNT] = {
+  &clockLatency, &alarmLatency, &menuLatency, &editLatency, &viewLatency,
+};
+static const char* const screenNames[UI_SCREEN_COUNT] = {"clock", "alarm", "menu", "edit", "view"};
+static uint32_t maxUs[UI_SCREEN_COUNT];
+
+// The earliest event no frame has answered yet; only touched by loop()
+static bool pending = false;
+static uint32_t pendingUs = 0;
+static UiScreen pendingScreen = UI_SCREEN_CLOCK;
+
+void input_latency_event(const ButtonEvent& ev, UiScreen screen) {
+  if (ev.button == NONE || pending || screen >= UI_SCREEN_COUNT) return;
+  pending = true;
+  pendingUs = ev.atUs;
+  pendingScreen = screen;
+}
+
+void input_latency_frame() {
+  if (!pending) return;
+  pending = false;
+  uint32_t latency = hal_micros() - pendingUs;
+  histograms[pendingScreen]->observe(latency);
+  if (latency > maxUs[pendingScreen]) maxUs[pendingScreen] = latency;
+}
+
+// Upper bound of the bucket holding the given fraction of observations
+static uint32_t quantile_bound(const MetricHistogram* h, uint32_t count, uint32_t percent) {
+  uint32_t rank = (count * percent + 99) / 100;
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < h->boundCount; i++) {
+    cumulative += h->buckets[i];
+    if (cumulative >= rank) return h->bounds[i];
+  }
+  return UINT32_MAX;
+}
+
+void input_latency_report(Print& out) {
+  out.println("Input-to-photon latency, ms (p50/p95 are bucket bounds)");
+  out.println("screen   count    p50    p95      max");
+  for (int s = 0; s < UI_SCREEN_COUNT; s++) {
+    const MetricHistogram* h = histograms[s];
+    uint32_t count = 0;
+    for (uint8_t i = 0; i <= h->boundCount; i++) count += h->buckets[i];
+    if (count == 0) {
+      out.printf("%-6s %7d      -      -        -\n", screenNames[s], 0);
+      continue;
+    }
+    uint32_t p50 = quantile_bound(h, count, 50);
+    uint32_t p95 = quantile_bound(h, count, 95);
+    // Past the last bound there is only the maximum to go by
+    out.printf("%-6s %7lu %6lu %6lu %8.1f\n", screenNames[s], (unsigned long)count,
+               (unsigned long)((p50 == UINT32_MAX ? maxUs[s] : p50) / 1000),
+               (unsigned long)((p95 == UINT32_MAX ? maxUs[s] : p95) / 1000), maxUs[s] / 1000.0f);
+  }
+}
@@ -0,0 +1,164 @@
+/*
+ * Medibox - input macro recorder and replayer (see input_macro.h)
+ */
+
+#include "input_macro.h"
+
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "hal.h"
+
+static SemaphoreHandle_t lock = NULL;
+static volatile MacroState state = MACRO_IDLE;
+static MacroStep steps[MACRO_MAX_STEPS];
+static MacroResult results[MACRO_MAX_STEPS];
+static size_t stepCount = 0;
+
+// Recording: time of the first event
+static uint32_t recordStart = 0;
+// Replaying: next step to hand out, and the one being measured
+static uint32_t replayStart = 0;
+static size_t nextStep = 0;
+static uint32_t stepStartUs = 0;
+static uint32_t lastStepMs = 0;
+
+static const char* const buttonNames[] = {"NONE", "UP", "OK", "DOWN", "CANCEL"};
+
+void macro_begin() {
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+}
+
+bool macro_record() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = state != MACRO_RECORDING && state != MACRO_REPLAYING;
+  if (ok) {
+    stepCount = 0;
+    state = MACRO_RECORDING;
+  }
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool macro_stop() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = state == MACRO_RECORDING || state == MACRO_REPLAYING;
+  if (ok) state = MACRO_IDLE;
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool macro_clear() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = state == MACRO_IDLE || state == MACRO_DONE;
+  if (ok) {
+    stepCount = 0;
+    state = MACRO_IDLE;
+  }
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool macro_append(const MacroStep& step) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = (state == MACRO_IDLE || state == MACRO_DONE) && stepCount < MACRO_MAX_STEPS &&
+            step.event.button != NONE && step.event.count > 0 &&
+            (stepCount == 0 || step.atMs >= steps[stepCount - 1].atMs);
+  if (ok) {
+    steps[stepCount++] = step;
+    state = MACRO_IDLE;   // Old results no longer match the macro
+  }
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+bool macro_replay() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = (state == MACRO_IDLE || state == MACRO_DONE) && stepCount > 0;
+  if (ok) {
+    memset(results, 0, sizeof(results));
+    nextStep = 0;
+    replayStart = hal_millis();
+    state = MACRO_REPLAYING;
+  }
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+MacroState macro_state() {
+  return state;
+}
+
+size_t macro_step_count() {
+  return stepCount;
+}
+
+bool macro_step(size_t i, MacroStep* step, MacroResult* result) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = i < stepCount;
+  if (ok) {
+    *step = steps[i];
+    *result = results[i];
+  }
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+const char* macro_button_name(Button button) {
+  return button <= CANCEL_BTN ? buttonNames[button] : "NONE";
+}
+
+bool macro_parse_button(const char* name, Button* button) {
+  for (int b = UP; b <= CANCEL_BTN; b++) {
+    if (strcmp(name, buttonNames[b]) == 0) {
+      *button = (Button)b;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool macro_next(ButtonEvent* ev) {
+  if (state != MACRO_REPLAYING) return false;
+  ButtonEvent none = {NONE, 0, false, 0};
+  *ev = none;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint32_t elapsed = hal_millis() - replayStart;
+  if (state != MACRO_REPLAYING) {
+    // Stopped from another task since the check above
+  } else if (nextStep < stepCount && elapsed >= steps[nextStep].atMs) {
+    *ev = steps[nextStep].event;
+    stepStartUs = hal_micros();
+    ev->atUs = stepStartUs;
+    lastStepMs = elapsed;
+    nextStep++;
+  } else if (nextStep == stepCount && elapsed - lastStepMs >= MACRO_SETTLE_MS) {
+    state = MACRO_DONE;
+  }
+  xSemaphoreGive(lock);
+  return true;
+}
+
+void macro_observe(const ButtonEvent& ev) {
+  if (state != MACRO_RECORDING || ev.button == NONE) return;
+  uint32_t now = hal_millis();
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (state == MACRO_RECORDING && stepCount < MACRO_MAX_STEPS) {
+    if (stepCount == 0) recordStart = now;
+    steps[stepCount].atMs = now - recordStart;
+    steps[stepCount].event = ev;
+    stepCount++;
+  }
+  xSemaphoreGive(lock);
+}
+
+// Frames are charged to the step handed out most recently
+void macro_note_flush(uint32_t bytes) {
+  if (state != MACRO_REPLAYING || nextStep == 0) return;
+  MacroResult& r = results[nextStep - 1];
+  if (r.frames == 0) r.latencyUs = hal_micros() - stepStartUs;
+  r.frames++;
+  r.bytes += bytes;
+}
@@ -0,0 +1,112 @@
+/*
+ * Medibox - streaming LTTB downsampling (see lttb.h)
+ */
+
+#include "lttb.h"
+
+#include <string.h>
+
+void LttbStream::begin(uint32_t from, uint32_t to, uint32_t points, LttbEmit emit, void* ctx) {
+  if (points < LTTB_MIN_POINTS) points = LTTB_MIN_POINTS;
+  // First and last point are kept as they are, the rest get one bucket each
+  uint32_t buckets = points - 2;
+  uint64_t span = to >= from ? (uint64_t)to - from + 1 : 1;
+  this->from = from;
+  width = (uint32_t)((span + buckets - 1) / buckets);
+  emitFn = emit;
+  emitCtx = ctx;
+  emittedCount = 0;
+  ok = true;
+  haveFirst = havePending = haveCurrent = false;
+}
+
+void LttbStream::start_bucket(Bucket& b, uint32_t index) {
+  b.index = index;
+  b.count = 0;
+  b.sumT = 0;
+  b.sumY = 0;
+  b.used = 0;
+}
+
+void LttbStream::emit(const LttbPoint& p) {
+  if (ok) ok = emitFn(emitCtx, p);
+  emittedCount++;
+  selected = p;
+}
+
+void LttbStream::select(const Bucket& b, int64_t cT, int64_t cY) {
+  int64_t aT = selected.t, aY = selected.y;
+  const LttbPoint* best = NULL;
+  int64_t bestArea = -1;
+  for (int i = 0; i < LTTB_SUBBUCKETS; i++) {
+    if (!(b.used & (1 << i))) continue;
+    const LttbPoint* pair[2] = {&b.min[i], &b.max[i]};
+    for (const LttbPoint* p : pair) {
+      // Twice the triangle area; the sign only tells the orientation
+      int64_t area = (aT - cT) * ((int64_t)p->y - aY) - (aT - (int64_t)p->t) * (cY - aY);
+      if (area < 0) area = -area;
+      if (area > bestArea) {
+        bestArea = area;
+        best = p;
+      }
+    }
+  }
+  // The last point is emitted by finish(), never as a bucket's choice
+  if (best != NULL && !(best->t == last.t && best->y == last.y)) emit(*best);
+}
+
+bool LttbStream::add(uint32_t t, int32_t y) {
+  LttbPoint p = {t, y};
+  if (!ok) return false;
+  if (!haveFirst) {
+    haveFirst = true;
+    last = p;
+    emit(p);
+    return ok;
+  }
+  last = p;
+
+  uint32_t index = (t - from) / width;
+  if (!haveCurrent || index != current.index) {
+    if (haveCurrent) {
+      // current is complete, so its average closes the pending bucket
+      if (havePending) {
+        select(pending, from + current.sumT / current.count, current.sumY / (int64_t)current.count);
+      }
+      pending = current;
+      havePending = true;
+    }
+    start_bucket(current, index);
+    haveCurrent = true;
+  }
+
+  Bucket& b = current;
+  b.count++;
+  b.sumT += t - from;
+  b.sumY += y;
+  uint32_t slice = (uint32_t)((uint64_t)((t - from) % width) * LTTB_SUBBUCKETS / width);
+  if (!(b.used & (1 << slice))) {
+    b.used |= 1 << slice;
+    b.min[slice] = b.max[slice] = p;
+  } else if (y < b.min[slice].y) {
+    b.min[slice] = p;
+  } else if (y > b.max[slice].y) {
+    b.max[slice] = p;
+  }
+  return ok;
+}
+
+bool LttbStream::finish() {
+  if (!haveFirst || !ok) return ok;
+  if (haveCurrent && current.count == 1) {
+    // The last point sits alone in its bucket and is the final corner
+    if (havePending) select(pending, last.t, last.y);
+  } else if (haveCurrent) {
+    if (havePending) {
+      select(pending, from + current.sumT / current.count, current.sumY / (int64_t)current.count);
+    }
+    select(current, last.t, last.y);
+  }
+  if (haveCurrent) emit(last);
+  return ok;
+}
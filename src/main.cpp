@@ -16,124 +16,102 @@
  */
 
 #include <Arduino.h>
-#include <WiFi.h>
 #include <time.h>
 #include <Wire.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
-#include <DHT.h>
+#include "board.h"
+#include "hal.h"
+#include "settings.h"
+#include "time_sync.h"
+#include "wifi_manager.h"
+#include "telemetry.h"
+#include "mqtt_telemetry.h"
+#include "udp_telemetry.h"
+#include "rest_api.h"
+#include "dashboard.h"
+#include "flash_storage.h"
+#include "sensor_log.h"
+#include "buttons.h"
+#include "encoder.h"
+#include "input_macro.h"
+#include "input_latency.h"
+#include "menu.h"
+#include "metrics.h"
+#include "alloc_stats.h"
+#include "mem_monitor.h"
+#include "fixed_string.h"
+#include "ui_text.h"
+#include "trace.h"
 
 // OLED Display Configuration
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET    -1
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
-
-// DHT22 Configuration
-#define DHTPIN 12
-#define DHTTYPE DHT22
-DHT dht(DHTPIN, DHTTYPE);
-
-// Button Pin Definitions
-#define BTN_UP 33
-#define BTN_OK 32
-#define BTN_DOWN 35
-#define BTN_CANCEL 34
-
-// Output Pin Definitions
-#define LED_PIN 15
-#define BUZZER_PIN 5
-
-// Button debounce time in milliseconds
-#define DEBOUNCE_TIME 250
-#define BUTTON_DELAY 50    // Add a small delay after button press
-
-
-// Button States - Renamed to avoid conflicts
-enum Button {NONE, UP, OK_BTN, DOWN, CANCEL_BTN};
-
-// Menu States
-enum MenuState {
-  MAIN_MENU,
-  SET_TIMEZONE,
-  SET_ALARM_1,
-  SET_ALARM_2,
-  VIEW_ALARMS,
-  DELETE_ALARM,      // Keep this as the main delete menu entry
-  DELETE_ALARM_1,    // New state for deleting alarm 1
-  DELETE_ALARM_2,    // New state for deleting alarm 2
-  NORMAL_DISPLAY
-};
-
-// Submenu States for alarm setting
-enum AlarmSettingState {
-  SETTING_HOUR,
-  SETTING_MINUTE,
-  CONFIRM_ALARM
-};
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, hal_display_bus(), OLED_RESET);
 
 
 // Global Variables
-MenuState currentState = NORMAL_DISPLAY;
-AlarmSettingState alarmSettingState = SETTING_HOUR;
-int menuPosition = 0;
-float timeZoneOffset = 0.0; // Changed to float to support 30min increments
-bool alarm1Active = false;
-bool alarm2Active = false;
-int alarm1Hour = 0, alarm1Minute = 0;
-int alarm2Hour = 0, alarm2Minute = 0;
-int settingHour = 0, settingMinute = 0;
 bool alarmRinging = false;
 int alarmRingingNum = 0;
 unsigned long alarmStartTime = 0;
 bool alarmSnoozing = false;
 unsigned long snoozeStartTime = 0;
+int lastAlarmMinute = -1; // Minute (and day) an alarm last fired, guards clock corrections
 const int SNOOZE_DURATION = 5 * 60 * 1000; // 5 minutes in milliseconds
 
 
 
-// Button debouncing variables
-unsigned long lastButtonPressTime = 0;
-bool menuInitialized = false;
-int deletePosition = 0;
-
-// Wi-Fi Credentials
-const char* ssid = "Wokwi-GUEST";
-const char* password = "";
+// Wi-Fi Credentials (tried in order, add more networks as needed)
+const WifiNetwork wifiNetworks[] = {
+  {"Wokwi-GUEST", ""},
+};
+bool timeSyncStarted = false;
+uint32_t appliedSettingsVersion = 0;
 
 // NTP Configuration
 const char* ntpServer = "pool.ntp.org";
 
-// Temperature and humidity healthy ranges
-const float MIN_HEALTHY_TEMP = 24.0;
-const float MAX_HEALTHY_TEMP = 32.0;
-const float MIN_HEALTHY_HUMIDITY = 65.0;
-const float MAX_HEALTHY_HUMIDITY = 80.0;
+// Metrics (scraped from /metrics)
+METRIC_HISTOGRAM(loopPeriod, "medibox_loop_period_us", "Time between loop() iterations",
+                 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 250000, 1000000);
+MetricCounter displayFlushBytes("medibox_display_flush_bytes_total",
+                                "Bytes pushed to the OLED over I2C");
+MetricCounter dhtFailures("medibox_dht_failures_total", "DHT22 reads that returned NaN");
+// Drawing a frame must not allocate: counted from the clock, warning and
+// alarm screens here and from the menus in menu.cpp
+static uint32_t drawAllocs = 0;
+static uint32_t ui_allocs() {
+  return drawAllocs + menu_render_allocs();
+}
+MetricCounter uiAllocs("medibox_ui_allocs_total",
+                       "Heap allocations made while drawing the display, should stay 0",
+                       ui_allocs);
+uint32_t lastLoopUs = 0;
 
 // Function Prototypes
-void print_line(String message, int x = 0, int y = 0, int size = 1, bool clear = true);
+void print_line(const char* message, int x = 0, int y = 0, int size = 1, bool clear = true);
+void print_centered(StrId id, int y, int size);
+void print_clock(const struct tm& t);
 void print_time_now();
 void update_time();
 void update_time_with_check_alarm();
 void ring_alarm(int alarmNum);
+ButtonEvent poll_input();
 Button check_button_press();
-void go_to_menu();
-void run_mode();
-void set_timezone();
-void set_alarm(int alarmNum);
-void view_alarms();
 void check_temp();
 void stop_alarm(bool snooze = false);
 void check_snooze();
-void display_alarm_setting(int alarmNum);
-void handle_alarm_setting(int alarmNum, Button value);
-String format_timezone(float tz);
-void display_delete_alarm_menu();
-void delete_alarm_1();
-void delete_alarm_2();
+void flush_display();
+void on_wifi_state(WifiState state);
 
 void setup() {
+  // setup() and loop() share the Arduino loop task
+  alloc_stats_watch_current_task();
+  mem_monitor_begin();
+  mem_monitor_watch_current_task(MEM_TASK_LOOP);
   Serial.begin(115200);
+  settings_begin();
 
   // Initialize the OLED display
   if(!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) { 
@@ -142,69 +120,89 @@ void setup() {
   }
   display.clearDisplay();
   display.setTextColor(WHITE);
+  display.cp437(true);   // The encoding of the UI string tables
   display.setTextSize(1);
   display.setCursor(0, 0);
-  display.println("Medibox starting...");
-  display.display();
-  delay(1000);
+  display.println(tr(STR_BOOT_STARTING));
+  flush_display();
+  menu_begin(&display, flush_display);
+  hal_delay(1000);
 
-  // Initialize DHT sensor
-  dht.begin();
+  // Initialize the temperature/humidity sensor
+  hal_sensor_begin();
   
   // Initialize pins
-  pinMode(BTN_UP, INPUT_PULLUP);
-  pinMode(BTN_OK, INPUT_PULLUP);
-  pinMode(BTN_DOWN, INPUT_PULLUP);
-  pinMode(BTN_CANCEL, INPUT_PULLUP);
-  pinMode(LED_PIN, OUTPUT);
-  pinMode(BUZZER_PIN, OUTPUT);
-  
-  // Turn off LED and buzzer
-  digitalWrite(LED_PIN, LOW);
-  digitalWrite(BUZZER_PIN, LOW);
-  
-  // Connect to Wi-Fi
-  print_line("Connecting to WiFi..");
-  WiFi.begin(ssid, password);
-  
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 10) {
-    delay(500);
-    display.print(".");
-    display.display();
-    attempts++;
+  buttons_begin(BTN_UP, BTN_OK, BTN_DOWN, BTN_CANCEL);
+  input_add_device(buttons_device());
+  macro_begin();
+#if INPUT_ENCODER
+  if (!input_add_device(encoder_begin(ENC_A, ENC_B, ENC_SW))) {
+    Serial.println("Rotary encoder setup failed");
   }
+#endif
+  hal_pin_mode(LED_PIN, HAL_OUTPUT);
+  hal_pin_mode(BUZZER_PIN, HAL_OUTPUT);
   
-  if (WiFi.status() == WL_CONNECTED) {
-    print_line("WiFi connected!");
-    
-    // Initialize and get time from NTP server
-    configTime(timeZoneOffset * 3600, 0, ntpServer);
-    print_line("Time synchronized");
-  } else {
-    print_line("WiFi connection failed");
-  }
-  
-  delay(1000);
-  print_line("Medibox ready!");
-  delay(1000);
+  // Turn off LED and buzzer
+  hal_pin_write(LED_PIN, false);
+  hal_pin_write(BUZZER_PIN, false);
+  
+  // Connect to Wi-Fi in the background, time sync starts once it is up
+  print_line(tr(STR_WIFI_CONNECTING));
+  for (const WifiNetwork& net : wifiNetworks) {
+    wifi_manager_add_network(net.ssid, net.password);
+  }
+  wifi_manager_add_listener(on_wifi_state);
+  wifi_manager_begin();
+
+  // Telemetry is queued from loop() and published by a background task
+  telemetry_begin();
+#if TELEMETRY_UDP
+  udp_telemetry_begin();
+#else
+  mqtt_telemetry_begin();
+#endif
+
+  // Sensor history on flash, queried through /api/history
+  sensor_log_begin(flash_storage_partition(SENSOR_LOG_PARTITION));
+
+  // REST API for alarms and settings, live dashboard on ws://<device>/ws
+  dashboard_begin(display.getBuffer(), SCREEN_WIDTH * SCREEN_HEIGHT / 8);
+  rest_api_begin();
+  
+  hal_delay(1000);
+  print_line(tr(STR_BOOT_READY));
+  hal_delay(1000);
 }
 
 void loop() {
-  check_snooze();
+  uint32_t loopStartUs = hal_micros();
+  if (lastLoopUs != 0) loopPeriod.observe(loopStartUs - lastLoopUs);
+  lastLoopUs = loopStartUs;
+
+  wifi_manager_loop();
+  time_sync_loop();
+  dashboard_update_alarm(alarmRinging, alarmSnoozing, alarmRingingNum);
   
+  // Pick up settings changed over the network
+  if (settings_version() != appliedSettingsVersion) {
+    appliedSettingsVersion = settings_version();
+    time_sync_set_timezone(settings.timeZoneOffset);
+  }
+  check_snooze();
+
   // Only run normal display when alarm is not ringing
   if (!alarmRinging) {
-    if (currentState == NORMAL_DISPLAY) {
+    if (!menu_active()) {
       update_time_with_check_alarm();
       check_temp();
       
       Button pressedButton = check_button_press();
       if (pressedButton == OK_BTN) {
-        go_to_menu();
+        menu_open(&mainMenu);
       }
     } else {
-      run_mode();
+      menu_handle(poll_input());
     }
   } 
   // Special handling when alarm is ringing - keep showing alarm and check buttons
@@ -214,55 +212,105 @@ void loop() {
       stop_alarm(false); // Stop
     } else if (pressedButton == UP) {
       stop_alarm(true); // Snooze
+    } else {
+      // Keep displaying alarm message; once stopped, the pulse below would
+      // turn the LED and buzzer back on with nothing to turn them off
+      uint32_t allocsBefore = alloc_stats_task_allocs();
+      display.clearDisplay();
+      display.setTextSize(2);
+      print_centered(STR_RING_LINE1, 10, 2);
+      print_centered(STR_RING_LINE2, 30, 2);
+      display.setTextSize(1);
+      display.setCursor(30, 50);
+      FixedString<24> label;
+      label.printf(tr(STR_RING_ALARM), alarmRingingNum);
+      display.println(label.c_str());
+      display.setCursor(0, 55);
+      display.println(tr(STR_RING_HELP));
+      flush_display();
+      drawAllocs += alloc_stats_task_allocs() - allocsBefore;
+
+      // Pulse the LED and buzzer periodically
+      if (hal_millis() % 2000 < 200) {
+        hal_pin_write(LED_PIN, true);
+        hal_pin_write(BUZZER_PIN, true);
+      } else if (hal_millis() % 2000 < 400) {
+        hal_pin_write(LED_PIN, false);
+        hal_pin_write(BUZZER_PIN, false);
+      }
     }
-    
-    // Keep displaying alarm message
-    display.clearDisplay();
-    display.setTextSize(2);
-    display.setCursor(10, 10);
-    display.println("MEDICINE");
-    display.setCursor(10, 30);
-    display.println("TIME!");
-    display.setTextSize(1);
-    display.setCursor(30, 50);
-    display.println("Alarm " + String(alarmRingingNum));
-    display.setCursor(0, 55);
-    display.println("UP=Snooze, CANCEL=Stop");
-    display.display();
-    
-    // Pulse the LED and buzzer periodically
-    if (millis() % 2000 < 200) {
-      digitalWrite(LED_PIN, HIGH);
-      digitalWrite(BUZZER_PIN, HIGH);
-    } else if (millis() % 2000 < 400) {
-      digitalWrite(LED_PIN, LOW);
-      digitalWrite(BUZZER_PIN, LOW);
+  }
+
+  mem_monitor_loop();
+
+  // Serial console: 'l' prints the latency summary, 't' dumps the trace,
+  // 'm' prints heap and stack headroom
+  if (Serial.available() > 0) {
+    int command = Serial.read();
+    if (command == 'l') {
+      input_latency_report(Serial);
+    } else if (command == 't') {
+      trace_print(Serial);
+    } else if (command == 'm') {
+      mem_monitor_report(Serial);
     }
   }
 }
 
+// React to WiFi connectivity changes
+void on_wifi_state(WifiState state) {
+  trace(TRACE_WIFI, state);
+  if (state == WIFI_CONNECTED) {
+    Serial.printf("WiFi connected to %s\n", wifi_manager_ssid());
+    // Initialize and get time from NTP server (SNTP retries on its own later)
+    if (!timeSyncStarted) {
+      time_sync_begin(ntpServer, settings.timeZoneOffset);
+      timeSyncStarted = true;
+    }
+  } else if (state == WIFI_BACKOFF) {
+    Serial.println("WiFi connection lost, retrying");
+  }
+}
+
 // Print a message on the OLED display
-void print_line(String message, int x, int y, int size, bool clear) {
+void print_line(const char* message, int x, int y, int size, bool clear) {
   if (clear) {
     display.clearDisplay();
   }
   display.setTextSize(size);
   display.setCursor(x, y);
   display.println(message);
-  display.display();
+  flush_display();
+}
+
+// Single-line text centred horizontally, using the width measured at build time
+void print_centered(StrId id, int y, int size) {
+  int x = (SCREEN_WIDTH - tr_metrics(id).width * size) / 2;
+  display.setCursor(x < 0 ? 0 : x, y);
+  display.println(tr(id));
+}
+
+// Weekday and month names come from the string table, not the C locale
+static_assert(STR_DAY_SATURDAY == STR_DAY_SUNDAY + 6, "weekdays in tm_wday order");
+static_assert(STR_MONTH_DECEMBER == STR_MONTH_JANUARY + 11, "months in tm_mon order");
+
+void print_clock(const struct tm& t) {
+  uint32_t allocsBefore = alloc_stats_task_allocs();
+  FixedString<64> text;
+  text.printf(tr(STR_CLOCK_FORMAT), tr((StrId)(STR_DAY_SUNDAY + t.tm_wday)), t.tm_mday,
+              tr((StrId)(STR_MONTH_JANUARY + t.tm_mon)), t.tm_hour, t.tm_min, t.tm_sec);
+  print_line(text.c_str());
+  drawAllocs += alloc_stats_task_allocs() - allocsBefore;
 }
 
 // Print the current time on the OLED
 void print_time_now() {
   struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    print_line("Failed to get time");
+  if (!hal_local_time(&timeinfo)) {
+    print_line(tr(STR_TIME_FAILED));
     return;
   }
-  
-  char timeStr[50];
-  strftime(timeStr, sizeof(timeStr), "%A %d %B\n%H:%M:%S", &timeinfo);
-  print_line(String(timeStr));
+  print_clock(timeinfo);
 }
 
 // Update and display the time
@@ -273,699 +321,171 @@ void update_time() {
 // Update time and check alarms
 void update_time_with_check_alarm() {
   struct tm timeinfo;
-  if (!getLocalTime(&timeinfo)) {
-    print_line("Failed to get time");
+  if (!hal_local_time(&timeinfo)) {
+    print_line(tr(STR_TIME_FAILED));
     return;
   }
   
-  if (!alarmRinging && !alarmSnoozing) {
+  // Match on the minute rather than second 0 so a clock correction can
+  // neither skip an alarm nor fire it twice. The day is part of the key,
+  // or a daily alarm would ring only once.
+  int minute = ((timeinfo.tm_year * 366 + timeinfo.tm_yday) * 24 + timeinfo.tm_hour) * 60 +
+               timeinfo.tm_min;
+  if (!alarmRinging && !alarmSnoozing && minute != lastAlarmMinute) {
     // Check if alarm 1 should ring
-    if (alarm1Active && timeinfo.tm_hour == alarm1Hour && timeinfo.tm_min == alarm1Minute && timeinfo.tm_sec == 0) {
+    if (settings.alarms[0].active && timeinfo.tm_hour == settings.alarms[0].hour && timeinfo.tm_min == settings.alarms[0].minute) {
+      lastAlarmMinute = minute;
       ring_alarm(1);
       return; // Exit to prevent screen refresh
     }
     // Check if alarm 2 should ring
-    else if (alarm2Active && timeinfo.tm_hour == alarm2Hour && timeinfo.tm_min == alarm2Minute && timeinfo.tm_sec == 0) {
+    else if (settings.alarms[1].active && timeinfo.tm_hour == settings.alarms[1].hour && timeinfo.tm_min == settings.alarms[1].minute) {
+      lastAlarmMinute = minute;
       ring_alarm(2);
       return; // Exit to prevent screen refresh
     }
   }
   
-  char timeStr[50];
-  strftime(timeStr, sizeof(timeStr), "%A %d %B\n%H:%M:%S", &timeinfo);
-  print_line(String(timeStr));
+  print_clock(timeinfo);
 }
 
 // Ring the alarm with visual and audio indicators
 void ring_alarm(int alarmNum) {
   alarmRinging = true;
   alarmRingingNum = alarmNum;
-  alarmStartTime = millis();
+  alarmStartTime = hal_millis();
+  trace(TRACE_ALARM_RING, alarmNum);
+  telemetry_adherence(alarmNum, ADHERENCE_RANG, 0);
   
   // Initial buzzer pattern
   for (int i = 0; i < 3; i++) {
-    digitalWrite(LED_PIN, HIGH);
-    digitalWrite(BUZZER_PIN, HIGH);
-    delay(200);
-    digitalWrite(LED_PIN, LOW);
-    digitalWrite(BUZZER_PIN, LOW);
-    delay(100);
-  }
-}
-
-// Format timezone for display
-String format_timezone(float tz) {
-  String result = "UTC";
-  
-  // Add sign for both positive and negative
-  if (tz >= 0) {
-    result += "+";
-  }else{
-    result += "-";
-  }
-  
-  int whole = (int)std::abs(tz);  // Use absolute value
-  int frac = std::abs((int)((tz - (int)tz) * 60));  // Ensure correct fractional part
-  
-  if (frac == 0) {
-    result += String(whole);
-  } else {
-    result += String(whole) + ":" + (frac == 30 ? "30" : "00");
-  }
-  
-  
-  return result;
-}
-
-// Check for button press with debouncing
-Button check_button_press() {
-  // Check if enough time has passed since last button press
-  if (millis() - lastButtonPressTime < DEBOUNCE_TIME) {
-    return NONE;
-  }
-  
-  Button pressedButton = NONE;
-  
-  if (digitalRead(BTN_UP) == LOW) {
-    pressedButton = UP;
-  }
-  else if (digitalRead(BTN_OK) == LOW) {
-    pressedButton = OK_BTN;
-  }
-  else if (digitalRead(BTN_DOWN) == LOW) {
-    pressedButton = DOWN;
-  }
-  else if (digitalRead(BTN_CANCEL) == LOW) {
-    pressedButton = CANCEL_BTN;
-  }
-  
-  // If a button is pressed
-  if (pressedButton != NONE) {
-    lastButtonPressTime = millis();
-    
-    // Additional anti-bounce delay
-    delay(BUTTON_DELAY);
-    
-    return pressedButton;
-  }
-  
-  return NONE;
-}
-
-// Navigate to the main menu
-void go_to_menu() {
-  currentState = MAIN_MENU;
-  menuPosition = 0;
-  menuInitialized = false;
-  
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("MENU:");
-  display.println("> Set Time Zone");
-  display.println("  Set Alarm 1");
-  display.println("  Set Alarm 2");
-  display.println("  View Alarms");
-  display.println("  Delete Alarm");
-  display.println("  Back");
-  display.display();
-}
-
-// Run the current menu mode
-void run_mode() {
-  Button pressedButton = check_button_press();
-  if (pressedButton == NONE) return;
-  
-  // Main Menu handling
-  if (currentState == MAIN_MENU) {
-    if (pressedButton == UP && menuPosition > 0) {
-      menuPosition--;
-    } else if (pressedButton == DOWN && menuPosition < 5) {
-      menuPosition++;
-    } else if (pressedButton == OK_BTN) {
-      switch (menuPosition) {
-        case 0: // Set Time Zone
-          currentState = SET_TIMEZONE;
-          menuInitialized = false; // Force redisplay of timezone screen
-          break;
-        case 1: // Set Alarm 1
-          currentState = SET_ALARM_1;
-          settingHour = alarm1Hour;
-          settingMinute = alarm1Minute;
-          alarmSettingState = SETTING_HOUR;
-          display_alarm_setting(1);
-          break;
-        case 2: // Set Alarm 2
-          currentState = SET_ALARM_2;
-          settingHour = alarm2Hour;
-          settingMinute = alarm2Minute;
-          alarmSettingState = SETTING_HOUR;
-          display_alarm_setting(2);
-          break;
-        case 3: // View Alarms
-          currentState = VIEW_ALARMS;
-          view_alarms();
-          break;
-        case 4: // Delete Alarm
-          currentState = DELETE_ALARM;
-          menuInitialized = false; // Force redisplay of delete screen
-          break;
-        case 5: // Back
-          currentState = NORMAL_DISPLAY;
-          break;
-      }
-    } else if (pressedButton == CANCEL_BTN) {
-      currentState = NORMAL_DISPLAY;
-    }
-    
-    if (pressedButton == UP || pressedButton == DOWN) {
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("MENU:");
-      display.println(menuPosition == 0 ? "> Set Time Zone" : "  Set Time Zone");
-      display.println(menuPosition == 1 ? "> Set Alarm 1" : "  Set Alarm 1");
-      display.println(menuPosition == 2 ? "> Set Alarm 2" : "  Set Alarm 2");
-      display.println(menuPosition == 3 ? "> View Alarms" : "  View Alarms");
-      display.println(menuPosition == 4 ? "> Delete Alarm" : "  Delete Alarm");
-      display.println(menuPosition == 5 ? "> Back" : "  Back");
-      display.display();
-    }
-  } 
-  // Timezone Setting screen
-  else if (currentState == SET_TIMEZONE) {
-    // Display timezone screen if not already displayed
-    if (!menuInitialized) {
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("SET TIME ZONE");
-      display.println("Current: " + format_timezone(timeZoneOffset));
-      display.println("UP/DOWN to change");
-      display.println("OK to confirm");
-      display.println("CANCEL to go back");
-      display.display();
-      menuInitialized = true;
-      return;
-    }
-    
-    if (pressedButton == UP && timeZoneOffset < 12.0) {
-      timeZoneOffset += 0.5; // Increment by 0.5 hours (30 minutes)
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("SET TIME ZONE");
-      display.println("Current: " + format_timezone(timeZoneOffset));
-      display.println("UP/DOWN to change");
-      display.println("OK to confirm");
-      display.println("CANCEL to go back");
-      display.display();
-    } 
-    else if (pressedButton == DOWN && timeZoneOffset > -12.0) {
-      timeZoneOffset -= 0.5; // Decrement by 0.5 hours (30 minutes)
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("SET TIME ZONE");
-      display.println("Current: " + format_timezone(timeZoneOffset));
-      display.println("UP/DOWN to change");
-      display.println("OK to confirm");
-      display.println("CANCEL to go back");
-      display.display();
-    } 
-    else if (pressedButton == OK_BTN) {
-      // Update time with new timezone
-      // Convert to seconds
-      int seconds = (int)(timeZoneOffset * 3600);
-      configTime(seconds, 0, ntpServer);
-      
-      // Confirm timezone change
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("Time Zone Updated!");
-      display.println(format_timezone(timeZoneOffset));
-      display.display();
-      delay(1500);
-      
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-    } 
-    else if (pressedButton == CANCEL_BTN) {
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-    }
-  } 
-  else if (currentState == SET_ALARM_1) {
-    handle_alarm_setting(1, pressedButton);
-  } 
-  else if (currentState == SET_ALARM_2) {
-    handle_alarm_setting(2, pressedButton);
-  } 
-  else if (currentState == VIEW_ALARMS) {
-    if (pressedButton == CANCEL_BTN || pressedButton == OK_BTN) {
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-    }
-  } 
-  else if (currentState == DELETE_ALARM) {
-    // Display delete menu screen if not already displayed
-    if (!menuInitialized) {
-      if (!alarm1Active && !alarm2Active) {
-        menuPosition = 2;
-      } 
-      // If Alarm 1 is active, start there
-      else if (alarm1Active) {
-        menuPosition = 0;
-      } 
-      // Otherwise, start at Alarm 2 if it's active
-      else if (alarm2Active) {
-        menuPosition = 1;
-      }
-      
-      display_delete_alarm_menu();
-      menuInitialized = true;
-      return;
-    }
-    
-    if (pressedButton == UP) {
-      do {
-        menuPosition = (menuPosition + 2) % 3;  // Wrap around
-      } while ((menuPosition == 0 && !alarm1Active) || 
-              (menuPosition == 1 && !alarm2Active));
-      display_delete_alarm_menu();
-    } 
-    else if (pressedButton == DOWN) {
-      do {
-        menuPosition = (menuPosition + 1) % 3;  // Wrap around
-      } while ((menuPosition == 0 && !alarm1Active) || 
-              (menuPosition == 1 && !alarm2Active));
-      display_delete_alarm_menu();
-    }
-     else if (pressedButton == OK_BTN) {
-    if (menuPosition == 0 && alarm1Active) {
-      currentState = DELETE_ALARM_1;
-      menuInitialized = false;
-    } else if (menuPosition == 1 && alarm2Active) {
-      currentState = DELETE_ALARM_2;
-      menuInitialized = false;
-    } else if (menuPosition == 2) {
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-    }
-  } else if (pressedButton == CANCEL_BTN) {
-    currentState = MAIN_MENU;
-    menuInitialized = false;
-    go_to_menu();
+    hal_pin_write(LED_PIN, true);
+    hal_pin_write(BUZZER_PIN, true);
+    hal_delay(200);
+    hal_pin_write(LED_PIN, false);
+    hal_pin_write(BUZZER_PIN, false);
+    hal_delay(100);
   }
-} else if (currentState == DELETE_ALARM_1) {
-  delete_alarm_1();
-} else if (currentState == DELETE_ALARM_2) {
-  delete_alarm_2();
-}
 }
 
-// Display the alarm setting screen
-void display_alarm_setting(int alarmNum) {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("SET ALARM " + String(alarmNum));
-  
-  if (alarmSettingState == SETTING_HOUR) {
-    display.println("Setting hour: ");
-  } else if (alarmSettingState == SETTING_MINUTE) {
-    display.println("Setting minute: ");
-  }
-  
-  display.setTextSize(2);
-  display.setCursor(40, 25);
-  display.println(String(settingHour < 10 ? "0" : "") + String(settingHour) + ":" + 
-                  String(settingMinute < 10 ? "0" : "") + String(settingMinute));
-  
-  display.setTextSize(1);
-  display.setCursor(0, 50);
-  
-  if (alarmSettingState == SETTING_HOUR) {
-    display.println("UP/DOWN to change, OK next");
-  } else if (alarmSettingState == SETTING_MINUTE) {
-    display.println("UP/DOWN to change, OK to set");
-  }
-  
-  display.display();
-}
-
-// Handle alarm setting for a specific alarm number
-void handle_alarm_setting(int alarmNum, Button pressedButton) {
-  if (alarmSettingState == SETTING_HOUR) {
-    if (pressedButton == UP) {
-      settingHour = (settingHour + 1) % 24;
-    } else if (pressedButton == DOWN) {
-      settingHour = (settingHour + 23) % 24; // Wrap around from 0 to 23
-    } else if (pressedButton == OK_BTN) {
-      alarmSettingState = SETTING_MINUTE;
-    } else if (pressedButton == CANCEL_BTN) {
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-      return;
-    }
-  } else if (alarmSettingState == SETTING_MINUTE) {
-    if (pressedButton == UP) {
-      settingMinute = (settingMinute + 1) % 60;
-    } else if (pressedButton == DOWN) {
-      settingMinute = (settingMinute + 59) % 60; // Wrap around from 0 to 59
-    } else if (pressedButton == OK_BTN) {
-      // Save alarm
-      if (alarmNum == 1) {
-        alarm1Hour = settingHour;
-        alarm1Minute = settingMinute;
-        alarm1Active = true;
-      } else {
-        alarm2Hour = settingHour;
-        alarm2Minute = settingMinute;
-        alarm2Active = true;
-      }
-      
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("Alarm " + String(alarmNum) + " set for");
-      display.setTextSize(2);
-      display.setCursor(30, 20);
-      display.println(String(settingHour < 10 ? "0" : "") + String(settingHour) + ":" + 
-                      String(settingMinute < 10 ? "0" : "") + String(settingMinute));
-      display.display();
-      
-      delay(2000);
-      alarmSettingState = SETTING_HOUR; // Reset for next time
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-      return;
-    } else if (pressedButton == CANCEL_BTN) {
-      currentState = MAIN_MENU;
-      menuInitialized = false;
-      go_to_menu();
-      return;
+// The next input, noted with the screen it was aimed at for the latency histograms
+ButtonEvent poll_input() {
+  ButtonEvent ev = input_poll();
+  if (ev.button != NONE) trace(TRACE_INPUT, ev.button | ev.repeat << 7 | ev.count << 8);
+  UiScreen screen = UI_SCREEN_CLOCK;
+  if (alarmRinging) {
+    screen = UI_SCREEN_ALARM;
+  } else if (menu_active()) {
+    switch (menu_screen_kind()) {
+      case SCREEN_MENU: screen = UI_SCREEN_MENU; break;
+      case SCREEN_EDIT: screen = UI_SCREEN_EDIT; break;
+      case SCREEN_VIEW: screen = UI_SCREEN_VIEW; break;
     }
   }
-  
-  // If we changed something, update the display
-  if (pressedButton != NONE) {
-    display_alarm_setting(alarmNum);
-  }
-}
-
-// View all active alarms
-void view_alarms() {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("ACTIVE ALARMS");
-  display.println("");
-  
-  if (!alarm1Active && !alarm2Active) {
-    display.println("No active alarms");
-  } else {
-    if (alarm1Active) {
-      display.print("Alarm 1: ");
-      display.println(String(alarm1Hour < 10 ? "0" : "") + String(alarm1Hour) + ":" + 
-                      String(alarm1Minute < 10 ? "0" : "") + String(alarm1Minute));
-    }
-    
-    if (alarm2Active) {
-      display.print("Alarm 2: ");
-      display.println(String(alarm2Hour < 10 ? "0" : "") + String(alarm2Hour) + ":" + 
-                      String(alarm2Minute < 10 ? "0" : "") + String(alarm2Minute));
-    }
-  }
-  
-  display.println("\nPress OK/CANCEL to go back");
-  display.display();
+  input_latency_event(ev, screen);
+  return ev;
 }
 
-// Function to display delete alarm menu
-// Display the delete alarm menu
-void display_delete_alarm_menu() {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("DELETE ALARM");
-  display.println("");
-  
-  // Adjust menuPosition to first available alarm
-  if (!alarm1Active && !alarm2Active) {
-    display.println("No active alarms");
-    display.println("\nPress any button to exit");
-    display.display();
-    menuPosition = 2;  // Default to "Back" option
-    return;
-  }
-  
-  // Adjust menuPosition if current selection is not valid
-  if (menuPosition == 0 && !alarm1Active) {
-    menuPosition = 1;
-  }
-  if (menuPosition == 1 && !alarm2Active) {
-    menuPosition = 2;
-  }
-  
-  // Only show options for active alarms
-  if (alarm1Active) {
-    display.println(menuPosition == 0 ? "> Delete Alarm 1" : "  Delete Alarm 1");
-  } else {
-    display.println("  Alarm 1 not set");
-  }
-  
-  if (alarm2Active) {
-    display.println(menuPosition == 1 ? "> Delete Alarm 2" : "  Delete Alarm 2");
-  } else {
-    display.println("  Alarm 2 not set");
-  }
-  
-  display.println(menuPosition == 2 ? "> Back to Menu" : "  Back to Menu");
-  
-  display.println("\nUP/DOWN to select");
-  display.println("OK to choose");
-  display.println("CANCEL to exit");
-  display.display();
-}
-
-// Handle deleting alarm 1
-void delete_alarm_1() {
-  // Display confirmation screen
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("DELETE ALARM 1?");
-  display.println("");
-  display.println("Current setting:");
-  display.setTextSize(2);
-  display.setCursor(30, 20);
-  display.println(String(alarm1Hour < 10 ? "0" : "") + String(alarm1Hour) + ":" + 
-                  String(alarm1Minute < 10 ? "0" : "") + String(alarm1Minute));
-  display.setTextSize(1);
-  display.println("");
-  display.println("OK to delete");
-  display.println("CANCEL to go back");
-  display.display();
-
-  // Wait for user input with a dedicated loop
-  while (true) {
-    // Check for button press
-    Button pressedButton = check_button_press();
-    
-    // Handle OK button - confirm deletion
-    if (pressedButton == OK_BTN) {
-      // Delete alarm 1
-      alarm1Active = false;
-      
-      // Show deletion confirmation
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("ALARM 1 DELETED");
-      display.println("\nPress any button");
-      display.display();
-      
-      // Wait for any button to return to main menu
-      while (true) {
-        Button exitButton = check_button_press();
-        if (exitButton != NONE) {
-          currentState = MAIN_MENU;
-          menuInitialized = false;
-          go_to_menu();
-          return;
-        }
-        // Prevent tight loop from blocking other processes
-        delay(50);
-      }
-    }
-    // Handle CANCEL button - go back to delete menu
-    else if (pressedButton == CANCEL_BTN) {
-      currentState = DELETE_ALARM;
-      menuPosition = 0;
-      menuInitialized = false;
-      return;
-    }
-    
-    // Prevent tight loop from blocking other processes
-    delay(50);
-  }
-}
-
-// Handle deleting alarm 2 (same approach as delete_alarm_1)
-void delete_alarm_2() {
-  // Display confirmation screen
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-  display.println("DELETE ALARM 2?");
-  display.println("");
-  display.println("Current setting:");
-  display.setTextSize(2);
-  display.setCursor(30, 20);
-  display.println(String(alarm2Hour < 10 ? "0" : "") + String(alarm2Hour) + ":" + 
-                  String(alarm2Minute < 10 ? "0" : "") + String(alarm2Minute));
-  display.setTextSize(1);
-  display.println("");
-  display.println("OK to delete");
-  display.println("CANCEL to go back");
-  display.display();
-
-  // Wait for user input with a dedicated loop
-  while (true) {
-    // Check for button press
-    Button pressedButton = check_button_press();
-    
-    // Handle OK button - confirm deletion
-    if (pressedButton == OK_BTN) {
-      // Delete alarm 2
-      alarm2Active = false;
-      
-      // Show deletion confirmation
-      display.clearDisplay();
-      display.setTextSize(1);
-      display.setCursor(0, 0);
-      display.println("ALARM 2 DELETED");
-      display.println("\nPress any button");
-      display.display();
-      
-      // Wait for any button to return to main menu
-      while (true) {
-        Button exitButton = check_button_press();
-        if (exitButton != NONE) {
-          currentState = MAIN_MENU;
-          menuInitialized = false;
-          go_to_menu();
-          return;
-        }
-        // Prevent tight loop from blocking other processes
-        delay(50);
-      }
-    }
-    // Handle CANCEL button - go back to delete menu
-    else if (pressedButton == CANCEL_BTN) {
-      currentState = DELETE_ALARM;
-      menuPosition = 0;
-      menuInitialized = false;
-      return;
-    }
-    
-    // Prevent tight loop from blocking other processes
-    delay(50);
-  }
+// Single presses only; bursts (auto-repeat, encoder turns) are for the menus
+Button check_button_press() {
+  ButtonEvent ev = poll_input();
+  return ev.repeat ? NONE : ev.button;
 }
 
 // Check temperature and humidity
 void check_temp() {
-  float humidity = dht.readHumidity();
-  float temperature = dht.readTemperature();
-
-  if (isnan(humidity) || isnan(temperature)) {
+  float temperature, humidity;
+  trace_begin(TRACE_SENSOR_READ);
+  bool ok = hal_sensor_read(&temperature, &humidity);
+  trace_end(TRACE_SENSOR_READ, ok ? (int16_t)lroundf(temperature * 10) : INT16_MIN);
+  if (!ok) {
+    dhtFailures.inc();
     Serial.println("Failed to read from DHT sensor!");
     return;
   }
 
-  bool tempWarning = (temperature < MIN_HEALTHY_TEMP || temperature > MAX_HEALTHY_TEMP);
-  bool humidityWarning = (humidity < MIN_HEALTHY_HUMIDITY || humidity > MAX_HEALTHY_HUMIDITY);
+  telemetry_sensor_sample(temperature, humidity);
+  sensor_log_sample(temperature, humidity);
+  dashboard_update_sensor(temperature, humidity);
+
+  bool tempWarning = (temperature < settings.ranges.minTemp || temperature > settings.ranges.maxTemp);
+  bool humidityWarning = (humidity < settings.ranges.minHumidity || humidity > settings.ranges.maxHumidity);
 
   if (tempWarning || humidityWarning) {
+    uint32_t allocsBefore = alloc_stats_task_allocs();
     display.clearDisplay();
     display.setTextSize(1);
     display.setCursor(0, 0);
     
+    display.println(tr(STR_WARNING));
     if (tempWarning && humidityWarning) {
-      display.println("WARNING!");
-      display.println("Temp & Humidity Issues");
+      display.println(tr(STR_WARN_BOTH));
     } else if (tempWarning) {
-      display.println("WARNING!");
-      display.println("Temperature Issue");
+      display.println(tr(STR_WARN_TEMP));
     } else {
-      display.println("WARNING!");
-      display.println("Humidity Issue");
+      display.println(tr(STR_WARN_HUMIDITY));
     }
     
     display.println("");
-    display.print("Temp: ");
+    display.print(tr(STR_TEMP_LABEL));
     display.print(temperature, 1);
     display.println(" C");
-    display.print("Humidity: ");
+    display.print(tr(STR_HUMIDITY_LABEL));
     display.print(humidity, 1);
     display.println("%");
     
     if (tempWarning) {
-      display.print("Healthy temp: ");
-      display.print(MIN_HEALTHY_TEMP, 0);
+      display.print(tr(STR_HEALTHY_TEMP));
+      display.print(settings.ranges.minTemp, 0);
       display.print("-");
-      display.print(MAX_HEALTHY_TEMP, 0);
+      display.print(settings.ranges.maxTemp, 0);
       display.println("C");
     }
     
     if (humidityWarning) {
-      display.print("Healthy humidity: ");
-      display.print(MIN_HEALTHY_HUMIDITY, 0);
+      display.print(tr(STR_HEALTHY_HUMIDITY));
+      display.print(settings.ranges.minHumidity, 0);
       display.print("-");
-      display.print(MAX_HEALTHY_HUMIDITY, 0);
+      display.print(settings.ranges.maxHumidity, 0);
       display.println("%");
     }
     
-    display.display();
+    flush_display();
+    drawAllocs += alloc_stats_task_allocs() - allocsBefore;
     
     // Flash LED and sound buzzer
-    digitalWrite(LED_PIN, HIGH);
-    digitalWrite(BUZZER_PIN, HIGH);
-    delay(500);
-    digitalWrite(LED_PIN, LOW);
-    digitalWrite(BUZZER_PIN, LOW);
-    delay(500);
+    hal_pin_write(LED_PIN, true);
+    hal_pin_write(BUZZER_PIN, true);
+    hal_delay(500);
+    hal_pin_write(LED_PIN, false);
+    hal_pin_write(BUZZER_PIN, false);
+    hal_delay(500);
     
-    delay(4000); // Time to read warning
+    hal_delay(4000); // Time to read warning
   }
 }
 
 // Stop the currently ringing alarm
 void stop_alarm(bool snooze) {
-  digitalWrite(LED_PIN, LOW);
-  digitalWrite(BUZZER_PIN, LOW);
+  hal_pin_write(LED_PIN, false);
+  hal_pin_write(BUZZER_PIN, false);
+  
+  uint16_t responseSec = (hal_millis() - alarmStartTime) / 1000;
+  trace(snooze ? TRACE_ALARM_SNOOZE : TRACE_ALARM_STOP, alarmRingingNum);
+  telemetry_adherence(alarmRingingNum, snooze ? ADHERENCE_SNOOZED : ADHERENCE_DISMISSED, responseSec);
   
   if (snooze) {
     alarmSnoozing = true;
     alarmRinging = false;
-    snoozeStartTime = millis();
+    snoozeStartTime = hal_millis();
     
     display.clearDisplay();
     display.setTextSize(1);
     display.setCursor(0, 0);
-    display.println("Alarm Snoozed");
-    display.println("Will ring again in 5 min");
-    display.display();
-    delay(2000);
+    display.println(tr(STR_SNOOZED));
+    display.println(tr(STR_SNOOZE_HELP));
+    flush_display();
+    hal_delay(2000);
   } else {
     alarmRinging = false;
     alarmSnoozing = false;
@@ -973,18 +493,26 @@ void stop_alarm(bool snooze) {
     display.clearDisplay();
     display.setTextSize(1);
     display.setCursor(0, 0);
-    display.println("Alarm Stopped");
-    display.display();
-    delay(1000);
+    display.println(tr(STR_STOPPED));
+    flush_display();
+    hal_delay(1000);
   }
 }
 
 // Check if snoozed alarm should ring again
 void check_snooze() {
-  if (alarmSnoozing && (millis() - snoozeStartTime >= SNOOZE_DURATION)) {
+  if (alarmSnoozing && (hal_millis() - snoozeStartTime >= SNOOZE_DURATION)) {
     alarmSnoozing = false;
     ring_alarm(alarmRingingNum);
   }
 }
 
-
+// The SSD1306 driver always sends the whole frame buffer
+void flush_display() {
+  trace_begin(TRACE_DISPLAY_FLUSH);
+  display.display();
+  trace_end(TRACE_DISPLAY_FLUSH, SCREEN_WIDTH * SCREEN_HEIGHT / 8);
+  input_latency_frame();
+  displayFlushBytes.inc(SCREEN_WIDTH * SCREEN_HEIGHT / 8);
+  macro_note_flush(SCREEN_WIDTH * SCREEN_HEIGHT / 8);
+}
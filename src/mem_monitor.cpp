@@ -0,0 +1,197 @@
+/*
+ * Medibox - heap and task stack monitor (see mem_monitor.h)
+ */
+
+#include "mem_monitor.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include "metrics.h"
+#include "trace.h"
+
+struct MemSample {
+  uint32_t atMs;
+  uint32_t freeHeap;
+};
+
+static SemaphoreHandle_t lock = NULL;   // Watched task handles
+static TaskHandle_t tasks[MEM_TASK_COUNT];
+static int32_t stackFree[MEM_TASK_COUNT] = {-1, -1, -1, -1};
+static const char* const taskNames[] = {"loop", "http", "uplink", "ota"};
+
+static MemSample history[MEM_MONITOR_HISTORY];
+static uint8_t historyCount = 0;
+static uint8_t historyNext = 0;
+static uint32_t lastSampleMs = 0;
+static bool sampled = false;
+static int32_t trendPerMin = 0;         // Bytes of free heap per minute
+static uint32_t forecastS = 0;          // Until MEM_HEAP_CRITICAL_BYTES, 0 if not falling
+static MemAlert alert = MEM_OK;
+static uint8_t alertReasons = 0;
+
+MetricGauge heapFree("medibox_heap_free_bytes", "Free heap",
+                     [] { return (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT); });
+MetricGauge heapMinFree("medibox_heap_min_free_bytes", "Lowest free heap since boot",
+                        [] { return (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT); });
+MetricGauge heapLargestBlock("medibox_heap_largest_free_block_bytes",
+                             "Largest allocatable block",
+                             [] { return (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT); });
+// 0 while the free heap is one block, towards 100 as it splinters
+MetricGauge heapFragmentation("medibox_heap_fragmentation_percent",
+                              "Free heap not usable as one block", [] {
+  size_t free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  return free == 0 ? 0u : (uint32_t)(100 - largest * 100 / free);
+});
+static MetricGauge heapTrend("medibox_heap_trend_bytes_per_minute",
+                             "Change of the free heap over the last samples");
+static MetricGauge heapForecast("medibox_heap_exhaustion_forecast_seconds",
+                                "Until the free heap trend reaches the critical level, 0 if not falling");
+static MetricGauge alertLevel("medibox_memory_alert_level", "0 ok, 1 warning, 2 critical");
+static MetricCounter alertsRaised("medibox_memory_alerts_total",
+                                  "Times the memory alert rose to warning or critical");
+
+#define STACK_HELP "Least free stack the task has had, -1 while not running"
+static MetricGauge loopStack("medibox_task_stack_free_bytes", STACK_HELP, NULL, "task=\"loop\"");
+static MetricGauge httpStack("medibox_task_stack_free_bytes", STACK_HELP, NULL, "task=\"http\"");
+static MetricGauge uplinkStack("medibox_task_stack_free_bytes", STACK_HELP, NULL, "task=\"uplink\"");
+static MetricGauge otaStack("medibox_task_stack_free_bytes", STACK_HELP, NULL, "task=\"ota\"");
+static MetricGauge* const stackGauges[] = {&loopStack, &httpStack, &uplinkStack, &otaStack};
+
+static_assert(sizeof(taskNames) / sizeof(taskNames[0]) == MEM_TASK_COUNT, "a name per task");
+static_assert(sizeof(stackGauges) / sizeof(stackGauges[0]) == MEM_TASK_COUNT, "a gauge per task");
+
+void mem_monitor_begin() {
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+  for (MetricGauge* g : stackGauges) g->set(-1);
+}
+
+void mem_monitor_watch_current_task(MemTask task) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  tasks[task] = xTaskGetCurrentTaskHandle();
+  xSemaphoreGive(lock);
+}
+
+void mem_monitor_forget_task(MemTask task) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  tasks[task] = NULL;
+  stackFree[task] = -1;
+  stackGauges[task]->set(-1);
+  xSemaphoreGive(lock);
+}
+
+// Least-squares slope of the free heap over the history, per minute
+static int32_t heap_trend() {
+  float n = historyCount, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  uint32_t t0 = history[(historyNext + MEM_MONITOR_HISTORY - historyCount) % MEM_MONITOR_HISTORY].atMs;
+  for (uint8_t i = 0; i < historyCount; i++) {
+    const MemSample& s = history[(historyNext + MEM_MONITOR_HISTORY - historyCount + i) % MEM_MONITOR_HISTORY];
+    float x = (s.atMs - t0) / 60000.0f;
+    sx += x;
+    sy += s.freeHeap;
+    sxx += x * x;
+    sxy += x * s.freeHeap;
+  }
+  float d = n * sxx - sx * sx;
+  return d > 0 ? (int32_t)((n * sxy - sx * sy) / d) : 0;
+}
+
+static void sample(uint32_t now) {
+  uint32_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  history[historyNext] = {now, freeHeap};
+  historyNext = (historyNext + 1) % MEM_MONITOR_HISTORY;
+  if (historyCount < MEM_MONITOR_HISTORY) historyCount++;
+
+  MemAlert level = MEM_OK;
+  uint8_t reasons = 0;
+  if (freeHeap < MEM_HEAP_WARN_BYTES) {
+    reasons |= MEM_REASON_LOW_HEAP;
+    level = freeHeap < MEM_HEAP_CRITICAL_BYTES ? MEM_CRITICAL : MEM_WARNING;
+  }
+  if (largest < MEM_BLOCK_WARN_BYTES) {
+    reasons |= MEM_REASON_FRAGMENTED;
+    if (level < MEM_WARNING) level = MEM_WARNING;
+  }
+
+  trendPerMin = historyCount >= MEM_TREND_MIN_SAMPLES ? heap_trend() : 0;
+  forecastS = 0;
+  if (trendPerMin < 0) {
+    uint32_t margin = freeHeap > MEM_HEAP_CRITICAL_BYTES ? freeHeap - MEM_HEAP_CRITICAL_BYTES : 0;
+    forecastS = (uint32_t)(margin * 60.0f / -trendPerMin) + 1;
+    if (forecastS < MEM_FORECAST_WARN_S) {
+      reasons |= MEM_REASON_HEAP_FALLING;
+      if (level < MEM_WARNING) level = MEM_WARNING;
+    }
+  }
+
+  // The high-water mark is in bytes on the ESP32
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for (int t = 0; t < MEM_TASK_COUNT; t++) {
+    if (tasks[t] == NULL) continue;
+    stackFree[t] = uxTaskGetStackHighWaterMark(tasks[t]);
+    stackGauges[t]->set(stackFree[t]);
+    if (stackFree[t] < MEM_STACK_WARN_BYTES) {
+      reasons |= MEM_REASON_LOW_STACK;
+      MemAlert stackLevel = stackFree[t] < MEM_STACK_CRITICAL_BYTES ? MEM_CRITICAL : MEM_WARNING;
+      if (level < stackLevel) level = stackLevel;
+    }
+  }
+  xSemaphoreGive(lock);
+
+  heapTrend.set(trendPerMin);
+  heapForecast.set(forecastS);
+  alertLevel.set(level);
+  if (level == alert && reasons == alertReasons) return;
+  if (level > alert) alertsRaised.inc();
+  alert = level;
+  alertReasons = reasons;
+  trace(TRACE_MEMORY_ALERT, level | reasons << 8);
+  mem_monitor_report(Serial);
+}
+
+void mem_monitor_loop() {
+  uint32_t now = millis();
+  if (sampled && now - lastSampleMs < MEM_MONITOR_PERIOD_MS) return;
+  sampled = true;
+  lastSampleMs = now;
+  sample(now);
+}
+
+MemAlert mem_monitor_alert(uint8_t* reasons) {
+  if (reasons != NULL) *reasons = alertReasons;
+  return alert;
+}
+
+void mem_monitor_report(Print& out) {
+  static const char* const levels[] = {"ok", "warning", "critical"};
+  out.printf("Memory: %s%s%s%s%s\n", levels[alert],
+             alertReasons & MEM_REASON_LOW_HEAP ? ", low heap" : "",
+             alertReasons & MEM_REASON_FRAGMENTED ? ", fragmented" : "",
+             alertReasons & MEM_REASON_HEAP_FALLING ? ", heap falling" : "",
+             alertReasons & MEM_REASON_LOW_STACK ? ", low stack" : "");
+  out.printf("heap free %lu, lowest %lu, largest block %lu bytes\n",
+             (unsigned long)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+             (unsigned long)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+             (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+  if (historyCount < MEM_TREND_MIN_SAMPLES) {
+    out.println("trend: not enough samples yet");
+  } else if (forecastS > 0) {
+    out.printf("trend %ld bytes/min, critical in about %lu min\n", (long)trendPerMin,
+               (unsigned long)(forecastS + 59) / 60);
+  } else {
+    out.printf("trend %ld bytes/min\n", (long)trendPerMin);
+  }
+  out.println("task   stack free");
+  for (int t = 0; t < MEM_TASK_COUNT; t++) {
+    if (stackFree[t] < 0) {
+      out.printf("%-6s -\n", taskNames[t]);
+    } else {
+      out.printf("%-6s %ld\n", taskNames[t], (long)stackFree[t]);
+    }
+  }
+}
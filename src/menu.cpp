@@ -0,0 +1,243 @@
+/*
+ * Medibox - menu navigator and renderer (see menu.h)
+ */
+
+#include "menu.h"
+
+#include <Adafruit_SSD1306.h>
+
+#include "alloc_stats.h"
+#include "hal.h"
+#include "metrics.h"
+
+struct Frame {
+  const Screen* screen;
+  uint8_t arg;
+  uint8_t position;               // Selected item or field being edited
+  int16_t values[MENU_MAX_FIELDS];
+};
+
+static Adafruit_SSD1306* gfx = NULL;
+static void (*flushFn)() = NULL;
+static Frame stack[MENU_DEPTH];
+static uint8_t depth = 0;         // 0 while no menu is open
+static bool done = false;         // Showing the confirmation after a commit
+static unsigned long doneAt = 0;
+static bool dirty = false;        // A coalesced redraw is pending
+static unsigned long lastRender = 0;
+static uint32_t renderAllocs = 0;
+
+static MetricCounter redrawsSkipped("medibox_menu_redraws_coalesced_total",
+                                    "Menu redraws merged during a burst of input");
+
+static Frame& top() {
+  return stack[depth - 1];
+}
+
+static bool item_enabled(const Frame& f, uint8_t i) {
+  const MenuItem& item = f.screen->items[i];
+  return item.enabled == NULL || item.enabled(item.arg);
+}
+
+// Next enabled item from position in direction dir, or position if none
+static uint8_t step_item(const Frame& f, int dir) {
+  for (int i = f.position + dir; i >= 0 && i < f.screen->count; i += dir) {
+    if (item_enabled(f, i)) return i;
+  }
+  return f.position;
+}
+
+static int direction(Button button) {
+  return button == UP ? 1 : -1;
+}
+
+// Titles and labels are formats given arg + 1
+static void print_format(StrId format, uint8_t arg) {
+  char line[32];
+  snprintf(line, sizeof(line), tr(format), arg + 1);
+  gfx->println(line);
+}
+
+static void draw() {
+  const Frame& f = top();
+  const Screen& s = *f.screen;
+  gfx->clearDisplay();
+  gfx->setTextSize(1);
+  gfx->setCursor(0, 0);
+
+  if (done) {
+    print_format(s.doneTitle, f.arg);
+    if (s.kind == SCREEN_EDIT) s.draw(*gfx, f.arg, f.values);
+    flushFn();
+    return;
+  }
+
+  print_format(s.title, f.arg);
+  switch (s.kind) {
+    case SCREEN_MENU:
+      for (uint8_t i = 0; i < s.count; i++) {
+        const MenuItem& item = s.items[i];
+        bool enabled = item_enabled(f, i);
+        gfx->print(i == f.position && enabled ? "> " : "  ");
+        print_format(enabled || item.disabledLabel == STR_NONE ? item.label : item.disabledLabel,
+                     item.arg);
+      }
+      break;
+    case SCREEN_EDIT:
+      if (s.fields[f.position].label != STR_NONE) gfx->println(tr(s.fields[f.position].label));
+      s.draw(*gfx, f.arg, f.values);
+      if (s.footer == STR_NONE) {
+        gfx->println(tr(f.position + 1 < s.count ? STR_EDIT_HELP_NEXT : STR_EDIT_HELP_SET));
+      }
+      break;
+    case SCREEN_VIEW:
+      s.draw(*gfx, f.arg, f.values);
+      break;
+  }
+  if (s.footer != STR_NONE) gfx->print(tr(s.footer));
+  flushFn();
+}
+
+static void render() {
+  uint32_t allocsBefore = alloc_stats_task_allocs();
+  draw();
+  renderAllocs += alloc_stats_task_allocs() - allocsBefore;
+  dirty = false;
+  lastRender = hal_millis();
+}
+
+static void push(const Screen* screen, uint8_t arg) {
+  if (depth == MENU_DEPTH) return;
+  Frame& f = stack[depth++];
+  f.screen = screen;
+  f.arg = arg;
+  f.position = 0;
+  if (screen->load != NULL) screen->load(arg, f.values);
+  // Start menus on the first item that can be chosen
+  if (screen->kind == SCREEN_MENU && !item_enabled(f, 0)) f.position = step_item(f, 1);
+}
+
+// Back to the top menu with the selection reset, as after a commit
+static void return_to_root() {
+  depth = 1;
+  top().position = 0;
+  if (!item_enabled(top(), 0)) top().position = step_item(top(), 1);
+}
+
+static void back() {
+  depth--;
+}
+
+static void handle_menu(Frame& f, Button button, uint8_t count) {
+  const MenuItem& item = f.screen->items[f.position];
+  if (button == UP || button == DOWN) {
+    // UP moves towards the top of the list
+    while (count--) f.position = step_item(f, -direction(button));
+  } else if (button == OK_BTN && item_enabled(f, f.position)) {
+    if (item.child == NULL) {
+      back();
+    } else {
+      push(item.child, item.arg);
+    }
+  } else if (button == CANCEL_BTN) {
+    back();
+  }
+}
+
+static void commit(Frame& f) {
+  f.screen->commit(f.arg, f.values);
+  done = true;
+  doneAt = hal_millis();
+}
+
+static void handle_edit(Frame& f, Button button, uint8_t count) {
+  const EditField& field = f.screen->fields[f.position];
+  int16_t& v = f.values[f.position];
+  if (button == UP || button == DOWN) {
+    int next = v + direction(button) * count;
+    if (field.wrap) {
+      int range = field.max - field.min + 1;
+      next = field.min + ((next - field.min) % range + range) % range;
+    } else if (next > field.max) {
+      next = field.max;
+    } else if (next < field.min) {
+      next = field.min;
+    }
+    v = next;
+  } else if (button == OK_BTN) {
+    if (f.position + 1 < f.screen->count) {
+      f.position++;
+    } else {
+      commit(f);
+    }
+  } else if (button == CANCEL_BTN) {
+    back();
+  }
+}
+
+static void handle_view(Frame& f, Button button) {
+  if (button == OK_BTN && f.screen->commit != NULL) {
+    commit(f);
+  } else if (button == OK_BTN || button == CANCEL_BTN) {
+    back();
+  }
+}
+
+void menu_begin(Adafruit_SSD1306* display, void (*flush)()) {
+  gfx = display;
+  flushFn = flush;
+}
+
+void menu_open(const Screen* root) {
+  depth = 0;
+  done = false;
+  push(root, 0);
+  render();
+}
+
+bool menu_active() {
+  return depth > 0;
+}
+
+uint32_t menu_render_allocs() {
+  return renderAllocs;
+}
+
+ScreenKind menu_screen_kind() {
+  return depth > 0 ? top().screen->kind : SCREEN_MENU;
+}
+
+void menu_handle(const ButtonEvent& ev) {
+  if (depth == 0) return;
+  Button button = ev.button;
+  if (done) {
+    // A burst that is still going does not dismiss the message
+    if ((button == NONE || ev.repeat) && hal_millis() - doneAt < MENU_DONE_MS) return;
+    done = false;
+    return_to_root();
+    render();
+    return;
+  }
+  if (button == NONE) {
+    // Polls between repeats look the same as a released button, so a
+    // pending frame waits for the cap too; the last value of a burst is
+    // shown at most MENU_REPEAT_REDRAW_MS late
+    if (dirty && hal_millis() - lastRender >= MENU_REPEAT_REDRAW_MS) render();
+    return;
+  }
+
+  Frame& f = top();
+  switch (f.screen->kind) {
+    case SCREEN_MENU: handle_menu(f, button, ev.count); break;
+    case SCREEN_EDIT: handle_edit(f, button, ev.count); break;
+    case SCREEN_VIEW: if (!ev.repeat) handle_view(f, button); break;
+  }
+  if (depth == 0) return;
+  // A frame still pending is merged into this one and never drawn
+  if (dirty) redrawsSkipped.inc();
+  if (ev.repeat && hal_millis() - lastRender < MENU_REPEAT_REDRAW_MS) {
+    dirty = true;
+  } else {
+    render();
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ * Medibox - the menu screens (see menu.h)
+ */
+
+#include "menu.h"
+
+#include <Adafruit_GFX.h>
+
+#include "settings.h"
+
+// Editor values: alarms are {hour, minute}, the timezone is in half hours
+
+static void load_alarm(uint8_t arg, int16_t* values) {
+  values[0] = settings.alarms[arg].hour;
+  values[1] = settings.alarms[arg].minute;
+}
+
+static void draw_time(Adafruit_GFX& gfx, int16_t hour, int16_t minute, int16_t x, int16_t y) {
+  char text[sizeof("-32768:-32768")];
+  snprintf(text, sizeof(text), "%02d:%02d", hour, minute);
+  gfx.setTextSize(2);
+  gfx.setCursor(x, y);
+  gfx.print(text);
+  gfx.setTextSize(1);
+  gfx.setCursor(0, 50);
+}
+
+static void draw_alarm(Adafruit_GFX& gfx, uint8_t arg, const int16_t* values) {
+  draw_time(gfx, values[0], values[1], 40, 25);
+}
+
+// Both commits skip a no-op, which would bump the version and give
+// remote patch clients a false 409
+static void commit_alarm(uint8_t arg, const int16_t* values) {
+  settings_lock();
+  Alarm& alarm = settings.alarms[arg];
+  if (!alarm.active || alarm.hour != values[0] || alarm.minute != values[1]) {
+    alarm.hour = values[0];
+    alarm.minute = values[1];
+    alarm.active = true;
+    settings_commit_alarms(1u << arg);
+  }
+  settings_unlock();
+}
+
+static bool alarm_active(uint8_t arg) {
+  return settings.alarms[arg].active;
+}
+
+static void draw_delete_alarm(Adafruit_GFX& gfx, uint8_t arg, const int16_t* values) {
+  gfx.println(tr(STR_DELETE_CURRENT));
+  draw_time(gfx, values[0], values[1], 30, 25);
+}
+
+static void delete_alarm(uint8_t arg, const int16_t* values) {
+  settings_lock();
+  // Already gone if a remote client deleted it while this screen was up
+  if (settings.alarms[arg].active) {
+    settings.alarms[arg].active = false;
+    settings_commit_alarms(1u << arg);
+  }
+  settings_unlock();
+}
+
+static void draw_alarm_list(Adafruit_GFX& gfx, uint8_t arg, const int16_t* values) {
+  gfx.println();
+  bool any = false;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    const Alarm& a = settings.alarms[i];
+    if (!a.active) continue;
+    gfx.printf(tr(STR_ALARMS_ENTRY), i + 1, a.hour, a.minute);
+    any = true;
+  }
+  if (!any) gfx.println(tr(STR_ALARMS_NONE));
+}
+
+static void load_timezone(uint8_t arg, int16_t* values) {
+  values[0] = (int16_t)lroundf(settings.timeZoneOffset * 2);
+}
+
+static void draw_timezone(Adafruit_GFX& gfx, uint8_t arg, const int16_t* values) {
+  int halfHours = values[0] < 0 ? -values[0] : values[0];
+  gfx.printf(tr(STR_TIMEZONE_CURRENT), values[0] < 0 ? '-' : '+', halfHours / 2,
+             halfHours % 2 ? ":30" : "");
+}
+
+static void commit_timezone(uint8_t arg, const int16_t* values) {
+  settings_lock();
+  settings.timeZoneOffset = values[0] / 2.0f;
+  // loop() applies it on its next pass, no NTP round trip needed
+  settings_changed();
+  settings_unlock();
+}
+
+static constexpr EditField alarmFields[] = {
+  {STR_SET_HOUR, 0, 23, true},
+  {STR_SET_MINUTE, 0, 59, true},
+};
+
+static constexpr EditField timezoneFields[] = {
+  {STR_NONE, -24, 24, false},
+};
+
+static constexpr Screen alarmEditor = edit_screen(
+    STR_SET_ALARM_TITLE, alarmFields, count_of(alarmFields), load_alarm, draw_alarm, commit_alarm,
+    STR_ALARM_SET, STR_NONE);
+
+static constexpr Screen timezoneEditor = edit_screen(
+    STR_SET_TIMEZONE_TITLE, timezoneFields, count_of(timezoneFields), load_timezone,
+    draw_timezone, commit_timezone, STR_TIMEZONE_UPDATED, STR_TIMEZONE_HELP);
+
+static constexpr Screen alarmList = view_screen(
+    STR_ALARMS_TITLE, NULL, draw_alarm_list, NULL, STR_NONE, STR_ALARMS_HELP);
+
+static constexpr Screen deleteConfirm = view_screen(
+    STR_DELETE_TITLE, load_alarm, draw_delete_alarm, delete_alarm, STR_DELETED, STR_DELETE_HELP);
+
+// One row per alarm slot; a NULL child goes back one screen
+static constexpr MenuItem deleteItems[] = {
+  {STR_DELETE_ITEM, STR_DELETE_NOT_SET, &deleteConfirm, alarm_active, 0},
+  {STR_DELETE_ITEM, STR_DELETE_NOT_SET, &deleteConfirm, alarm_active, 1},
+  {STR_DELETE_BACK, STR_NONE, NULL, NULL, 0},
+};
+
+static constexpr Screen deleteMenu = menu_screen(
+    STR_DELETE_MENU_TITLE, deleteItems, count_of(deleteItems), STR_DELETE_MENU_HELP);
+
+static constexpr MenuItem mainItems[] = {
+  {STR_MENU_SET_TIMEZONE, STR_NONE, &timezoneEditor, NULL, 0},
+  {STR_MENU_SET_ALARM, STR_NONE, &alarmEditor, NULL, 0},
+  {STR_MENU_SET_ALARM, STR_NONE, &alarmEditor, NULL, 1},
+  {STR_MENU_VIEW_ALARMS, STR_NONE, &alarmList, NULL, 0},
+  {STR_MENU_DELETE_ALARM, STR_NONE, &deleteMenu, NULL, 0},
+  {STR_MENU_BACK, STR_NONE, NULL, NULL, 0},
+};
+
+static_assert(count_of(deleteItems) == MAX_ALARMS + 1, "one delete row per alarm slot");
+static_assert(count_of(mainItems) == MAX_ALARMS + 4, "one set row per alarm slot");
+
+constexpr Screen mainMenu = menu_screen(STR_MENU_TITLE, mainItems, count_of(mainItems), STR_NONE);
@@ -0,0 +1,88 @@
+/*
+ * Medibox - metrics registry rendered in Prometheus text format (see metrics.h)
+ */
+
+#include "metrics.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Constant-initialised, so it is valid before any static constructor runs
+static Metric* registry = NULL;
+
+Metric::Metric(const char* name, const char* help, MetricType type, const char* labels)
+    : name(name), help(help), type(type), labels(labels), next(registry) {
+  registry = this;
+}
+
+static const char* const typeNames[] = {"counter", "gauge", "histogram"};
+
+static bool emit(MetricSink sink, void* ctx, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static bool emit(MetricSink sink, void* ctx, const char* fmt, ...) {
+  char line[128];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (n < 0) return false;
+  return sink(ctx, line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+}
+
+static bool render_histogram(const MetricHistogram* h, MetricSink sink, void* ctx) {
+  // Labels go before le in the bucket lines, and in braces elsewhere
+  const char* labels = h->labels != NULL ? h->labels : "";
+  const char* comma = h->labels != NULL ? "," : "";
+  char braced[64] = "";
+  if (h->labels != NULL) snprintf(braced, sizeof(braced), "{%s}", h->labels);
+
+  // Buckets are read one by one while tasks keep observing, so the count
+  // is derived from the same reads to keep the output self-consistent
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i <= h->boundCount; i++) {
+    cumulative += __atomic_load_n(&h->buckets[i], __ATOMIC_RELAXED);
+    bool ok = i < h->boundCount
+                  ? emit(sink, ctx, "%s_bucket{%s%sle=\"%lu\"} %lu\n", h->name, labels, comma,
+                         (unsigned long)h->bounds[i], (unsigned long)cumulative)
+                  : emit(sink, ctx, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", h->name, labels, comma,
+                         (unsigned long)cumulative);
+    if (!ok) return false;
+  }
+  return emit(sink, ctx, "%s_sum%s %lu\n%s_count%s %lu\n", h->name, braced,
+              (unsigned long)__atomic_load_n(&h->sum, __ATOMIC_RELAXED), h->name, braced,
+              (unsigned long)cumulative);
+}
+
+bool metrics_render(MetricSink sink, void* ctx) {
+  const Metric* previous = NULL;
+  for (const Metric* m = registry; m != NULL; previous = m, m = m->next) {
+    // One header per family; its labelled series are adjacent
+    bool sameFamily = previous != NULL && strcmp(previous->name, m->name) == 0;
+    // Separate lines, as each must fit emit()'s buffer
+    if (!sameFamily && (!emit(sink, ctx, "# HELP %s %s\n", m->name, m->help) ||
+                        !emit(sink, ctx, "# TYPE %s %s\n", m->name, typeNames[m->type]))) {
+      return false;
+    }
+    bool ok = true;
+    const char* open = m->labels != NULL ? "{" : "";
+    const char* labels = m->labels != NULL ? m->labels : "";
+    const char* close = m->labels != NULL ? "}" : "";
+    switch (m->type) {
+      case METRIC_COUNTER:
+        ok = emit(sink, ctx, "%s%s%s%s %lu\n", m->name, open, labels, close,
+                  (unsigned long)static_cast<const MetricCounter*>(m)->get());
+        break;
+      case METRIC_GAUGE:
+        ok = emit(sink, ctx, "%s%s%s%s %ld\n", m->name, open, labels, close,
+                  (long)static_cast<const MetricGauge*>(m)->get());
+        break;
+      case METRIC_HISTOGRAM:
+        ok = render_histogram(static_cast<const MetricHistogram*>(m), sink, ctx);
+        break;
+    }
+    if (!ok) return false;
+  }
+  return true;
+}
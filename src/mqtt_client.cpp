@@ -0,0 +1,287 @@
+/*
+ * Medibox - minimal MQTT 3.1.1 publisher (see mqtt_client.h)
+ */
+
+#include "mqtt_client.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "metrics.h"
+
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+#define MQTT_DUP_FLAG 0x08
+
+struct InflightSlot {
+  bool used;
+  uint16_t packetId;
+  unsigned long sentAt;
+  size_t len;
+  uint8_t packet[MQTT_MAX_PACKET];
+};
+
+static WiFiClient client;
+static bool sessionUp = false;
+static uint32_t keepAliveMs = 0;
+static unsigned long lastSend = 0;
+static unsigned long lastReceive = 0;
+static uint16_t nextPacketId = 1;
+
+static InflightSlot inflight[MQTT_MAX_INFLIGHT];
+static uint8_t scratch[MQTT_MAX_PACKET];   // QoS 0 and control packets
+static MqttMetrics metrics = {};
+
+static MetricCounter publishedMetric("medibox_mqtt_published_total", "MQTT messages published",
+                                     [] { return metrics.published; });
+static MetricCounter retransmitsMetric("medibox_mqtt_retransmits_total",
+                                       "MQTT QoS 1 messages sent again",
+                                       [] { return metrics.retransmits; });
+static MqttAckHandler ackHandler = NULL;
+
+// Incoming packet parser state
+static uint8_t rxHeader = 0;
+static uint32_t rxRemaining = 0;
+static uint8_t rxShift = 0;
+static bool rxInLength = false;
+static uint8_t rxBody[8];
+static size_t rxLen = 0;
+
+static size_t put_length(uint8_t* p, size_t n) {
+  size_t i = 0;
+  do {
+    uint8_t b = n % 128;
+    n /= 128;
+    p[i++] = n ? (b | 0x80) : b;
+  } while (n);
+  return i;
+}
+
+static size_t put_string(uint8_t* p, const char* s, size_t len) {
+  p[0] = len >> 8;
+  p[1] = len & 0xFF;
+  memcpy(p + 2, s, len);
+  return len + 2;
+}
+
+static bool send_raw(const uint8_t* data, size_t len) {
+  if (client.write(data, len) != len) {
+    mqtt_disconnect();
+    return false;
+  }
+  metrics.bytesSent += len;
+  lastSend = millis();
+  return true;
+}
+
+// Builds a complete PUBLISH packet into dst, returns its size or 0
+static size_t build_publish(uint8_t* dst, const char* topic, const uint8_t* payload,
+                            size_t len, uint8_t qos, uint16_t packetId) {
+  size_t topicLen = strlen(topic);
+  size_t remaining = 2 + topicLen + (qos ? 2 : 0) + len;
+  if (remaining + 5 > MQTT_MAX_PACKET) return 0;
+
+  size_t i = 0;
+  dst[i++] = MQTT_PUBLISH | (qos << 1);
+  i += put_length(dst + i, remaining);
+  i += put_string(dst + i, topic, topicLen);
+  if (qos) {
+    dst[i++] = packetId >> 8;
+    dst[i++] = packetId & 0xFF;
+  }
+  memcpy(dst + i, payload, len);
+  return i + len;
+}
+
+static void handle_packet(uint8_t header, const uint8_t* body, size_t len) {
+  if ((header & 0xF0) == MQTT_PUBACK && len >= 2) {
+    uint16_t id = (body[0] << 8) | body[1];
+    for (int i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+      if (inflight[i].used && inflight[i].packetId == id) {
+        inflight[i].used = false;
+        metrics.acked++;
+        if (ackHandler != NULL) ackHandler(id);
+        break;
+      }
+    }
+  }
+  // CONNACK is consumed in mqtt_connect(), PINGRESP only refreshes lastReceive
+}
+
+// Feed received bytes through a small parser; unknown payloads are skipped
+static void read_packets() {
+  while (client.available() > 0) {
+    int c = client.read();
+    if (c < 0) break;
+    lastReceive = millis();
+
+    if (rxHeader == 0) {
+      rxHeader = c;
+      rxRemaining = 0;
+      rxShift = 0;
+      rxLen = 0;
+      rxInLength = true;
+      continue;
+    }
+    if (rxInLength) {
+      rxRemaining |= (uint32_t)(c & 0x7F) << rxShift;
+      rxShift += 7;
+      if (c & 0x80) continue;
+      rxInLength = false;
+    } else {
+      if (rxLen < sizeof(rxBody)) rxBody[rxLen] = c;
+      rxLen++;
+    }
+    if (rxLen == rxRemaining) {
+      handle_packet(rxHeader, rxBody, rxLen < sizeof(rxBody) ? rxLen : sizeof(rxBody));
+      rxHeader = 0;
+    }
+  }
+}
+
+static void resend(InflightSlot& slot) {
+  slot.packet[0] |= MQTT_DUP_FLAG;
+  slot.sentAt = millis();
+  if (send_raw(slot.packet, slot.len)) {
+    metrics.retransmits++;
+  }
+}
+
+bool mqtt_connect(const char* host, uint16_t port, const char* clientId, uint16_t keepAliveS) {
+  mqtt_disconnect();
+  if (!client.connect(host, port)) {
+    return false;
+  }
+  client.setNoDelay(true);
+
+  size_t idLen = strlen(clientId);
+  size_t remaining = 10 + 2 + idLen;
+  size_t i = 0;
+  scratch[i++] = MQTT_CONNECT;
+  i += put_length(scratch + i, remaining);
+  i += put_string(scratch + i, "MQTT", 4);
+  scratch[i++] = 4;            // protocol level 3.1.1
+  scratch[i++] = 0x02;         // clean session
+  scratch[i++] = keepAliveS >> 8;
+  scratch[i++] = keepAliveS & 0xFF;
+  i += put_string(scratch + i, clientId, idLen);
+  rxHeader = 0;
+  if (!send_raw(scratch, i)) return false;
+
+  // Wait for CONNACK; this runs in the uplink task so blocking is fine
+  unsigned long start = millis();
+  uint8_t ack[4];
+  size_t got = 0;
+  while (got < sizeof(ack) && millis() - start < MQTT_CONNECT_TIMEOUT_MS) {
+    if (client.available() > 0) {
+      ack[got++] = client.read();
+    } else {
+      delay(10);
+    }
+  }
+  if (got < sizeof(ack) || ack[0] != MQTT_CONNACK || ack[3] != 0) {
+    mqtt_disconnect();
+    return false;
+  }
+
+  sessionUp = true;
+  keepAliveMs = keepAliveS * 1000UL;
+  lastReceive = millis();
+  metrics.connects++;
+
+  // Clean session: anything still unacknowledged goes out again
+  for (int s = 0; s < MQTT_MAX_INFLIGHT; s++) {
+    if (inflight[s].used) resend(inflight[s]);
+  }
+  return sessionUp;
+}
+
+void mqtt_disconnect() {
+  if (sessionUp) {
+    uint8_t pkt[2] = {MQTT_DISCONNECT, 0};
+    client.write(pkt, sizeof(pkt));
+  }
+  sessionUp = false;
+  client.stop();
+}
+
+bool mqtt_connected() {
+  return sessionUp && client.connected();
+}
+
+bool mqtt_publish(const char* topic, const uint8_t* payload, size_t len, uint8_t qos,
+                  uint16_t* packetId) {
+  if (!mqtt_connected()) return false;
+
+  if (qos == 0) {
+    size_t n = build_publish(scratch, topic, payload, len, 0, 0);
+    if (n == 0 || !send_raw(scratch, n)) return false;
+    metrics.published++;
+    return true;
+  }
+
+  for (int i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+    InflightSlot& slot = inflight[i];
+    if (slot.used) continue;
+
+    uint16_t id = nextPacketId++;
+    if (nextPacketId == 0) nextPacketId = 1;
+    size_t n = build_publish(slot.packet, topic, payload, len, 1, id);
+    if (n == 0) return false;
+
+    slot.used = true;
+    slot.packetId = id;
+    slot.len = n;
+    slot.sentAt = millis();
+    metrics.published++;
+    if (packetId != NULL) *packetId = id;
+    // Even if the write fails the slot stays queued for the next session
+    send_raw(slot.packet, n);
+    return true;
+  }
+  return false;
+}
+
+void mqtt_on_ack(MqttAckHandler handler) {
+  ackHandler = handler;
+}
+
+void mqtt_poll() {
+  if (!mqtt_connected()) {
+    sessionUp = false;
+    return;
+  }
+  read_packets();
+
+  unsigned long now = millis();
+  for (int i = 0; i < MQTT_MAX_INFLIGHT && sessionUp; i++) {
+    if (inflight[i].used && now - inflight[i].sentAt >= MQTT_RETRY_MS) {
+      resend(inflight[i]);
+    }
+  }
+
+  if (keepAliveMs == 0 || !sessionUp) return;
+  if (now - lastReceive > keepAliveMs * 3 / 2) {
+    mqtt_disconnect(); // Broker went quiet
+  } else if (now - lastSend >= keepAliveMs / 2) {
+    uint8_t ping[2] = {MQTT_PINGREQ, 0};
+    send_raw(ping, sizeof(ping));
+  }
+}
+
+int mqtt_inflight() {
+  int n = 0;
+  for (int i = 0; i < MQTT_MAX_INFLIGHT; i++) {
+    if (inflight[i].used) n++;
+  }
+  return n;
+}
+
+void mqtt_metrics(MqttMetrics* out) {
+  *out = metrics;
+}
@@ -0,0 +1,161 @@
+/*
+ * Medibox - MQTT telemetry uplink (see mqtt_telemetry.h)
+ */
+
+#include "mqtt_telemetry.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "flash_queue.h"
+#include "flash_storage.h"
+#include "mem_monitor.h"
+#include "mqtt_client.h"
+#include "telemetry.h"
+#include "wifi_manager.h"
+
+#define UPLINK_STACK 4096
+#define UPLINK_POLL_MS 100
+#define RECONNECT_MS 5000
+
+static volatile uint32_t publishPeriodMs = MQTT_PUBLISH_PERIOD_MS;
+static char deviceId[20];
+static char topic[48];
+static bool persistent = false;
+
+// Records read from the flash queue but not yet handed to the MQTT client
+static TelemetryRecord batch[MQTT_BATCH_MAX];
+static size_t batchCount = 0;
+static uint32_t batchSeq = 0;
+static char payload[MQTT_MAX_PACKET - 64];
+
+// Published batches in send order; the queue is truncated strictly in
+// this order even if the broker acknowledges out of order
+struct PendingAck {
+  uint16_t packetId;
+  uint16_t count;
+  bool acked;
+};
+static PendingAck pendingAcks[MQTT_MAX_INFLIGHT];
+static size_t pendingCount = 0;
+
+static void on_ack(uint16_t packetId) {
+  for (size_t i = 0; i < pendingCount; i++) {
+    if (pendingAcks[i].packetId == packetId) pendingAcks[i].acked = true;
+  }
+  size_t done = 0;
+  while (done < pendingCount && pendingAcks[done].acked) {
+    flash_queue_ack(pendingAcks[done].count);
+    done++;
+  }
+  if (done > 0) {
+    memmove(pendingAcks, pendingAcks + done, (pendingCount - done) * sizeof(PendingAck));
+    pendingCount -= done;
+  }
+}
+
+// Move everything the sampler produced into the flash queue
+static void store_records() {
+  TelemetryRecord rec;
+  while (persistent && telemetry_pop(&rec, 0)) {
+    flash_queue_push(rec);
+  }
+}
+
+static size_t next_records(TelemetryRecord* out, size_t max) {
+  if (persistent) return flash_queue_read(out, max);
+  size_t n = 0;
+  while (n < max && telemetry_pop(&out[n], 0)) n++;
+  return n;
+}
+
+// Encode the next batch and hand it to the client; false if it must wait
+static bool publish_batch() {
+  if (batchCount == 0) {
+    batchCount = next_records(batch, MQTT_BATCH_MAX);
+  }
+  if (batchCount == 0) return true;
+  if (pendingCount == MQTT_MAX_INFLIGHT) return false;
+
+  size_t len = 0;
+  size_t used = telemetry_encode_json(payload, sizeof(payload), deviceId, batchSeq,
+                                      batch, batchCount, &len);
+  if (used == 0) {
+    flash_queue_ack(batchCount);  // Cannot happen with sane sizes; drop rather than wedge
+    batchCount = 0;
+    return true;
+  }
+  uint16_t packetId = 0;
+  if (!mqtt_publish(topic, (const uint8_t*)payload, len, 1, &packetId)) {
+    return false;    // Window full or link down, keep the batch
+  }
+
+  pendingAcks[pendingCount++] = {packetId, (uint16_t)used, false};
+  batchSeq++;
+  memmove(batch, batch + used, (batchCount - used) * sizeof(TelemetryRecord));
+  batchCount -= used;
+  return true;
+}
+
+static bool backlog_empty() {
+  FlashQueueStats s;
+  flash_queue_stats(&s);
+  return s.unread == 0 && telemetry_pending() == 0 && batchCount == 0;
+}
+
+static void uplink_task(void* arg) {
+  mem_monitor_watch_current_task(MEM_TASK_UPLINK);
+  unsigned long lastPublish = millis();
+  unsigned long lastDrain = 0;
+  unsigned long lastAttempt = 0;
+
+  for (;;) {
+    store_records();
+
+    if (!wifi_manager_connected()) {
+      if (mqtt_connected()) mqtt_disconnect();
+    } else if (!mqtt_connected()) {
+      if (millis() - lastAttempt >= RECONNECT_MS) {
+        lastAttempt = millis();
+        mqtt_connect(MQTT_BROKER_HOST, MQTT_BROKER_PORT, deviceId, MQTT_KEEPALIVE_S);
+      }
+    } else {
+      mqtt_poll();
+      // Once due, keep draining one batch per interval until caught up so
+      // a week of backlog does not monopolise the flash and the radio
+      if (millis() - lastPublish >= publishPeriodMs &&
+          millis() - lastDrain >= MQTT_DRAIN_INTERVAL_MS) {
+        lastDrain = millis();
+        if (publish_batch() && backlog_empty()) {
+          lastPublish = millis();
+        }
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(UPLINK_POLL_MS));
+  }
+}
+
+void mqtt_telemetry_begin() {
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  snprintf(deviceId, sizeof(deviceId), "medibox-%02x%02x%02x", mac[3], mac[4], mac[5]);
+  snprintf(topic, sizeof(topic), "medibox/%s/telemetry", deviceId);
+
+  persistent = flash_queue_begin(flash_storage_partition(TELEMETRY_PARTITION));
+  if (!persistent) {
+    Serial.println("telemetry: no flash queue, records are lost while offline");
+  }
+  mqtt_on_ack(on_ack);
+
+  xTaskCreatePinnedToCore(uplink_task, "mqtt_uplink", UPLINK_STACK, NULL, 1, NULL, 0);
+}
+
+void mqtt_telemetry_set_period(uint32_t periodMs) {
+  publishPeriodMs = periodMs;
+}
+
+const char* mqtt_telemetry_device_id() {
+  return deviceId;
+}
@@ -0,0 +1,316 @@
+/*
+ * Medibox - streaming firmware update over HTTP (see ota_update.h)
+ */
+
+#include "ota_update.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mbedtls/sha256.h>
+
+#include "mem_monitor.h"
+
+#define OTA_STACK 6144
+#define OTA_NVS "ota"
+#define HASH_LEN 32
+#define LINE_MAX 128
+
+enum Result { DONE, RETRY, FATAL };
+
+static volatile OtaState state = OTA_IDLE;
+static volatile uint32_t offset = 0;
+static volatile uint32_t imageSize = 0;
+static volatile uint32_t resumes = 0;
+static const char* volatile error = NULL;
+
+static char host[32];
+static uint16_t port = 0;
+static TaskHandle_t task = NULL;
+
+// Only touched by the update task
+static WiFiClient client;
+static const esp_partition_t* target = NULL;
+static mbedtls_sha256_context sha;
+static uint8_t expected[HASH_LEN];
+static uint8_t chunk[OTA_CHUNK];
+
+static Result fail(const char* why) {
+  error = why;
+  return FATAL;
+}
+
+// Reads exactly len bytes, giving up after OTA_IO_TIMEOUT_MS without progress
+static bool read_exact(uint8_t* dst, size_t len) {
+  size_t got = 0;
+  unsigned long lastProgress = millis();
+  while (got < len) {
+    int avail = client.available();
+    if (avail > 0) {
+      int n = client.read(dst + got, len - got);
+      if (n > 0) {
+        got += n;
+        lastProgress = millis();
+        continue;
+      }
+    }
+    if (!client.connected() || millis() - lastProgress >= OTA_IO_TIMEOUT_MS) return false;
+    delay(5);
+  }
+  return true;
+}
+
+static bool read_line(char* line, size_t cap) {
+  size_t n = 0;
+  uint8_t c;
+  while (read_exact(&c, 1)) {
+    if (c == '\n') {
+      if (n > 0 && line[n - 1] == '\r') n--;
+      line[n] = '\0';
+      return true;
+    }
+    if (n < cap - 1) line[n++] = c;
+  }
+  return false;
+}
+
+// Sends a ranged GET and parses the headers. Returns the HTTP status or
+// -1; rangeStart and total come from Content-Range on a 206
+static int http_get(const char* path, uint32_t from, uint32_t* length,
+                    uint32_t* rangeStart, uint32_t* total) {
+  client.stop();
+  if (!client.connect(host, port)) return -1;
+
+  char line[LINE_MAX];
+  int len = snprintf(line, sizeof(line),
+                     "GET %s HTTP/1.1\r\nHost: %s\r\nRange: bytes=%lu-\r\n"
+                     "Connection: close\r\n\r\n",
+                     path, host, (unsigned long)from);
+  if (client.write((const uint8_t*)line, len) != (size_t)len) return -1;
+
+  int status = -1;
+  if (!read_line(line, sizeof(line)) || sscanf(line, "HTTP/%*s %d", &status) != 1) return -1;
+
+  *length = 0;
+  *rangeStart = 0;
+  *total = 0;
+  while (read_line(line, sizeof(line))) {
+    if (line[0] == '\0') return status;
+    unsigned long a, b, c;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      *length = strtoul(line + 15, NULL, 10);
+    } else if (strncasecmp(line, "Content-Range:", 14) == 0 &&
+               sscanf(line + 14, " bytes %lu-%lu/%lu", &a, &b, &c) == 3) {
+      *rangeStart = a;
+      *total = c;
+    }
+  }
+  return -1;
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static Result fetch_hash() {
+  uint32_t length, rangeStart, total;
+  int status = http_get(OTA_HASH_PATH, 0, &length, &rangeStart, &total);
+  if (status < 0) return RETRY;
+  if (status != 200 && status != 206) return fail("no hash file");
+
+  char hex[HASH_LEN * 2];
+  if (!read_exact((uint8_t*)hex, sizeof(hex))) return RETRY;
+  for (int i = 0; i < HASH_LEN; i++) {
+    int hi = hex_value(hex[2 * i]), lo = hex_value(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0) return fail("bad hash file");
+    expected[i] = hi << 4 | lo;
+  }
+  return DONE;
+}
+
+static void save_checkpoint() {
+  Preferences prefs;
+  if (!prefs.begin(OTA_NVS, false)) return;
+  prefs.putBytes("hash", expected, HASH_LEN);
+  prefs.putUInt("addr", target->address);
+  prefs.putUInt("size", imageSize);
+  prefs.putUInt("offset", offset);
+  prefs.end();
+}
+
+static void clear_checkpoint() {
+  Preferences prefs;
+  if (!prefs.begin(OTA_NVS, false)) return;
+  prefs.remove("offset");
+  prefs.end();
+}
+
+static void restart_hash() {
+  mbedtls_sha256_starts_ret(&sha, 0);
+  offset = 0;
+}
+
+// Picks up an interrupted download of the same image into the same slot,
+// rebuilding the hash state from what is already in flash
+static void resume_checkpoint() {
+  restart_hash();
+  Preferences prefs;
+  if (!prefs.begin(OTA_NVS, true)) return;
+  uint8_t hash[HASH_LEN];
+  bool same = prefs.getBytes("hash", hash, HASH_LEN) == HASH_LEN &&
+              memcmp(hash, expected, HASH_LEN) == 0 &&
+              prefs.getUInt("addr", 0) == target->address;
+  uint32_t saved = same ? prefs.getUInt("offset", 0) : 0;
+  imageSize = same ? prefs.getUInt("size", 0) : 0;
+  prefs.end();
+
+  while (offset < saved) {
+    if (esp_partition_read(target, offset, chunk, OTA_CHUNK) != ESP_OK) {
+      restart_hash();
+      return;
+    }
+    mbedtls_sha256_update_ret(&sha, chunk, OTA_CHUNK);
+    offset += OTA_CHUNK;
+  }
+}
+
+static Result download() {
+  uint32_t length, rangeStart, total;
+  int status = http_get(OTA_IMAGE_PATH, offset, &length, &rangeStart, &total);
+  if (status < 0) return RETRY;
+  if (status == 416 && imageSize > 0 && offset == imageSize) return DONE;
+  if (status == 200) {
+    // Server ignored the Range header, start over
+    if (offset > 0) restart_hash();
+    total = length;
+  } else if (status != 206 || rangeStart != offset) {
+    return fail("unexpected HTTP response");
+  }
+  if (total == 0) return fail("image size unknown");
+  if (total > target->size) return fail("image larger than partition");
+  if (imageSize != 0 && total != imageSize) {
+    // A different image than the checkpoint was taken from
+    imageSize = 0;
+    client.stop();
+    restart_hash();
+    return RETRY;
+  }
+  imageSize = total;
+
+  while (offset < imageSize) {
+    size_t n = imageSize - offset < OTA_CHUNK ? imageSize - offset : OTA_CHUNK;
+    if (!read_exact(chunk, n)) return RETRY;
+    if (esp_partition_erase_range(target, offset, OTA_CHUNK) != ESP_OK ||
+        esp_partition_write(target, offset, chunk, n) != ESP_OK) {
+      return fail("flash write failed");
+    }
+    mbedtls_sha256_update_ret(&sha, chunk, n);
+    offset += n;
+    if (offset % OTA_CHECKPOINT_BYTES == 0) save_checkpoint();
+  }
+  return DONE;
+}
+
+static Result run_update() {
+  target = esp_ota_get_next_update_partition(NULL);
+  if (target == NULL) return fail("no OTA partition");
+
+  Result r = RETRY;
+  for (uint32_t attempt = 0; r == RETRY && attempt <= OTA_MAX_RETRIES; attempt++) {
+    if (attempt > 0) delay(OTA_RETRY_MS);
+    r = fetch_hash();
+  }
+  if (r != DONE) return r == FATAL ? r : fail("hash download failed");
+
+  resume_checkpoint();
+  r = RETRY;
+  for (uint32_t attempt = 0; r == RETRY && attempt <= OTA_MAX_RETRIES; attempt++) {
+    if (attempt > 0) {
+      resumes++;
+      delay(OTA_RETRY_MS);
+    }
+    r = download();
+  }
+  client.stop();
+  if (r != DONE) return r == FATAL ? r : fail("too many retries");
+
+  state = OTA_VERIFYING;
+  uint8_t actual[HASH_LEN];
+  mbedtls_sha256_finish_ret(&sha, actual);
+  if (memcmp(actual, expected, HASH_LEN) != 0) {
+    clear_checkpoint();
+    return fail("hash mismatch");
+  }
+  // Also validates the image header and checksum
+  if (esp_ota_set_boot_partition(target) != ESP_OK) {
+    clear_checkpoint();
+    return fail("image rejected");
+  }
+  clear_checkpoint();
+  return DONE;
+}
+
+static void ota_task(void* arg) {
+  mem_monitor_watch_current_task(MEM_TASK_OTA);
+  mbedtls_sha256_init(&sha);
+  Result r = run_update();
+  mbedtls_sha256_free(&sha);
+
+  if (r == DONE) {
+    Serial.println("OTA: update verified, restarting");
+    state = OTA_REBOOTING;
+    delay(1000);
+    esp_restart();
+  }
+  Serial.printf("OTA: failed at %lu/%lu: %s\n", (unsigned long)offset,
+                (unsigned long)imageSize, error);
+  state = OTA_FAILED;
+  task = NULL;
+  mem_monitor_forget_task(MEM_TASK_OTA);
+  vTaskDelete(NULL);
+}
+
+bool ota_update_start(const char* serverHost, uint16_t serverPort) {
+  if (task != NULL || strlen(serverHost) >= sizeof(host)) return false;
+  strcpy(host, serverHost);
+  port = serverPort;
+  offset = 0;
+  imageSize = 0;
+  resumes = 0;
+  error = NULL;
+  state = OTA_DOWNLOADING;
+  if (xTaskCreatePinnedToCore(ota_task, "ota", OTA_STACK, NULL, 1, &task, 0) != pdPASS) {
+    task = NULL;
+    state = OTA_FAILED;
+    error = "no memory for task";
+    return false;
+  }
+  return true;
+}
+
+void ota_update_status(OtaStatus* out) {
+  out->state = state;
+  out->offset = offset;
+  out->size = imageSize;
+  out->resumes = resumes;
+  out->error = error;
+}
+
+const char* ota_state_name(OtaState s) {
+  switch (s) {
+    case OTA_IDLE: return "idle";
+    case OTA_DOWNLOADING: return "downloading";
+    case OTA_VERIFYING: return "verifying";
+    case OTA_REBOOTING: return "rebooting";
+    case OTA_FAILED: return "failed";
+  }
+  return "unknown";
+}
@@ -0,0 +1,518 @@
+/*
+ * Medibox - REST API for alarms and settings (see rest_api.h)
+ */
+
+#include "rest_api.h"
+
+#include <Arduino.h>
+#include <esp_system.h>
+
+#include "alarm_patch.h"
+#include "http_server.h"
+#include "input_macro.h"
+#include "lttb.h"
+#include "metrics.h"
+#include "ota_update.h"
+#include "sensor_log.h"
+#include "settings.h"
+#include "trace.h"
+#include "web_ui.h"
+
+static void write_alarm(JsonWriter& w, int index, const Alarm& a) {
+  w.begin_object();
+  w.key("id");
+  w.value((int32_t)(index + 1));
+  w.key("active");
+  w.value(a.active);
+  w.key("hour");
+  w.value((int32_t)a.hour);
+  w.key("minute");
+  w.value((int32_t)a.minute);
+  w.end_object();
+}
+
+static void send_alarm(HttpResponse& res, int status, int index) {
+  JsonWriter& w = res.begin_json(status);
+  write_alarm(w, index, settings.alarms[index]);
+  res.end();
+}
+
+// Applies the fields present in the body; false if any is invalid
+static bool apply_alarm(const JsonFlatParser& body, Alarm& alarm) {
+  long hour = alarm.hour, minute = alarm.minute;
+  bool active = alarm.active;
+  if (body.find("hour") && (!body.get_int("hour", &hour) || hour < 0 || hour > 23)) return false;
+  if (body.find("minute") && (!body.get_int("minute", &minute) || minute < 0 || minute > 59)) return false;
+  if (body.find("active") && !body.get_bool("active", &active)) return false;
+
+  alarm.hour = hour;
+  alarm.minute = minute;
+  alarm.active = active;
+  return true;
+}
+
+static bool same_alarm(const Alarm& a, const Alarm& b) {
+  return a.active == b.active && a.hour == b.hour && a.minute == b.minute;
+}
+
+static void handle_alarms(HttpRequest& req, HttpResponse& res, const char* idPart) {
+  if (*idPart == '\0') {
+    if (req.method == HTTP_GET) {
+      JsonWriter& w = res.begin_json(200);
+      w.begin_array();
+      for (int i = 0; i < MAX_ALARMS; i++) {
+        write_alarm(w, i, settings.alarms[i]);
+      }
+      w.end_array();
+      res.end();
+    } else if (req.method == HTTP_POST) {
+      if (!req.body.complete()) return res.send_status(400);
+      settings_lock();
+      int slot = -1;
+      for (int i = 0; i < MAX_ALARMS && slot < 0; i++) {
+        if (!settings.alarms[i].active) slot = i;
+      }
+      if (slot < 0) {
+        settings_unlock();
+        return res.send_status(409);
+      }
+      Alarm alarm = {true, 0, 0};
+      bool ok = req.body.find("hour") && req.body.find("minute") && apply_alarm(req.body, alarm);
+      if (ok) {
+        alarm.active = true;
+        settings.alarms[slot] = alarm;
+        settings_commit_alarms(1u << slot);
+      }
+      settings_unlock();
+      if (!ok) return res.send_status(422);
+      send_alarm(res, 201, slot);
+    } else {
+      res.send_status(405);
+    }
+    return;
+  }
+
+  if (idPart[0] != '/') return res.send_status(404);
+  char* end;
+  long id = strtol(idPart + 1, &end, 10);
+  if (*end != '\0' || id < 1 || id > MAX_ALARMS) return res.send_status(404);
+  int index = id - 1;
+
+  if (req.method == HTTP_GET) {
+    send_alarm(res, 200, index);
+  } else if (req.method == HTTP_PUT) {
+    if (!req.body.complete()) return res.send_status(400);
+    settings_lock();
+    Alarm alarm = settings.alarms[index];
+    bool ok = apply_alarm(req.body, alarm);
+    // A no-op must not bump the version, or patch clients get a false 409
+    if (ok && !same_alarm(alarm, settings.alarms[index])) {
+      settings.alarms[index] = alarm;
+      settings_commit_alarms(1u << index);
+    }
+    settings_unlock();
+    if (!ok) return res.send_status(422);
+    send_alarm(res, 200, index);
+  } else if (req.method == HTTP_DELETE) {
+    settings_lock();
+    if (settings.alarms[index].active) {
+      settings.alarms[index].active = false;
+      settings_commit_alarms(1u << index);
+    }
+    settings_unlock();
+    res.send_status(204);
+  } else {
+    res.send_status(405);
+  }
+}
+
+// Versioned view of the whole table; the version is the base for patches
+static void send_alarm_set(HttpResponse& res, int status) {
+  // Snapshot under the lock so version and entries match, send without it
+  Alarm alarms[MAX_ALARMS];
+  settings_lock();
+  uint32_t version = settings.alarmVersion;
+  memcpy(alarms, settings.alarms, sizeof(alarms));
+  settings_unlock();
+
+  JsonWriter& w = res.begin_json(status);
+  w.begin_object();
+  w.key("version");
+  w.value(version);
+  w.key("alarms");
+  w.begin_array();
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    write_alarm(w, i, alarms[i]);
+  }
+  w.end_array();
+  w.end_object();
+  res.end();
+}
+
+static void handle_alarm_set(HttpRequest& req, HttpResponse& res) {
+  if (req.method == HTTP_PATCH) {
+    if (!req.body.complete()) return res.send_status(400);
+    settings_lock();
+    uint32_t changed;
+    AlarmPatchResult r = alarm_patch_apply(req.body, settings.alarms, settings.alarmVersion, &changed);
+    if (r == ALARM_PATCH_OK) settings_commit_alarms(changed);
+    settings_unlock();
+    if (r == ALARM_PATCH_INVALID) return res.send_status(422);
+    // A stale client gets the current table so it can rebase
+    send_alarm_set(res, r == ALARM_PATCH_STALE ? 409 : 200);
+  } else if (req.method == HTTP_GET) {
+    send_alarm_set(res, 200);
+  } else {
+    res.send_status(405);
+  }
+}
+
+static void handle_timezone(HttpRequest& req, HttpResponse& res) {
+  if (req.method == HTTP_PUT) {
+    float offset;
+    if (!req.body.complete()) return res.send_status(400);
+    // Same range and 30 minute steps as the on-device screen
+    if (!req.body.get_float("offset", &offset) || offset < -12.0f || offset > 12.0f ||
+        fmodf(fabsf(offset) * 2.0f, 1.0f) != 0.0f) {
+      return res.send_status(422);
+    }
+    settings_lock();
+    settings.timeZoneOffset = offset;
+    settings_changed();
+    settings_unlock();
+  } else if (req.method != HTTP_GET) {
+    return res.send_status(405);
+  }
+
+  JsonWriter& w = res.begin_json(200);
+  w.begin_object();
+  w.key("offset");
+  w.value(settings.timeZoneOffset, 1);
+  w.end_object();
+  res.end();
+}
+
+static void handle_thresholds(HttpRequest& req, HttpResponse& res) {
+  if (req.method == HTTP_PUT) {
+    if (!req.body.complete()) return res.send_status(400);
+    settings_lock();
+    HealthRanges r = settings.ranges;
+    bool ok = true;
+    if (req.body.find("minTemp")) ok &= req.body.get_float("minTemp", &r.minTemp);
+    if (req.body.find("maxTemp")) ok &= req.body.get_float("maxTemp", &r.maxTemp);
+    if (req.body.find("minHumidity")) ok &= req.body.get_float("minHumidity", &r.minHumidity);
+    if (req.body.find("maxHumidity")) ok &= req.body.get_float("maxHumidity", &r.maxHumidity);
+    ok &= r.minTemp < r.maxTemp && r.minHumidity < r.maxHumidity;
+    if (ok) {
+      settings.ranges = r;
+      settings_changed();
+    }
+    settings_unlock();
+    if (!ok) return res.send_status(422);
+  } else if (req.method != HTTP_GET) {
+    return res.send_status(405);
+  }
+
+  const HealthRanges& r = settings.ranges;
+  JsonWriter& w = res.begin_json(200);
+  w.begin_object();
+  w.key("minTemp");
+  w.value(r.minTemp, 1);
+  w.key("maxTemp");
+  w.value(r.maxTemp, 1);
+  w.key("minHumidity");
+  w.value(r.minHumidity, 1);
+  w.key("maxHumidity");
+  w.value(r.maxHumidity, 1);
+  w.end_object();
+  res.end();
+}
+
+static void handle_stats(HttpRequest& req, HttpResponse& res) {
+  HttpStats s;
+  http_server_stats(&s);
+  JsonWriter& w = res.begin_json(200);
+  w.begin_object();
+  w.key("requests");
+  w.value(s.requests);
+  w.key("errors");
+  w.value(s.errors);
+  w.key("bytesSent");
+  w.value(s.bytesSent);
+  w.key("clients");
+  w.value(s.activeClients);
+  w.key("freeHeap");
+  w.value((uint32_t)esp_get_free_heap_size());
+  w.key("minFreeHeapServing");
+  w.value(s.minFreeHeap);
+  w.key("minFreeHeapEver");
+  w.value((uint32_t)esp_get_minimum_free_heap_size());
+  w.end_object();
+  res.end();
+}
+
+#define HISTORY_DEFAULT_POINTS 300
+#define HISTORY_MAX_POINTS 2000
+
+struct HistoryStream {
+  HttpResponse* res;
+  JsonWriter* w;
+  bool humidity;
+  LttbStream lttb;
+};
+
+static bool write_point(void* ctx, const LttbPoint& p) {
+  HistoryStream* s = (HistoryStream*)ctx;
+  s->w->begin_array();
+  s->w->value(p.t);
+  s->w->value((float)p.y / TELEMETRY_SCALE, 2);
+  s->w->end_array();
+  return !s->res->failed();
+}
+
+static bool downsample_reading(void* ctx, const SensorReading& r) {
+  HistoryStream* s = (HistoryStream*)ctx;
+  return s->lttb.add(r.timestamp, s->humidity ? r.humidity : r.temp);
+}
+
+// Unreduced export, kept for comparison and bulk download
+static bool write_reading(void* ctx, const SensorReading& r) {
+  HistoryStream* s = (HistoryStream*)ctx;
+  s->w->begin_array();
+  s->w->value(r.timestamp);
+  s->w->value((float)r.temp / TELEMETRY_SCALE, 2);
+  s->w->value((float)r.humidity / TELEMETRY_SCALE, 2);
+  s->w->end_array();
+  return !s->res->failed();
+}
+
+static bool query_uint(const HttpRequest& req, const char* name, uint32_t* out) {
+  char buf[12];
+  if (!http_query_param(req, name, buf, sizeof(buf))) return true;   // Keep the default
+  char* end;
+  unsigned long v = strtoul(buf, &end, 10);
+  if (end == buf || *end != '\0') return false;
+  *out = v;
+  return true;
+}
+
+// GET /api/history?from=<unix>&to=<unix>&points=<n>&series=temp|humidity
+// streams an LTTB downsample of one series; raw=1 streams every reading
+static void handle_history(HttpRequest& req, HttpResponse& res) {
+  if (req.method != HTTP_GET) return res.send_status(405);
+  uint32_t from = 0, to = UINT32_MAX, points = HISTORY_DEFAULT_POINTS, raw = 0;
+  char series[12] = "temp";
+  http_query_param(req, "series", series, sizeof(series));
+  bool humidity = strcmp(series, "humidity") == 0;
+  if (!query_uint(req, "from", &from) || !query_uint(req, "to", &to) ||
+      !query_uint(req, "points", &points) || !query_uint(req, "raw", &raw) ||
+      points < LTTB_MIN_POINTS || points > HISTORY_MAX_POINTS ||
+      (!humidity && strcmp(series, "temp") != 0)) {
+    return res.send_status(422);
+  }
+
+  // Buckets span only the stored part of the range
+  SensorLogStats log;
+  sensor_log_stats(&log);
+  if (from < log.oldest) from = log.oldest;
+  if (to > log.newest) to = log.newest;
+
+  HistoryStream s;
+  s.res = &res;
+  s.w = &res.begin_json(200);
+  s.humidity = humidity;
+  JsonWriter& w = *s.w;
+  w.begin_object();
+  w.key("from");
+  w.value(from);
+  w.key("to");
+  w.value(to);
+  uint32_t scanned = 0;
+  if (raw) {
+    w.key("readings");
+    w.begin_array();
+    if (from <= to) scanned = sensor_log_scan(from, to, write_reading, &s);
+  } else {
+    w.key("series");
+    w.value(series);
+    w.key("points");
+    w.begin_array();
+    s.lttb.begin(from, to, points, write_point, &s);
+    if (from <= to) scanned = sensor_log_scan(from, to, downsample_reading, &s);
+    s.lttb.finish();
+  }
+  w.end_array();
+  w.key("scanned");
+  w.value(scanned);
+  w.end_object();
+  res.end();
+}
+
+static bool write_metrics(void* ctx, const char* data, size_t len) {
+  return static_cast<HttpResponse*>(ctx)->write(data, len);
+}
+
+static void handle_metrics(HttpRequest& req, HttpResponse& res) {
+  res.begin_stream(200, "text/plain; version=0.0.4");
+  metrics_render(write_metrics, &res);
+  res.end();
+}
+
+static bool write_trace(void* ctx, const uint8_t* data, size_t len) {
+  return static_cast<HttpResponse*>(ctx)->write((const char*)data, len);
+}
+
+// GET streams the binary trace dump (trace.h); POST {"enabled":false}
+// pauses tracing, e.g. to keep the records around a fault
+static void handle_trace(HttpRequest& req, HttpResponse& res) {
+  if (req.method == HTTP_POST) {
+    bool on;
+    if (!req.body.complete()) return res.send_status(400);
+    if (!req.body.get_bool("enabled", &on)) return res.send_status(422);
+    trace_enable(on);
+    return res.send_status(204);
+  }
+  if (req.method != HTTP_GET) return res.send_status(405);
+  res.begin_stream(200, "application/octet-stream");
+  trace_dump(write_trace, &res);
+  res.end();
+}
+
+static void handle_ota(HttpRequest& req, HttpResponse& res) {
+  int status = 200;
+  if (req.method == HTTP_POST) {
+    if (!req.body.complete()) return res.send_status(400);
+    const JsonField* server = req.body.find("host");
+    long port = 80;
+    if (server == NULL || !server->isString ||
+        (req.body.find("port") && (!req.body.get_int("port", &port) || port < 1 || port > 65535))) {
+      return res.send_status(422);
+    }
+    if (!ota_update_start(server->value, port)) return res.send_status(409);
+    status = 202;
+  } else if (req.method != HTTP_GET) {
+    return res.send_status(405);
+  }
+
+  OtaStatus s;
+  ota_update_status(&s);
+  JsonWriter& w = res.begin_json(status);
+  w.begin_object();
+  w.key("state");
+  w.value(ota_state_name(s.state));
+  w.key("offset");
+  w.value(s.offset);
+  w.key("size");
+  w.value(s.size);
+  w.key("resumes");
+  w.value(s.resumes);
+  w.key("error");
+  if (s.error != NULL) {
+    w.value(s.error);
+  } else {
+    w.null();
+  }
+  w.end_object();
+  res.end();
+}
+
+static const char* const macroStates[] = {"idle", "recording", "replaying", "done"};
+
+static bool macro_action(const char* action) {
+  if (strcmp(action, "record") == 0) return macro_record();
+  if (strcmp(action, "stop") == 0) return macro_stop();
+  if (strcmp(action, "clear") == 0) return macro_clear();
+  if (strcmp(action, "replay") == 0) return macro_replay();
+  return false;
+}
+
+static void handle_macro(HttpRequest& req, HttpResponse& res) {
+  if (req.method == HTTP_POST) {
+    if (!req.body.complete()) return res.send_status(400);
+    const JsonField* action = req.body.find("action");
+    if (action != NULL) {
+      if (!action->isString) return res.send_status(422);
+      if (!macro_action(action->value)) return res.send_status(409);
+    } else {
+      long at, count = 1;
+      bool repeat = false;
+      const JsonField* button = req.body.find("button");
+      MacroStep step;
+      if (!req.body.get_int("at", &at) || at < 0 || button == NULL || !button->isString ||
+          !macro_parse_button(button->value, &step.event.button) ||
+          (req.body.find("count") && (!req.body.get_int("count", &count) || count < 1 || count > 255)) ||
+          (req.body.find("repeat") && !req.body.get_bool("repeat", &repeat))) {
+        return res.send_status(422);
+      }
+      step.atMs = at;
+      step.event.count = count;
+      step.event.repeat = repeat;
+      if (!macro_append(step)) return res.send_status(409);
+    }
+  } else if (req.method != HTTP_GET) {
+    return res.send_status(405);
+  }
+
+  JsonWriter& w = res.begin_json(200);
+  w.begin_object();
+  w.key("state");
+  w.value(macroStates[macro_state()]);
+  w.key("steps");
+  w.begin_array();
+  MacroStep step;
+  MacroResult result;
+  for (size_t i = 0; macro_step(i, &step, &result); i++) {
+    w.begin_object();
+    w.key("at");
+    w.value(step.atMs);
+    w.key("button");
+    w.value(macro_button_name(step.event.button));
+    w.key("count");
+    w.value((uint32_t)step.event.count);
+    w.key("repeat");
+    w.value(step.event.repeat);
+    if (macro_state() == MACRO_DONE) {
+      w.key("us");
+      w.value(result.latencyUs);
+      w.key("frames");
+      w.value((uint32_t)result.frames);
+      w.key("bytes");
+      w.value(result.bytes);
+    }
+    w.end_object();
+  }
+  w.end_array();
+  w.end_object();
+  res.end();
+}
+
+static void handle_request(HttpRequest& req, HttpResponse& res) {
+  const char* path = req.path;
+  if (strcmp(path, "/api/alarmset") == 0) {
+    handle_alarm_set(req, res);
+  } else if (strncmp(path, "/api/alarms", 11) == 0) {
+    handle_alarms(req, res, path + 11);
+  } else if (strcmp(path, "/api/timezone") == 0) {
+    handle_timezone(req, res);
+  } else if (strcmp(path, "/api/thresholds") == 0) {
+    handle_thresholds(req, res);
+  } else if (strcmp(path, "/api/stats") == 0 && req.method == HTTP_GET) {
+    handle_stats(req, res);
+  } else if (strcmp(path, "/api/history") == 0) {
+    handle_history(req, res);
+  } else if (strcmp(path, "/api/ota") == 0) {
+    handle_ota(req, res);
+  } else if (strcmp(path, "/api/macro") == 0) {
+    handle_macro(req, res);
+  } else if (strcmp(path, "/api/trace") == 0) {
+    handle_trace(req, res);
+  } else if (strcmp(path, "/metrics") == 0 && req.method == HTTP_GET) {
+    handle_metrics(req, res);
+  } else if (!web_ui_handle(req, res)) {
+    res.send_status(404);
+  }
+}
+
+void rest_api_begin() {
+  http_server_begin(HTTP_PORT, handle_request);
+}
@@ -0,0 +1,181 @@
+/*
+ * Medibox - on-flash sensor history (see sensor_log.h)
+ */
+
+#include "sensor_log.h"
+
+#include <Arduino.h>
+#include <string.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "flash_ring.h"
+#include "telemetry_codec.h"
+
+#define PAGES_PER_SECTOR FLASH_RING_PAGES_PER_SECTOR
+
+struct Page {
+  FlashPageHeader header;
+  SensorReading readings[SENSOR_LOG_PER_PAGE];
+};
+
+static_assert(sizeof(Page) <= FLASH_QUEUE_PAGE, "page overflows a flash page");
+
+static const FlashStorage* store = NULL;
+static SemaphoreHandle_t lock = NULL;
+static FlashRing ring;
+static uint32_t pageCount = 0;
+
+static Page ramPage;                 // Page being filled, logically seq headSeq
+static uint32_t headSeq = 0;
+static uint32_t newestTs = 0;
+// First timestamp of each sector's oldest page, 0 if the sector is empty
+static uint32_t sectorFirstTs[SENSOR_LOG_MAX_SECTORS];
+
+static unsigned long lastSampleMs = 0;
+static bool sampledOnce = false;
+static SensorLogStats stats = {};
+
+static uint32_t slot_of(uint32_t seq) {
+  return seq % pageCount;
+}
+
+// Everything before this was erased or never written; the head's sector
+// was erased when its first page went out
+static uint32_t oldest_seq() {
+  uint32_t end = headSeq + (PAGES_PER_SECTOR - headSeq % PAGES_PER_SECTOR) % PAGES_PER_SECTOR;
+  return end > pageCount ? end - pageCount : 0;
+}
+
+static void write_ram_page() {
+  if (flash_ring_starts_sector(&ring, headSeq)) {
+    sectorFirstTs[slot_of(headSeq) / PAGES_PER_SECTOR] = ramPage.readings[0].timestamp;
+    stats.sectorsErased++;
+  }
+  flash_ring_write(&ring, headSeq, &ramPage, sizeof(ramPage));
+  stats.pagesWritten++;
+  headSeq++;
+  ramPage.header.count = 0;
+}
+
+// Copies page seq into out; false if it is gone or unreadable
+static bool load_page(uint32_t seq, Page* out) {
+  if (seq == headSeq) {
+    *out = ramPage;
+    return true;
+  }
+  if (seq > headSeq || seq < oldest_seq()) return false;
+  return flash_ring_read(&ring, seq, out, sizeof(*out));
+}
+
+// A sector is erased before its first page is programmed, so within a
+// sector the first valid slot holds the oldest page
+static void scan_page(void* ctx, uint32_t slot, const FlashPageHeader& h, const uint8_t* peek) {
+  uint32_t& first = sectorFirstTs[slot / PAGES_PER_SECTOR];
+  if (first == 0) memcpy(&first, peek, sizeof(first));
+}
+
+bool sensor_log_begin(const FlashStorage* storage) {
+  if (!flash_ring_begin(&ring, storage, SENSOR_LOG_MAX_SECTORS * PAGES_PER_SECTOR,
+                        SENSOR_LOG_PER_PAGE)) {
+    return false;
+  }
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+  store = storage;
+  pageCount = ring.pageCount;
+
+  memset(sectorFirstTs, 0, sizeof(sectorFirstTs));
+  uint32_t newest = flash_ring_scan(&ring, scan_page, NULL);
+  headSeq = flash_ring_resume(&ring, newest, 0);
+
+  ramPage.header.count = 0;
+  newestTs = 0;
+  Page last;
+  if (newest != FLASH_RING_BLANK && load_page(newest, &last)) {
+    newestTs = last.readings[SENSOR_LOG_PER_PAGE - 1].timestamp;
+  }
+  return true;
+}
+
+void sensor_log_sample(float temperature, float humidity) {
+  if (store == NULL) return;
+  if (sampledOnce && millis() - lastSampleMs < SENSOR_LOG_INTERVAL_MS) return;
+  // Readings are found by time, so none are kept before the first NTP sync
+  time_t now = time(NULL);
+  if (now < 1600000000) return;
+  lastSampleMs = millis();
+  sampledOnce = true;
+
+  SensorReading r;
+  r.timestamp = (uint32_t)now;
+  r.temp = (int16_t)lroundf(temperature * TELEMETRY_SCALE);
+  r.humidity = (int16_t)lroundf(humidity * TELEMETRY_SCALE);
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ramPage.readings[ramPage.header.count++] = r;
+  newestTs = r.timestamp;
+  if (ramPage.header.count == SENSOR_LOG_PER_PAGE) {
+    write_ram_page();
+  }
+  xSemaphoreGive(lock);
+}
+
+// Oldest page whose sector starts at or before from
+static uint32_t find_start(uint32_t from) {
+  uint32_t start = oldest_seq();
+  for (uint32_t seq = start - start % PAGES_PER_SECTOR; seq < headSeq; seq += PAGES_PER_SECTOR) {
+    uint32_t first = sectorFirstTs[slot_of(seq) / PAGES_PER_SECTOR];
+    if (first == 0) continue;
+    if (first > from) break;
+    if (seq > start) start = seq;
+  }
+  return start;
+}
+
+uint32_t sensor_log_scan(uint32_t from, uint32_t to, SensorLogVisitor visit, void* ctx) {
+  if (store == NULL) return 0;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint32_t seq = find_start(from);
+  uint32_t end = headSeq;
+  xSemaphoreGive(lock);
+
+  // Pages appended during the scan are left out; a page copy is the only
+  // thing done under the lock
+  uint32_t visited = 0;
+  Page page;
+  for (; seq <= end; seq++) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool ok = load_page(seq, &page);
+    xSemaphoreGive(lock);
+    if (!ok) continue;
+
+    for (uint16_t i = 0; i < page.header.count; i++) {
+      const SensorReading& r = page.readings[i];
+      if (r.timestamp < from) continue;
+      if (r.timestamp > to) return visited;
+      visited++;
+      if (!visit(ctx, r)) return visited;
+    }
+  }
+  return visited;
+}
+
+void sensor_log_stats(SensorLogStats* out) {
+  if (store == NULL) {
+    *out = stats;
+    return;
+  }
+  xSemaphoreTake(lock, portMAX_DELAY);
+  *out = stats;
+  uint32_t oldest = oldest_seq();
+  out->readings = (headSeq - oldest) * SENSOR_LOG_PER_PAGE + ramPage.header.count;
+  out->oldest = 0;
+  for (uint32_t seq = oldest - oldest % PAGES_PER_SECTOR; seq <= headSeq && out->oldest == 0;
+       seq += PAGES_PER_SECTOR) {
+    out->oldest = sectorFirstTs[slot_of(seq) / PAGES_PER_SECTOR];
+  }
+  if (out->oldest == 0 && ramPage.header.count > 0) out->oldest = ramPage.readings[0].timestamp;
+  out->newest = newestTs;
+  xSemaphoreGive(lock);
+}
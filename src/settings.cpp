@@ -0,0 +1,82 @@
+/*
+ * Medibox - user settings (see settings.h)
+ */
+
+#include "settings.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+Settings settings = {
+  {{false, 0, 0}, {false, 0, 0}},
+  0.0,
+  {24.0, 32.0, 65.0, 80.0},
+  0,
+};
+
+#define ALARM_NVS "alarms"
+
+static SemaphoreHandle_t lock = NULL;
+static volatile uint32_t version = 0;
+
+static void alarm_key(char* key, int index) {
+  snprintf(key, 8, "a%d", index);
+}
+
+static void load_alarms() {
+  Preferences prefs;
+  if (!prefs.begin(ALARM_NVS, true)) return;
+  for (int i = 0; i < MAX_ALARMS; i++) {
+    char key[8];
+    alarm_key(key, i);
+    Alarm a;
+    if (prefs.getBytes(key, &a, sizeof(a)) == sizeof(a) &&
+        a.hour >= 0 && a.hour < 24 && a.minute >= 0 && a.minute < 60) {
+      settings.alarms[i] = a;
+    }
+  }
+  settings.alarmVersion = prefs.getUInt("version", 0);
+  prefs.end();
+}
+
+void settings_begin() {
+  if (lock == NULL) {
+    lock = xSemaphoreCreateRecursiveMutex();
+    load_alarms();
+  }
+}
+
+void settings_lock() {
+  xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+}
+
+void settings_unlock() {
+  xSemaphoreGiveRecursive(lock);
+}
+
+void settings_changed() {
+  version++;
+}
+
+uint32_t settings_version() {
+  return version;
+}
+
+void settings_commit_alarms(uint32_t changedMask) {
+  if (changedMask == 0) return;
+  settings.alarmVersion++;
+  Preferences prefs;
+  if (prefs.begin(ALARM_NVS, false)) {
+    for (int i = 0; i < MAX_ALARMS; i++) {
+      if (!(changedMask & (1u << i))) continue;
+      char key[8];
+      alarm_key(key, i);
+      prefs.putBytes(key, &settings.alarms[i], sizeof(Alarm));
+    }
+    prefs.putUInt("version", settings.alarmVersion);
+    prefs.end();
+  }
+  settings_changed();
+}
@@ -0,0 +1,104 @@
+/*
+ * Medibox - telemetry producer side (see telemetry.h)
+ */
+
+#include "telemetry.h"
+
+#include <Arduino.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include "metrics.h"
+
+static QueueHandle_t queue = NULL;
+static uint32_t droppedCount = 0;
+
+static MetricCounter droppedMetric("medibox_telemetry_dropped_total",
+                                   "Telemetry records lost to a full queue",
+                                   [] { return droppedCount; });
+
+// Current sensor window
+static unsigned long windowStart = 0;
+static uint16_t windowSamples = 0;
+static int32_t tempSum = 0, humSum = 0;
+static int16_t tempMin, tempMax, humMin, humMax;
+
+static uint32_t now_unix() {
+  time_t now = time(NULL);
+  // Before the first NTP sync the clock sits near 1970
+  return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+static void push(const TelemetryRecord& rec) {
+  if (queue == NULL || xQueueSend(queue, &rec, 0) != pdTRUE) {
+    droppedCount++;
+  }
+}
+
+static void flush_window() {
+  TelemetryRecord rec = {};
+  rec.timestamp = now_unix();
+  rec.type = TELEMETRY_SENSOR;
+  rec.sensor.samples = windowSamples;
+  rec.sensor.tempMin = tempMin;
+  rec.sensor.tempMax = tempMax;
+  rec.sensor.tempMean = (int16_t)(tempSum / windowSamples);
+  rec.sensor.humMin = humMin;
+  rec.sensor.humMax = humMax;
+  rec.sensor.humMean = (int16_t)(humSum / windowSamples);
+  push(rec);
+  windowSamples = 0;
+}
+
+void telemetry_begin() {
+  if (queue == NULL) {
+    queue = xQueueCreate(TELEMETRY_QUEUE_LEN, sizeof(TelemetryRecord));
+  }
+  windowStart = millis();
+}
+
+void telemetry_sensor_sample(float temperature, float humidity) {
+  int16_t t = (int16_t)lroundf(temperature * TELEMETRY_SCALE);
+  int16_t h = (int16_t)lroundf(humidity * TELEMETRY_SCALE);
+
+  if (windowSamples == 0) {
+    tempMin = tempMax = t;
+    humMin = humMax = h;
+    tempSum = humSum = 0;
+  }
+  if (t < tempMin) tempMin = t;
+  if (t > tempMax) tempMax = t;
+  if (h < humMin) humMin = h;
+  if (h > humMax) humMax = h;
+  tempSum += t;
+  humSum += h;
+  windowSamples++;
+
+  if (millis() - windowStart >= TELEMETRY_WINDOW_MS) {
+    windowStart = millis();
+    flush_window();
+  }
+}
+
+void telemetry_adherence(int alarmNum, AdherenceEvent event, uint16_t responseSec) {
+  TelemetryRecord rec = {};
+  rec.timestamp = now_unix();
+  rec.type = TELEMETRY_ADHERENCE;
+  rec.adherence.alarm = (uint8_t)alarmNum;
+  rec.adherence.event = event;
+  rec.adherence.responseSec = responseSec;
+  push(rec);
+}
+
+bool telemetry_pop(TelemetryRecord* out, uint32_t waitMs) {
+  return queue != NULL && xQueueReceive(queue, out, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+}
+
+uint32_t telemetry_pending() {
+  return queue != NULL ? uxQueueMessagesWaiting(queue) : 0;
+}
+
+uint32_t telemetry_dropped() {
+  return droppedCount;
+}
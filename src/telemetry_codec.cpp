@@ -0,0 +1,360 @@
+/*
+ * Medibox - telemetry payload codec (see telemetry_codec.h)
+ */
+
+#include "telemetry_codec.h"
+#include "cbor_writer.h"
+#include "json_writer.h"
+
+#include <string.h>
+
+size_t telemetry_encode_json(char* buf, size_t cap, const char* device, uint32_t seq,
+                             const TelemetryRecord* recs, size_t count, size_t* outLen) {
+  // Reserve room for the header and the closing brackets up front
+  const size_t overhead = 64;
+  if (cap < overhead + TELEMETRY_JSON_RECORD_MAX) {
+    *outLen = 0;
+    return 0;
+  }
+  size_t fit = (cap - overhead) / TELEMETRY_JSON_RECORD_MAX;
+  if (fit > count) fit = count;
+
+  JsonWriter w(buf, cap);
+  w.begin_object();
+  w.key("dev");
+  w.value(device);
+  w.key("seq");
+  w.value(seq);
+
+  w.key("sensor");
+  w.begin_array();
+  for (size_t i = 0; i < fit; i++) {
+    if (recs[i].type != TELEMETRY_SENSOR) continue;
+    const SensorWindow& s = recs[i].sensor;
+    w.begin_array();
+    w.value(recs[i].timestamp);
+    w.value((uint32_t)s.samples);
+    w.value((int32_t)s.tempMin);
+    w.value((int32_t)s.tempMax);
+    w.value((int32_t)s.tempMean);
+    w.value((int32_t)s.humMin);
+    w.value((int32_t)s.humMax);
+    w.value((int32_t)s.humMean);
+    w.end_array();
+  }
+  w.end_array();
+
+  w.key("events");
+  w.begin_array();
+  for (size_t i = 0; i < fit; i++) {
+    if (recs[i].type != TELEMETRY_ADHERENCE) continue;
+    const AdherenceRecord& a = recs[i].adherence;
+    w.begin_array();
+    w.value(recs[i].timestamp);
+    w.value((uint32_t)a.alarm);
+    w.value((uint32_t)a.event);
+    w.value((uint32_t)a.responseSec);
+    w.end_array();
+  }
+  w.end_array();
+  w.end_object();
+
+  if (w.overflowed()) {
+    *outLen = 0;
+    return 0;
+  }
+  *outLen = w.length();
+  return fit;
+}
+
+size_t telemetry_encode_cbor(uint8_t* buf, size_t cap, const char* device, uint32_t seq,
+                             const TelemetryRecord* recs, size_t count, size_t* outLen) {
+  // Map head, four keys, text head, seq and the two array heads
+  const size_t overhead = 16 + strlen(device);
+  if (cap < overhead + TELEMETRY_CBOR_RECORD_MAX) {
+    *outLen = 0;
+    return 0;
+  }
+  size_t fit = (cap - overhead) / TELEMETRY_CBOR_RECORD_MAX;
+  if (fit > count) fit = count;
+
+  // Arrays are definite length, so count each kind first
+  uint32_t sensors = 0, events = 0;
+  for (size_t i = 0; i < fit; i++) {
+    if (recs[i].type == TELEMETRY_SENSOR) sensors++;
+    if (recs[i].type == TELEMETRY_ADHERENCE) events++;
+  }
+
+  CborWriter w(buf, cap);
+  w.begin_map(4);
+  w.value((uint32_t)0);
+  w.value(device);
+  w.value((uint32_t)1);
+  w.value(seq);
+
+  w.value((uint32_t)2);
+  w.begin_array(sensors);
+  for (size_t i = 0; i < fit; i++) {
+    if (recs[i].type != TELEMETRY_SENSOR) continue;
+    const SensorWindow& s = recs[i].sensor;
+    w.begin_array(8);
+    w.value(recs[i].timestamp);
+    w.value((uint32_t)s.samples);
+    w.value((int32_t)s.tempMin);
+    w.value((int32_t)s.tempMax);
+    w.value((int32_t)s.tempMean);
+    w.value((int32_t)s.humMin);
+    w.value((int32_t)s.humMax);
+    w.value((int32_t)s.humMean);
+  }
+
+  w.value((uint32_t)3);
+  w.begin_array(events);
+  for (size_t i = 0; i < fit; i++) {
+    if (recs[i].type != TELEMETRY_ADHERENCE) continue;
+    const AdherenceRecord& a = recs[i].adherence;
+    w.begin_array(4);
+    w.value(recs[i].timestamp);
+    w.value((uint32_t)a.alarm);
+    w.value((uint32_t)a.event);
+    w.value((uint32_t)a.responseSec);
+  }
+
+  if (w.overflowed()) {
+    *outLen = 0;
+    return 0;
+  }
+  *outLen = w.length();
+  return fit;
+}
+
+// ---- Decoding -------------------------------------------------------------
+
+static const int SENSOR_FIELDS = 8;
+static const int EVENT_FIELDS = 4;
+
+// Builds a record from the flat field list of one sensor or event entry
+static bool make_record(bool sensor, const int32_t* f, TelemetryRecord* rec) {
+  *rec = {};
+  rec->timestamp = (uint32_t)f[0];
+  if (sensor) {
+    if (f[1] < 0 || f[1] > 0xFFFF) return false;
+    for (int i = 2; i < SENSOR_FIELDS; i++) {
+      if (f[i] < INT16_MIN || f[i] > INT16_MAX) return false;
+    }
+    rec->type = TELEMETRY_SENSOR;
+    rec->sensor.samples = f[1];
+    rec->sensor.tempMin = f[2];
+    rec->sensor.tempMax = f[3];
+    rec->sensor.tempMean = f[4];
+    rec->sensor.humMin = f[5];
+    rec->sensor.humMax = f[6];
+    rec->sensor.humMean = f[7];
+  } else {
+    if (f[1] < 0 || f[1] > 0xFF || f[2] < 0 || f[2] > 0xFF || f[3] < 0 || f[3] > 0xFFFF) {
+      return false;
+    }
+    rec->type = TELEMETRY_ADHERENCE;
+    rec->adherence.alarm = f[1];
+    rec->adherence.event = f[2];
+    rec->adherence.responseSec = f[3];
+  }
+  return true;
+}
+
+static void store_record(bool sensor, const int32_t* f, TelemetryBatch* batch,
+                         TelemetryRecord* out, size_t max, bool* ok) {
+  TelemetryRecord rec;
+  if (!make_record(sensor, f, &rec)) {
+    *ok = false;
+  } else if (batch->count < max) {
+    out[batch->count++] = rec;
+  }
+}
+
+struct JsonCursor {
+  const char* p;
+  const char* end;
+};
+
+static void skip_ws(JsonCursor& c) {
+  while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\r' || *c.p == '\n')) c.p++;
+}
+
+static bool expect(JsonCursor& c, char ch) {
+  skip_ws(c);
+  if (c.p >= c.end || *c.p != ch) return false;
+  c.p++;
+  return true;
+}
+
+static bool peek(JsonCursor& c, char ch) {
+  skip_ws(c);
+  return c.p < c.end && *c.p == ch;
+}
+
+// Plain strings only: the encoder never escapes device ids or keys
+static bool json_string(JsonCursor& c, char* dst, size_t cap) {
+  if (!expect(c, '"')) return false;
+  size_t n = 0;
+  while (c.p < c.end && *c.p != '"') {
+    if (*c.p == '\\' || n + 1 >= cap) return false;
+    dst[n++] = *c.p++;
+  }
+  dst[n] = '\0';
+  return expect(c, '"');
+}
+
+static bool json_int(JsonCursor& c, int32_t* out) {
+  skip_ws(c);
+  bool neg = c.p < c.end && *c.p == '-';
+  if (neg) c.p++;
+  if (c.p >= c.end || *c.p < '0' || *c.p > '9') return false;
+  int64_t v = 0;
+  while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+    v = v * 10 + (*c.p++ - '0');
+    if (v > 0xFFFFFFFFLL) return false;
+  }
+  if (neg) v = -v;
+  if (v < INT32_MIN) return false;
+  *out = (int32_t)(uint32_t)v;   // Timestamps and seq use the full u32 range
+  return true;
+}
+
+static bool json_records(JsonCursor& c, bool sensor, TelemetryBatch* batch,
+                         TelemetryRecord* out, size_t max) {
+  const int fields = sensor ? SENSOR_FIELDS : EVENT_FIELDS;
+  if (!expect(c, '[')) return false;
+  if (expect(c, ']')) return true;
+  bool ok = true;
+  do {
+    int32_t f[SENSOR_FIELDS];
+    if (!expect(c, '[')) return false;
+    for (int i = 0; i < fields; i++) {
+      if ((i > 0 && !expect(c, ',')) || !json_int(c, &f[i])) return false;
+    }
+    if (!expect(c, ']')) return false;
+    store_record(sensor, f, batch, out, max, &ok);
+  } while (ok && expect(c, ','));
+  return ok && expect(c, ']');
+}
+
+bool telemetry_decode_json(const char* buf, size_t len, TelemetryBatch* batch,
+                           TelemetryRecord* out, size_t max) {
+  JsonCursor c = {buf, buf + len};
+  batch->device[0] = '\0';
+  batch->seq = 0;
+  batch->count = 0;
+  bool haveDev = false, haveSeq = false;
+
+  if (!expect(c, '{')) return false;
+  if (!peek(c, '}')) {
+    do {
+      char key[8];
+      int32_t seq;
+      if (!json_string(c, key, sizeof(key)) || !expect(c, ':')) return false;
+      if (strcmp(key, "dev") == 0) {
+        if (!json_string(c, batch->device, sizeof(batch->device))) return false;
+        haveDev = true;
+      } else if (strcmp(key, "seq") == 0) {
+        if (!json_int(c, &seq)) return false;
+        batch->seq = (uint32_t)seq;
+        haveSeq = true;
+      } else if (strcmp(key, "sensor") == 0) {
+        if (!json_records(c, true, batch, out, max)) return false;
+      } else if (strcmp(key, "events") == 0) {
+        if (!json_records(c, false, batch, out, max)) return false;
+      } else {
+        return false;
+      }
+    } while (expect(c, ','));
+  }
+  if (!expect(c, '}')) return false;
+  skip_ws(c);
+  return c.p == c.end && haveDev && haveSeq;
+}
+
+struct CborCursor {
+  const uint8_t* p;
+  const uint8_t* end;
+};
+
+static bool cbor_head(CborCursor& c, uint8_t* major, uint32_t* arg) {
+  if (c.p >= c.end) return false;
+  uint8_t head = *c.p++;
+  *major = head & 0xE0;
+  uint8_t info = head & 0x1F;
+  if (info < 24) {
+    *arg = info;
+    return true;
+  }
+  if (info > 26) return false;
+  size_t n = (size_t)1 << (info - 24);
+  if ((size_t)(c.end - c.p) < n) return false;
+  *arg = 0;
+  while (n--) *arg = (*arg << 8) | *c.p++;
+  return true;
+}
+
+static bool cbor_int(CborCursor& c, int32_t* out) {
+  uint8_t major;
+  uint32_t arg;
+  if (!cbor_head(c, &major, &arg)) return false;
+  if (major == CBOR_UINT) {
+    *out = (int32_t)arg;
+  } else if (major == CBOR_NEGINT && arg <= (uint32_t)INT32_MAX) {
+    *out = -1 - (int32_t)arg;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool cbor_records(CborCursor& c, bool sensor, TelemetryBatch* batch,
+                         TelemetryRecord* out, size_t max) {
+  const uint32_t fields = sensor ? SENSOR_FIELDS : EVENT_FIELDS;
+  uint8_t major;
+  uint32_t items;
+  if (!cbor_head(c, &major, &items) || major != CBOR_ARRAY) return false;
+  bool ok = true;
+  for (uint32_t r = 0; r < items && ok; r++) {
+    uint32_t n;
+    int32_t f[SENSOR_FIELDS];
+    if (!cbor_head(c, &major, &n) || major != CBOR_ARRAY || n != fields) return false;
+    for (uint32_t i = 0; i < fields; i++) {
+      if (!cbor_int(c, &f[i])) return false;
+    }
+    store_record(sensor, f, batch, out, max, &ok);
+  }
+  return ok;
+}
+
+bool telemetry_decode_cbor(const uint8_t* buf, size_t len, TelemetryBatch* batch,
+                           TelemetryRecord* out, size_t max) {
+  CborCursor c = {buf, buf + len};
+  batch->device[0] = '\0';
+  batch->seq = 0;
+  batch->count = 0;
+
+  uint8_t major;
+  uint32_t pairs, arg;
+  if (!cbor_head(c, &major, &pairs) || major != CBOR_MAP || pairs != 4) return false;
+  for (uint32_t key = 0; key < 4; key++) {
+    // The encoder always writes keys 0..3 in order
+    if (!cbor_head(c, &major, &arg) || major != CBOR_UINT || arg != key) return false;
+    if (key == 0) {
+      if (!cbor_head(c, &major, &arg) || major != CBOR_TEXT || arg >= TELEMETRY_DEVICE_MAX ||
+          (size_t)(c.end - c.p) < arg) {
+        return false;
+      }
+      memcpy(batch->device, c.p, arg);
+      batch->device[arg] = '\0';
+      c.p += arg;
+    } else if (key == 1) {
+      if (!cbor_head(c, &major, &batch->seq) || major != CBOR_UINT) return false;
+    } else if (!cbor_records(c, key == 2, batch, out, max)) {
+      return false;
+    }
+  }
+  return c.p == c.end;
+}
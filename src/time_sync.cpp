@@ -0,0 +1,199 @@
+/*
+ * Medibox - NTP time service (see time_sync.h)
+ */
+
+#include "time_sync.h"
+
+#include <Arduino.h>
+#include <time.h>
+#include <sys/time.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Smoothing applied to each new drift measurement (rejects NTP jitter)
+#define DRIFT_GAIN 0.5f
+// Drift beyond this is a bad sample, not a real crystal
+#define DRIFT_LIMIT_PPM 500.0f
+// Never assume the estimate is better than this when sizing the interval
+#define RESIDUAL_FLOOR_PPM 2.0f
+// Safety factor between the expected and the allowed error
+#define INTERVAL_MARGIN 2.0f
+
+// Guards adjtime()/settimeofday(): SNTP runs in the lwIP task, trims in loop()
+static SemaphoreHandle_t clockLock = NULL;
+
+static bool synced = false;
+static int64_t lastSyncUs = 0;      // esp_timer time of the previous sync
+static float driftPpm = 0.0f;       // + means the local clock runs slow
+static float residualPpm = 50.0f;   // smoothed |prediction error| of driftPpm
+static int32_t lastOffsetMs = 0;
+static uint32_t syncCount = 0;
+static uint32_t stepCount = 0;
+static uint32_t intervalS = TIME_SYNC_MIN_INTERVAL_S;
+
+static int64_t lastTrimUs = 0;
+static float trimCarryUs = 0.0f;    // sub-microsecond remainder of the trim
+
+static int64_t timeval_to_us(const struct timeval& tv) {
+  return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static struct timeval us_to_timeval(int64_t us) {
+  struct timeval tv;
+  tv.tv_sec = us / 1000000LL;
+  tv.tv_usec = us % 1000000LL;
+  return tv;
+}
+
+// Slew the clock by an extra amount on top of whatever is still pending
+static void add_slew_locked(int64_t us) {
+  struct timeval pending = {0, 0};
+  adjtime(NULL, &pending);
+  struct timeval delta = us_to_timeval(timeval_to_us(pending) + us);
+  adjtime(&delta, NULL);
+}
+
+// Pick the longest interval whose expected drift stays inside the bound
+static uint32_t next_interval_s() {
+  float ppm = residualPpm < RESIDUAL_FLOOR_PPM ? RESIDUAL_FLOOR_PPM : residualPpm;
+  float seconds = (TIME_SYNC_ERROR_BOUND_MS * 1000.0f) / (ppm * INTERVAL_MARGIN);
+  if (seconds < TIME_SYNC_MIN_INTERVAL_S) return TIME_SYNC_MIN_INTERVAL_S;
+  if (seconds > TIME_SYNC_MAX_INTERVAL_S) return TIME_SYNC_MAX_INTERVAL_S;
+  return (uint32_t)seconds;
+}
+
+// Fold one residual offset into the frequency estimate
+static void update_drift(int64_t residualUs, int64_t elapsedUs) {
+  if (elapsedUs < TIME_SYNC_MIN_SAMPLE_S * 1000000LL) return;
+
+  float errorPpm = (float)residualUs * 1e6f / (float)elapsedUs;
+  if (fabsf(errorPpm) > DRIFT_LIMIT_PPM) return;
+
+  driftPpm += DRIFT_GAIN * errorPpm;
+  if (driftPpm > DRIFT_LIMIT_PPM) driftPpm = DRIFT_LIMIT_PPM;
+  if (driftPpm < -DRIFT_LIMIT_PPM) driftPpm = -DRIFT_LIMIT_PPM;
+  residualPpm = 0.75f * residualPpm + 0.25f * fabsf(errorPpm);
+}
+
+// Overrides the weak ESP-IDF hook that SNTP calls with each new server time
+extern "C" void sntp_sync_time(struct timeval* tv) {
+  if (clockLock == NULL) {
+    settimeofday(tv, NULL);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    return;
+  }
+
+  xSemaphoreTake(clockLock, portMAX_DELAY);
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  int64_t offsetUs = timeval_to_us(*tv) - timeval_to_us(now);
+  int64_t monoUs = esp_timer_get_time();
+
+  struct timeval pending = {0, 0};
+  adjtime(NULL, &pending);
+  int64_t pendingUs = timeval_to_us(pending);
+
+  if (!synced || llabs(offsetUs) > TIME_SYNC_SLEW_LIMIT_MS * 1000LL) {
+    // First fix or gross error: step, and restart the drift measurement
+    struct timeval zero = {0, 0};
+    adjtime(&zero, NULL);
+    settimeofday(tv, NULL);
+    stepCount++;
+  } else {
+    // What the pending slew will not cover is the frequency error we missed
+    update_drift(offsetUs - pendingUs, monoUs - lastSyncUs);
+    struct timeval delta = us_to_timeval(offsetUs);
+    adjtime(&delta, NULL);
+  }
+
+  synced = true;
+  lastSyncUs = monoUs;
+  lastOffsetMs = (int32_t)(offsetUs / 1000);
+  syncCount++;
+  intervalS = next_interval_s();
+
+  xSemaphoreGive(clockLock);
+
+  sntp_set_sync_interval(intervalS * 1000UL);
+  sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+
+  Serial.printf("NTP sync: offset %ld ms, drift %.2f ppm, next in %lu s\n",
+                (long)lastOffsetMs, driftPpm, (unsigned long)intervalS);
+}
+
+void time_sync_begin(const char* server, float tzHours) {
+  if (clockLock == NULL) {
+    clockLock = xSemaphoreCreateMutex();
+  }
+  lastTrimUs = esp_timer_get_time();
+
+  if (sntp_enabled()) {
+    sntp_stop();
+  }
+  sntp_setoperatingmode(SNTP_OPMODE_POLL);
+  sntp_setservername(0, server);
+  sntp_set_sync_interval(intervalS * 1000UL);
+  sntp_init();
+
+  time_sync_set_timezone(tzHours);
+}
+
+// Timezone only affects localtime(), so it never needs a new NTP request
+void time_sync_set_timezone(float tzHours) {
+  int minutes = (int)lroundf(tzHours * 60.0f);
+  char sign = minutes >= 0 ? '-' : '+';   // POSIX TZ offsets are inverted
+  if (minutes < 0) minutes = -minutes;
+
+  char tz[16];
+  snprintf(tz, sizeof(tz), "UTC%c%d:%02d", sign, minutes / 60, minutes % 60);
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+// Apply the estimated frequency correction as a continuous slew
+void time_sync_loop() {
+  int64_t nowUs = esp_timer_get_time();
+  if (nowUs - lastTrimUs < TIME_SYNC_TRIM_PERIOD_MS * 1000LL) return;
+
+  float trimUs = driftPpm * (float)(nowUs - lastTrimUs) / 1e6f + trimCarryUs;
+  lastTrimUs = nowUs;
+  if (!synced || clockLock == NULL) {
+    trimCarryUs = 0.0f;
+    return;
+  }
+
+  int64_t wholeUs = (int64_t)trimUs;
+  trimCarryUs = trimUs - (float)wholeUs;
+  if (wholeUs == 0) return;
+
+  xSemaphoreTake(clockLock, portMAX_DELAY);
+  add_slew_locked(wholeUs);
+  xSemaphoreGive(clockLock);
+}
+
+bool time_sync_is_synced() {
+  return synced;
+}
+
+float time_sync_drift_ppm() {
+  return driftPpm;
+}
+
+int32_t time_sync_last_offset_ms() {
+  return lastOffsetMs;
+}
+
+uint32_t time_sync_interval_s() {
+  return intervalS;
+}
+
+uint32_t time_sync_count() {
+  return syncCount;
+}
+
+uint32_t time_sync_step_count() {
+  return stepCount;
+}
@@ -0,0 +1,115 @@
+/*
+ * Medibox - event trace (see trace.h)
+ */
+
+#include "trace.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+#include "hal.h"
+
+struct Slot {
+  uint32_t us;
+  uint8_t event;
+  uint8_t phase;
+  uint16_t arg;
+};
+
+static Slot ring[TRACE_CAPACITY];
+// Sequence number of the record in each slot, 0 while it is being written
+static std::atomic<uint32_t> stamps[TRACE_CAPACITY];
+static std::atomic<uint32_t> written(0);
+static volatile bool enabled = true;
+
+void IRAM_ATTR trace(TraceEvent event, uint16_t arg, TracePhase phase) {
+  if (!enabled) return;
+  uint32_t seq = written.fetch_add(1, std::memory_order_relaxed) + 1;
+  size_t i = seq % TRACE_CAPACITY;
+  stamps[i].store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  ring[i].us = hal_micros();
+  ring[i].event = event;
+  ring[i].phase = phase;
+  ring[i].arg = arg;
+  stamps[i].store(seq, std::memory_order_release);
+}
+
+void IRAM_ATTR trace_begin(TraceEvent event, uint16_t arg) {
+  trace(event, arg, TRACE_BEGIN);
+}
+
+void IRAM_ATTR trace_end(TraceEvent event, uint16_t arg) {
+  trace(event, arg, TRACE_END);
+}
+
+void trace_enable(bool on) {
+  enabled = on;
+}
+
+bool trace_enabled() {
+  return enabled;
+}
+
+// Copies record seq if its slot still holds it, unchanged throughout
+static bool read_record(uint32_t seq, TraceRecord* out) {
+  size_t i = seq % TRACE_CAPACITY;
+  if (stamps[i].load(std::memory_order_acquire) != seq) return false;
+  out->seq = seq;
+  out->us = ring[i].us;
+  out->event = ring[i].event;
+  out->phase = ring[i].phase;
+  out->arg = ring[i].arg;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return stamps[i].load(std::memory_order_relaxed) == seq;
+}
+
+bool trace_dump(TraceSink sink, void* ctx) {
+  TraceDumpHeader header;
+  header.magic = TRACE_MAGIC;
+  header.version = TRACE_VERSION;
+  header.recordSize = sizeof(TraceRecord);
+  header.capacity = TRACE_CAPACITY;
+  header.nowUs = hal_micros();
+  header.written = written.load(std::memory_order_acquire);
+  if (!sink(ctx, (const uint8_t*)&header, sizeof(header))) return false;
+
+  // Records that are overwritten meanwhile are left out
+  uint32_t last = header.written;
+  uint32_t first = last > TRACE_CAPACITY ? last - TRACE_CAPACITY + 1 : 1;
+  TraceRecord batch[16];
+  size_t n = 0;
+  for (uint32_t seq = first; seq <= last && seq != 0; seq++) {
+    if (!read_record(seq, &batch[n])) continue;
+    if (++n == sizeof(batch) / sizeof(batch[0])) {
+      if (!sink(ctx, (const uint8_t*)batch, sizeof(batch))) return false;
+      n = 0;
+    }
+  }
+  return n == 0 || sink(ctx, (const uint8_t*)batch, n * sizeof(TraceRecord));
+}
+
+static bool print_hex(void* ctx, const uint8_t* data, size_t len) {
+  Print& out = *static_cast<Print*>(ctx);
+  static const char digits[] = "0123456789abcdef";
+  while (len > 0) {
+    char line[2 * 32 + 1];
+    size_t n = len < 32 ? len : 32;
+    for (size_t i = 0; i < n; i++) {
+      line[2 * i] = digits[data[i] >> 4];
+      line[2 * i + 1] = digits[data[i] & 15];
+    }
+    line[2 * n] = '\0';
+    out.println(line);
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+void trace_print(Print& out) {
+  out.println("TRACE BEGIN");
+  trace_dump(print_hex, &out);
+  out.println("TRACE END");
+}
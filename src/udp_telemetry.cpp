@@ -0,0 +1,91 @@
+/*
+ * Medibox - CBOR over UDP telemetry uplink (see udp_telemetry.h)
+ */
+
+#include "udp_telemetry.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "mem_monitor.h"
+#include "metrics.h"
+#include "telemetry.h"
+#include "wifi_manager.h"
+
+#define UPLINK_STACK 3072
+#define UPLINK_WAIT_MS 1000
+
+static char deviceId[20];
+static WiFiUDP udp;
+
+static TelemetryRecord batch[UDP_BATCH_MAX];
+static size_t batchCount = 0;
+static unsigned long batchStart = 0;
+static uint32_t datagramSeq = 0;
+static uint8_t datagram[UDP_DATAGRAM_MAX];
+static UdpTelemetryStats stats = {};
+
+static MetricCounter datagramsMetric("medibox_udp_datagrams_total", "UDP telemetry datagrams sent",
+                                     [] { return stats.datagrams; });
+static MetricCounter recordsMetric("medibox_udp_records_total", "Telemetry records sent over UDP",
+                                   [] { return stats.records; });
+static MetricCounter bytesMetric("medibox_udp_sent_bytes_total", "UDP telemetry payload bytes sent",
+                                 [] { return stats.bytes; });
+static MetricCounter sendErrorsMetric("medibox_udp_send_errors_total",
+                                      "UDP telemetry datagrams that failed to send",
+                                      [] { return stats.sendErrors; });
+
+static void send_batch() {
+  size_t sent = 0;
+  while (sent < batchCount) {
+    size_t len = 0;
+    size_t used = telemetry_encode_cbor(datagram, sizeof(datagram), deviceId, datagramSeq,
+                                        batch + sent, batchCount - sent, &len);
+    if (used == 0) break;    // Cannot happen with sane sizes
+    sent += used;
+
+    // The sequence number advances even on failure so the loss shows up
+    datagramSeq++;
+    if (udp.beginPacket(UDP_TELEMETRY_HOST, UDP_TELEMETRY_PORT) &&
+        udp.write(datagram, len) == len && udp.endPacket()) {
+      stats.datagrams++;
+      stats.records += used;
+      stats.bytes += len;
+    } else {
+      stats.sendErrors++;
+    }
+  }
+  batchCount = 0;
+}
+
+static void uplink_task(void* arg) {
+  mem_monitor_watch_current_task(MEM_TASK_UPLINK);
+  for (;;) {
+    // While offline records stay in the telemetry queue
+    if (!wifi_manager_connected()) {
+      vTaskDelay(pdMS_TO_TICKS(UPLINK_WAIT_MS));
+      continue;
+    }
+    if (telemetry_pop(&batch[batchCount], UPLINK_WAIT_MS)) {
+      if (batchCount++ == 0) batchStart = millis();
+    }
+    if (batchCount == UDP_BATCH_MAX ||
+        (batchCount > 0 && millis() - batchStart >= UDP_MAX_DELAY_MS)) {
+      send_batch();
+    }
+  }
+}
+
+void udp_telemetry_begin() {
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  snprintf(deviceId, sizeof(deviceId), "medibox-%02x%02x%02x", mac[3], mac[4], mac[5]);
+  xTaskCreatePinnedToCore(uplink_task, "udp_uplink", UPLINK_STACK, NULL, 1, NULL, 0);
+}
+
+void udp_telemetry_stats(UdpTelemetryStats* out) {
+  *out = stats;
+}
@@ -0,0 +1,297 @@
+/*
+ * Medibox - UI strings, generated by tools/gen_strings.py from strings/.
+ * Do not edit.
+ */
+
+#include "ui_text.h"
+
+static const char text_en[] =
+  "\0"
+  "Medibox starting...\0"
+  "Connecting to WiFi..\0"
+  "Medibox ready!\0"
+  "Failed to get time\0"
+  "Sunday\0"
+  "Monday\0"
+  "Tuesday\0"
+  "Wednesday\0"
+  "Thursday\0"
+  "Friday\0"
+  "Saturday\0"
+  "January\0"
+  "February\0"
+  "March\0"
+  "April\0"
+  "May\0"
+  "June\0"
+  "July\0"
+  "August\0"
+  "September\0"
+  "October\0"
+  "November\0"
+  "December\0"
+  "%s %02d %s\n%02d:%02d:%02d\0"
+  "MEDICINE\0"
+  "TIME!\0"
+  "Alarm %d\0"
+  "UP=Snooze, CANCEL=Stop\0"
+  "Alarm Snoozed\0"
+  "Will ring again in 5 min\0"
+  "Alarm Stopped\0"
+  "WARNING!\0"
+  "Temp & Humidity Issues\0"
+  "Temperature Issue\0"
+  "Humidity Issue\0"
+  "Temp: \0"
+  "Humidity: \0"
+  "Healthy temp: \0"
+  "Healthy humidity: \0"
+  "MENU:\0"
+  "Set Time Zone\0"
+  "Set Alarm %d\0"
+  "View Alarms\0"
+  "Delete Alarm\0"
+  "Back\0"
+  "UP/DOWN to change, OK next\0"
+  "UP/DOWN to change, OK to set\0"
+  "SET ALARM %d\0"
+  "Setting hour:\0"
+  "Setting minute:\0"
+  "Alarm %d set for\0"
+  "SET TIME ZONE\0"
+  "Current: UTC%c%d%s\n\0"
+  "Time Zone Updated!\0"
+  "UP/DOWN to change\nOK to confirm\nCANCEL to go back\0"
+  "ACTIVE ALARMS\0"
+  "Alarm %d: %02d:%02d\n\0"
+  "No active alarms\0"
+  "\nPress OK/CANCEL to go back\0"
+  "DELETE ALARM\0"
+  "Delete Alarm %d\0"
+  "Alarm %d not set\0"
+  "Back to Menu\0"
+  "\nOK to choose\nCANCEL to exit\0"
+  "DELETE ALARM %d?\0"
+  "Current setting:\0"
+  "OK to delete\nCANCEL to go back\0"
+  "ALARM %d DELETED\0";
+
+static const UiText entries_en[STR_COUNT] = {
+  {0, 0, 0, 0},  // NONE
+  {1, 19, 1, 114},  // BOOT_STARTING
+  {21, 20, 1, 120},  // WIFI_CONNECTING
+  {42, 14, 1, 84},  // BOOT_READY
+  {57, 18, 1, 108},  // TIME_FAILED
+  {76, 6, 1, 36},  // DAY_SUNDAY
+  {83, 6, 1, 36},  // DAY_MONDAY
+  {90, 7, 1, 42},  // DAY_TUESDAY
+  {98, 9, 1, 54},  // DAY_WEDNESDAY
+  {108, 8, 1, 48},  // DAY_THURSDAY
+  {117, 6, 1, 36},  // DAY_FRIDAY
+  {124, 8, 1, 48},  // DAY_SATURDAY
+  {133, 7, 1, 42},  // MONTH_JANUARY
+  {141, 8, 1, 48},  // MONTH_FEBRUARY
+  {150, 5, 1, 30},  // MONTH_MARCH
+  {156, 5, 1, 30},  // MONTH_APRIL
+  {162, 3, 1, 18},  // MONTH_MAY
+  {166, 4, 1, 24},  // MONTH_JUNE
+  {171, 4, 1, 24},  // MONTH_JULY
+  {176, 6, 1, 36},  // MONTH_AUGUST
+  {183, 9, 1, 54},  // MONTH_SEPTEMBER
+  {193, 7, 1, 42},  // MONTH_OCTOBER
+  {201, 8, 1, 48},  // MONTH_NOVEMBER
+  {210, 8, 1, 48},  // MONTH_DECEMBER
+  {219, 25, 2, 84},  // CLOCK_FORMAT
+  {245, 8, 1, 48},  // RING_LINE1
+  {254, 5, 1, 30},  // RING_LINE2
+  {260, 8, 1, 48},  // RING_ALARM
+  {269, 22, 1, 132},  // RING_HELP
+  {292, 13, 1, 78},  // SNOOZED
+  {306, 24, 1, 144},  // SNOOZE_HELP
+  {331, 13, 1, 78},  // STOPPED
+  {345, 8, 1, 48},  // WARNING
+  {354, 22, 1, 132},  // WARN_BOTH
+  {377, 17, 1, 102},  // WARN_TEMP
+  {395, 14, 1, 84},  // WARN_HUMIDITY
+  {410, 6, 1, 36},  // TEMP_LABEL
+  {417, 10, 1, 60},  // HUMIDITY_LABEL
+  {428, 14, 1, 84},  // HEALTHY_TEMP
+  {443, 18, 1, 108},  // HEALTHY_HUMIDITY
+  {462, 5, 1, 30},  // MENU_TITLE
+  {468, 13, 1, 78},  // MENU_SET_TIMEZONE
+  {482, 12, 1, 72},  // MENU_SET_ALARM
+  {495, 11, 1, 66},  // MENU_VIEW_ALARMS
+  {507, 12, 1, 72},  // MENU_DELETE_ALARM
+  {520, 4, 1, 24},  // MENU_BACK
+  {525, 26, 1, 156},  // EDIT_HELP_NEXT
+  {552, 28, 1, 168},  // EDIT_HELP_SET
+  {581, 12, 1, 72},  // SET_ALARM_TITLE
+  {594, 13, 1, 78},  // SET_HOUR
+  {608, 15, 1, 90},  // SET_MINUTE
+  {624, 16, 1, 96},  // ALARM_SET
+  {641, 13, 1, 78},  // SET_TIMEZONE_TITLE
+  {655, 19, 1, 108},  // TIMEZONE_CURRENT
+  {675, 18, 1, 108},  // TIMEZONE_UPDATED
+  {694, 49, 3, 102},  // TIMEZONE_HELP
+  {744, 13, 1, 78},  // ALARMS_TITLE
+  {758, 20, 1, 114},  // ALARMS_ENTRY
+  {779, 16, 1, 96},  // ALARMS_NONE
+  {796, 27, 2, 156},  // ALARMS_HELP
+  {824, 12, 1, 72},  // DELETE_MENU_TITLE
+  {837, 15, 1, 90},  // DELETE_ITEM
+  {853, 16, 1, 96},  // DELETE_NOT_SET
+  {870, 12, 1, 72},  // DELETE_BACK
+  {883, 28, 3, 84},  // DELETE_MENU_HELP
+  {912, 16, 1, 96},  // DELETE_TITLE
+  {929, 16, 1, 96},  // DELETE_CURRENT
+  {946, 30, 2, 102},  // DELETE_HELP
+  {977, 16, 1, 96},  // DELETED
+};
+
+static const char text_de[] =
+  "\0"
+  "Medibox startet...\0"
+  "Verbinde mit WLAN..\0"
+  "Medibox bereit!\0"
+  "Keine Uhrzeit\0"
+  "Sonntag\0"
+  "Montag\0"
+  "Dienstag\0"
+  "Mittwoch\0"
+  "Donnerstag\0"
+  "Freitag\0"
+  "Samstag\0"
+  "Januar\0"
+  "Februar\0"
+  "M\204rz\0"
+  "April\0"
+  "Mai\0"
+  "Juni\0"
+  "Juli\0"
+  "August\0"
+  "September\0"
+  "Oktober\0"
+  "November\0"
+  "Dezember\0"
+  "%s %02d. %s\n%02d:%02d:%02d\0"
+  "MEDIZIN\0"
+  "ZEIT!\0"
+  "Alarm %d\0"
+  "UP=Snooze CANCEL=Aus\0"
+  "Alarm pausiert\0"
+  "Klingelt in 5 Min.\0"
+  "Alarm beendet\0"
+  "WARNUNG!\0"
+  "Temp. & Feuchte\0"
+  "Temperatur\0"
+  "Luftfeuchte\0"
+  "Temp.: \0"
+  "Feuchte: \0"
+  "Ideal Temp.: \0"
+  "Ideal Feuchte: \0"
+  "MEN\232:\0"
+  "Zeitzone\0"
+  "Alarm %d stellen\0"
+  "Alarme anzeigen\0"
+  "Alarm l\224schen\0"
+  "Zur\201ck\0"
+  "UP/DOWN \204ndern, OK weiter\0"
+  "UP/DOWN \204ndern, OK setzen\0"
+  "ALARM %d STELLEN\0"
+  "Stunde:\0"
+  "Minute:\0"
+  "Alarm %d gestellt auf\0"
+  "ZEITZONE\0"
+  "Aktuell: UTC%c%d%s\n\0"
+  "Zeitzone gespeichert!\0"
+  "UP/DOWN \204ndern\nOK best\204tigen\nCANCEL zur\201ck\0"
+  "AKTIVE ALARME\0"
+  "Alarm %d: %02d:%02d\n\0"
+  "Keine aktiven Alarme\0"
+  "\nOK/CANCEL: zur\201ck\0"
+  "ALARM L\231SCHEN\0"
+  "Alarm %d l\224schen\0"
+  "Alarm %d nicht aktiv\0"
+  "Zur\201ck zum Men\201\0"
+  "\nOK w\204hlen\nCANCEL verlassen\0"
+  "ALARM %d L\231SCHEN?\0"
+  "Aktuell:\0"
+  "OK l\224schen\nCANCEL zur\201ck\0"
+  "ALARM %d GEL\231SCHT\0";
+
+static const UiText entries_de[STR_COUNT] = {
+  {0, 0, 0, 0},  // NONE
+  {1, 18, 1, 108},  // BOOT_STARTING
+  {20, 19, 1, 114},  // WIFI_CONNECTING
+  {40, 15, 1, 90},  // BOOT_READY
+  {56, 13, 1, 78},  // TIME_FAILED
+  {70, 7, 1, 42},  // DAY_SUNDAY
+  {78, 6, 1, 36},  // DAY_MONDAY
+  {85, 8, 1, 48},  // DAY_TUESDAY
+  {94, 8, 1, 48},  // DAY_WEDNESDAY
+  {103, 10, 1, 60},  // DAY_THURSDAY
+  {114, 7, 1, 42},  // DAY_FRIDAY
+  {122, 7, 1, 42},  // DAY_SATURDAY
+  {130, 6, 1, 36},  // MONTH_JANUARY
+  {137, 7, 1, 42},  // MONTH_FEBRUARY
+  {145, 4, 1, 24},  // MONTH_MARCH
+  {150, 5, 1, 30},  // MONTH_APRIL
+  {156, 3, 1, 18},  // MONTH_MAY
+  {160, 4, 1, 24},  // MONTH_JUNE
+  {165, 4, 1, 24},  // MONTH_JULY
+  {170, 6, 1, 36},  // MONTH_AUGUST
+  {177, 9, 1, 54},  // MONTH_SEPTEMBER
+  {187, 7, 1, 42},  // MONTH_OCTOBER
+  {195, 8, 1, 48},  // MONTH_NOVEMBER
+  {204, 8, 1, 48},  // MONTH_DECEMBER
+  {213, 26, 2, 84},  // CLOCK_FORMAT
+  {240, 7, 1, 42},  // RING_LINE1
+  {248, 5, 1, 30},  // RING_LINE2
+  {254, 8, 1, 48},  // RING_ALARM
+  {263, 20, 1, 120},  // RING_HELP
+  {284, 14, 1, 84},  // SNOOZED
+  {299, 18, 1, 108},  // SNOOZE_HELP
+  {318, 13, 1, 78},  // STOPPED
+  {332, 8, 1, 48},  // WARNING
+  {341, 15, 1, 90},  // WARN_BOTH
+  {357, 10, 1, 60},  // WARN_TEMP
+  {368, 11, 1, 66},  // WARN_HUMIDITY
+  {380, 7, 1, 42},  // TEMP_LABEL
+  {388, 9, 1, 54},  // HUMIDITY_LABEL
+  {398, 13, 1, 78},  // HEALTHY_TEMP
+  {412, 15, 1, 90},  // HEALTHY_HUMIDITY
+  {428, 5, 1, 30},  // MENU_TITLE
+  {434, 8, 1, 48},  // MENU_SET_TIMEZONE
+  {443, 16, 1, 96},  // MENU_SET_ALARM
+  {460, 15, 1, 90},  // MENU_VIEW_ALARMS
+  {476, 13, 1, 78},  // MENU_DELETE_ALARM
+  {490, 6, 1, 36},  // MENU_BACK
+  {497, 25, 1, 150},  // EDIT_HELP_NEXT
+  {523, 25, 1, 150},  // EDIT_HELP_SET
+  {549, 16, 1, 96},  // SET_ALARM_TITLE
+  {566, 7, 1, 42},  // SET_HOUR
+  {574, 7, 1, 42},  // SET_MINUTE
+  {582, 21, 1, 126},  // ALARM_SET
+  {604, 8, 1, 48},  // SET_TIMEZONE_TITLE
+  {613, 19, 1, 108},  // TIMEZONE_CURRENT
+  {633, 21, 1, 126},  // TIMEZONE_UPDATED
+  {655, 42, 3, 84},  // TIMEZONE_HELP
+  {698, 13, 1, 78},  // ALARMS_TITLE
+  {712, 20, 1, 114},  // ALARMS_ENTRY
+  {733, 20, 1, 120},  // ALARMS_NONE
+  {754, 18, 2, 102},  // ALARMS_HELP
+  {773, 13, 1, 78},  // DELETE_MENU_TITLE
+  {787, 16, 1, 96},  // DELETE_ITEM
+  {804, 20, 1, 120},  // DELETE_NOT_SET
+  {825, 15, 1, 90},  // DELETE_BACK
+  {841, 27, 3, 96},  // DELETE_MENU_HELP
+  {869, 17, 1, 102},  // DELETE_TITLE
+  {887, 8, 1, 48},  // DELETE_CURRENT
+  {896, 24, 2, 78},  // DELETE_HELP
+  {921, 17, 1, 102},  // DELETED
+};
+
+const UiLanguageTable uiLanguages[LANG_COUNT] = {
+  {"en", text_en, entries_en},
+  {"de", text_de, entries_de},
+};
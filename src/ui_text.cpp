@@ -0,0 +1,24 @@
+/*
+ * Medibox - localized UI text (see ui_text.h)
+ */
+
+#include "ui_text.h"
+
+static UiLanguage language = UI_LANGUAGE;
+
+void ui_set_language(UiLanguage lang) {
+  if (lang < LANG_COUNT) language = lang;
+}
+
+UiLanguage ui_language() {
+  return language;
+}
+
+const char* tr(StrId id) {
+  const UiLanguageTable& t = uiLanguages[language];
+  return t.text + t.entries[id < STR_COUNT ? id : STR_NONE].offset;
+}
+
+const UiText& tr_metrics(StrId id) {
+  return uiLanguages[language].entries[id < STR_COUNT ? id : STR_NONE];
+}
@@ -0,0 +1,161 @@
+/*
+ * Medibox - web UI assets, generated by tools/embed_web.py from web/.
+ * Do not edit.
+ */
+
+#include "web_ui.h"
+
+// /app.js
+static const uint8_t asset0[1260] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x56, 0xdf, 0x6f, 0xdb, 0x36,
+  0x10, 0x7e, 0xf7, 0x5f, 0x71, 0x55, 0x83, 0x42, 0x02, 0x5c, 0x39, 0x28, 0xfa, 0x32, 0x1b, 0xde,
+  0x50, 0xa4, 0xe9, 0xd6, 0x01, 0x4b, 0x83, 0x26, 0xdd, 0x8b, 0x61, 0xcc, 0xb4, 0x74, 0x8a, 0xd5,
+  0xd0, 0xa2, 0x47, 0x52, 0x4e, 0x3d, 0x57, 0xff, 0xfb, 0xee, 0x48, 0x5a, 0x92, 0x9d, 0xf4, 0xc7,
+  0x43, 0x10, 0x93, 0xbc, 0x3b, 0x7e, 0x77, 0xf7, 0xdd, 0x47, 0x8d, 0x46, 0xf0, 0x17, 0xe6, 0xe5,
+  0x52, 0x7d, 0x81, 0x97, 0x20, 0xa4, 0xd0, 0x6b, 0x10, 0x55, 0x0e, 0x06, 0xad, 0x2d, 0xab, 0x3b,
+  0x03, 0x9f, 0xde, 0x83, 0xaa, 0xc0, 0xaa, 0x0d, 0xa8, 0x02, 0xec, 0x0a, 0xe1, 0xe3, 0xe5, 0xcd,
+  0x2d, 0xbc, 0xb9, 0x7e, 0x0f, 0x71, 0x59, 0x65, 0xb2, 0xce, 0x71, 0xa4, 0xd1, 0xd8, 0x7f, 0xc4,
+  0xa6, 0x4c, 0x57, 0xc9, 0x20, 0xaa, 0x0d, 0x82, 0xb1, 0xba, 0xcc, 0x6c, 0x34, 0x19, 0x0c, 0x32,
+  0x55, 0x19, 0x0b, 0x67, 0x30, 0x85, 0xd8, 0xa0, 0x4c, 0x60, 0xfa, 0x2b, 0xe4, 0x2a, 0xab, 0xd7,
+  0x58, 0xd9, 0xf4, 0xdf, 0x1a, 0xf5, 0xee, 0x06, 0x25, 0x66, 0x56, 0x69, 0x77, 0x3c, 0x19, 0x48,
+  0xb4, 0x1e, 0xc4, 0xdf, 0xa8, 0x4d, 0x49, 0x17, 0x4f, 0xe1, 0x9c, 0xc2, 0x14, 0x75, 0x95, 0x59,
+  0x5e, 0x1a, 0x2b, 0x6c, 0x6d, 0x62, 0x8b, 0x5f, 0x6c, 0x02, 0xfb, 0x01, 0xc0, 0x59, 0x1c, 0x3d,
+  0xf7, 0x9b, 0x51, 0x92, 0xf2, 0xf6, 0x85, 0xaa, 0x2c, 0x45, 0x27, 0x47, 0x5e, 0xc1, 0xd7, 0xaf,
+  0x10, 0x11, 0x90, 0x66, 0x30, 0x10, 0x66, 0x57, 0x65, 0xd0, 0x46, 0x22, 0xbc, 0xf1, 0x1a, 0xed,
+  0x4a, 0xe5, 0x43, 0xd8, 0x08, 0xbb, 0x1a, 0xc2, 0x52, 0xe5, 0x3b, 0x1f, 0xd4, 0xa3, 0xa6, 0xb4,
+  0x28, 0x8a, 0x78, 0x10, 0xa5, 0x85, 0x02, 0x6d, 0xb6, 0x8a, 0xbd, 0x1d, 0x5b, 0x00, 0x04, 0x5f,
+  0xf7, 0x7b, 0x85, 0x22, 0x27, 0xbc, 0x63, 0x17, 0x02, 0x7e, 0x83, 0x3d, 0x44, 0x01, 0xc6, 0xcb,
+  0xdb, 0xdd, 0x06, 0xa3, 0x31, 0x44, 0x62, 0xb3, 0x91, 0x65, 0x26, 0xf8, 0xea, 0xd1, 0x67, 0xa3,
+  0xaa, 0x08, 0x1a, 0x18, 0xc3, 0xbe, 0xf1, 0x01, 0xd8, 0xaf, 0xf5, 0xfe, 0xf3, 0xe6, 0xc3, 0x55,
+  0xca, 0x25, 0xac, 0xee, 0xca, 0x62, 0x17, 0x7b, 0x58, 0x63, 0xa8, 0xab, 0x1c, 0x8b, 0xb2, 0x42,
+  0x77, 0x67, 0x43, 0xb5, 0x02, 0x28, 0x0b, 0x88, 0x09, 0x65, 0xea, 0x0b, 0x00, 0xd3, 0xe9, 0x14,
+  0x5e, 0x9d, 0xbf, 0x4e, 0x08, 0xb9, 0xad, 0x75, 0x05, 0x55, 0x2d, 0xe5, 0xa4, 0x4d, 0x27, 0x17,
+  0x56, 0xb4, 0xf9, 0xb0, 0x17, 0xc3, 0x88, 0x93, 0x94, 0x40, 0x51, 0x6a, 0xb1, 0xeb, 0x0d, 0x7b,
+  0xb4, 0x91, 0x9f, 0xb1, 0x91, 0xba, 0x4f, 0x42, 0xc2, 0x3e, 0x0a, 0x6a, 0x4d, 0x41, 0x2a, 0x7c,
+  0x80, 0x4b, 0xad, 0xa9, 0x6d, 0x8b, 0xb3, 0xbd, 0xaf, 0x44, 0x03, 0x67, 0x7b, 0xae, 0x4f, 0x33,
+  0xa6, 0x1f, 0x1d, 0xa8, 0x66, 0xe1, 0xe2, 0x01, 0x3b, 0xb6, 0x38, 0xa1, 0x3b, 0xef, 0x0e, 0x03,
+  0x3e, 0xfe, 0xe7, 0x37, 0xed, 0x4a, 0xab, 0x07, 0x3e, 0xe2, 0x65, 0x43, 0x7f, 0x21, 0x2d, 0x6f,
+  0xd1, 0x1c, 0xc8, 0xb5, 0x11, 0x39, 0xd3, 0xab, 0x72, 0x09, 0xdc, 0xb8, 0xb2, 0xd1, 0x22, 0xa5,
+  0xed, 0x1b, 0x2b, 0xb4, 0x8d, 0x5f, 0x0d, 0x21, 0x3a, 0x8f, 0x92, 0x3e, 0x8b, 0x34, 0x52, 0x2d,
+  0xf5, 0x1b, 0xe6, 0x99, 0x21, 0xe2, 0x05, 0x2a, 0x9d, 0xf0, 0x8e, 0xf6, 0xd3, 0xad, 0x5f, 0x4d,
+  0x02, 0xd1, 0xc2, 0xf2, 0x11, 0xd3, 0x16, 0xdb, 0xb3, 0x7d, 0xcf, 0xbc, 0x59, 0x74, 0x55, 0x77,
+  0x3d, 0x9d, 0x3a, 0x6f, 0x17, 0xdf, 0x80, 0xe5, 0xad, 0xc8, 0x55, 0x85, 0x7f, 0x9d, 0x84, 0x62,
+  0xb2, 0x02, 0x14, 0x4a, 0x43, 0xec, 0x03, 0x08, 0x9e, 0x3b, 0x0e, 0xee, 0xdd, 0x8f, 0xbb, 0xc1,
+  0x05, 0x9a, 0xfa, 0x30, 0x65, 0x65, 0x50, 0xdb, 0x8f, 0xea, 0x21, 0x0e, 0x05, 0xa7, 0xb3, 0x34,
+  0x93, 0xc2, 0x98, 0x2b, 0xb1, 0x46, 0x6e, 0x7c, 0x2a, 0x28, 0xfb, 0x2d, 0x12, 0xc3, 0xa2, 0x88,
+  0xf8, 0x14, 0xa9, 0xa2, 0x88, 0x3a, 0x53, 0xef, 0x7f, 0x81, 0x52, 0xc6, 0x8f, 0xd2, 0x73, 0x95,
+  0xa2, 0xb6, 0x8a, 0xb4, 0xcc, 0x7d, 0x72, 0x3f, 0xf4, 0xe9, 0xdd, 0xb6, 0x60, 0x62, 0xe4, 0xb1,
+  0x48, 0x57, 0xaa, 0xd6, 0x49, 0x33, 0x3e, 0x2c, 0xd7, 0x65, 0x55, 0x5b, 0x4c, 0x9a, 0xc5, 0x31,
+  0x18, 0x9f, 0x59, 0x46, 0x41, 0x99, 0x28, 0x27, 0xb7, 0x78, 0x13, 0x66, 0xe7, 0xe1, 0x82, 0x43,
+  0x41, 0x5a, 0x9a, 0x23, 0xfb, 0xb5, 0x22, 0x93, 0x69, 0x14, 0x16, 0x2f, 0x25, 0xf2, 0x2a, 0x8e,
+  0x96, 0xb5, 0xb5, 0xdc, 0xc0, 0x49, 0xf0, 0x21, 0xeb, 0xd3, 0x06, 0xbc, 0x25, 0x45, 0xb2, 0x18,
+  0xf5, 0x2d, 0x14, 0x09, 0x5d, 0x99, 0xdd, 0x33, 0xcd, 0x1c, 0xcb, 0x36, 0x3c, 0x32, 0x81, 0x3e,
+  0x7b, 0x98, 0x71, 0x59, 0xe6, 0x63, 0x37, 0x3c, 0x61, 0x30, 0x1d, 0x1c, 0x02, 0x9c, 0xd2, 0xd8,
+  0x13, 0xd7, 0x2e, 0x56, 0xa5, 0xcc, 0xe3, 0x1c, 0x65, 0x38, 0x6c, 0x1c, 0xa1, 0x89, 0xc1, 0xa3,
+  0x11, 0x04, 0xc2, 0x61, 0xee, 0xa3, 0x4e, 0x58, 0x6d, 0x5f, 0x9f, 0xff, 0xe2, 0xa4, 0x36, 0xc7,
+  0x6d, 0x99, 0x61, 0xe0, 0xbd, 0x71, 0x5b, 0x59, 0xad, 0x35, 0x03, 0xb5, 0x62, 0x29, 0x91, 0x64,
+  0x99, 0x0e, 0x97, 0x82, 0x24, 0x57, 0x55, 0xa7, 0x02, 0xd7, 0x07, 0x99, 0xad, 0x44, 0x75, 0x87,
+  0x81, 0x3c, 0x56, 0xef, 0x42, 0xcd, 0x8e, 0xe6, 0xc0, 0x0b, 0x03, 0xcb, 0x62, 0x74, 0xfd, 0xe6,
+  0xf6, 0xe2, 0x8f, 0x88, 0xe6, 0x66, 0x44, 0xcb, 0x91, 0x27, 0x1e, 0x5a, 0xda, 0xd8, 0x03, 0x5f,
+  0x36, 0x3e, 0x1a, 0x95, 0x21, 0xa4, 0x69, 0x1a, 0x2e, 0xa0, 0xf4, 0x43, 0x8a, 0x41, 0xa8, 0xdd,
+  0xaa, 0x01, 0xa7, 0x31, 0x10, 0xb7, 0xcd, 0xe2, 0x06, 0x62, 0x5f, 0xb6, 0x38, 0xe3, 0x17, 0x2f,
+  0x00, 0x9d, 0x0a, 0x74, 0x2d, 0x3d, 0x02, 0x18, 0x0e, 0x0f, 0xf5, 0x0d, 0x37, 0x44, 0xfe, 0x14,
+  0x3c, 0x82, 0xdc, 0x3d, 0x56, 0x6d, 0xe9, 0x48, 0xda, 0x25, 0x72, 0x79, 0xa8, 0x84, 0x7a, 0x77,
+  0x68, 0x7b, 0x03, 0x28, 0x69, 0x6f, 0x7f, 0x1c, 0x08, 0xd3, 0x35, 0x1a, 0x23, 0xee, 0xf0, 0xb4,
+  0x49, 0x6d, 0x45, 0x8b, 0x52, 0xca, 0x77, 0x4a, 0xaf, 0x63, 0x1a, 0xcf, 0xf5, 0x10, 0xb6, 0x42,
+  0xd6, 0x87, 0x9a, 0xf6, 0x06, 0x76, 0x76, 0x4f, 0x47, 0x73, 0x9e, 0xda, 0x0f, 0xcb, 0xcf, 0xf4,
+  0xb6, 0xa5, 0xd4, 0x2e, 0x5d, 0xa2, 0x89, 0x83, 0x7d, 0xbf, 0x06, 0x1c, 0x28, 0x45, 0x4f, 0x4e,
+  0x33, 0xbb, 0x9f, 0x27, 0x70, 0xba, 0x93, 0x3a, 0x2f, 0x62, 0xde, 0x76, 0xf2, 0x18, 0x0f, 0xd9,
+  0x5e, 0xd5, 0xeb, 0x25, 0xf5, 0xc1, 0x45, 0xea, 0x3f, 0x5e, 0xaa, 0x66, 0x32, 0xef, 0x9b, 0x13,
+  0x35, 0xa1, 0xe1, 0x20, 0x60, 0x47, 0x97, 0x1c, 0xf5, 0x44, 0xa6, 0x15, 0xab, 0x05, 0xb7, 0x82,
+  0x06, 0x83, 0xde, 0x2e, 0xd7, 0x9d, 0xa8, 0x72, 0xb7, 0x44, 0x09, 0x87, 0x9d, 0x05, 0xa3, 0x39,
+  0xc5, 0xdf, 0x08, 0x6d, 0xf0, 0x9d, 0x54, 0xc2, 0xb2, 0xab, 0x83, 0x9a, 0x9c, 0xa8, 0x35, 0x79,
+  0x38, 0xb1, 0x76, 0x0a, 0x98, 0xe7, 0xa4, 0x9d, 0x04, 0xa4, 0x5e, 0xae, 0x4b, 0xa7, 0x12, 0x8e,
+  0xb2, 0x31, 0x6e, 0xdd, 0x58, 0x31, 0x0e, 0xdc, 0xa6, 0x1b, 0x8d, 0x5b, 0x02, 0xf6, 0x16, 0x0b,
+  0x51, 0x4b, 0xeb, 0x29, 0xe4, 0xd1, 0x13, 0x09, 0xdb, 0x17, 0xcc, 0x11, 0xf5, 0xf7, 0xcb, 0xdb,
+  0xc7, 0x34, 0x75, 0x0e, 0x8f, 0x24, 0xbe, 0x8b, 0x52, 0x68, 0xc4, 0xa0, 0xef, 0xde, 0x27, 0xa5,
+  0x67, 0x35, 0x8f, 0x63, 0xe1, 0x40, 0x3c, 0x6b, 0x85, 0xa5, 0x7d, 0x07, 0xd9, 0xa1, 0x7d, 0x54,
+  0x0f, 0xb4, 0xbb, 0x52, 0x3e, 0x90, 0xff, 0x64, 0x32, 0x52, 0x85, 0x8b, 0x4f, 0xb4, 0x81, 0x6d,
+  0xbc, 0x3c, 0x50, 0x66, 0xf4, 0x1e, 0xdd, 0xd1, 0xad, 0x87, 0xca, 0xa7, 0xb6, 0x5c, 0x63, 0x68,
+  0x30, 0xeb, 0x46, 0xc3, 0x6f, 0x54, 0x8f, 0x48, 0x65, 0xf8, 0x34, 0x71, 0x64, 0x9a, 0xcd, 0xa2,
+  0xe7, 0x6c, 0xff, 0x1f, 0x69, 0x45, 0x9b, 0x73, 0xbb, 0x31, 0x1f, 0x02, 0x9f, 0xaf, 0xe8, 0x61,
+  0x5d, 0x29, 0x99, 0x9b, 0xce, 0xa2, 0xdb, 0x9a, 0xcf, 0x0f, 0x9f, 0x4c, 0x65, 0xfe, 0x83, 0x2e,
+  0x7c, 0xb3, 0x0f, 0x7d, 0xf5, 0x80, 0x6e, 0x20, 0xda, 0xdc, 0x86, 0xfd, 0xee, 0x5c, 0x7f, 0xe2,
+  0xee, 0xf8, 0x8f, 0xa6, 0x3e, 0x57, 0x5b, 0xeb, 0x24, 0x39, 0x9d, 0xe6, 0x76, 0x42, 0x4f, 0x15,
+  0xe3, 0xfb, 0x63, 0xfa, 0xd4, 0x07, 0x1e, 0xb1, 0x32, 0x8f, 0x7f, 0x56, 0xf1, 0x9e, 0x26, 0x52,
+  0xb8, 0xa2, 0x4d, 0x93, 0x39, 0xdc, 0x96, 0x3c, 0x19, 0x7e, 0x8b, 0x89, 0x9d, 0xc9, 0x93, 0x01,
+  0xba, 0x8e, 0x7c, 0x27, 0x44, 0xcf, 0xe8, 0xa7, 0x14, 0xf5, 0xc9, 0xea, 0x38, 0xb9, 0xf0, 0x75,
+  0x98, 0x0c, 0xfe, 0x07, 0x35, 0x83, 0x6f, 0x75, 0xe9, 0x0b, 0x00, 0x00,
+};
+
+// /index.html
+static const uint8_t asset1[501] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x54, 0xc1, 0x8e, 0xd3, 0x30,
+  0x10, 0xbd, 0xf7, 0x2b, 0x06, 0x4b, 0xac, 0x8a, 0x44, 0x1b, 0x5a, 0x09, 0x09, 0x69, 0x9d, 0x48,
+  0xab, 0x82, 0xb4, 0x17, 0x04, 0x12, 0xe5, 0xc0, 0xd1, 0x89, 0x27, 0x6b, 0x83, 0xed, 0x04, 0x7b,
+  0xd2, 0x6d, 0xf9, 0x7a, 0x6c, 0x27, 0xe9, 0xaa, 0xda, 0xd5, 0x22, 0xe0, 0xe4, 0xc9, 0xf8, 0xbd,
+  0x97, 0xf7, 0x26, 0x76, 0xf8, 0x8b, 0xf7, 0x9f, 0x76, 0xfb, 0x6f, 0x9f, 0x3f, 0x80, 0x22, 0x6b,
+  0xaa, 0x05, 0x4f, 0x0b, 0x18, 0xe1, 0xee, 0x4a, 0x86, 0x8e, 0xa5, 0x06, 0x0a, 0x19, 0x17, 0x8b,
+  0x24, 0xa0, 0x51, 0xc2, 0x07, 0xa4, 0x92, 0x0d, 0xd4, 0xae, 0xde, 0xb1, 0xb9, 0xed, 0x84, 0xc5,
+  0x92, 0x1d, 0x34, 0xde, 0xf7, 0x9d, 0x27, 0x06, 0x4d, 0xe7, 0x08, 0x5d, 0x84, 0xdd, 0x6b, 0x49,
+  0xaa, 0x94, 0x78, 0xd0, 0x0d, 0xae, 0xf2, 0xc3, 0x6b, 0xd0, 0x4e, 0x93, 0x16, 0x66, 0x15, 0x1a,
+  0x61, 0xb0, 0xdc, 0x24, 0x11, 0xd2, 0x64, 0xb0, 0xfa, 0x88, 0x52, 0xd7, 0xdd, 0x91, 0x17, 0xe3,
+  0xe3, 0x82, 0x1b, 0xed, 0x7e, 0x80, 0x47, 0x53, 0xb2, 0x40, 0x27, 0x83, 0x41, 0x21, 0x46, 0x71,
+  0xe5, 0xb1, 0x2d, 0x59, 0x91, 0x5b, 0xeb, 0x26, 0x84, 0x24, 0x50, 0x4c, 0x26, 0xeb, 0x4e, 0x9e,
+  0x26, 0xcb, 0xe8, 0x2b, 0xae, 0x36, 0x0f, 0xa2, 0xb1, 0xe6, 0xa1, 0x17, 0x0e, 0xb4, 0x4c, 0x7a,
+  0x82, 0x86, 0xc8, 0xe4, 0x45, 0x6a, 0x55, 0x23, 0x3f, 0x32, 0x16, 0x0b, 0x1e, 0xb0, 0x21, 0xdd,
+  0xb9, 0x6a, 0x01, 0xc0, 0xd5, 0xb6, 0xba, 0x31, 0xc2, 0xdb, 0x00, 0x3c, 0x58, 0x61, 0x4c, 0xe6,
+  0x1e, 0xd0, 0x87, 0x08, 0xc8, 0xe4, 0xd4, 0x4c, 0xec, 0x6d, 0x86, 0x93, 0xa8, 0x0d, 0x66, 0x8c,
+  0xc8, 0xac, 0x08, 0xa1, 0xec, 0x28, 0x46, 0x9a, 0xd7, 0x04, 0xc9, 0xe0, 0xb6, 0xf3, 0x76, 0xc4,
+  0x4a, 0xc9, 0x52, 0x27, 0xf6, 0xb4, 0xeb, 0x07, 0x02, 0x3a, 0xf5, 0x71, 0x9a, 0xa4, 0x2d, 0xb2,
+  0x69, 0xb2, 0x63, 0xed, 0xf1, 0xe7, 0xa0, 0x3d, 0xca, 0x09, 0x5c, 0x0f, 0x44, 0xd1, 0xe7, 0x8d,
+  0x94, 0x90, 0x5f, 0xc7, 0x8b, 0xa9, 0x93, 0xd4, 0x8b, 0x24, 0x9f, 0x06, 0x73, 0x8e, 0xf3, 0x28,
+  0xd9, 0x3e, 0x8a, 0xfe, 0xea, 0x1c, 0x9e, 0xed, 0x9f, 0x1d, 0xd1, 0xb4, 0x33, 0xdb, 0x32, 0xa2,
+  0x46, 0x53, 0x7d, 0xdd, 0xef, 0xa0, 0x6b, 0xdb, 0xf8, 0xf9, 0x61, 0xa9, 0x5e, 0x5d, 0x9a, 0x75,
+  0x83, 0xad, 0xd1, 0xcf, 0x76, 0x47, 0x14, 0x03, 0xab, 0x5d, 0xc9, 0x56, 0x9b, 0x6d, 0xac, 0xc4,
+  0xb1, 0x64, 0xa9, 0x08, 0x84, 0x7d, 0xc9, 0xde, 0xac, 0xdf, 0xa6, 0xf1, 0x8d, 0xba, 0x17, 0x69,
+  0xbe, 0x88, 0x03, 0xfe, 0x6d, 0x90, 0x5b, 0x14, 0x86, 0x14, 0x50, 0x3c, 0x18, 0x41, 0x75, 0x46,
+  0x86, 0x27, 0x12, 0x9d, 0xf7, 0x2e, 0x33, 0xed, 0xd1, 0xf6, 0xe8, 0xe3, 0x59, 0xf0, 0x08, 0xcb,
+  0x2b, 0x89, 0x77, 0xd7, 0xbb, 0x67, 0x93, 0xc5, 0x44, 0x89, 0xf2, 0x90, 0x23, 0x1e, 0x5f, 0xb8,
+  0x72, 0x52, 0x04, 0x75, 0x9d, 0x75, 0xe1, 0x59, 0xb6, 0x38, 0x3e, 0x62, 0x5f, 0x4e, 0x61, 0xac,
+  0x6f, 0x07, 0xab, 0xa5, 0xa6, 0x13, 0x2c, 0x5f, 0xfe, 0xc9, 0xcd, 0x0c, 0xfd, 0x77, 0x47, 0x4f,
+  0x2a, 0xfc, 0xc7, 0xb7, 0x69, 0xbc, 0xee, 0x09, 0x82, 0x6f, 0xe2, 0x1d, 0x15, 0x7d, 0xbf, 0xfe,
+  0x3e, 0x5e, 0xb3, 0xdc, 0x4e, 0xd8, 0xe9, 0x8a, 0x16, 0xe3, 0xef, 0xe6, 0x37, 0x83, 0x58, 0x1e,
+  0x31, 0x7f, 0x04, 0x00, 0x00,
+};
+
+// /style.css
+static const uint8_t asset2[375] = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x6d, 0x51, 0xcb, 0xae, 0xd3, 0x30,
+  0x10, 0xdd, 0xf7, 0x2b, 0x46, 0xaa, 0xd8, 0xe1, 0xd0, 0xa6, 0x17, 0x28, 0xb1, 0xf8, 0x12, 0xc4,
+  0x62, 0x1c, 0x4f, 0x5a, 0x83, 0x63, 0x5b, 0xf6, 0x44, 0x4d, 0xb8, 0xe2, 0xdf, 0x99, 0xa4, 0x09,
+  0x37, 0x42, 0xec, 0xa2, 0x93, 0x33, 0xe7, 0x65, 0x13, 0xed, 0x04, 0xaf, 0x07, 0x80, 0x2e, 0x06,
+  0x6e, 0xe0, 0xfc, 0x29, 0x8d, 0x1f, 0xce, 0xd5, 0x0b, 0x94, 0xa9, 0x30, 0xf5, 0x6a, 0x70, 0xef,
+  0xa1, 0x60, 0x28, 0xaa, 0x50, 0x76, 0x9d, 0x16, 0x5e, 0x8f, 0xa3, 0x7a, 0x38, 0xcb, 0xf7, 0x06,
+  0x2e, 0x75, 0xa6, 0xfe, 0x89, 0xe5, 0x9b, 0x0b, 0x0d, 0x9c, 0x00, 0x07, 0x8e, 0x33, 0x92, 0xd0,
+  0x5a, 0x17, 0x6e, 0x33, 0x74, 0x5e, 0x49, 0x6d, 0xf4, 0x31, 0x37, 0x70, 0xac, 0xeb, 0x5a, 0x1f,
+  0x7e, 0x1f, 0xee, 0x84, 0x96, 0x32, 0xbc, 0x82, 0x75, 0x25, 0x79, 0x9c, 0x1a, 0xe8, 0x3c, 0x8d,
+  0x1a, 0xd0, 0xbb, 0x5b, 0x50, 0x4e, 0xcc, 0x4b, 0x03, 0x06, 0x0b, 0x79, 0x17, 0x48, 0xc3, 0x8f,
+  0xa1, 0xb0, 0xeb, 0x26, 0xd5, 0x4a, 0x4c, 0x9a, 0x93, 0x96, 0x84, 0x2d, 0x29, 0x43, 0xfc, 0x20,
+  0x0a, 0x1a, 0x44, 0xb0, 0x86, 0xd2, 0xa3, 0xf7, 0x22, 0xb9, 0x59, 0x5d, 0xaf, 0x57, 0xbd, 0x14,
+  0x53, 0x0f, 0x72, 0xb7, 0xbb, 0x5c, 0x85, 0x98, 0x85, 0xb3, 0x82, 0xc5, 0xfd, 0x22, 0x49, 0x58,
+  0x7d, 0x96, 0x80, 0x22, 0x50, 0xa8, 0x65, 0x17, 0x83, 0xdc, 0x9b, 0x98, 0x25, 0x9b, 0xe2, 0x98,
+  0x64, 0x91, 0x34, 0x42, 0x89, 0xde, 0x59, 0x38, 0x5a, 0x6b, 0xf5, 0xae, 0x59, 0xf5, 0x51, 0x9a,
+  0x6d, 0x05, 0xe5, 0x9e, 0xd1, 0x78, 0x92, 0xeb, 0x75, 0x9d, 0xf3, 0xe9, 0xf4, 0x4e, 0x6f, 0x52,
+  0x92, 0xc8, 0x63, 0x2a, 0x62, 0xb7, 0x7d, 0xe9, 0x75, 0x35, 0x65, 0x22, 0x73, 0xec, 0x37, 0xbd,
+  0x45, 0xc8, 0x8a, 0xca, 0xce, 0xe7, 0xb2, 0xf8, 0x3c, 0xff, 0x34, 0x1e, 0x0b, 0xab, 0xf6, 0xee,
+  0xfc, 0x4c, 0x62, 0x1a, 0x59, 0x2d, 0x8b, 0x35, 0x90, 0xe7, 0x86, 0x0b, 0x29, 0x57, 0xb1, 0xeb,
+  0x76, 0x33, 0x20, 0xe2, 0x8c, 0x7b, 0x34, 0xe4, 0xf7, 0x83, 0x1b, 0x1f, 0xdb, 0x9f, 0xfa, 0xed,
+  0xf5, 0xaa, 0x97, 0xbf, 0x46, 0x2e, 0xa4, 0x81, 0xbf, 0xf1, 0x94, 0xe8, 0x6b, 0x18, 0x7a, 0x43,
+  0xf9, 0xfb, 0x5b, 0xb1, 0x2d, 0xa6, 0x19, 0x24, 0x78, 0xf8, 0x5f, 0xd4, 0xea, 0xba, 0x52, 0x8e,
+  0x85, 0x91, 0x87, 0xb2, 0xcb, 0xd2, 0x5e, 0x2e, 0xff, 0xac, 0xff, 0xe5, 0x49, 0xfd, 0x03, 0xb3,
+  0xe2, 0x55, 0xbf, 0x89, 0x02, 0x00, 0x00,
+};
+
+const WebAsset webAssets[] = {
+  {"/app.js", "application/javascript", "\"d94db86978a7d9d8\"", asset0, sizeof(asset0)},
+  {"/index.html", "text/html; charset=utf-8", "\"0369e7793ac688d5\"", asset1, sizeof(asset1)},
+  {"/style.css", "text/css", "\"e7fc601af0977309\"", asset2, sizeof(asset2)},
+};
+
+const size_t webAssetCount = sizeof(webAssets) / sizeof(webAssets[0]);
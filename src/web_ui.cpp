@@ -0,0 +1,44 @@
+/*
+ * Medibox - browser UI served from flash (see web_ui.h)
+ */
+
+#include "web_ui.h"
+
+#include <string.h>
+
+#include "http_server.h"
+#include "metrics.h"
+
+static MetricCounter assetsSent("medibox_web_assets_sent_total", "UI assets sent with a body");
+static MetricCounter assetsNotModified("medibox_web_not_modified_total",
+                                       "UI requests answered with 304");
+
+static const WebAsset* find_asset(const char* path) {
+  if (strcmp(path, "/") == 0) path = "/index.html";
+  for (size_t i = 0; i < webAssetCount; i++) {
+    if (strcmp(webAssets[i].path, path) == 0) return &webAssets[i];
+  }
+  return NULL;
+}
+
+// If-None-Match may list several tags or weak ones (W/"..."), so look for
+// ours anywhere in the value
+static bool etag_matches(const char* ifNoneMatch, const char* etag) {
+  if (ifNoneMatch[0] == '\0') return false;
+  return strcmp(ifNoneMatch, "*") == 0 || strstr(ifNoneMatch, etag) != NULL;
+}
+
+bool web_ui_handle(HttpRequest& req, HttpResponse& res) {
+  if (req.method != HTTP_GET) return false;
+  const WebAsset* asset = find_asset(req.path);
+  if (asset == NULL) return false;
+
+  if (etag_matches(req.ifNoneMatch, asset->etag)) {
+    assetsNotModified.inc();
+    res.send_not_modified(asset->etag);
+  } else {
+    assetsSent.inc();
+    res.send_gzip(asset->contentType, asset->etag, asset->data, asset->size);
+  }
+  return true;
+}
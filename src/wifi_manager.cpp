@@ -0,0 +1,183 @@
+/*
+ * Medibox - background WiFi connection manager (see wifi_manager.h)
+ */
+
+#include "wifi_manager.h"
+
+#include "hal.h"
+#include "metrics.h"
+
+static WifiNetwork networks[WIFI_MAX_NETWORKS];
+static int networkCount = 0;
+static int networkIndex = 0;
+
+static WifiListener listeners[WIFI_MAX_LISTENERS];
+static int listenerCount = 0;
+
+static WifiState state = WIFI_IDLE;
+static WifiState publishedState = WIFI_IDLE;
+static unsigned long stateSince = 0;
+static unsigned long backoffMs = 0;
+static unsigned long backoffDelay = WIFI_BACKOFF_MIN_MS;
+
+// Set from the WiFi event task, taken in loop() with an atomic exchange so
+// an event landing in between is never lost
+static bool gotIpEvent = false;
+static bool disconnectEvent = false;
+
+static WifiMetrics metrics = {};
+
+static MetricCounter connectsMetric("medibox_wifi_connects_total",
+                                    "WiFi sessions established",
+                                    [] { return metrics.connects; });
+static MetricCounter reconnectsMetric("medibox_wifi_reconnects_total",
+                                      "WiFi sessions re-established after a drop",
+                                      [] { return metrics.reconnects; });
+static MetricGauge lastConnectMetric("medibox_wifi_last_connect_ms",
+                                     "Connect to IP time of the latest session",
+                                     [] { return metrics.lastConnectMs; });
+static MetricGauge avgConnectMetric("medibox_wifi_avg_connect_ms", "Mean connect to IP time",
+                                    [] { return metrics.avgConnectMs; });
+// Seconds: a millisecond gauge would wrap after 24 days
+static MetricGauge sessionUptimeMetric("medibox_wifi_session_uptime_seconds",
+                                       "Current WiFi session, 0 when offline", [] {
+                                         WifiMetrics m;
+                                         wifi_manager_metrics(&m);
+                                         return m.sessionUptimeMs / 1000;
+                                       });
+static MetricCounter uptimeMetric("medibox_wifi_uptime_seconds_total",
+                                  "Time connected over all sessions", [] {
+                                    WifiMetrics m;
+                                    wifi_manager_metrics(&m);
+                                    return m.totalUptimeMs / 1000;
+                                  });
+static unsigned long sessionStart = 0;
+static uint32_t closedUptimeMs = 0;
+static bool hadSession = false;
+
+static void on_network_event(HalNetworkEvent event) {
+  if (event == HAL_NETWORK_GOT_IP) {
+    __atomic_store_n(&gotIpEvent, true, __ATOMIC_RELEASE);
+  } else {
+    __atomic_store_n(&disconnectEvent, true, __ATOMIC_RELEASE);
+  }
+}
+
+static void set_state(WifiState next) {
+  state = next;
+  stateSince = hal_millis();
+}
+
+static void start_attempt() {
+  const WifiNetwork& net = networks[networkIndex];
+  __atomic_store_n(&gotIpEvent, false, __ATOMIC_RELEASE);
+  __atomic_store_n(&disconnectEvent, false, __ATOMIC_RELEASE);
+  metrics.attempts++;
+  hal_network_connect(net.ssid, net.password);
+  set_state(WIFI_CONNECTING);
+}
+
+// Equal jitter: wait between half and all of the current backoff step
+static void start_backoff() {
+  hal_network_disconnect();
+  networkIndex = (networkIndex + 1) % networkCount;
+  backoffMs = backoffDelay / 2 + hal_random() % (backoffDelay / 2 + 1);
+  backoffDelay = backoffDelay * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : backoffDelay * 2;
+  set_state(WIFI_BACKOFF);
+}
+
+static void on_connected() {
+  unsigned long now = hal_millis();
+  metrics.connects++;
+  if (hadSession) {
+    metrics.reconnects++;
+  }
+  metrics.lastConnectMs = now - stateSince;
+  metrics.avgConnectMs += ((int32_t)metrics.lastConnectMs - (int32_t)metrics.avgConnectMs) / (int32_t)metrics.connects;
+  sessionStart = now;
+  hadSession = true;
+  backoffDelay = WIFI_BACKOFF_MIN_MS;
+  set_state(WIFI_CONNECTED);
+}
+
+static void on_disconnected() {
+  closedUptimeMs += hal_millis() - sessionStart;
+  start_backoff();
+}
+
+bool wifi_manager_add_network(const char* ssid, const char* password) {
+  if (networkCount >= WIFI_MAX_NETWORKS) return false;
+  networks[networkCount].ssid = ssid;
+  networks[networkCount].password = password;
+  networkCount++;
+  return true;
+}
+
+void wifi_manager_add_listener(WifiListener listener) {
+  if (listenerCount < WIFI_MAX_LISTENERS) {
+    listeners[listenerCount++] = listener;
+  }
+}
+
+void wifi_manager_begin() {
+  if (networkCount == 0) return;
+
+  // Reconnects are paced by the backoff below, not by the driver
+  hal_network_begin(on_network_event);
+  start_attempt();
+}
+
+// Advance the state machine; never waits
+void wifi_manager_loop() {
+  if (networkCount == 0) return;
+
+  bool gotIp = __atomic_exchange_n(&gotIpEvent, false, __ATOMIC_ACQ_REL);
+  bool dropped = __atomic_exchange_n(&disconnectEvent, false, __ATOMIC_ACQ_REL);
+
+  switch (state) {
+    case WIFI_CONNECTING:
+      if (gotIp) {
+        on_connected();
+      } else if (dropped || hal_millis() - stateSince >= WIFI_CONNECT_TIMEOUT_MS) {
+        start_backoff();
+      }
+      break;
+    case WIFI_CONNECTED:
+      if (dropped) {
+        on_disconnected();
+      }
+      break;
+    case WIFI_BACKOFF:
+      if (hal_millis() - stateSince >= backoffMs) {
+        start_attempt();
+      }
+      break;
+    case WIFI_IDLE:
+      break;
+  }
+
+  if (state != publishedState) {
+    publishedState = state;
+    for (int i = 0; i < listenerCount; i++) {
+      listeners[i](state);
+    }
+  }
+}
+
+WifiState wifi_manager_state() {
+  return publishedState;
+}
+
+bool wifi_manager_connected() {
+  return publishedState == WIFI_CONNECTED;
+}
+
+const char* wifi_manager_ssid() {
+  return networkCount > 0 ? networks[networkIndex].ssid : "";
+}
+
+void wifi_manager_metrics(WifiMetrics* out) {
+  *out = metrics;
+  out->sessionUptimeMs = state == WIFI_CONNECTED ? hal_millis() - sessionStart : 0;
+  out->totalUptimeMs = closedUptimeMs + out->sessionUptimeMs;
+}
@@ -0,0 +1,281 @@
+/*
+ * Medibox - host tests for alarm patches and alarm table commits
+ *
+ * The remote side is alarm_patch_apply() as PATCH /api/alarmset runs it,
+ * the device side is the alarm editor driven through the menus. A stale
+ * patch is what the REST API answers with 409.
+ *
+ *   pio test -e native -f test_alarm_patch
+ */
+
+#include <Adafruit_SSD1306.h>
+#include <Preferences.h>
+#include <Wire.h>
+#include <string.h>
+#include <unity.h>
+
+#include "alarm_patch.h"
+#include "hal_linux.h"
+#include "menu.h"
+#include "settings.h"
+
+static Adafruit_SSD1306 panel(128, 64, &Wire, -1);
+
+static void no_flush() {}
+
+static const ButtonEvent press_of(Button button) {
+  ButtonEvent ev = {button, 1, false, 0};
+  return ev;
+}
+
+static void press(Button button) {
+  menu_handle(press_of(button));
+}
+
+// What PATCH /api/alarmset does with the settings lock held
+static AlarmPatchResult patch(const char* body, uint32_t* changed) {
+  JsonFlatParser parser;
+  TEST_ASSERT_TRUE_MESSAGE(parser.feed(body, strlen(body)), body);
+  TEST_ASSERT_TRUE_MESSAGE(parser.complete(), body);
+  settings_lock();
+  AlarmPatchResult r = alarm_patch_apply(parser, settings.alarms, settings.alarmVersion, changed);
+  if (r == ALARM_PATCH_OK) settings_commit_alarms(*changed);
+  settings_unlock();
+  return r;
+}
+
+static void set_table(bool active0, int hour0, int minute0, bool active1, int hour1, int minute1) {
+  settings_lock();
+  settings.alarms[0] = {active0, hour0, minute0};
+  settings.alarms[1] = {active1, hour1, minute1};
+  settings_commit_alarms(3);
+  settings_unlock();
+}
+
+// The slot as last written to NVS
+static Alarm stored(int slot) {
+  Alarm a = {false, -1, -1};
+  char key[8];
+  snprintf(key, sizeof(key), "a%d", slot);
+  Preferences prefs;
+  prefs.begin("alarms", true);
+  prefs.getBytes(key, &a, sizeof(a));
+  prefs.end();
+  return a;
+}
+
+static void assert_alarm(bool active, int hour, int minute, const Alarm& a) {
+  TEST_ASSERT_EQUAL(active, a.active);
+  if (!active) return;
+  TEST_ASSERT_EQUAL(hour, a.hour);
+  TEST_ASSERT_EQUAL(minute, a.minute);
+}
+
+void setUp() {
+  set_table(true, 8, 0, false, 0, 0);
+}
+
+void tearDown() {
+  for (int i = 0; i < MENU_DEPTH + 1 && menu_active(); i++) press(CANCEL_BTN);
+}
+
+static void test_patch_updates_deletes_and_bumps_the_version() {
+  set_table(true, 8, 0, true, 20, 0);
+  uint32_t version = settings.alarmVersion;
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"07:30\",\"2\":null}", (unsigned)version);
+
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  TEST_ASSERT_EQUAL_UINT32(3, changed);
+  TEST_ASSERT_EQUAL_UINT32(version + 1, settings.alarmVersion);
+  assert_alarm(true, 7, 30, settings.alarms[0]);
+  assert_alarm(false, 0, 0, settings.alarms[1]);
+  assert_alarm(true, 7, 30, stored(0));
+  assert_alarm(false, 0, 0, stored(1));
+}
+
+static void test_patch_without_changes_keeps_the_version() {
+  uint32_t version = settings.alarmVersion;
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"08:00\",\"2\":null}", (unsigned)version);
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  TEST_ASSERT_EQUAL_UINT32(0, changed);
+  TEST_ASSERT_EQUAL_UINT32(version, settings.alarmVersion);
+}
+
+static void test_only_changed_slots_are_rewritten() {
+  // Mark slot 2 in NVS; a patch of slot 1 must not write it
+  Preferences prefs;
+  prefs.begin("alarms", false);
+  Alarm marker = {true, 23, 59};
+  prefs.putBytes("a1", &marker, sizeof(marker));
+  prefs.end();
+
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"09:15\"}", (unsigned)settings.alarmVersion);
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  TEST_ASSERT_EQUAL_UINT32(1, changed);
+  assert_alarm(true, 9, 15, stored(0));
+  assert_alarm(true, 23, 59, stored(1));
+}
+
+static void test_stale_base_is_rejected() {
+  uint32_t version = settings.alarmVersion;
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"06:00\"}", (unsigned)(version - 1));
+  uint32_t changed = 99;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_STALE, patch(body, &changed));
+  TEST_ASSERT_EQUAL_UINT32(0, changed);
+  TEST_ASSERT_EQUAL_UINT32(version, settings.alarmVersion);
+  assert_alarm(true, 8, 0, settings.alarms[0]);
+
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"06:00\"}", (unsigned)(version + 1));
+  TEST_ASSERT_EQUAL(ALARM_PATCH_STALE, patch(body, &changed));
+  TEST_ASSERT_EQUAL(ALARM_PATCH_STALE, patch("{\"base\":-1,\"1\":\"06:00\"}", &changed));
+  assert_alarm(true, 8, 0, settings.alarms[0]);
+}
+
+static void test_invalid_patches_leave_the_table_untouched() {
+  uint32_t version = settings.alarmVersion;
+  // A valid first entry must not be applied when a later one is bad
+  static const char* const entries[] = {
+    "\"1\":\"06:00\",\"2\":\"24:00\"",     // Hour out of range
+    "\"1\":\"06:00\",\"2\":\"07:60\"",     // Minute out of range
+    "\"1\":\"06:00\",\"2\":\"7:30\"",      // Not HH:MM
+    "\"1\":\"06:00\",\"2\":\"07:30 \"",
+    "\"1\":\"06:00\",\"3\":\"07:30\"",     // No such alarm
+    "\"1\":\"06:00\",\"0\":\"07:30\"",
+    "\"1\":\"06:00\",\"x\":\"07:30\"",
+    "\"1\":\"06:00\",\"2\":true",          // Neither a time nor null
+    "\"1\":\"06:00\",\"2\":700",
+    "\"1\":\"06:00\",\"1\":\"07:00\"",     // Same alarm twice
+    "\"1\":\"06:00\",\"01\":null",
+  };
+  for (const char* entry : entries) {
+    char body[96];
+    snprintf(body, sizeof(body), "{\"base\":%u,%s}", (unsigned)version, entry);
+    uint32_t changed = 99;
+    TEST_ASSERT_EQUAL_MESSAGE(ALARM_PATCH_INVALID, patch(body, &changed), body);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, changed, body);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(version, settings.alarmVersion, body);
+    assert_alarm(true, 8, 0, settings.alarms[0]);
+    assert_alarm(false, 0, 0, settings.alarms[1]);
+    assert_alarm(true, 8, 0, stored(0));
+  }
+
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_INVALID, patch("{\"1\":\"06:00\"}", &changed));   // No base
+  TEST_ASSERT_EQUAL(ALARM_PATCH_INVALID, patch("{\"base\":\"1\",\"1\":\"06:00\"}", &changed));
+  assert_alarm(true, 8, 0, settings.alarms[0]);
+}
+
+// A remote client reads the table, then the alarm is edited on the device
+static void test_ui_edit_in_between_makes_the_remote_patch_conflict() {
+  uint32_t base = settings.alarmVersion;
+
+  // Set Alarm 1 is the second row; the hour goes from 08 to 09
+  menu_open(&mainMenu);
+  press(DOWN);
+  press(OK_BTN);
+  TEST_ASSERT_EQUAL(SCREEN_EDIT, menu_screen_kind());
+  press(UP);
+  press(OK_BTN);
+  press(OK_BTN);
+  assert_alarm(true, 9, 0, settings.alarms[0]);
+  TEST_ASSERT_EQUAL_UINT32(base + 1, settings.alarmVersion);
+
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"06:45\"}", (unsigned)base);
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_STALE, patch(body, &changed));
+  assert_alarm(true, 9, 0, settings.alarms[0]);
+  assert_alarm(true, 9, 0, stored(0));
+
+  // Rebased on the version it is sent back, the patch goes through
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":\"06:45\"}", (unsigned)settings.alarmVersion);
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  assert_alarm(true, 6, 45, settings.alarms[0]);
+}
+
+// And the other way round: the editor commits over the remote change,
+// which the device owner sees on screen, and the version moves on
+static void test_remote_patch_in_between_is_not_lost_silently() {
+  menu_open(&mainMenu);
+  press(DOWN);
+  press(OK_BTN);
+
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"2\":\"21:00\"}", (unsigned)settings.alarmVersion);
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  uint32_t afterRemote = settings.alarmVersion;
+
+  press(UP);
+  press(OK_BTN);
+  press(OK_BTN);
+  // Only the slot being edited is committed; the remote one stays
+  assert_alarm(true, 9, 0, settings.alarms[0]);
+  assert_alarm(true, 21, 0, settings.alarms[1]);
+  assert_alarm(true, 21, 0, stored(1));
+  TEST_ASSERT_EQUAL_UINT32(afterRemote + 1, settings.alarmVersion);
+}
+
+// Confirming the editor on the times it opened with writes nothing
+static void test_ui_edit_without_changes_keeps_the_version() {
+  uint32_t version = settings.alarmVersion;
+  Preferences prefs;
+  prefs.begin("alarms", false);
+  Alarm marker = {true, 23, 59};
+  prefs.putBytes("a0", &marker, sizeof(marker));
+  prefs.end();
+
+  menu_open(&mainMenu);
+  press(DOWN);
+  press(OK_BTN);
+  press(OK_BTN);
+  press(OK_BTN);
+  assert_alarm(true, 8, 0, settings.alarms[0]);
+  TEST_ASSERT_EQUAL_UINT32(version, settings.alarmVersion);
+  assert_alarm(true, 23, 59, stored(0));
+}
+
+// The delete screen is open when a remote patch deletes the same alarm
+static void test_ui_delete_of_a_deleted_alarm_keeps_the_version() {
+  menu_open(&mainMenu);
+  for (int i = 0; i < 4; i++) press(DOWN);
+  press(OK_BTN);
+  press(OK_BTN);
+  TEST_ASSERT_EQUAL(SCREEN_VIEW, menu_screen_kind());
+
+  char body[64];
+  snprintf(body, sizeof(body), "{\"base\":%u,\"1\":null}", (unsigned)settings.alarmVersion);
+  uint32_t changed;
+  TEST_ASSERT_EQUAL(ALARM_PATCH_OK, patch(body, &changed));
+  uint32_t afterRemote = settings.alarmVersion;
+
+  press(OK_BTN);
+  assert_alarm(false, 0, 0, settings.alarms[0]);
+  TEST_ASSERT_EQUAL_UINT32(afterRemote, settings.alarmVersion);
+}
+
+int main() {
+  hal_linux_virtual_time(true);
+  settings_begin();
+  panel.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  menu_begin(&panel, no_flush);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_patch_updates_deletes_and_bumps_the_version);
+  RUN_TEST(test_patch_without_changes_keeps_the_version);
+  RUN_TEST(test_only_changed_slots_are_rewritten);
+  RUN_TEST(test_stale_base_is_rejected);
+  RUN_TEST(test_invalid_patches_leave_the_table_untouched);
+  RUN_TEST(test_ui_edit_in_between_makes_the_remote_patch_conflict);
+  RUN_TEST(test_remote_patch_in_between_is_not_lost_silently);
+  RUN_TEST(test_ui_edit_without_changes_keeps_the_version);
+  RUN_TEST(test_ui_delete_of_a_deleted_alarm_keeps_the_version);
+  return UNITY_END();
+}
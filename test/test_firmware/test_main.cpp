@@ -0,0 +1,173 @@
+/*
+ * Medibox - host tests that run the firmware's setup() and loop()
+ *
+ * Time is virtual and only moves while loop() runs, in TICK_MS steps as
+ * on the device; buttons are driven through their pins.
+ *
+ *   pio test -e native -f test_firmware
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "board.h"
+#include "buttons.h"
+#include "hal_linux.h"
+#include "menu.h"
+#include "metrics.h"
+#include "settings.h"
+
+// main.cpp
+void setup();
+void loop();
+extern bool alarmRinging;
+extern int alarmRingingNum;
+extern bool alarmSnoozing;
+extern MetricCounter displayFlushBytes;
+
+#define TICK_MS 10
+#define TEST_START_TIME 1760000000
+#define FRAME_BYTES (128 * 64 / 8)
+
+static void pass_ms(uint32_t ms) {
+  uint32_t end = hal_millis() + ms;
+  while ((int32_t)(hal_millis() - end) < 0) {
+    hal_linux_advance_us(TICK_MS * 1000);
+    loop();
+  }
+}
+
+static uint32_t frames() {
+  return displayFlushBytes.get() / FRAME_BYTES;
+}
+
+static void press(uint8_t pin) {
+  hal_linux_set_pin(pin, false);
+  pass_ms(100);
+  hal_linux_set_pin(pin, true);
+  pass_ms(BUTTON_DEBOUNCE_MS + TICK_MS);
+}
+
+// Local time on the given day after the start
+static void set_local_time(int day, int hour, int minute, int second) {
+  time_t start = TEST_START_TIME;
+  struct tm t;
+  localtime_r(&start, &t);
+  t.tm_mday += day;
+  t.tm_hour = hour;
+  t.tm_min = minute;
+  t.tm_sec = second;
+  t.tm_isdst = -1;
+  hal_linux_set_time(mktime(&t));
+}
+
+// What the alarm editor or a REST client does
+static void set_alarm(int slot, bool active, int hour, int minute) {
+  settings_lock();
+  settings.alarms[slot].active = active;
+  settings.alarms[slot].hour = hour;
+  settings.alarms[slot].minute = minute;
+  settings_commit_alarms(1u << slot);
+  settings_unlock();
+}
+
+void setUp() {
+  for (int slot = 0; slot < MAX_ALARMS; slot++) set_alarm(slot, false, 0, 0);
+  hal_linux_set_sensor(28, 70);
+}
+
+void tearDown() {
+  if (alarmRinging) press(BTN_CANCEL);
+}
+
+static void test_daily_alarm_rings_every_day() {
+  set_alarm(0, true, 8, 0);
+  for (int day = 0; day < 3; day++) {
+    set_local_time(day, 7, 59, 30);
+    pass_ms(20000);
+    TEST_ASSERT_FALSE(alarmRinging);
+    pass_ms(20000);
+    TEST_ASSERT_TRUE_MESSAGE(alarmRinging, "the 08:00 alarm did not ring");
+    TEST_ASSERT_EQUAL(1, alarmRingingNum);
+
+    press(BTN_CANCEL);
+    TEST_ASSERT_FALSE(alarmRinging);
+    TEST_ASSERT_FALSE(alarmSnoozing);
+    // A clock correction back into the same minute does not ring it again
+    set_local_time(day, 8, 0, 0);
+    pass_ms(5000);
+    TEST_ASSERT_FALSE(alarmRinging);
+  }
+}
+
+static void test_both_alarms_ring_on_consecutive_days() {
+  set_alarm(0, true, 8, 0);
+  set_alarm(1, true, 20, 30);
+  for (int day = 0; day < 2; day++) {
+    set_local_time(day, 8, 0, 0);
+    pass_ms(1000);
+    TEST_ASSERT_TRUE(alarmRinging);
+    TEST_ASSERT_EQUAL(1, alarmRingingNum);
+    press(BTN_CANCEL);
+
+    set_local_time(day, 20, 30, 0);
+    pass_ms(1000);
+    TEST_ASSERT_TRUE(alarmRinging);
+    TEST_ASSERT_EQUAL(2, alarmRingingNum);
+    press(BTN_CANCEL);
+  }
+}
+
+static void test_inactive_alarm_stays_quiet() {
+  set_alarm(0, false, 8, 0);
+  set_local_time(0, 8, 0, 0);
+  pass_ms(5000);
+  TEST_ASSERT_FALSE(alarmRinging);
+}
+
+static void test_held_button_redraws_at_most_ten_times_a_second() {
+  set_alarm(0, true, 8, 0);
+  set_local_time(0, 12, 0, 0);
+  press(BTN_OK);
+  press(BTN_DOWN);
+  press(BTN_OK);
+  TEST_ASSERT_TRUE(menu_active());
+  TEST_ASSERT_EQUAL(SCREEN_EDIT, menu_screen_kind());
+
+  // Past BUTTON_FAST_AFTER_MS the hour steps 20 times a second
+  hal_linux_set_pin(BTN_UP, false);
+  pass_ms(BUTTON_HOLD_MS + BUTTON_FAST_AFTER_MS);
+  uint32_t before = frames();
+  pass_ms(2000);
+  uint32_t held = frames() - before;
+  hal_linux_set_pin(BTN_UP, true);
+  TEST_ASSERT_GREATER_THAN_UINT32(10, held);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(2000 / MENU_REPEAT_REDRAW_MS + 1, held);
+
+  // The last value is drawn after the release, and nothing after that
+  pass_ms(MENU_REPEAT_REDRAW_MS + TICK_MS);
+  before = frames();
+  pass_ms(1000);
+  TEST_ASSERT_EQUAL_UINT32(before, frames());
+
+  press(BTN_OK);
+  press(BTN_OK);
+  TEST_ASSERT_NOT_EQUAL(8, settings.alarms[0].hour);
+  pass_ms(MENU_DONE_MS);
+  press(BTN_CANCEL);
+  press(BTN_CANCEL);
+  TEST_ASSERT_FALSE(menu_active());
+}
+
+int main() {
+  hal_linux_virtual_time(true);
+  hal_linux_set_time(TEST_START_TIME);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_daily_alarm_rings_every_day);
+  RUN_TEST(test_both_alarms_ring_on_consecutive_days);
+  RUN_TEST(test_inactive_alarm_stays_quiet);
+  RUN_TEST(test_held_button_redraws_at_most_ten_times_a_second);
+  return UNITY_END();
+}
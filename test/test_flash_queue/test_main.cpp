@@ -0,0 +1,291 @@
+/*
+ * Medibox - host tests for the telemetry flash queue (flash_queue.h)
+ *
+ * The queue runs over a FlashStorage in RAM that behaves like NOR flash:
+ * an erase sets a whole sector to 0xFF and programming can only clear
+ * bits. A reboot is a second flash_queue_begin() over the same memory.
+ *
+ *   pio test -e native -f test_flash_queue
+ */
+
+#include <string.h>
+#include <unity.h>
+
+#include "flash_queue.h"
+
+#define PARTITION_SIZE 0x40000       // telemq in partitions.csv
+#define SMALL_SIZE (4 * FLASH_QUEUE_SECTOR)
+#define WEEK_RECORDS (7 * 24 * 60)   // A sensor window a minute
+#define BATCH 32                     // Records per uplink publish
+#define START_TIME 1760000000
+
+struct RamFlash {
+  uint8_t mem[PARTITION_SIZE];
+  uint32_t acked;
+  uint32_t erases;
+};
+
+static RamFlash flash;
+static FlashStorage storage;
+
+static bool ram_read(void* ctx, size_t offset, void* dst, size_t len) {
+  if (offset + len > storage.size) return false;
+  memcpy(dst, flash.mem + offset, len);
+  return true;
+}
+
+static bool ram_write(void* ctx, size_t offset, const void* src, size_t len) {
+  if (offset + len > storage.size) return false;
+  const uint8_t* in = (const uint8_t*)src;
+  for (size_t i = 0; i < len; i++) flash.mem[offset + i] &= in[i];
+  return true;
+}
+
+static bool ram_erase(void* ctx, size_t offset) {
+  TEST_ASSERT_EQUAL(0, offset % FLASH_QUEUE_SECTOR);
+  memset(flash.mem + offset, 0xFF, FLASH_QUEUE_SECTOR);
+  flash.erases++;
+  return true;
+}
+
+static uint32_t ram_load_acked(void* ctx) {
+  return flash.acked;
+}
+
+static void ram_store_acked(void* ctx, uint32_t seq) {
+  flash.acked = seq;
+}
+
+// A blank part of the given size, with nothing acknowledged
+static void blank_flash(size_t size) {
+  memset(flash.mem, 0xFF, sizeof(flash.mem));
+  flash.acked = 0;
+  flash.erases = 0;
+  storage.ctx = &flash;
+  storage.size = size;
+  storage.read = ram_read;
+  storage.write = ram_write;
+  storage.erase_sector = ram_erase;
+  storage.load_acked = ram_load_acked;
+  storage.store_acked = ram_store_acked;
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+}
+
+static TelemetryRecord record(uint32_t i) {
+  TelemetryRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.timestamp = START_TIME + i * 60;
+  rec.type = TELEMETRY_SENSOR;
+  rec.sensor.samples = 12;
+  rec.sensor.tempMean = (int16_t)(2000 + i % 500);
+  rec.sensor.humMean = (int16_t)(6000 - i % 700);
+  return rec;
+}
+
+static void push(uint32_t from, uint32_t count) {
+  for (uint32_t i = from; i < from + count; i++) flash_queue_push(record(i));
+}
+
+// Reads and acknowledges batches like the uplink until the queue is empty,
+// checking the records come back in order from first; returns how many
+static uint32_t drain(uint32_t first) {
+  TelemetryRecord batch[BATCH];
+  uint32_t next = first;
+  for (;;) {
+    size_t n = flash_queue_read(batch, BATCH);
+    if (n == 0) break;
+    for (size_t i = 0; i < n; i++, next++) {
+      TelemetryRecord want = record(next);
+      TEST_ASSERT_EQUAL_UINT32(want.timestamp, batch[i].timestamp);
+      TEST_ASSERT_EQUAL_MEMORY(&want, &batch[i], sizeof(want));
+    }
+    flash_queue_ack(n);
+  }
+  return next - first;
+}
+
+static FlashQueueStats stats() {
+  FlashQueueStats s;
+  flash_queue_stats(&s);
+  return s;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_rejects_storage_smaller_than_two_sectors() {
+  blank_flash(SMALL_SIZE);
+  storage.size = FLASH_QUEUE_SECTOR;
+  TEST_ASSERT_FALSE(flash_queue_begin(&storage));
+  TEST_ASSERT_FALSE(flash_queue_begin(NULL));
+}
+
+static void test_week_offline_then_catch_up() {
+  blank_flash(PARTITION_SIZE);
+  FlashQueueStats before = stats();
+  push(0, WEEK_RECORDS);
+
+  FlashQueueStats s = stats();
+  TEST_ASSERT_EQUAL_UINT32(WEEK_RECORDS, s.pending);
+  TEST_ASSERT_EQUAL_UINT32(WEEK_RECORDS, s.unread);
+  TEST_ASSERT_EQUAL_UINT32(before.dropped, s.dropped);
+  TEST_ASSERT_EQUAL_UINT32(WEEK_RECORDS / FLASH_QUEUE_PER_PAGE, s.pagesWritten - before.pagesWritten);
+
+  TEST_ASSERT_EQUAL_UINT32(WEEK_RECORDS, drain(0));
+  s = stats();
+  TEST_ASSERT_EQUAL_UINT32(0, s.pending);
+  TEST_ASSERT_EQUAL_UINT32(0, s.unread);
+
+  // Records pushed after the catch-up follow on
+  push(WEEK_RECORDS, 5);
+  TEST_ASSERT_EQUAL_UINT32(5, drain(WEEK_RECORDS));
+}
+
+static void test_week_offline_survives_a_reboot() {
+  blank_flash(PARTITION_SIZE);
+  push(0, WEEK_RECORDS);
+
+  // The page still in RAM is lost, every programmed page comes back
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+  uint32_t kept = WEEK_RECORDS / FLASH_QUEUE_PER_PAGE * FLASH_QUEUE_PER_PAGE;
+  TEST_ASSERT_EQUAL_UINT32(kept, stats().pending);
+  TEST_ASSERT_EQUAL_UINT32(kept, drain(0));
+}
+
+static void test_reboot_resends_what_was_not_acknowledged() {
+  blank_flash(SMALL_SIZE);
+  push(0, 10 * FLASH_QUEUE_PER_PAGE);
+
+  // Three and a half pages confirmed, more handed out but not confirmed
+  TelemetryRecord batch[80];
+  TEST_ASSERT_EQUAL(80, flash_queue_read(batch, 80));
+  flash_queue_ack(3 * FLASH_QUEUE_PER_PAGE + FLASH_QUEUE_PER_PAGE / 2);
+  TEST_ASSERT_EQUAL_UINT32(10 * FLASH_QUEUE_PER_PAGE - 42, stats().pending);
+
+  // At least once: the half-acknowledged page is sent again whole
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+  TEST_ASSERT_EQUAL_UINT32(7 * FLASH_QUEUE_PER_PAGE, stats().pending);
+  TEST_ASSERT_EQUAL_UINT32(7 * FLASH_QUEUE_PER_PAGE, drain(3 * FLASH_QUEUE_PER_PAGE));
+
+  // Once everything is confirmed a reboot sends nothing
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+  TEST_ASSERT_EQUAL_UINT32(0, stats().pending);
+  TEST_ASSERT_EQUAL_UINT32(0, drain(0));
+}
+
+static void test_ack_truncates_page_by_page() {
+  blank_flash(SMALL_SIZE);
+  uint32_t ackedBefore = flash.acked;
+  push(0, 3 * FLASH_QUEUE_PER_PAGE + 5);
+
+  TelemetryRecord batch[BATCH];
+  TEST_ASSERT_EQUAL(BATCH, flash_queue_read(batch, BATCH));
+  flash_queue_ack(FLASH_QUEUE_PER_PAGE - 1);
+  TEST_ASSERT_EQUAL_UINT32(ackedBefore, flash.acked);    // Not a whole page yet
+  flash_queue_ack(1);
+  TEST_ASSERT_EQUAL_UINT32(ackedBefore + 1, flash.acked);
+  flash_queue_ack(BATCH - FLASH_QUEUE_PER_PAGE);
+  TEST_ASSERT_EQUAL_UINT32(ackedBefore + 2, flash.acked);
+
+  FlashQueueStats s = stats();
+  TEST_ASSERT_EQUAL_UINT32(3 * FLASH_QUEUE_PER_PAGE + 5 - BATCH, s.pending);
+  TEST_ASSERT_EQUAL_UINT32(3 * FLASH_QUEUE_PER_PAGE + 5 - BATCH, s.unread);
+  // The records still in the RAM page are read and acknowledged too
+  TEST_ASSERT_EQUAL_UINT32(s.unread, drain(BATCH));
+  TEST_ASSERT_EQUAL_UINT32(0, stats().pending);
+}
+
+static void test_wrap_drops_the_oldest_sector() {
+  blank_flash(SMALL_SIZE);
+  uint32_t pages = SMALL_SIZE / FLASH_QUEUE_PAGE;
+  uint32_t perSector = FLASH_QUEUE_SECTOR / FLASH_QUEUE_PAGE;
+  FlashQueueStats before = stats();
+
+  // Never acknowledged: the page that wraps to slot 0 reclaims the first
+  // sector. Page sequences start at 1, so it held pages 1 .. perSector - 1.
+  push(0, pages * FLASH_QUEUE_PER_PAGE);
+  uint32_t lost = (perSector - 1) * FLASH_QUEUE_PER_PAGE;
+  FlashQueueStats s = stats();
+  TEST_ASSERT_EQUAL_UINT32(lost, s.dropped - before.dropped);
+  TEST_ASSERT_EQUAL_UINT32(pages * FLASH_QUEUE_PER_PAGE - lost, s.pending);
+  TEST_ASSERT_EQUAL_UINT32(perSector - 1, flash.acked);
+
+  // A reboot agrees, then everything left comes out in order
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+  TEST_ASSERT_EQUAL_UINT32(pages * FLASH_QUEUE_PER_PAGE - lost, stats().pending);
+  TEST_ASSERT_EQUAL_UINT32(pages * FLASH_QUEUE_PER_PAGE - lost, drain(lost));
+}
+
+static void test_wrap_while_keeping_up_drops_nothing() {
+  blank_flash(SMALL_SIZE);
+  uint32_t pages = SMALL_SIZE / FLASH_QUEUE_PAGE;
+  FlashQueueStats before = stats();
+  uint32_t next = 0;
+  for (int round = 0; round < 3; round++) {
+    push(next, pages * FLASH_QUEUE_PER_PAGE / 2);
+    next += drain(next);
+  }
+  FlashQueueStats s = stats();
+  TEST_ASSERT_EQUAL_UINT32(3 * pages * FLASH_QUEUE_PER_PAGE / 2, next);
+  TEST_ASSERT_EQUAL_UINT32(before.dropped, s.dropped);
+  TEST_ASSERT_EQUAL_UINT32(flash.erases, s.sectorsErased - before.sectorsErased);
+  TEST_ASSERT_GREATER_THAN(SMALL_SIZE / FLASH_QUEUE_SECTOR, flash.erases);
+}
+
+static void test_reboot_skips_a_dirty_head_sector() {
+  blank_flash(SMALL_SIZE);
+  push(0, 2 * FLASH_QUEUE_PER_PAGE);
+
+  // A page after the head holds a stray header, e.g. from a write cut off
+  // by a reset; programming over it would corrupt the next page
+  uint32_t stray = 0x00ABCDEF;
+  ram_write(&flash, 5 * FLASH_QUEUE_PAGE, &stray, sizeof(stray));
+  uint32_t erases = flash.erases;
+  FlashQueueStats before = stats();
+  TEST_ASSERT_TRUE(flash_queue_begin(&storage));
+  TEST_ASSERT_EQUAL_UINT32(2 * FLASH_QUEUE_PER_PAGE, stats().pending);
+
+  // The next page goes to the following sector, which is erased first
+  push(2 * FLASH_QUEUE_PER_PAGE, FLASH_QUEUE_PER_PAGE);
+  TEST_ASSERT_EQUAL_UINT32(erases + 1, flash.erases);
+  TEST_ASSERT_EQUAL_UINT32(3 * FLASH_QUEUE_PER_PAGE, drain(0));
+  // The skipped slots held nothing, so nothing was lost
+  TEST_ASSERT_EQUAL_UINT32(before.dropped, stats().dropped);
+}
+
+static void test_corrupt_page_is_skipped_and_counted() {
+  blank_flash(SMALL_SIZE);
+  push(0, 3 * FLASH_QUEUE_PER_PAGE);
+  FlashQueueStats before = stats();
+
+  // Clear a bit in the second page's records (page sequence 2, slot 2)
+  uint8_t zero = 0;
+  ram_write(&flash, 2 * FLASH_QUEUE_PAGE + 20, &zero, 1);
+
+  TelemetryRecord batch[3 * FLASH_QUEUE_PER_PAGE];
+  TEST_ASSERT_EQUAL(2 * FLASH_QUEUE_PER_PAGE, flash_queue_read(batch, 3 * FLASH_QUEUE_PER_PAGE));
+  TEST_ASSERT_EQUAL_UINT32(record(0).timestamp, batch[0].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(record(2 * FLASH_QUEUE_PER_PAGE).timestamp,
+                           batch[FLASH_QUEUE_PER_PAGE].timestamp);
+  TEST_ASSERT_EQUAL_UINT32(FLASH_QUEUE_PER_PAGE, stats().dropped - before.dropped);
+
+  // Acknowledging what was read empties the queue despite the gap
+  flash_queue_ack(2 * FLASH_QUEUE_PER_PAGE);
+  TEST_ASSERT_EQUAL_UINT32(0, stats().pending);
+  TEST_ASSERT_EQUAL_UINT32(3, flash.acked);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rejects_storage_smaller_than_two_sectors);
+  RUN_TEST(test_week_offline_then_catch_up);
+  RUN_TEST(test_week_offline_survives_a_reboot);
+  RUN_TEST(test_reboot_resends_what_was_not_acknowledged);
+  RUN_TEST(test_ack_truncates_page_by_page);
+  RUN_TEST(test_wrap_drops_the_oldest_sector);
+  RUN_TEST(test_wrap_while_keeping_up_drops_nothing);
+  RUN_TEST(test_reboot_skips_a_dirty_head_sector);
+  RUN_TEST(test_corrupt_page_is_skipped_and_counted);
+  return UNITY_END();
+}
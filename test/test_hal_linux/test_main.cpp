@@ -0,0 +1,139 @@
+/*
+ * Medibox - host tests for the Linux side of the HAL (hal_linux.h)
+ *
+ *   pio test -e native -f test_hal_linux
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "hal_linux.h"
+
+#define TEST_PIN 40
+#define TEST_START_TIME 1760000000    // 2025-10-09 08:53:20 UTC
+
+static int falls = 0;
+static void* fallArg = NULL;
+
+static void on_fall(void* arg) {
+  falls++;
+  fallArg = arg;
+}
+
+void setUp() {
+  hal_linux_virtual_time(true);
+  falls = 0;
+  fallArg = NULL;
+}
+
+void tearDown() {
+  hal_pin_on_falling(TEST_PIN, NULL, NULL);
+  hal_linux_set_pin(TEST_PIN, true);
+}
+
+static void test_virtual_time_moves_only_when_told() {
+  TEST_ASSERT_EQUAL_UINT32(0, hal_millis());
+  hal_linux_advance_us(1500);
+  TEST_ASSERT_EQUAL_UINT32(1500, hal_micros());
+  TEST_ASSERT_EQUAL_UINT32(1, hal_millis());
+  hal_delay(4000);
+  TEST_ASSERT_EQUAL_UINT32(4001, hal_millis());
+  TEST_ASSERT_EQUAL_UINT32(4001500, hal_micros());
+}
+
+static void test_wall_clock_follows_virtual_time() {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  hal_linux_set_time(TEST_START_TIME);
+  struct tm t;
+  TEST_ASSERT_TRUE(hal_local_time(&t));
+  TEST_ASSERT_EQUAL(8, t.tm_hour);
+  TEST_ASSERT_EQUAL(53, t.tm_min);
+  TEST_ASSERT_EQUAL(20, t.tm_sec);
+
+  hal_delay(40 * 1000);
+  TEST_ASSERT_TRUE(hal_local_time(&t));
+  TEST_ASSERT_EQUAL(54, t.tm_min);
+  TEST_ASSERT_EQUAL(0, t.tm_sec);
+
+  // Before NTP
+  hal_linux_set_time(0);
+  TEST_ASSERT_FALSE(hal_local_time(&t));
+}
+
+static void test_falling_edge_runs_the_handler() {
+  int arg;
+  hal_pin_mode(TEST_PIN, HAL_INPUT_PULLUP);
+  hal_pin_on_falling(TEST_PIN, on_fall, &arg);
+  TEST_ASSERT_TRUE(hal_pin_read(TEST_PIN));
+
+  hal_linux_set_pin(TEST_PIN, false);
+  TEST_ASSERT_EQUAL(1, falls);
+  TEST_ASSERT_TRUE(fallArg == &arg);
+  TEST_ASSERT_FALSE(hal_pin_read(TEST_PIN));
+
+  // Staying low or rising is not an edge
+  hal_linux_set_pin(TEST_PIN, false);
+  hal_linux_set_pin(TEST_PIN, true);
+  TEST_ASSERT_EQUAL(1, falls);
+  hal_linux_set_pin(TEST_PIN, false);
+  TEST_ASSERT_EQUAL(2, falls);
+}
+
+static void test_outputs_read_back() {
+  hal_pin_mode(TEST_PIN + 1, HAL_OUTPUT);
+  hal_pin_write(TEST_PIN + 1, true);
+  TEST_ASSERT_TRUE(hal_linux_pin(TEST_PIN + 1));
+  hal_pin_write(TEST_PIN + 1, false);
+  TEST_ASSERT_FALSE(hal_linux_pin(TEST_PIN + 1));
+  // Out of range pins read low and ignore writes
+  hal_pin_write(HAL_LINUX_PINS, true);
+  TEST_ASSERT_FALSE(hal_linux_pin(HAL_LINUX_PINS));
+}
+
+static void test_sensor_and_failed_reads() {
+  float t, h;
+  hal_linux_set_sensor(21.5f, 40.0f);
+  TEST_ASSERT_TRUE(hal_sensor_read(&t, &h));
+  TEST_ASSERT_EQUAL_FLOAT(21.5f, t);
+  TEST_ASSERT_EQUAL_FLOAT(40.0f, h);
+  hal_linux_set_sensor(NAN, 40.0f);
+  TEST_ASSERT_FALSE(hal_sensor_read(&t, &h));
+}
+
+static HalNetworkEvent lastEvent;
+static int networkEvents = 0;
+
+static void on_network(HalNetworkEvent event) {
+  lastEvent = event;
+  networkEvents++;
+}
+
+static void test_network_connects_at_once_unless_told_not_to() {
+  hal_network_begin(on_network);
+  hal_network_connect("ward-3", "secret");
+  TEST_ASSERT_EQUAL(1, networkEvents);
+  TEST_ASSERT_EQUAL(HAL_NETWORK_GOT_IP, lastEvent);
+  TEST_ASSERT_EQUAL_STRING("ward-3", hal_linux_network_ssid());
+
+  hal_linux_network_autoconnect(false);
+  hal_network_disconnect();
+  hal_network_connect("ward-4", "");
+  TEST_ASSERT_EQUAL(1, networkEvents);
+  hal_linux_network_event(HAL_NETWORK_DROPPED);
+  TEST_ASSERT_EQUAL(HAL_NETWORK_DROPPED, lastEvent);
+  hal_linux_network_autoconnect(true);
+  hal_network_begin(NULL);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_virtual_time_moves_only_when_told);
+  RUN_TEST(test_wall_clock_follows_virtual_time);
+  RUN_TEST(test_falling_edge_runs_the_handler);
+  RUN_TEST(test_outputs_read_back);
+  RUN_TEST(test_sensor_and_failed_reads);
+  RUN_TEST(test_network_connects_at_once_unless_told_not_to);
+  return UNITY_END();
+}
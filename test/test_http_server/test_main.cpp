@@ -0,0 +1,148 @@
+/*
+ * Medibox - host tests for the HTTP parser
+ *
+ * The server runs on its own thread as on the device, on a loopback port;
+ * each test talks to it over a real socket.
+ *
+ *   pio test -e native -f test_http_server
+ */
+
+#include <lwip/sockets.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "http_server.h"
+
+#define TEST_PORT 18080
+
+static char lastPath[HTTP_MAX_PATH];
+static char lastIfNoneMatch[48];
+static HttpMethod lastMethod;
+
+static void handle(HttpRequest& req, HttpResponse& res) {
+  lastMethod = req.method;
+  strcpy(lastPath, req.path);
+  strcpy(lastIfNoneMatch, req.ifNoneMatch);
+  res.send_status(204);
+}
+
+static int connect_server() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct timeval tv = {2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(TEST_PORT);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST_ASSERT_EQUAL(0, connect(fd, (struct sockaddr*)&addr, sizeof(addr)));
+  return fd;
+}
+
+// Sends request and reads one response head into out; false if the
+// server closed the connection first
+static bool exchange(int fd, const char* request, char* out, size_t cap) {
+  send(fd, request, strlen(request), 0);
+  size_t len = 0;
+  out[0] = '\0';
+  while (strstr(out, "\r\n\r\n") == NULL && len + 1 < cap) {
+    int n = recv(fd, out + len, 1, 0);
+    if (n <= 0) return false;
+    out[++len] = '\0';
+  }
+  return true;
+}
+
+// True once the server has closed the connection
+static bool closed(int fd) {
+  char ch;
+  return recv(fd, &ch, 1, 0) == 0;
+}
+
+void setUp() {
+  lastPath[0] = '\0';
+  lastIfNoneMatch[0] = '\0';
+  lastMethod = HTTP_UNKNOWN;
+}
+
+void tearDown() {}
+
+static void test_request_is_routed() {
+  int fd = connect_server();
+  char res[256];
+  TEST_ASSERT_TRUE(exchange(fd, "GET /api/alarms?x=1 HTTP/1.1\r\nHost: medibox\r\n\r\n", res,
+                            sizeof(res)));
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 204", res, 12);
+  TEST_ASSERT_EQUAL(HTTP_GET, lastMethod);
+  TEST_ASSERT_EQUAL_STRING("/api/alarms", lastPath);
+  close(fd);
+}
+
+// A stock Chrome navigation: its Accept and User-Agent lines are longer
+// than HTTP_MAX_LINE
+static void test_long_header_lines_are_skipped() {
+  char accept[256], request[1024], res[256];
+  memset(accept, 'a', 200);
+  accept[200] = '\0';
+  snprintf(request, sizeof(request),
+           "GET / HTTP/1.1\r\nHost: medibox\r\n"
+           "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 "
+           "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+           "Accept: %s\r\nIf-None-Match: \"v1\"\r\n\r\n",
+           accept);
+  int fd = connect_server();
+  TEST_ASSERT_TRUE(exchange(fd, request, res, sizeof(res)));
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 204", res, 12);
+  TEST_ASSERT_EQUAL_STRING("/", lastPath);
+  // The header after the skipped one is still parsed
+  TEST_ASSERT_EQUAL_STRING("\"v1\"", lastIfNoneMatch);
+
+  // and the connection is still good for the next request
+  TEST_ASSERT_TRUE(exchange(fd, "DELETE /api/alarms/1 HTTP/1.1\r\n\r\n", res, sizeof(res)));
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 204", res, 12);
+  TEST_ASSERT_EQUAL(HTTP_DELETE, lastMethod);
+  close(fd);
+}
+
+static void test_long_request_line_is_rejected() {
+  char path[200], request[256], res[256];
+  memset(path, 'p', sizeof(path) - 1);
+  path[sizeof(path) - 1] = '\0';
+  snprintf(request, sizeof(request), "GET /%s HTTP/1.1\r\n\r\n", path);
+  HttpStats before, after;
+  http_server_stats(&before);
+
+  int fd = connect_server();
+  TEST_ASSERT_TRUE(exchange(fd, request, res, sizeof(res)));
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 400", res, 12);
+  TEST_ASSERT_TRUE(closed(fd));
+  TEST_ASSERT_EQUAL_STRING("", lastPath);
+  http_server_stats(&after);
+  TEST_ASSERT_EQUAL_UINT32(before.errors + 1, after.errors);
+  close(fd);
+}
+
+// The example handshake from RFC 6455
+static void test_websocket_upgrade() {
+  int fd = connect_server();
+  char res[256];
+  TEST_ASSERT_TRUE(exchange(fd,
+                            "GET " HTTP_WS_PATH " HTTP/1.1\r\nUpgrade: websocket\r\n"
+                            "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                            "Sec-WebSocket-Version: 13\r\n\r\n",
+                            res, sizeof(res)));
+  TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 101", res, 12);
+  TEST_ASSERT_NOT_NULL(strstr(res, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"));
+  close(fd);
+}
+
+int main() {
+  http_server_begin(TEST_PORT, handle);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_request_is_routed);
+  RUN_TEST(test_long_header_lines_are_skipped);
+  RUN_TEST(test_long_request_line_is_rejected);
+  RUN_TEST(test_websocket_upgrade);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/*
+ * Medibox - host tests for input_poll() and its devices
+ *
+ * Two scripted devices (input_script.h) sit around the buttons, in that
+ * order, so the tests can tell which device an event came from. Bursts
+ * are sent the way the encoder sends a fast turn: one event with a count.
+ *
+ *   pio test -e native -f test_input
+ */
+
+#include <Adafruit_SSD1306.h>
+#include <Wire.h>
+#include <unity.h>
+
+#include "board.h"
+#include "buttons.h"
+#include "hal_linux.h"
+#include "input.h"
+#include "input_macro.h"
+#include "input_script.h"
+#include "menu.h"
+#include "settings.h"
+
+#define TICK_MS 10
+
+static InputScript first;
+static InputScript last;
+static Adafruit_SSD1306 panel(128, 64, &Wire, -1);
+static uint32_t frames = 0;
+
+static void count_flush() {
+  frames++;
+}
+
+// What loop() does with the menus open, until both scripts have run out
+static void run_menu() {
+  while (input_script_pending(&first) > 0 || input_script_pending(&last) > 0) {
+    hal_linux_advance_us(TICK_MS * 1000);
+    menu_handle(input_poll());
+  }
+}
+
+void setUp() {
+  input_script_clear(&first);
+  input_script_clear(&last);
+  frames = 0;
+}
+
+void tearDown() {
+  static const ButtonEvent cancel = {CANCEL_BTN, 1, false, 0};
+  for (int i = 0; i < MENU_DEPTH + 1 && menu_active(); i++) menu_handle(cancel);
+}
+
+static void test_nothing_queued_polls_none() {
+  ButtonEvent ev = input_poll();
+  TEST_ASSERT_EQUAL(NONE, ev.button);
+  TEST_ASSERT_EQUAL(0, ev.count);
+}
+
+static void test_devices_are_polled_in_order() {
+  input_script_press(&last, OK_BTN);
+  input_script_press(&first, UP);
+  hal_linux_advance_us(1000);
+  ButtonEvent ev = input_poll();
+  TEST_ASSERT_EQUAL(UP, ev.button);
+  TEST_ASSERT_EQUAL_UINT32(hal_micros(), ev.atUs);
+  // The later device kept its event
+  TEST_ASSERT_EQUAL(OK_BTN, input_poll().button);
+  TEST_ASSERT_EQUAL(NONE, input_poll().button);
+}
+
+static void test_idle_device_lets_the_next_one_through() {
+  input_script_idle(&first, 1);
+  input_script_press(&first, DOWN);
+  input_script_press(&last, OK_BTN);
+  TEST_ASSERT_EQUAL(OK_BTN, input_poll().button);
+  TEST_ASSERT_EQUAL(DOWN, input_poll().button);
+  TEST_ASSERT_EQUAL(NONE, input_poll().button);
+}
+
+static void test_buttons_sit_between_the_scripts() {
+  input_script_press(&last, OK_BTN);
+  hal_linux_set_pin(BTN_DOWN, false);
+  hal_linux_advance_us((BUTTON_DEBOUNCE_MS + TICK_MS) * 1000);
+  TEST_ASSERT_EQUAL(DOWN, input_poll().button);
+  TEST_ASSERT_EQUAL(OK_BTN, input_poll().button);
+  hal_linux_set_pin(BTN_DOWN, true);
+  hal_linux_advance_us((BUTTON_DEBOUNCE_MS + TICK_MS) * 1000);
+  TEST_ASSERT_EQUAL(NONE, input_poll().button);
+}
+
+static void test_bursts_keep_their_count() {
+  input_script_burst(&first, DOWN, 7);
+  input_script_burst(&last, UP, 200);
+  ButtonEvent ev = input_poll();
+  TEST_ASSERT_EQUAL(DOWN, ev.button);
+  TEST_ASSERT_EQUAL(7, ev.count);
+  TEST_ASSERT_TRUE(ev.repeat);
+  ev = input_poll();
+  TEST_ASSERT_EQUAL(UP, ev.button);
+  TEST_ASSERT_EQUAL(200, ev.count);
+}
+
+static void test_full_queue_refuses_events() {
+  for (int i = 0; i < INPUT_SCRIPT_MAX; i++) TEST_ASSERT_TRUE(input_script_press(&first, UP));
+  TEST_ASSERT_FALSE(input_script_press(&first, DOWN));
+  TEST_ASSERT_FALSE(input_script_idle(&first, 1));
+  TEST_ASSERT_EQUAL(INPUT_SCRIPT_MAX, input_script_pending(&first));
+}
+
+static void test_macro_records_bursts_with_their_count() {
+  TEST_ASSERT_TRUE(macro_record());
+  input_script_press(&first, OK_BTN);
+  input_script_burst(&first, UP, 12);
+  while (input_script_pending(&first) > 0) {
+    hal_linux_advance_us(TICK_MS * 1000);
+    input_poll();
+  }
+  TEST_ASSERT_TRUE(macro_stop());
+  TEST_ASSERT_EQUAL(2, macro_step_count());
+  MacroStep step;
+  MacroResult result;
+  TEST_ASSERT_TRUE(macro_step(1, &step, &result));
+  TEST_ASSERT_EQUAL(UP, step.event.button);
+  TEST_ASSERT_EQUAL(12, step.event.count);
+  TEST_ASSERT_TRUE(step.event.repeat);
+  TEST_ASSERT_EQUAL_UINT32(TICK_MS, step.atMs);
+  macro_clear();
+}
+
+// Encoder turns in the alarm editor: each burst is applied whole, with
+// wrap-around, and costs at most one frame
+static void test_encoder_bursts_set_an_alarm() {
+  settings_lock();
+  settings.alarms[0] = {true, 8, 0};
+  settings_commit_alarms(1);
+  settings_unlock();
+
+  menu_open(&mainMenu);
+  input_script_press(&first, DOWN);
+  input_script_press(&first, OK_BTN);
+  input_script_burst(&first, UP, 5);
+  input_script_burst(&first, UP, 20);     // 13 + 20 wraps to 9
+  input_script_idle(&first, 20);
+  input_script_press(&first, OK_BTN);
+  input_script_burst(&first, DOWN, 75);   // 0 - 75 wraps to 45
+  input_script_idle(&first, 20);
+  run_menu();
+  TEST_ASSERT_EQUAL(SCREEN_EDIT, menu_screen_kind());
+  TEST_ASSERT_LESS_OR_EQUAL(7, frames);
+
+  input_script_press(&first, OK_BTN);
+  run_menu();
+  TEST_ASSERT_TRUE(settings.alarms[0].active);
+  TEST_ASSERT_EQUAL(9, settings.alarms[0].hour);
+  TEST_ASSERT_EQUAL(45, settings.alarms[0].minute);
+}
+
+int main() {
+  hal_linux_virtual_time(true);
+  settings_begin();
+  macro_begin();
+  panel.begin(SSD1306_SWITCHCAPVCC, 0x3C);
+  menu_begin(&panel, count_flush);
+  buttons_begin(BTN_UP, BTN_OK, BTN_DOWN, BTN_CANCEL);
+  input_add_device(input_script_begin(&first, "first"));
+  input_add_device(buttons_device());
+  input_add_device(input_script_begin(&last, "last"));
+
+  UNITY_BEGIN();
+  RUN_TEST(test_nothing_queued_polls_none);
+  RUN_TEST(test_devices_are_polled_in_order);
+  RUN_TEST(test_idle_device_lets_the_next_one_through);
+  RUN_TEST(test_buttons_sit_between_the_scripts);
+  RUN_TEST(test_bursts_keep_their_count);
+  RUN_TEST(test_full_queue_refuses_events);
+  RUN_TEST(test_macro_records_bursts_with_their_count);
+  RUN_TEST(test_encoder_bursts_set_an_alarm);
+  return UNITY_END();
+}
@@ -0,0 +1,195 @@
+/*
+ * Medibox - host tests for the streaming LTTB downsampler
+ *
+ * The output must always keep the first and last point, never exceed the
+ * requested number of points and stay in strictly increasing time order,
+ * whatever the input leaves empty or crowds into one bucket.
+ *
+ *   pio test -e native -f test_lttb
+ */
+
+#include <unity.h>
+
+#include "lttb.h"
+
+#define MAX_OUT 4096
+
+struct Output {
+  LttbPoint p[MAX_OUT];
+  uint32_t count;
+  uint32_t stopAfter;   // Emit returns false from this point on, 0 never
+};
+
+static Output out;
+
+static bool record(void* ctx, const LttbPoint& p) {
+  Output* o = (Output*)ctx;
+  TEST_ASSERT_TRUE_MESSAGE(o->count < MAX_OUT, "too many points");
+  o->p[o->count++] = p;
+  return o->stopAfter == 0 || o->count < o->stopAfter;
+}
+
+static uint32_t seed = 1;
+
+static uint32_t next_random() {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+void setUp() {
+  out.count = 0;
+  out.stopAfter = 0;
+}
+
+void tearDown() {}
+
+static void assert_shape(uint32_t firstT, uint32_t lastT, uint32_t points) {
+  TEST_ASSERT_TRUE(out.count >= 1);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(points, out.count);
+  TEST_ASSERT_EQUAL_UINT32(firstT, out.p[0].t);
+  TEST_ASSERT_EQUAL_UINT32(lastT, out.p[out.count - 1].t);
+  for (uint32_t i = 1; i < out.count; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(out.p[i].t > out.p[i - 1].t, "timestamps not increasing");
+  }
+}
+
+static bool has_value(int32_t y) {
+  for (uint32_t i = 0; i < out.count; i++) {
+    if (out.p[i].y == y) return true;
+  }
+  return false;
+}
+
+static void test_single_point_is_emitted_once() {
+  LttbStream lttb;
+  lttb.begin(100, 200, 10, record, &out);
+  TEST_ASSERT_TRUE(lttb.add(150, 7));
+  TEST_ASSERT_TRUE(lttb.finish());
+  TEST_ASSERT_EQUAL_UINT32(1, out.count);
+  TEST_ASSERT_EQUAL_UINT32(1, lttb.emitted());
+  TEST_ASSERT_EQUAL_UINT32(150, out.p[0].t);
+  TEST_ASSERT_EQUAL(7, out.p[0].y);
+}
+
+static void test_nothing_in_range_emits_nothing() {
+  LttbStream lttb;
+  lttb.begin(100, 200, 10, record, &out);
+  TEST_ASSERT_TRUE(lttb.finish());
+  TEST_ASSERT_EQUAL_UINT32(0, out.count);
+}
+
+static void test_fewer_points_than_asked_are_kept_as_they_are() {
+  LttbStream lttb;
+  lttb.begin(0, 999, 100, record, &out);
+  for (uint32_t t = 0; t < 1000; t += 200) lttb.add(t, (int32_t)t);
+  TEST_ASSERT_TRUE(lttb.finish());
+  TEST_ASSERT_EQUAL_UINT32(5, out.count);
+  assert_shape(0, 800, 100);
+}
+
+// Random walks with random gaps, over ranges from narrower than the
+// bucket count to much wider
+static void test_random_series_keep_their_shape() {
+  static const uint32_t pointCounts[] = {1, 3, 4, 10, 100, 300};
+  static const uint32_t spans[] = {5, 50, 1000, 86400};
+  for (uint32_t points : pointCounts) {
+    for (uint32_t span : spans) {
+      for (int round = 0; round < 20; round++) {
+        uint32_t from = 1760000000 + next_random() % 1000;
+        uint32_t to = from + span - 1;
+        LttbStream lttb;
+        out.count = 0;
+        lttb.begin(from, to, points, record, &out);
+
+        uint32_t t = from + next_random() % 3, firstT = 0, lastT = 0, n = 0;
+        int32_t y = 0;
+        while (t <= to && n < 3000) {
+          if (n == 0) firstT = t;
+          lastT = t;
+          TEST_ASSERT_TRUE(lttb.add(t, y));
+          n++;
+          y += (int32_t)(next_random() % 21) - 10;
+          // Mostly dense, sometimes a gap of several buckets
+          t += next_random() % 8 == 0 ? 1 + next_random() % (span / 4 + 1) : 1 + span / 2000;
+        }
+        TEST_ASSERT_TRUE(lttb.finish());
+        assert_shape(firstT, lastT, points < LTTB_MIN_POINTS ? LTTB_MIN_POINTS : points);
+        TEST_ASSERT_EQUAL_UINT32(out.count, lttb.emitted());
+      }
+    }
+  }
+}
+
+// A one-sample spike in a flat day survives a 100x reduction, either way
+static void test_spikes_survive() {
+  LttbStream lttb;
+  lttb.begin(0, 86399, 100, record, &out);
+  for (uint32_t t = 0; t < 86400; t += 10) {
+    int32_t y = t == 30010 ? 5000 : t == 61230 ? -4000 : 2500;
+    lttb.add(t, y);
+  }
+  TEST_ASSERT_TRUE(lttb.finish());
+  assert_shape(0, 86390, 100);
+  TEST_ASSERT_TRUE(has_value(5000));
+  TEST_ASSERT_TRUE(has_value(-4000));
+}
+
+// With points == 3 there is one bucket, and its point is the spike
+static void test_three_points_pick_the_extreme() {
+  LttbStream lttb;
+  lttb.begin(0, 99, 3, record, &out);
+  for (uint32_t t = 0; t < 100; t++) lttb.add(t, t == 42 ? 90 : 10);
+  TEST_ASSERT_TRUE(lttb.finish());
+  TEST_ASSERT_EQUAL_UINT32(3, out.count);
+  TEST_ASSERT_EQUAL_UINT32(42, out.p[1].t);
+  assert_shape(0, 99, 3);
+}
+
+// The last point starts a bucket of its own: finish() closes the
+// pending bucket against it and emits it once
+static void test_last_point_alone_in_its_bucket() {
+  LttbStream lttb;
+  lttb.begin(0, 999, 12, record, &out);   // 10 buckets of 100
+  for (uint32_t t = 0; t < 900; t += 10) lttb.add(t, (int32_t)(t % 70));
+  lttb.add(950, 1);
+  TEST_ASSERT_TRUE(lttb.finish());
+  assert_shape(0, 950, 12);
+  TEST_ASSERT_TRUE(out.p[out.count - 2].t >= 800);   // From the pending bucket
+}
+
+// The last point is also the largest candidate of its bucket; it must
+// not be emitted twice
+static void test_last_point_as_its_bucket_extreme() {
+  LttbStream lttb;
+  lttb.begin(0, 999, 12, record, &out);
+  for (uint32_t t = 0; t < 1000; t += 10) lttb.add(t, t == 990 ? 1000 : 0);
+  TEST_ASSERT_TRUE(lttb.finish());
+  assert_shape(0, 990, 12);
+}
+
+static void test_emit_failure_stops_the_stream() {
+  LttbStream lttb;
+  out.stopAfter = 3;
+  lttb.begin(0, 9999, 50, record, &out);
+  bool ok = true;
+  for (uint32_t t = 0; t < 10000 && ok; t++) ok = lttb.add(t, (int32_t)(next_random() % 100));
+  TEST_ASSERT_FALSE(ok);
+  TEST_ASSERT_EQUAL_UINT32(3, out.count);
+  TEST_ASSERT_FALSE(lttb.add(9999, 0));
+  TEST_ASSERT_FALSE(lttb.finish());
+  TEST_ASSERT_EQUAL_UINT32(3, out.count);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_single_point_is_emitted_once);
+  RUN_TEST(test_nothing_in_range_emits_nothing);
+  RUN_TEST(test_fewer_points_than_asked_are_kept_as_they_are);
+  RUN_TEST(test_random_series_keep_their_shape);
+  RUN_TEST(test_spikes_survive);
+  RUN_TEST(test_three_points_pick_the_extreme);
+  RUN_TEST(test_last_point_alone_in_its_bucket);
+  RUN_TEST(test_last_point_as_its_bucket_extreme);
+  RUN_TEST(test_emit_failure_stops_the_stream);
+  return UNITY_END();
+}
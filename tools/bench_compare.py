@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+Medibox - compares drawing benchmark results against a baseline
+
+Reads the JSON written by the bench environment (src/host/bench.cpp)
+and prints each benchmark's host time and bus traffic next to the
+baseline's, with the change. Given several result files it takes each
+benchmark's fastest run, as noise only ever adds time. The exit status
+is 1 if a benchmark got slower than the tolerance allows, sends more
+over the display bus than before, or is missing; --update-baseline
+writes the results as the new baseline instead. Bus traffic is exact
+and machine-independent; host times only compare on the machine and
+build the baseline came from.
+
+    pio run -e bench && .pio/build/bench/program bench.json
+    python3 tools/bench_compare.py bench.json
+    python3 tools/bench_compare.py run1.json run2.json run3.json --update-baseline
+"""
+
+import argparse
+import json
+import os
+import sys
+
+BASELINE = os.path.join(os.path.dirname(__file__), "bench", "baseline.json")
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)["benchmarks"]
+
+
+def fastest(paths):
+    best = {}
+    for path in paths:
+        for name, result in load(path).items():
+            if name not in best or result["ns"] < best[name]["ns"]:
+                best[name] = result
+    return best
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("results", nargs="+")
+    ap.add_argument("--baseline", default=BASELINE)
+    ap.add_argument("--update-baseline", action="store_true",
+                    help="write the results as the baseline")
+    ap.add_argument("--tolerance", type=float, default=15, help="percent, per benchmark")
+    ap.add_argument("--slack-ns", type=float, default=20,
+                    help="also allowed, for the shortest benchmarks")
+    args = ap.parse_args()
+
+    results = fastest(args.results)
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump({"benchmarks": results}, f, indent=1)
+            f.write("\n")
+        print(f"baseline -> {args.baseline}")
+        return 0
+    base = load(args.baseline)
+
+    print(f"{'benchmark':<22} {'ns/op':>10} {'baseline':>10} {'change':>8} {'bus B/op':>9} {'baseline':>9}")
+    failures = []
+    limit = 1 + args.tolerance / 100
+    for name, now in results.items():
+        then = base.get(name)
+        if then is None:
+            print(f"{name:<22} {now['ns']:10.1f} {'new':>10}")
+            continue
+        change = (now["ns"] / then["ns"] - 1) * 100 if then["ns"] else 0
+        print(f"{name:<22} {now['ns']:10.1f} {then['ns']:10.1f} {change:+7.1f}% "
+              f"{now['bus_bytes']:9} {then['bus_bytes']:9}")
+        if now["ns"] > then["ns"] * limit + args.slack_ns:
+            failures.append(f"{name}: {now['ns']:.1f} ns, baseline {then['ns']:.1f} ns")
+        for key in ("bus_bytes", "bus_transactions"):
+            if now[key] > then[key]:
+                failures.append(f"{name}: {key} {now[key]}, baseline {then[key]}")
+    for name in base:
+        if name not in results:
+            failures.append(f"{name}: missing from the results")
+    for failure in failures:
+        print(f"REGRESSION {failure}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
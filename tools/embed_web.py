@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Medibox - embeds the web UI into the firmware
+
+Gzips every file under web/ and writes src/web_assets.cpp: one const byte
+array per file, which the linker places in flash, plus a table with the
+path, content type and a strong ETag (hash of the gzipped bytes). The
+device sends those bytes unchanged with Content-Encoding: gzip.
+
+Runs before each build as a PlatformIO extra script and only rewrites the
+output when an asset changed. Can also be run by hand:
+
+    python3 tools/embed_web.py
+"""
+
+import gzip
+import hashlib
+import os
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".json": "application/json",
+}
+
+
+def collect(web_dir):
+    assets = []
+    for root, _, files in os.walk(web_dir):
+        for name in sorted(files):
+            full = os.path.join(root, name)
+            ext = os.path.splitext(name)[1]
+            if ext not in CONTENT_TYPES:
+                continue
+            with open(full, "rb") as f:
+                # mtime=0 keeps the output (and the ETag) reproducible
+                gz = gzip.compress(f.read(), compresslevel=9, mtime=0)
+            path = "/" + os.path.relpath(full, web_dir).replace(os.sep, "/")
+            assets.append((path, CONTENT_TYPES[ext], hashlib.sha256(gz).hexdigest()[:16], gz))
+    assets.sort()
+    return assets
+
+
+def render(assets):
+    out = [
+        "/*",
+        " * Medibox - web UI assets, generated by tools/embed_web.py from web/.",
+        " * Do not edit.",
+        " */",
+        "",
+        '#include "web_ui.h"',
+        "",
+    ]
+    for i, (path, _, _, gz) in enumerate(assets):
+        out.append(f"// {path}")
+        out.append(f"static const uint8_t asset{i}[{len(gz)}] = {{")
+        for off in range(0, len(gz), 16):
+            out.append("  " + ", ".join(f"0x{b:02x}" for b in gz[off:off + 16]) + ",")
+        out.append("};")
+        out.append("")
+    out.append("const WebAsset webAssets[] = {")
+    for i, (path, ctype, etag, gz) in enumerate(assets):
+        out.append(f'  {{"{path}", "{ctype}", "\\"{etag}\\"", asset{i}, sizeof(asset{i})}},')
+    out.append("};")
+    out.append("")
+    out.append("const size_t webAssetCount = sizeof(webAssets) / sizeof(webAssets[0]);")
+    out.append("")
+    return "\n".join(out)
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    target = os.path.join(project_dir, "src", "web_assets.cpp")
+    assets = collect(web_dir)
+    text = render(assets)
+    try:
+        with open(target) as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(target, "w") as f:
+        f.write(text)
+    total = sum(len(a[3]) for a in assets)
+    print(f"embed_web: {len(assets)} assets, {total} bytes gzipped -> {target}")
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    generate(env.subst("$PROJECT_DIR"))
+elif __name__ == "__main__":
+    generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
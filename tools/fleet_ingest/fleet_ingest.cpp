@@ -0,0 +1,608 @@
+/*
+ * Medibox - fleet telemetry ingest service (Linux)
+ *
+ * Receives device telemetry as CBOR datagrams (TELEMETRY_UDP firmware) and
+ * as MQTT JSON payloads piped in from mosquitto_sub -v, decodes both with
+ * the firmware's own telemetry_codec, and folds them into per-device
+ * statistics. Devices are sharded by id hash across worker threads; each
+ * shard owns its devices, so workers never contend with each other.
+ *
+ *   ./fleet_ingest --udp-port 5683 --http-port 8080 --workers 4
+ *   mosquitto_sub -h broker -t 'medibox/+/telemetry' -v | ./fleet_ingest --mqtt-stdin
+ *
+ * Query endpoints (JSON):
+ *   GET /fleet            totals: adherence, excursions, loss
+ *   GET /devices          one summary line per device
+ *   GET /devices/<id>     full statistics of one device
+ *   GET /stats            ingest counters, rate and latency percentiles
+ *   GET /stats/reset      clears the latency histogram and rate window
+ *
+ * Ingest latency runs from the kernel receive timestamp of a datagram (or
+ * the read of an MQTT line) to the moment its records are applied.
+ */
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json_writer.h"
+#include "telemetry_codec.h"
+
+#define MAX_RECORDS 64
+#define SHARD_QUEUE 4096
+#define RECV_BATCH 64
+#define DATAGRAM_MAX 2048
+#define LINE_MAX 4096
+#define HIST_BUCKETS (64 + 34 * 32)
+
+struct Options {
+  int udpPort = 5683;
+  int httpPort = 8080;
+  int workers = 4;
+  int receivers = 2;
+  bool mqttStdin = false;
+  // Same defaults as the firmware's healthy ranges, in hundredths
+  int32_t minTemp = 2400, maxTemp = 3200;
+  int32_t minHumidity = 6500, maxHumidity = 8000;
+};
+
+static Options opt;
+
+struct Message {
+  uint64_t receivedNs;    // CLOCK_REALTIME
+  TelemetryBatch batch;
+  TelemetryRecord records[MAX_RECORDS];
+};
+
+struct DeviceStats {
+  bool seqValid = false;
+  uint32_t nextSeq = 0;
+  uint32_t messages = 0;
+  uint32_t lost = 0;          // Sequence gaps
+  uint32_t late = 0;          // Arrived after a gap was counted
+  uint32_t windows = 0;
+  uint32_t samples = 0;
+  uint32_t tempExcursions = 0;     // Windows with min or max outside range
+  uint32_t humidityExcursions = 0;
+  int32_t lastTemp = 0, lastHumidity = 0;
+  uint32_t lastTimestamp = 0;
+  uint32_t rang = 0, dismissed = 0, snoozed = 0;
+  uint64_t responseSumSec = 0;
+  uint32_t responseMaxSec = 0;
+  uint64_t lastSeenNs = 0;
+};
+
+// Log-linear histogram: exact below 64 us, then 32 buckets per octave
+struct LatencyHistogram {
+  uint64_t buckets[HIST_BUCKETS] = {};
+  uint64_t count = 0;
+  uint64_t maxUs = 0;
+
+  static int bucket_of(uint64_t us) {
+    if (us < 64) return (int)us;
+    int e = 63 - __builtin_clzll(us);
+    if (e > 39) return HIST_BUCKETS - 1;
+    return 64 + (e - 6) * 32 + (int)((us >> (e - 5)) & 31);
+  }
+
+  static uint64_t bucket_floor(int b) {
+    if (b < 64) return b;
+    int e = (b - 64) / 32 + 6;
+    return (1ULL << e) + ((uint64_t)((b - 64) % 32) << (e - 5));
+  }
+
+  void add(uint64_t us) {
+    buckets[bucket_of(us)]++;
+    count++;
+    if (us > maxUs) maxUs = us;
+  }
+
+  void merge(const LatencyHistogram& o) {
+    for (int i = 0; i < HIST_BUCKETS; i++) buckets[i] += o.buckets[i];
+    count += o.count;
+    if (o.maxUs > maxUs) maxUs = o.maxUs;
+  }
+
+  uint64_t percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(p * (count - 1)) + 1, seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+      seen += buckets[i];
+      if (seen >= rank) return bucket_floor(i);
+    }
+    return maxUs;
+  }
+};
+
+struct Shard {
+  // Queue filled by the receivers
+  std::mutex queueLock;
+  std::condition_variable notEmpty, notFull;
+  std::vector<Message> ring = std::vector<Message>(SHARD_QUEUE);
+  size_t head = 0, tail = 0;
+
+  // Owned by the worker, read by queries
+  std::mutex stateLock;
+  std::unordered_map<std::string, DeviceStats> devices;
+  LatencyHistogram latency;
+  uint64_t processed = 0;
+};
+
+static std::vector<Shard*> shards;
+static std::atomic<uint64_t> datagrams{0}, mqttLines{0}, decodeErrors{0}, records{0};
+
+static uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t hash_device(const char* s) {
+  uint32_t h = 2166136261u;   // FNV-1a
+  while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+  return h;
+}
+
+// ---- Receivers -------------------------------------------------------------
+
+static void dispatch(Message& msg) {
+  records += msg.batch.count;
+  Shard& s = *shards[hash_device(msg.batch.device) % shards.size()];
+  std::unique_lock<std::mutex> lock(s.queueLock);
+  s.notFull.wait(lock, [&] { return s.head - s.tail < SHARD_QUEUE; });
+  s.ring[s.head % SHARD_QUEUE] = msg;
+  s.head++;
+  lock.unlock();
+  s.notEmpty.notify_one();
+}
+
+static void udp_receiver() {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int on = 1, rcvbuf = 8 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.udpPort);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("udp bind");
+    exit(1);
+  }
+
+  static thread_local uint8_t bufs[RECV_BATCH][DATAGRAM_MAX];
+  static thread_local char controls[RECV_BATCH][64];
+  mmsghdr msgs[RECV_BATCH];
+  iovec iovs[RECV_BATCH];
+  Message msg;
+  for (;;) {
+    for (int i = 0; i < RECV_BATCH; i++) {
+      iovs[i] = {bufs[i], DATAGRAM_MAX};
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_control = controls[i];
+      msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+    }
+    int n = recvmmsg(fd, msgs, RECV_BATCH, MSG_WAITFORONE, NULL);
+    if (n <= 0) continue;
+    uint64_t fallback = now_ns();
+    for (int i = 0; i < n; i++) {
+      datagrams++;
+      msg.receivedNs = fallback;
+      for (cmsghdr* c = CMSG_FIRSTHDR(&msgs[i].msg_hdr); c; c = CMSG_NXTHDR(&msgs[i].msg_hdr, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+          timespec ts;
+          memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+          msg.receivedNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        }
+      }
+      if (!telemetry_decode_cbor(bufs[i], msgs[i].msg_len, &msg.batch, msg.records, MAX_RECORDS)) {
+        decodeErrors++;
+        continue;
+      }
+      dispatch(msg);
+    }
+  }
+}
+
+// Lines from mosquitto_sub -v: "<topic> <payload>", or a bare payload
+static void mqtt_stdin_reader() {
+  static char line[LINE_MAX];
+  Message msg;
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    msg.receivedNs = now_ns();
+    mqttLines++;
+    char* payload = line[0] == '{' ? line : strchr(line, ' ');
+    if (payload == NULL ||
+        !telemetry_decode_json(payload, strlen(payload), &msg.batch, msg.records, MAX_RECORDS)) {
+      decodeErrors++;
+      continue;
+    }
+    dispatch(msg);
+  }
+}
+
+// ---- Workers ---------------------------------------------------------------
+
+static void apply(DeviceStats& d, const Message& msg) {
+  uint32_t seq = msg.batch.seq;
+  d.messages++;
+  d.lastSeenNs = msg.receivedNs;
+  if (!d.seqValid || seq == d.nextSeq || seq == 0) {
+    d.nextSeq = seq + 1;     // In order, first message, or a reboot
+  } else if (seq > d.nextSeq) {
+    d.lost += seq - d.nextSeq;
+    d.nextSeq = seq + 1;
+  } else {
+    d.late++;
+    if (d.lost > 0) d.lost--;
+  }
+  d.seqValid = true;
+
+  for (size_t i = 0; i < msg.batch.count; i++) {
+    const TelemetryRecord& r = msg.records[i];
+    if (r.type == TELEMETRY_SENSOR) {
+      const SensorWindow& w = r.sensor;
+      d.windows++;
+      d.samples += w.samples;
+      if (w.tempMin < opt.minTemp || w.tempMax > opt.maxTemp) d.tempExcursions++;
+      if (w.humMin < opt.minHumidity || w.humMax > opt.maxHumidity) d.humidityExcursions++;
+      if (r.timestamp >= d.lastTimestamp) {
+        d.lastTimestamp = r.timestamp;
+        d.lastTemp = w.tempMean;
+        d.lastHumidity = w.humMean;
+      }
+    } else if (r.type == TELEMETRY_ADHERENCE) {
+      const AdherenceRecord& a = r.adherence;
+      if (a.event == ADHERENCE_RANG) {
+        d.rang++;
+        continue;
+      }
+      if (a.event == ADHERENCE_DISMISSED) d.dismissed++;
+      if (a.event == ADHERENCE_SNOOZED) d.snoozed++;
+      d.responseSumSec += a.responseSec;
+      if (a.responseSec > d.responseMaxSec) d.responseMaxSec = a.responseSec;
+    }
+  }
+}
+
+static void worker(Shard* s) {
+  std::vector<Message> local(RECV_BATCH);
+  for (;;) {
+    size_t n = 0;
+    {
+      std::unique_lock<std::mutex> lock(s->queueLock);
+      s->notEmpty.wait(lock, [&] { return s->head != s->tail; });
+      while (n < local.size() && s->tail != s->head) {
+        local[n++] = s->ring[s->tail % SHARD_QUEUE];
+        s->tail++;
+      }
+    }
+    s->notFull.notify_all();
+
+    std::lock_guard<std::mutex> lock(s->stateLock);
+    for (size_t i = 0; i < n; i++) {
+      apply(s->devices[local[i].batch.device], local[i]);
+      s->processed++;
+    }
+    uint64_t done = now_ns();
+    for (size_t i = 0; i < n; i++) {
+      uint64_t ns = done > local[i].receivedNs ? done - local[i].receivedNs : 0;
+      s->latency.add(ns / 1000);
+    }
+  }
+}
+
+// ---- Queries ---------------------------------------------------------------
+
+static bool sink_fd(void* ctx, const char* data, size_t len) {
+  int fd = *(int*)ctx;
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n <= 0) return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+static void write_adherence(JsonWriter& w, uint32_t rang, uint32_t dismissed, uint32_t snoozed,
+                            uint64_t responseSum, uint32_t responseMax) {
+  uint32_t responses = dismissed + snoozed;
+  w.key("adherence");
+  w.begin_object();
+  w.key("rang");
+  w.value(rang);
+  w.key("dismissed");
+  w.value(dismissed);
+  w.key("snoozed");
+  w.value(snoozed);
+  w.key("dismissRate");
+  w.value(rang ? (float)dismissed / rang : 0.0f, 3);
+  w.key("meanResponseSec");
+  w.value(responses ? (float)responseSum / responses : 0.0f, 1);
+  w.key("maxResponseSec");
+  w.value(responseMax);
+  w.end_object();
+}
+
+static void write_device(JsonWriter& w, const std::string& id, const DeviceStats& d, bool full) {
+  w.begin_object();
+  w.key("dev");
+  w.value(id.c_str());
+  w.key("messages");
+  w.value(d.messages);
+  w.key("lost");
+  w.value(d.lost);
+  w.key("lastTemp");
+  w.value(d.lastTemp / 100.0f, 2);
+  w.key("lastHumidity");
+  w.value(d.lastHumidity / 100.0f, 2);
+  w.key("excursions");
+  w.value(d.tempExcursions + d.humidityExcursions);
+  if (full) {
+    w.key("late");
+    w.value(d.late);
+    w.key("windows");
+    w.value(d.windows);
+    w.key("samples");
+    w.value(d.samples);
+    w.key("tempExcursions");
+    w.value(d.tempExcursions);
+    w.key("humidityExcursions");
+    w.value(d.humidityExcursions);
+    w.key("lastTimestamp");
+    w.value(d.lastTimestamp);
+    w.key("lastSeenAgoMs");
+    w.value((uint32_t)((now_ns() - d.lastSeenNs) / 1000000));
+    write_adherence(w, d.rang, d.dismissed, d.snoozed, d.responseSumSec, d.responseMaxSec);
+  }
+  w.end_object();
+}
+
+static void query_fleet(JsonWriter& w) {
+  DeviceStats total;
+  uint32_t devices = 0;
+  for (Shard* s : shards) {
+    std::lock_guard<std::mutex> lock(s->stateLock);
+    devices += s->devices.size();
+    for (auto& kv : s->devices) {
+      const DeviceStats& d = kv.second;
+      total.messages += d.messages;
+      total.lost += d.lost;
+      total.windows += d.windows;
+      total.tempExcursions += d.tempExcursions;
+      total.humidityExcursions += d.humidityExcursions;
+      total.rang += d.rang;
+      total.dismissed += d.dismissed;
+      total.snoozed += d.snoozed;
+      total.responseSumSec += d.responseSumSec;
+      if (d.responseMaxSec > total.responseMaxSec) total.responseMaxSec = d.responseMaxSec;
+    }
+  }
+  w.begin_object();
+  w.key("devices");
+  w.value(devices);
+  w.key("messages");
+  w.value(total.messages);
+  w.key("lost");
+  w.value(total.lost);
+  w.key("windows");
+  w.value(total.windows);
+  w.key("tempExcursions");
+  w.value(total.tempExcursions);
+  w.key("humidityExcursions");
+  w.value(total.humidityExcursions);
+  write_adherence(w, total.rang, total.dismissed, total.snoozed, total.responseSumSec,
+                  total.responseMaxSec);
+  w.end_object();
+}
+
+static std::mutex rateLock;
+static uint64_t rateStartNs = now_ns();
+static uint64_t rateStartProcessed = 0;
+
+static uint64_t total_processed(LatencyHistogram* merged) {
+  uint64_t processed = 0;
+  for (Shard* s : shards) {
+    std::lock_guard<std::mutex> lock(s->stateLock);
+    processed += s->processed;
+    if (merged != NULL) merged->merge(s->latency);
+  }
+  return processed;
+}
+
+static void query_stats(JsonWriter& w, bool reset) {
+  static LatencyHistogram merged;
+  merged = LatencyHistogram();
+  uint64_t processed = total_processed(&merged);
+
+  std::lock_guard<std::mutex> lock(rateLock);
+  double seconds = (now_ns() - rateStartNs) / 1e9;
+  w.begin_object();
+  w.key("datagrams");
+  w.value((uint32_t)datagrams);
+  w.key("mqttMessages");
+  w.value((uint32_t)mqttLines);
+  w.key("decodeErrors");
+  w.value((uint32_t)decodeErrors);
+  w.key("records");
+  w.value((uint32_t)records);
+  w.key("processed");
+  w.value((uint32_t)processed);
+  w.key("windowSeconds");
+  w.value((float)seconds, 2);
+  w.key("messagesPerSec");
+  w.value(seconds > 0 ? (float)((processed - rateStartProcessed) / seconds) : 0.0f, 1);
+  w.key("latencyUs");
+  w.begin_object();
+  w.key("p50");
+  w.value((uint32_t)merged.percentile(0.50));
+  w.key("p90");
+  w.value((uint32_t)merged.percentile(0.90));
+  w.key("p99");
+  w.value((uint32_t)merged.percentile(0.99));
+  w.key("max");
+  w.value((uint32_t)merged.maxUs);
+  w.end_object();
+  w.end_object();
+
+  if (reset) {
+    for (Shard* s : shards) {
+      std::lock_guard<std::mutex> stateLock(s->stateLock);
+      s->latency = LatencyHistogram();
+    }
+    rateStartNs = now_ns();
+    rateStartProcessed = processed;
+  }
+}
+
+static void serve(int fd) {
+  char req[1024];
+  ssize_t n = read(fd, req, sizeof(req) - 1);
+  if (n <= 0) return;
+  req[n] = '\0';
+  char method[8], path[256];
+  if (sscanf(req, "%7s %255s", method, path) != 2) return;
+
+  const char* status = "200 OK";
+  bool found = true;
+  if (strcmp(method, "GET") != 0) {
+    status = "405 Method Not Allowed";
+    found = false;
+  } else if (strncmp(path, "/devices/", 9) == 0) {
+    Shard& s = *shards[hash_device(path + 9) % shards.size()];
+    std::lock_guard<std::mutex> lock(s.stateLock);
+    found = s.devices.count(path + 9) > 0;
+    if (!found) status = "404 Not Found";
+  } else if (strcmp(path, "/fleet") != 0 && strcmp(path, "/devices") != 0 &&
+             strcmp(path, "/stats") != 0 && strcmp(path, "/stats/reset") != 0) {
+    status = "404 Not Found";
+    found = false;
+  }
+
+  char head[128];
+  int len = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %s\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n",
+                     status);
+  if (!sink_fd(&fd, head, len) || !found) return;
+
+  char buf[4096];
+  JsonWriter w(buf, sizeof(buf), sink_fd, &fd);
+  if (strcmp(path, "/fleet") == 0) {
+    query_fleet(w);
+  } else if (strcmp(path, "/devices") == 0) {
+    // Streams through the writer's sink, so 10k devices need no big buffer
+    w.begin_array();
+    for (Shard* s : shards) {
+      std::lock_guard<std::mutex> lock(s->stateLock);
+      for (auto& kv : s->devices) write_device(w, kv.first, kv.second, false);
+    }
+    w.end_array();
+  } else if (strncmp(path, "/devices/", 9) == 0) {
+    Shard& s = *shards[hash_device(path + 9) % shards.size()];
+    std::lock_guard<std::mutex> lock(s.stateLock);
+    auto it = s.devices.find(path + 9);
+    if (it != s.devices.end()) write_device(w, it->first, it->second, true);
+  } else {
+    query_stats(w, strcmp(path, "/stats/reset") == 0);
+  }
+  w.flush();
+}
+
+static void http_server() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.httpPort);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+    perror("http bind");
+    exit(1);
+  }
+  for (;;) {
+    int client = accept(fd, NULL, NULL);
+    if (client < 0) continue;
+    serve(client);
+    close(client);
+  }
+}
+
+// ---- Main ------------------------------------------------------------------
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fleet_ingest [--udp-port N] [--http-port N] [--workers N]\n"
+          "                    [--receivers N] [--mqtt-stdin] [--no-udp]\n"
+          "                    [--temp-range MIN,MAX] [--humidity-range MIN,MAX]\n");
+  exit(2);
+}
+
+static void parse_range(const char* arg, int32_t* lo, int32_t* hi) {
+  float a, b;
+  if (sscanf(arg, "%f,%f", &a, &b) != 2 || a >= b) usage();
+  *lo = (int32_t)(a * TELEMETRY_SCALE);
+  *hi = (int32_t)(b * TELEMETRY_SCALE);
+}
+
+int main(int argc, char** argv) {
+  bool udp = true;
+  static const option longOpts[] = {
+      {"udp-port", required_argument, NULL, 'u'},
+      {"http-port", required_argument, NULL, 'h'},
+      {"workers", required_argument, NULL, 'w'},
+      {"receivers", required_argument, NULL, 'r'},
+      {"mqtt-stdin", no_argument, NULL, 'm'},
+      {"no-udp", no_argument, NULL, 'n'},
+      {"temp-range", required_argument, NULL, 't'},
+      {"humidity-range", required_argument, NULL, 'H'},
+      {NULL, 0, NULL, 0},
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "", longOpts, NULL)) != -1) {
+    switch (c) {
+      case 'u': opt.udpPort = atoi(optarg); break;
+      case 'h': opt.httpPort = atoi(optarg); break;
+      case 'w': opt.workers = atoi(optarg); break;
+      case 'r': opt.receivers = atoi(optarg); break;
+      case 'm': opt.mqttStdin = true; break;
+      case 'n': udp = false; break;
+      case 't': parse_range(optarg, &opt.minTemp, &opt.maxTemp); break;
+      case 'H': parse_range(optarg, &opt.minHumidity, &opt.maxHumidity); break;
+      default: usage();
+    }
+  }
+  if (opt.workers < 1 || opt.receivers < 1 || (!udp && !opt.mqttStdin)) usage();
+
+  for (int i = 0; i < opt.workers; i++) {
+    shards.push_back(new Shard());
+    std::thread(worker, shards.back()).detach();
+  }
+  if (udp) {
+    for (int i = 0; i < opt.receivers; i++) std::thread(udp_receiver).detach();
+  }
+  fprintf(stderr, "fleet_ingest: %d workers, udp %s, http :%d%s\n", opt.workers,
+          udp ? std::to_string(opt.udpPort).c_str() : "off", opt.httpPort,
+          opt.mqttStdin ? ", mqtt from stdin" : "");
+
+  std::thread httpThread(http_server);
+  if (opt.mqttStdin) mqtt_stdin_reader();
+  httpThread.join();
+  return 0;
+}
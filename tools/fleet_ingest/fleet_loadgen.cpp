@@ -0,0 +1,248 @@
+/*
+ * Medibox - load generator for fleet_ingest
+ *
+ * Simulates a fleet of devices, each sending sequence-numbered batches of
+ * sensor windows and alarm events encoded with the firmware codec. Sends
+ * CBOR datagrams over UDP, or with --mqtt writes mosquitto_sub -v style
+ * JSON lines to stdout for piping into fleet_ingest --mqtt-stdin. At the
+ * end it reads /stats from the service and reports the send rate, the
+ * ingest rate and the p99 ingest latency.
+ *
+ *   ./fleet_ingest &
+ *   ./fleet_loadgen --devices 10000 --rate 100000 --seconds 10
+ *   ./fleet_loadgen --mqtt --devices 10000 --seconds 10 | ./fleet_ingest --no-udp --mqtt-stdin
+ */
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "telemetry_codec.h"
+
+#define SEND_BATCH 32
+
+struct Options {
+  std::string host = "127.0.0.1";
+  int port = 5683;
+  int httpPort = 8080;
+  int devices = 10000;
+  int threads = 4;
+  int records = 4;         // Records per message
+  double rate = 0;         // Messages per second, 0 = as fast as possible
+  double seconds = 10;
+  bool mqtt = false;
+};
+
+static Options opt;
+static std::atomic<uint64_t> sent{0}, sendErrors{0};
+static std::mutex stdoutLock;
+
+struct Device {
+  char id[TELEMETRY_DEVICE_MAX];
+  uint32_t seq;
+  uint32_t clock;
+  int32_t temp, humidity;
+};
+
+static void fill_records(Device& d, std::mt19937& rng, TelemetryRecord* recs, int count) {
+  for (int i = 0; i < count; i++) {
+    TelemetryRecord& r = recs[i];
+    r = {};
+    d.clock += 60;
+    r.timestamp = d.clock;
+    if (rng() % 16 == 0) {
+      // Roughly the firmware mix: an alarm rings, then is dismissed or snoozed
+      r.type = TELEMETRY_ADHERENCE;
+      r.adherence.alarm = rng() % 2;
+      r.adherence.event = 1 + rng() % 3;
+      r.adherence.responseSec = r.adherence.event == ADHERENCE_RANG ? 0 : rng() % 300;
+      continue;
+    }
+    // Random walk around the healthy range with occasional excursions
+    d.temp += (int32_t)(rng() % 41) - 20;
+    d.humidity += (int32_t)(rng() % 81) - 40;
+    if (d.temp < 2000 || d.temp > 3600) d.temp = 2800;
+    if (d.humidity < 5500 || d.humidity > 9000) d.humidity = 7200;
+    r.type = TELEMETRY_SENSOR;
+    r.sensor.samples = 12;
+    r.sensor.tempMin = d.temp - 30;
+    r.sensor.tempMax = d.temp + 30;
+    r.sensor.tempMean = d.temp;
+    r.sensor.humMin = d.humidity - 50;
+    r.sensor.humMax = d.humidity + 50;
+    r.sensor.humMean = d.humidity;
+  }
+}
+
+static void sender(int index, int first, int count) {
+  std::mt19937 rng(index * 7919 + 1);
+  std::vector<Device> devices(count);
+  for (int i = 0; i < count; i++) {
+    Device& d = devices[i];
+    snprintf(d.id, sizeof(d.id), "sim-%06x", first + i);
+    d.seq = 0;
+    d.clock = 1760000000 + rng() % 60;
+    d.temp = 2800;
+    d.humidity = 7200;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.port);
+  inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr);
+
+  static thread_local uint8_t bufs[SEND_BATCH][512];
+  static thread_local char line[4096];
+  mmsghdr msgs[SEND_BATCH];
+  iovec iovs[SEND_BATCH];
+  TelemetryRecord recs[64];
+
+  using clock = std::chrono::steady_clock;
+  auto start = clock::now();
+  auto end = start + std::chrono::duration<double>(opt.seconds);
+  double perThread = opt.rate / opt.threads;
+  uint64_t mine = 0;
+  size_t next = 0;
+
+  while (clock::now() < end) {
+    if (perThread > 0) {
+      double due = std::chrono::duration<double>(clock::now() - start).count() * perThread;
+      if (mine >= due) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        continue;
+      }
+    }
+
+    int n = 0;
+    for (; n < SEND_BATCH; n++) {
+      Device& d = devices[next];
+      next = (next + 1) % devices.size();
+      fill_records(d, rng, recs, opt.records);
+      size_t len = 0;
+      if (opt.mqtt) {
+        int topic = snprintf(line, sizeof(line), "medibox/%s/telemetry ", d.id);
+        telemetry_encode_json(line + topic, sizeof(line) - topic - 1, d.id, d.seq++, recs,
+                              opt.records, &len);
+        line[topic + len] = '\n';
+        std::lock_guard<std::mutex> lock(stdoutLock);
+        fwrite(line, 1, topic + len + 1, stdout);
+      } else {
+        telemetry_encode_cbor(bufs[n], sizeof(bufs[n]), d.id, d.seq++, recs, opt.records, &len);
+        iovs[n] = {bufs[n], len};
+        msgs[n] = {};
+        msgs[n].msg_hdr.msg_name = &addr;
+        msgs[n].msg_hdr.msg_namelen = sizeof(addr);
+        msgs[n].msg_hdr.msg_iov = &iovs[n];
+        msgs[n].msg_hdr.msg_iovlen = 1;
+      }
+    }
+    if (!opt.mqtt) {
+      int done = sendmmsg(fd, msgs, n, 0);
+      if (done < n) sendErrors += n - (done > 0 ? done : 0);
+      n = done > 0 ? done : 0;
+    }
+    mine += n;
+    sent += n;
+  }
+  close(fd);
+}
+
+// Fetches a path from fleet_ingest, returns the body or ""
+static std::string http_get(const char* path) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(opt.httpPort);
+  inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr);
+  std::string out;
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+    std::string req = std::string("GET ") + path + " HTTP/1.1\r\nConnection: close\r\n\r\n";
+    if (write(fd, req.data(), req.size()) == (ssize_t)req.size()) {
+      char buf[4096];
+      ssize_t n;
+      while ((n = read(fd, buf, sizeof(buf))) > 0) out.append(buf, n);
+    }
+  }
+  close(fd);
+  size_t body = out.find("\r\n\r\n");
+  return body == std::string::npos ? "" : out.substr(body + 4);
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fleet_loadgen [--host IP] [--port N] [--http-port N] [--devices N]\n"
+          "                     [--threads N] [--records N] [--rate MSG_PER_S]\n"
+          "                     [--seconds S] [--mqtt]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  static const option longOpts[] = {
+      {"host", required_argument, NULL, 'a'},
+      {"port", required_argument, NULL, 'p'},
+      {"http-port", required_argument, NULL, 'h'},
+      {"devices", required_argument, NULL, 'd'},
+      {"threads", required_argument, NULL, 't'},
+      {"records", required_argument, NULL, 'r'},
+      {"rate", required_argument, NULL, 'R'},
+      {"seconds", required_argument, NULL, 's'},
+      {"mqtt", no_argument, NULL, 'm'},
+      {NULL, 0, NULL, 0},
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "", longOpts, NULL)) != -1) {
+    switch (c) {
+      case 'a': opt.host = optarg; break;
+      case 'p': opt.port = atoi(optarg); break;
+      case 'h': opt.httpPort = atoi(optarg); break;
+      case 'd': opt.devices = atoi(optarg); break;
+      case 't': opt.threads = atoi(optarg); break;
+      case 'r': opt.records = atoi(optarg); break;
+      case 'R': opt.rate = atof(optarg); break;
+      case 's': opt.seconds = atof(optarg); break;
+      case 'm': opt.mqtt = true; break;
+      default: usage();
+    }
+  }
+  // UDP datagrams hold at most 16 records (see UDP_DATAGRAM_MAX)
+  if (opt.threads < 1 || opt.devices < opt.threads || opt.records < 1 || opt.records > 16) {
+    usage();
+  }
+
+  if (!opt.mqtt) http_get("/stats/reset");
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  int per = opt.devices / opt.threads;
+  for (int i = 0; i < opt.threads; i++) {
+    int count = i == opt.threads - 1 ? opt.devices - per * i : per;
+    threads.emplace_back(sender, i, per * i, count);
+  }
+  for (auto& t : threads) t.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  fflush(stdout);
+
+  fprintf(stderr, "sent %llu messages from %d devices in %.1f s: %.0f msg/s (%llu send errors)\n",
+          (unsigned long long)sent.load(), opt.devices, elapsed, sent / elapsed,
+          (unsigned long long)sendErrors.load());
+  if (!opt.mqtt) {
+    // Let the workers drain before sampling
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::string stats = http_get("/stats");
+    fprintf(stderr, "service: %s\n", stats.empty() ? "unreachable" : stats.c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Medibox - generates the UI string table
+
+Reads strings/<lang>.txt and writes include/ui_strings.h (a StrId per
+string, a UiLanguage per file) and src/ui_strings.cpp: for each language
+one const char blob holding every string, which the linker keeps in
+flash, and a table with each string's offset, length, line count and
+width in pixels (6 px per character at text size 1) for layout.
+
+en.txt is the reference: it defines the IDs and their order. Other
+languages fall back to English for strings they lack. Text is stored in
+code page 437, the encoding of the display's built-in font, so accented
+letters show up as such. Fails the build if a translation has an unknown
+ID or printf conversions that differ from English.
+
+Runs before each build as a PlatformIO extra script and only rewrites the
+outputs when a string changed. Can also be run by hand:
+
+    python3 tools/gen_strings.py
+"""
+
+import json
+import os
+import re
+
+REFERENCE = "en"
+CHAR_WIDTH = 6
+SCREEN_WIDTH = 128
+LINE = re.compile(r'^([A-Z][A-Z0-9_]*)\s*=\s*(".*")\s*$')
+CONVERSION = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?[hlLzjt]*([diouxXcsfeEgGp%])")
+
+
+def parse(path):
+    strings = {}
+    with open(path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            m = LINE.match(line)
+            if m is None:
+                raise SystemExit(f"{path}:{number}: expected ID = \"text\"")
+            name, text = m.group(1), json.loads(m.group(2))
+            if name in strings:
+                raise SystemExit(f"{path}:{number}: {name} defined twice")
+            strings[name] = text
+    return strings
+
+
+def conversions(text):
+    return [c for c in CONVERSION.findall(text) if c != "%"]
+
+
+def encode(text, where):
+    try:
+        return text.encode("cp437")
+    except UnicodeEncodeError as e:
+        raise SystemExit(f"{where}: {text!r} has characters the display font lacks ({e})")
+
+
+def c_literal(data):
+    out = []
+    for b in data:
+        c = chr(b)
+        if c == '"' or c == "\\":
+            out.append("\\" + c)
+        elif c == "\n":
+            out.append("\\n")
+        elif 0x20 <= b < 0x7F:
+            out.append(c)
+        else:
+            # Always three digits, so a following digit is not swallowed
+            out.append(f"\\{b:03o}")
+    return '"' + "".join(out) + '\\0"'
+
+
+def load(strings_dir, warnings):
+    langs = sorted(os.path.splitext(n)[0] for n in os.listdir(strings_dir) if n.endswith(".txt"))
+    if REFERENCE not in langs:
+        raise SystemExit(f"{strings_dir}: {REFERENCE}.txt is missing")
+    langs.remove(REFERENCE)
+    langs.insert(0, REFERENCE)
+    tables = {lang: parse(os.path.join(strings_dir, lang + ".txt")) for lang in langs}
+    ids = list(tables[REFERENCE])
+
+    for lang in langs[1:]:
+        table = tables[lang]
+        for name in table:
+            if name not in tables[REFERENCE]:
+                raise SystemExit(f"{lang}.txt: {name} is not in {REFERENCE}.txt")
+        for name in ids:
+            if name not in table:
+                warnings.append(f"{lang}.txt lacks {name}, using {REFERENCE}")
+                table[name] = tables[REFERENCE][name]
+            elif conversions(table[name]) != conversions(tables[REFERENCE][name]):
+                raise SystemExit(f"{lang}.txt: {name} must use the conversions "
+                                 f"{conversions(tables[REFERENCE][name])}")
+    return langs, ids, tables
+
+
+def measure(text):
+    lines = text.split("\n")
+    if text.endswith("\n"):
+        lines.pop()
+    return len(lines), max(len(line) for line in lines) * CHAR_WIDTH if lines else 0
+
+
+def render_header(langs, ids):
+    out = [
+        "/*",
+        " * Medibox - UI string IDs, generated by tools/gen_strings.py from",
+        " * strings/. Do not edit; see ui_text.h.",
+        " */",
+        "",
+        "#ifndef UI_STRINGS_H",
+        "#define UI_STRINGS_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "enum StrId : uint16_t {",
+        "  STR_NONE,",
+    ]
+    out += [f"  STR_{name}," for name in ids]
+    out += ["  STR_COUNT", "};", "", "enum UiLanguage : uint8_t {"]
+    out += [f"  LANG_{lang.upper()}," for lang in langs]
+    out += ["  LANG_COUNT", "};", "", "#endif", ""]
+    return "\n".join(out)
+
+
+def render_source(langs, ids, tables, warnings):
+    out = [
+        "/*",
+        " * Medibox - UI strings, generated by tools/gen_strings.py from strings/.",
+        " * Do not edit.",
+        " */",
+        "",
+        '#include "ui_text.h"',
+        "",
+    ]
+    for lang in langs:
+        blob = [c_literal(b"")]
+        entries = ["  {0, 0, 0, 0},  // NONE"]
+        offset = 1
+        for name in ids:
+            text = tables[lang][name]
+            data = encode(text, f"{lang}.txt {name}")
+            if len(data) > 255:
+                raise SystemExit(f"{lang}.txt: {name} is longer than 255 bytes")
+            lines, width = measure(text)
+            if lines == 1 and width > SCREEN_WIDTH and not conversions(text):
+                warnings.append(f"{lang}.txt {name} is {width} px wide, "
+                                f"the display wraps at {SCREEN_WIDTH}")
+            blob.append(c_literal(data))
+            entries.append(f"  {{{offset}, {len(data)}, {lines}, {width}}},  // {name}")
+            offset += len(data) + 1
+        if offset > 0xFFFF:
+            raise SystemExit(f"{lang}.txt: more than 64 KiB of text")
+        out.append(f"static const char text_{lang}[] =")
+        out += ["  " + literal for literal in blob]
+        out[-1] += ";"
+        out.append("")
+        out.append(f"static const UiText entries_{lang}[STR_COUNT] = {{")
+        out += entries
+        out.append("};")
+        out.append("")
+    out.append("const UiLanguageTable uiLanguages[LANG_COUNT] = {")
+    out += [f'  {{"{lang}", text_{lang}, entries_{lang}}},' for lang in langs]
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def write_if_changed(path, text):
+    try:
+        with open(path, encoding="utf-8") as f:
+            if f.read() == text:
+                return False
+    except FileNotFoundError:
+        pass
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(text)
+    return True
+
+
+def generate(project_dir):
+    warnings = []
+    langs, ids, tables = load(os.path.join(project_dir, "strings"), warnings)
+    header = os.path.join(project_dir, "include", "ui_strings.h")
+    source = os.path.join(project_dir, "src", "ui_strings.cpp")
+    changed = write_if_changed(header, render_header(langs, ids))
+    changed |= write_if_changed(source, render_source(langs, ids, tables, warnings))
+    if changed:
+        # Only when the strings changed, not on every build
+        for warning in warnings:
+            print(f"gen_strings: {warning}")
+        print(f"gen_strings: {len(ids)} strings in {', '.join(langs)} -> {source}")
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    generate(env.subst("$PROJECT_DIR"))
+elif __name__ == "__main__":
+    generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Medibox - sensor history benchmark
+
+Compares the LTTB endpoint against a full export of the same range: total
+time, time-to-first-byte, response size and points returned, plus the
+device heap low-water mark from /api/stats. Defaults to the whole log.
+
+    python3 tools/history_bench.py 192.168.1.50 --points 300 --days 30
+"""
+
+import argparse
+import http.client
+import json
+import time
+
+
+def fetch(host, port, path):
+    conn = http.client.HTTPConnection(host, port, timeout=120)
+    start = time.perf_counter()
+    conn.request("GET", path)
+    resp = conn.getresponse()
+    first = time.perf_counter()
+    body = resp.read()
+    done = time.perf_counter()
+    conn.close()
+    if resp.status != 200:
+        raise SystemExit(f"GET {path}: {resp.status}")
+    return json.loads(body), len(body), first - start, done - start
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--points", type=int, default=300)
+    ap.add_argument("--series", default="temp", choices=("temp", "humidity"))
+    ap.add_argument("--days", type=float, help="only the most recent days")
+    ap.add_argument("--runs", type=int, default=3)
+    args = ap.parse_args()
+
+    query = ""
+    if args.days:
+        query = f"&from={int(time.time() - args.days * 86400)}"
+    paths = [
+        ("lttb", f"/api/history?points={args.points}&series={args.series}{query}"),
+        ("raw", f"/api/history?raw=1{query}"),
+    ]
+
+    print(f"{'':6}{'total s':>10}{'ttfb ms':>10}{'KiB':>10}{'points':>9}{'scanned':>9}")
+    for name, path in paths:
+        best = None
+        for _ in range(args.runs):
+            data, size, ttfb, total = fetch(args.host, args.port, path)
+            if best is None or total < best[3]:
+                best = (data, size, ttfb, total)
+        data, size, ttfb, total = best
+        points = len(data.get("points", data.get("readings", [])))
+        print(f"{name:6}{total:10.2f}{ttfb * 1000:10.1f}{size / 1024:10.1f}"
+              f"{points:9}{data['scanned']:9}")
+
+    stats, _, _, _ = fetch(args.host, args.port, "/api/stats")
+    print(f"device heap: free {stats['freeHeap']}  "
+          f"min while serving {stats['minFreeHeapServing']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Medibox - HTTP load generator
+
+Hammers the device REST API over keep-alive connections and reports
+requests/s, latency and time-to-first-byte percentiles and the device-side
+heap low-water mark from /api/stats.
+
+With --ui the clients load the web UI instead, revalidating with the
+ETags they were given like a browser reload does (304s); --no-cache
+always fetches the full gzipped assets.
+
+    python3 tools/http_load.py 192.168.1.50 --clients 4 --seconds 20
+    python3 tools/http_load.py 192.168.1.50 --ui --clients 4
+"""
+
+import argparse
+import http.client
+import json
+import threading
+import time
+
+REQUESTS = [
+    ("GET", "/api/alarms", None),
+    ("GET", "/api/alarms/1", None),
+    ("PUT", "/api/alarms/2", '{"hour":8,"minute":15}'),
+    ("GET", "/api/thresholds", None),
+    ("GET", "/api/timezone", None),
+]
+
+UI_REQUESTS = [
+    ("GET", "/", None),
+    ("GET", "/app.js", None),
+    ("GET", "/style.css", None),
+]
+
+
+def percentiles(label, values):
+    values.sort()
+    n = len(values)
+    if n:
+        pct = lambda p: values[min(n - 1, int(p * n))] * 1000
+        print(f"{label} ms: p50 {pct(0.50):.2f}  p90 {pct(0.90):.2f}  p99 {pct(0.99):.2f}")
+
+
+def worker(host, port, deadline, requests, revalidate, results, lock):
+    conn = http.client.HTTPConnection(host, port, timeout=5)
+    local, ttfb, failed, not_modified, i = [], [], 0, 0, 0
+    etags = {}
+    while time.monotonic() < deadline:
+        method, path, body = requests[i % len(requests)]
+        i += 1
+        headers = {"Content-Type": "application/json", "Accept-Encoding": "gzip"}
+        if revalidate and path in etags:
+            headers["If-None-Match"] = etags[path]
+        start = time.perf_counter()
+        try:
+            conn.request(method, path, body=body, headers=headers)
+            resp = conn.getresponse()
+            first = time.perf_counter()
+            resp.read()
+            if resp.status >= 400:
+                failed += 1
+            elif resp.status == 304:
+                not_modified += 1
+            if resp.getheader("ETag"):
+                etags[path] = resp.getheader("ETag")
+        except (OSError, http.client.HTTPException):
+            failed += 1
+            conn.close()
+            conn = http.client.HTTPConnection(host, port, timeout=5)
+            continue
+        local.append(time.perf_counter() - start)
+        ttfb.append(first - start)
+    conn.close()
+    with lock:
+        results["latency"].extend(local)
+        results["ttfb"].extend(ttfb)
+        results["errors"] += failed
+        results["not_modified"] += not_modified
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("host")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--ui", action="store_true", help="load the web UI assets")
+    ap.add_argument("--no-cache", action="store_true",
+                    help="never send If-None-Match")
+    args = ap.parse_args()
+
+    results = {"latency": [], "ttfb": [], "errors": 0, "not_modified": 0}
+    lock = threading.Lock()
+    requests = UI_REQUESTS if args.ui else REQUESTS
+    deadline = time.monotonic() + args.seconds
+    threads = [threading.Thread(target=worker,
+                                args=(args.host, args.port, deadline, requests,
+                                      not args.no_cache, results, lock))
+               for _ in range(args.clients)]
+    started = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - started
+
+    n = len(results["latency"])
+    print(f"requests: {n}  errors: {results['errors']}  "
+          f"304: {results['not_modified']}  rate: {n / elapsed:.1f} req/s")
+    percentiles("latency", results["latency"])
+    percentiles("ttfb", results["ttfb"])
+
+    conn = http.client.HTTPConnection(args.host, args.port, timeout=5)
+    conn.request("GET", "/api/stats")
+    stats = json.loads(conn.getresponse().read())
+    print(f"device heap: free {stats['freeHeap']}  "
+          f"min while serving {stats['minFreeHeapServing']}  "
+          f"min ever {stats['minFreeHeapEver']}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,20 @@
+"""
+Medibox - builds the fuzz environment with clang and libFuzzer
+
+PlatformIO's native platform uses the host's default compiler, which may
+be gcc; libFuzzer needs clang. Switches the compiler and adds the fuzzer
+with AddressSanitizer and UndefinedBehaviorSanitizer, to the compiler and
+linker flags alike (build_flags only reach the compiler). libFuzzer
+brings its own main(), so the harness leaves its replay main() out.
+"""
+
+Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+
+SANITIZE = "-fsanitize=fuzzer,address,undefined"
+
+env.Replace(CC="clang", CXX="clang++", LINK="clang++")  # noqa: F821
+env.Append(  # noqa: F821
+    CCFLAGS=[SANITIZE, "-g", "-fno-omit-frame-pointer"],
+    LINKFLAGS=[SANITIZE],
+    CPPDEFINES=["FUZZ_LIBFUZZER"],
+)
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Medibox - local firmware server for OTA testing
+
+Serves a firmware image as /firmware.bin (with Range support, so the
+device can resume) and its SHA-256 as /firmware.bin.sha256. --drop-every
+closes the connection after that many body bytes to exercise resume.
+
+    pio run
+    python3 tools/ota_server.py .pio/build/esp32dev/firmware.bin --port 8000
+    curl -X POST -d '{"host":"<this machine>","port":8000}' http://<device>/api/ota
+    curl http://<device>/api/ota
+"""
+
+import argparse
+import hashlib
+import http.server
+import re
+import time
+
+
+def make_handler(image, digest, drop_every, rate):
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_GET(self):
+            if self.path == "/firmware.bin.sha256":
+                body = f"{digest}  firmware.bin\n".encode()
+                self.send_response(200)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+                return
+            if self.path != "/firmware.bin":
+                self.send_error(404)
+                return
+
+            start = 0
+            match = re.match(r"bytes=(\d+)-$", self.headers.get("Range", ""))
+            if match:
+                start = int(match.group(1))
+                if start >= len(image):
+                    self.send_response(416)
+                    self.send_header("Content-Range", f"bytes */{len(image)}")
+                    self.send_header("Content-Length", "0")
+                    self.end_headers()
+                    return
+                self.send_response(206)
+                self.send_header("Content-Range",
+                                 f"bytes {start}-{len(image) - 1}/{len(image)}")
+            else:
+                self.send_response(200)
+            self.send_header("Content-Length", str(len(image) - start))
+            self.send_header("Connection", "close")
+            self.end_headers()
+
+            end = len(image)
+            if drop_every and start + drop_every < end:
+                end = start + drop_every
+            pos = start
+            while pos < end:
+                step = min(rate or 4096, end - pos)
+                self.wfile.write(image[pos:pos + step])
+                pos += step
+                if rate:
+                    time.sleep(1)
+            self.close_connection = True
+            self.log_message("sent %d-%d of %d", start, end, len(image))
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("image")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--drop-every", type=int, default=0,
+                        help="close each transfer after this many bytes")
+    parser.add_argument("--rate", type=int, default=0,
+                        help="limit to this many bytes per second")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    digest = hashlib.sha256(image).hexdigest()
+    print(f"serving {args.image}: {len(image)} bytes, sha256 {digest}")
+
+    handler = make_handler(image, digest, args.drop_every, args.rate)
+    http.server.ThreadingHTTPServer(("", args.port), handler).serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""
+Medibox - converts an event trace dump to Chrome trace_event JSON
+
+Reads the binary dump from GET /api/trace, or a serial console log with
+the hex dump printed by 't' (the last one in the log is used), and writes
+JSON to open in Perfetto (ui.perfetto.dev) or chrome://tracing. Input,
+alarms, the sensor, the display, WiFi and memory alerts each get a track;
+sensor reads and display flushes are spans. Times are in microseconds from the first
+record; the device clock's 32-bit wrap is undone.
+
+    curl -o trace.bin http://192.168.1.50/api/trace
+    python3 tools/trace_to_chrome.py trace.bin -o trace.json
+    python3 tools/trace_to_chrome.py serial.log -o trace.json
+
+The record layout and event numbers are those of include/trace.h.
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+MAGIC = 0x5254424D
+HEADER = struct.Struct("<IBBHII")
+RECORD = struct.Struct("<IIBBH")
+INSTANT, BEGIN, END = range(3)
+
+BUTTONS = ("NONE", "UP", "OK", "DOWN", "CANCEL")
+WIFI = ("idle", "connecting", "connected", "backoff")
+MEMORY = ("ok", "warning", "critical")
+MEMORY_REASONS = ("low heap", "fragmented", "heap falling", "low stack")
+TRACKS = ("buttons (interrupt)", "input", "alarm", "sensor", "display", "wifi", "memory")
+
+
+def button(arg):
+    return BUTTONS[arg] if arg < len(BUTTONS) else arg
+
+
+def input_args(arg):
+    return {"button": button(arg & 0x7F), "repeat": bool(arg & 0x80), "count": arg >> 8}
+
+
+def sensor_args(arg):
+    if arg == 0x8000:
+        return {"failed": True}
+    return {"temperature": (arg - 0x10000 if arg & 0x8000 else arg) / 10}
+
+
+def memory_args(arg):
+    level = arg & 0xFF
+    reasons = [r for i, r in enumerate(MEMORY_REASONS) if arg >> 8 & 1 << i]
+    return {"level": MEMORY[level] if level < len(MEMORY) else level, "reasons": reasons}
+
+
+# Event number: name, track, arguments of instants and span ends
+EVENTS = {
+    0: ("button edge", 0, lambda a: {"button": button(a)}),
+    1: ("input", 1, input_args),
+    2: ("alarm ring", 2, lambda a: {"alarm": a}),
+    3: ("alarm snooze", 2, lambda a: {"alarm": a}),
+    4: ("alarm stop", 2, lambda a: {"alarm": a}),
+    5: ("sensor read", 3, sensor_args),
+    6: ("display flush", 4, lambda a: {"bytes": a}),
+    7: ("wifi", 5, lambda a: {"state": WIFI[a] if a < len(WIFI) else a}),
+    8: ("memory alert", 6, memory_args),
+}
+
+
+def from_serial(text):
+    dumps = re.findall(r"TRACE BEGIN\s*\n(.*?)TRACE END", text, re.S)
+    if not dumps:
+        raise SystemExit("no TRACE BEGIN ... TRACE END block in the log")
+    # Other tasks may print in between; only whole hex lines are data
+    lines = [l.strip() for l in dumps[-1].splitlines()]
+    return bytes.fromhex("".join(l for l in lines if re.fullmatch(r"(?:[0-9a-f]{2})+", l)))
+
+
+def parse(data):
+    if len(data) < HEADER.size:
+        raise SystemExit("dump too short")
+    magic, version, record_size, capacity, now_us, written = HEADER.unpack_from(data)
+    if magic != MAGIC or version != 1 or record_size != RECORD.size:
+        raise SystemExit(f"not a version 1 trace dump (magic {magic:#x}, version {version})")
+    body = data[HEADER.size:]
+    records = [RECORD.unpack_from(body, i) for i in range(0, len(body) - RECORD.size + 1, RECORD.size)]
+    return {"capacity": capacity, "now_us": now_us, "written": written}, records
+
+
+def convert(records):
+    events = [{"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "Medibox"}}]
+    for tid, name in enumerate(TRACKS):
+        events.append({"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    base = prev = None
+    wraps = 0
+    open_spans = {}
+    gaps = 0
+    last_seq = None
+    for seq, us, event, phase, arg in records:
+        if last_seq is not None and seq != last_seq + 1:
+            gaps += seq - last_seq - 1
+        last_seq = seq
+        if prev is not None and us < prev and prev - us > 1 << 31:
+            wraps += 1
+        prev = us
+        ts = us + (wraps << 32)
+        if base is None:
+            base = ts
+        name, tid, decode = EVENTS.get(event, (f"event {event}", len(TRACKS), lambda a: {"arg": a}))
+        out = {"name": name, "pid": 1, "tid": tid, "ts": ts - base}
+        if phase == BEGIN:
+            open_spans[tid] = open_spans.get(tid, 0) + 1
+            out["ph"] = "B"
+        elif phase == END:
+            # The begin may have been overwritten
+            if not open_spans.get(tid):
+                continue
+            open_spans[tid] -= 1
+            out["ph"] = "E"
+            out["args"] = decode(arg)
+        else:
+            out["ph"] = "i"
+            out["s"] = "t"
+            out["args"] = decode(arg)
+        events.append(out)
+    return events, gaps
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("dump", help="binary dump or serial log, - for stdin")
+    ap.add_argument("-o", "--output", help="JSON file (default: stdout)")
+    args = ap.parse_args()
+
+    if args.dump == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    if not data.startswith(struct.pack("<I", MAGIC)):
+        data = from_serial(data.decode(errors="replace"))
+    header, records = parse(data)
+    events, gaps = convert(records)
+
+    trace = {"traceEvents": events, "displayTimeUnit": "ms", "otherData": header}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    overwritten = header["written"] - len(records) - gaps
+    print(f"{len(records)} records ({overwritten} older ones overwritten, {gaps} skipped "
+          f"while the dump ran)", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
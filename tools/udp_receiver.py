@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+Medibox - CBOR/UDP telemetry receiver
+
+Decodes datagrams from firmware built with -D TELEMETRY_UDP=1, tracks the
+per-device sequence numbers to count lost and reordered datagrams, and
+prints throughput once per interval. No third-party packages needed.
+
+    python3 tools/udp_receiver.py --port 5683 --print
+"""
+
+import argparse
+import socket
+import time
+
+SENSOR_FIELDS = ("ts", "n", "tmin", "tmax", "tmean", "hmin", "hmax", "hmean")
+EVENT_NAMES = {1: "rang", 2: "dismissed", 3: "snoozed"}
+
+
+class CborError(ValueError):
+    pass
+
+
+def cbor_decode(data, pos=0):
+    """Decodes one item; returns (value, next position)."""
+    if pos >= len(data):
+        raise CborError("truncated")
+    head = data[pos]
+    major, info = head >> 5, head & 0x1F
+    pos += 1
+    if info < 24:
+        arg = info
+    elif info in (24, 25, 26, 27):
+        size = 1 << (info - 24)
+        if pos + size > len(data):
+            raise CborError("truncated")
+        arg = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    else:
+        raise CborError(f"unsupported additional info {info}")
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        if pos + arg > len(data):
+            raise CborError("truncated")
+        raw = data[pos:pos + arg]
+        return (raw.decode() if major == 3 else raw), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = cbor_decode(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        for _ in range(arg):
+            key, pos = cbor_decode(data, pos)
+            result[key], pos = cbor_decode(data, pos)
+        return result, pos
+    raise CborError(f"unsupported major type {major}")
+
+
+class DeviceState:
+    def __init__(self):
+        self.next_seq = None
+        self.received = 0
+        self.lost = 0
+        self.late = 0
+
+
+def track(state, seq):
+    """Counts gaps as lost; a late datagram fills a gap it was counted in."""
+    state.received += 1
+    if state.next_seq is None or seq == state.next_seq:
+        pass
+    elif seq > state.next_seq:
+        state.lost += seq - state.next_seq
+    elif seq == 0:
+        state.next_seq = None    # Device rebooted
+    else:
+        state.late += 1
+        state.lost = max(0, state.lost - 1)
+        return
+    state.next_seq = seq + 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=5683)
+    parser.add_argument("--interval", type=float, default=5.0,
+                        help="seconds between throughput reports")
+    parser.add_argument("--print", action="store_true",
+                        help="print every decoded record")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 << 20)
+    sock.bind((args.bind, args.port))
+    sock.settimeout(0.5)
+    print(f"listening on udp/{args.port}")
+
+    devices = {}
+    datagrams = records = octets = errors = 0
+    window_start = time.monotonic()
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            data = None
+
+        if data is not None:
+            try:
+                msg, end = cbor_decode(data)
+                if end != len(data) or not isinstance(msg, dict):
+                    raise CborError("trailing bytes or not a map")
+                dev, seq = msg[0], msg[1]
+                sensors, events = msg.get(2, []), msg.get(3, [])
+            except (CborError, KeyError, UnicodeDecodeError) as e:
+                errors += 1
+                print(f"bad datagram ({e}): {data.hex()}")
+                continue
+
+            track(devices.setdefault(dev, DeviceState()), seq)
+            datagrams += 1
+            records += len(sensors) + len(events)
+            octets += len(data)
+            if args.print:
+                for s in sensors:
+                    fields = dict(zip(SENSOR_FIELDS, s))
+                    print(f"{dev} #{seq} sensor {fields}")
+                for ts, alarm, event, resp in events:
+                    print(f"{dev} #{seq} alarm {alarm} {EVENT_NAMES.get(event, event)}"
+                          f" after {resp}s at {ts}")
+
+        elapsed = time.monotonic() - window_start
+        if elapsed >= args.interval:
+            lost = sum(d.lost for d in devices.values())
+            seen = sum(d.received for d in devices.values())
+            loss = 100.0 * lost / (lost + seen) if lost + seen else 0.0
+            print(f"{datagrams / elapsed:8.1f} dgram/s {records / elapsed:8.1f} rec/s "
+                  f"{octets / elapsed / 1024:8.1f} KiB/s  devices {len(devices)} "
+                  f"lost {lost} ({loss:.2f}%) late {sum(d.late for d in devices.values())} "
+                  f"bad {errors}")
+            datagrams = records = octets = 0
+            window_start = time.monotonic()
+
+
+if __name__ == "__main__":
+    main()
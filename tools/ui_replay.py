@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+Medibox - records and replays UI input macros as a latency regression test
+
+record: captures button/encoder input on the device until Enter is
+pressed and saves it as a macro file.
+
+replay: uploads a macro, replays it on the device (live input is ignored
+meanwhile) and reports, per step, the time until the first frame it
+caused and the frames and bytes flushed to the display. With --baseline
+the results are compared against a stored baseline and the exit status
+is 1 if any step got slower, or the replay sent more frames or bytes,
+than the tolerances allow; --update-baseline writes the baseline
+instead. The clock screen redraws every loop(), so steps that end on it
+always see some variation in frames.
+
+native: replays macros with the host runner (the macro_replay
+environment, src/host/macro_replay.cpp) under virtual time, where frames
+and bytes are exact, and fails if any step sends more than its baseline
+in tools/macros/native/. A directory is replayed in one session, in
+NATIVE_SESSION order and then by name; --update-baseline rewrites the
+baselines.
+
+    python3 tools/ui_replay.py record 192.168.1.50 tools/macros/new.macro
+    python3 tools/ui_replay.py replay 192.168.1.50 tools/macros/set_alarm.macro \\
+        --baseline tools/macros/set_alarm.baseline.json
+    pio run -e macro_replay
+    python3 tools/ui_replay.py native .pio/build/macro_replay/program tools/macros
+
+Macro files have one step per line: time in ms since the first step,
+button (UP, OK, DOWN, CANCEL), then optionally a count and "repeat" for
+auto-repeat or encoder bursts. Record and replay from the clock screen.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+BUTTONS = ("UP", "OK", "DOWN", "CANCEL")
+MACROS = os.path.join(os.path.dirname(__file__), "macros")
+# Later macros start from where earlier ones left the device
+NATIVE_SESSION = ("set_alarm", "delete_alarm", "timezone")
+
+
+def request(host, port, method, path, body=None):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    data = json.dumps(body) if body is not None else None
+    headers = {"Content-Type": "application/json"} if data else {}
+    conn.request(method, path, body=data, headers=headers)
+    resp = conn.getresponse()
+    payload = resp.read()
+    conn.close()
+    if resp.status != 200:
+        raise SystemExit(f"{method} {path} {body or ''}: HTTP {resp.status}")
+    return json.loads(payload)
+
+
+def load_macro(path):
+    steps = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            try:
+                at, button = int(line[0]), line[1]
+                count = int(line[2]) if len(line) > 2 else 1
+                repeat = len(line) > 3 and line[3] == "repeat"
+            except (ValueError, IndexError):
+                raise SystemExit(f"{path}:{number}: expected <ms> <button> [count] [repeat]")
+            if button not in BUTTONS or (steps and at < steps[-1]["at"]):
+                raise SystemExit(f"{path}:{number}: bad button or time out of order")
+            steps.append({"at": at, "button": button, "count": count, "repeat": repeat})
+    return steps
+
+
+def save_macro(path, steps):
+    with open(path, "w") as f:
+        f.write("# Recorded with tools/ui_replay.py; <ms> <button> [count] [repeat]\n")
+        for s in steps:
+            extra = ""
+            if s["count"] != 1 or s["repeat"]:
+                extra = f" {s['count']}" + (" repeat" if s["repeat"] else "")
+            f.write(f"{s['at']} {s['button']}{extra}\n")
+
+
+def record(args):
+    request(args.host, args.port, "POST", "/api/macro", {"action": "record"})
+    input("Recording, use the device and press Enter to stop... ")
+    request(args.host, args.port, "POST", "/api/macro", {"action": "stop"})
+    steps = request(args.host, args.port, "GET", "/api/macro")["steps"]
+    save_macro(args.macro, steps)
+    print(f"{len(steps)} steps -> {args.macro}")
+
+
+def replay_once(args, steps):
+    request(args.host, args.port, "POST", "/api/macro", {"action": "clear"})
+    for s in steps:
+        request(args.host, args.port, "POST", "/api/macro", s)
+    request(args.host, args.port, "POST", "/api/macro", {"action": "replay"})
+    deadline = time.time() + steps[-1]["at"] / 1000 + 30
+    while time.time() < deadline:
+        time.sleep(0.5)
+        state = request(args.host, args.port, "GET", "/api/macro")
+        if state["state"] == "done":
+            return state["steps"]
+    raise SystemExit("replay did not finish")
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100))]
+
+
+def replay(args):
+    steps = load_macro(args.macro)
+    if not steps:
+        raise SystemExit(f"{args.macro}: no steps")
+    # Per step, the fastest of the runs: noise only ever adds time
+    best = None
+    for _ in range(args.runs):
+        run = replay_once(args, steps)
+        if best is None:
+            best = run
+        else:
+            for b, r in zip(best, run):
+                b["us"] = min(b["us"], r["us"])
+    latencies = [s["us"] for s in best]
+    result = {
+        "steps": latencies,
+        "frames": sum(s["frames"] for s in best),
+        "bytes": sum(s["bytes"] for s in best),
+    }
+
+    print(f"{'step':>4} {'at ms':>7} {'button':>7} {'ms':>8} {'frames':>7} {'bytes':>7}")
+    for i, s in enumerate(best):
+        print(f"{i:4} {s['at']:7} {s['button']:>7} {s['us'] / 1000:8.1f} "
+              f"{s['frames']:7} {s['bytes']:7}")
+    print(f"p50 {percentile(latencies, 50) / 1000:.1f} ms  p95 {percentile(latencies, 95) / 1000:.1f} ms  "
+          f"max {max(latencies) / 1000:.1f} ms  frames {result['frames']}  bytes {result['bytes']}")
+
+    if args.update_baseline:
+        with open(args.update_baseline, "w") as f:
+            json.dump(result, f, indent=1)
+            f.write("\n")
+        print(f"baseline -> {args.update_baseline}")
+        return 0
+    if not args.baseline:
+        return 0
+
+    with open(args.baseline) as f:
+        base = json.load(f)
+    if len(base["steps"]) != len(latencies):
+        raise SystemExit(f"{args.baseline}: recorded for a different macro")
+    failures = []
+    limit = 1 + args.tolerance / 100
+    for i, (now, then) in enumerate(zip(latencies, base["steps"])):
+        # Small steps are all jitter; allow a fixed slack as well
+        if now > then * limit + args.slack_us:
+            failures.append(f"step {i}: {now / 1000:.1f} ms, baseline {then / 1000:.1f} ms")
+    traffic = 1 + args.traffic_tolerance / 100
+    for key in ("frames", "bytes"):
+        if result[key] > base[key] * traffic:
+            failures.append(f"{key}: {result[key]}, baseline {base[key]}")
+    for failure in failures:
+        print(f"REGRESSION {failure}")
+    return 1 if failures else 0
+
+
+def session(path):
+    if not os.path.isdir(path):
+        return [path]
+    names = sorted(f[:-len(".macro")] for f in os.listdir(path) if f.endswith(".macro"))
+    ordered = [n for n in NATIVE_SESSION if n in names]
+    ordered += [n for n in names if n not in ordered]
+    return [os.path.join(path, n + ".macro") for n in ordered]
+
+
+def native(args):
+    macros = session(args.macro)
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, "replay.json")
+        run = subprocess.run([args.host, out] + macros)
+        if run.returncode != 0:
+            raise SystemExit(f"{args.host} failed with status {run.returncode}")
+        with open(out) as f:
+            results = json.load(f)["macros"]
+
+    failures = []
+    os.makedirs(args.baseline_dir, exist_ok=True)
+    print(f"{'macro':<16} {'frames':>7} {'baseline':>9} {'bytes':>8} {'baseline':>9}")
+    for name, r in results.items():
+        result = {
+            "frames": r["frames"],
+            "bytes": r["bytes"],
+            "step_frames": [s["frames"] for s in r["steps"]],
+            "step_bytes": [s["bytes"] for s in r["steps"]],
+        }
+        path = os.path.join(args.baseline_dir, name + ".baseline.json")
+        if args.update_baseline is not None:
+            with open(path, "w") as f:
+                json.dump(result, f, indent=1)
+                f.write("\n")
+            print(f"{name:<16} {result['frames']:7} {'-':>9} {result['bytes']:8} {'-':>9}")
+            continue
+        if not os.path.exists(path):
+            failures.append(f"{name}: no baseline, run with --update-baseline")
+            continue
+        with open(path) as f:
+            base = json.load(f)
+        print(f"{name:<16} {result['frames']:7} {base['frames']:9} "
+              f"{result['bytes']:8} {base['bytes']:9}")
+        if len(base["step_frames"]) != len(result["step_frames"]):
+            failures.append(f"{name}: baseline recorded for a different macro")
+            continue
+        # Virtual time makes these exact, so any increase is a regression
+        for i, (now, then) in enumerate(zip(result["step_bytes"], base["step_bytes"])):
+            if now > then:
+                failures.append(f"{name} step {i}: {now} bytes, baseline {then}")
+        for key in ("frames", "bytes"):
+            if result[key] > base[key]:
+                failures.append(f"{name} {key}: {result[key]}, baseline {base[key]}")
+            elif result[key] < base[key]:
+                print(f"{name} {key} down from {base[key]}, refresh with --update-baseline")
+    for failure in failures:
+        print(f"REGRESSION {failure}")
+    return 1 if failures else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("command", choices=("record", "replay", "native"))
+    ap.add_argument("host", help="device address, or for native the runner program")
+    ap.add_argument("macro", help="macro file, or for native also a directory")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--runs", type=int, default=3)
+    ap.add_argument("--baseline", help="fail if the replay is worse than this")
+    ap.add_argument("--update-baseline", metavar="FILE", nargs="?", const="",
+                    help="write the results as a baseline (native: no FILE)")
+    ap.add_argument("--baseline-dir", default=os.path.join(MACROS, "native"),
+                    help="native baselines, one per macro")
+    ap.add_argument("--tolerance", type=float, default=25, help="percent, per step")
+    ap.add_argument("--slack-us", type=int, default=2000)
+    ap.add_argument("--traffic-tolerance", type=float, default=10,
+                    help="percent, frames and bytes over the whole replay")
+    args = ap.parse_args()
+    if args.command == "record":
+        record(args)
+        return 0
+    if args.command == "native":
+        return native(args)
+    return replay(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
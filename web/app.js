@@ -0,0 +1,111 @@
+// Medibox - alarm and settings UI on top of the REST API (include/rest_api.h)
+"use strict";
+
+const $ = (sel) => document.querySelector(sel);
+let alarmVersion = 0;
+
+function status(text) {
+  $("#status").textContent = text || "";
+}
+
+async function api(method, path, body) {
+  const res = await fetch(path, {
+    method,
+    headers: body ? { "Content-Type": "application/json" } : {},
+    body: body ? JSON.stringify(body) : undefined,
+  });
+  if (res.status === 204) return null;
+  const data = await res.json().catch(() => null);
+  if (!res.ok) {
+    const err = new Error(`${method} ${path}: ${res.status}`);
+    err.status = res.status;
+    err.data = data;
+    throw err;
+  }
+  return data;
+}
+
+const pad = (n) => String(n).padStart(2, "0");
+
+function renderAlarms(set) {
+  alarmVersion = set.version;
+  $("#version").textContent = `v${set.version}`;
+  const body = $("#alarms tbody");
+  body.textContent = "";
+  for (const a of set.alarms) {
+    const row = body.insertRow();
+    row.className = a.active ? "" : "off";
+    row.insertCell().textContent = `Alarm ${a.id}`;
+    row.insertCell().textContent = a.active ? `${pad(a.hour)}:${pad(a.minute)}` : "off";
+    const cell = row.insertCell();
+    if (a.active) {
+      const del = document.createElement("button");
+      del.textContent = "Delete";
+      del.onclick = () => patchAlarms({ [a.id]: null });
+      cell.appendChild(del);
+    }
+  }
+}
+
+// Versioned patch; on 409 the device returns the current table to rebase on
+async function patchAlarms(changes) {
+  try {
+    renderAlarms(await api("PATCH", "/api/alarmset", { base: alarmVersion, ...changes }));
+    status();
+  } catch (e) {
+    if (e.status === 409 && e.data) {
+      renderAlarms(e.data);
+      status("Alarms changed on the device, please retry");
+    } else {
+      status(e.message);
+    }
+  }
+}
+
+function fillForm(form, values) {
+  for (const [k, v] of Object.entries(values)) {
+    if (form.elements[k]) form.elements[k].value = v;
+  }
+}
+
+function formNumbers(form) {
+  const out = {};
+  for (const el of form.elements) {
+    if (el.name && el.type === "number") out[el.name] = parseFloat(el.value);
+  }
+  return out;
+}
+
+$("#add").onsubmit = async (ev) => {
+  ev.preventDefault();
+  const set = await api("GET", "/api/alarmset");
+  renderAlarms(set);
+  const free = set.alarms.find((a) => !a.active);
+  if (!free) return status("No free alarm slot");
+  patchAlarms({ [free.id]: ev.target.elements.time.value });
+};
+
+for (const [id, path] of [["#timezone", "/api/timezone"], ["#thresholds", "/api/thresholds"]]) {
+  $(id).onsubmit = async (ev) => {
+    ev.preventDefault();
+    try {
+      fillForm(ev.target, await api("PUT", path, formNumbers(ev.target)));
+      status();
+    } catch (e) {
+      status(e.message);
+    }
+  };
+}
+
+async function load() {
+  try {
+    renderAlarms(await api("GET", "/api/alarmset"));
+    fillForm($("#timezone"), await api("GET", "/api/timezone"));
+    fillForm($("#thresholds"), await api("GET", "/api/thresholds"));
+    status();
+  } catch (e) {
+    status(e.message);
+  }
+}
+
+load();